@@ -12,6 +12,25 @@ static inline void cpuid(unsigned int op,
 	do_cpuid(eax, ebx, ecx, edx);
 }
 
+/*
+ * AVX2, and the OS saves the ymm registers
+ */
+static inline bool arch_cpu_has_avx2(void)
+{
+	unsigned int eax, ebx, ecx, edx, xcr0;
+
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1U << 27)) || !(ecx & (1U << 28)))
+		return false;
+
+	__asm__ __volatile__("xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0));
+	if ((xcr0 & 6) != 6)
+		return false;
+
+	cpuid(7, &eax, &ebx, &ecx, &edx);
+	return (ebx & (1U << 5)) != 0;
+}
+
 #define ARCH_HAVE_INIT
 
 extern bool tsc_reliable;
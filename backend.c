@@ -34,6 +34,8 @@
 #include "fio.h"
 #include "smalloc.h"
 #include "verify.h"
+#include "verify-journal.h"
+#include "content-pool.h"
 #include "diskutil.h"
 #include "cgroup.h"
 #include "profile.h"
@@ -563,7 +565,7 @@ static int unlink_all_files(struct thread_data *td)
 /*
  * Check if io_u will overlap an in-flight IO in the queue
  */
-bool in_flight_overlap(struct io_u_queue *q, struct io_u *io_u)
+static bool in_flight_overlap_scan(struct io_u_queue *q, struct io_u *io_u)
 {
 	bool overlap;
 	struct io_u *check_io_u;
@@ -591,6 +593,34 @@ bool in_flight_overlap(struct io_u_queue *q, struct io_u *io_u)
 	return overlap;
 }
 
+/*
+ * Check if io_u will overlap an in-flight IO of td
+ */
+bool in_flight_overlap(struct thread_data *td, struct io_u *io_u)
+{
+	struct prio_tree_iter iter;
+	struct prio_tree_node *n;
+	struct io_u *check_io_u;
+
+	if (!io_u->buflen)
+		return false;
+
+	if (td->io_u_overlap_scan)
+		return in_flight_overlap_scan(&td->io_u_all, io_u);
+
+	prio_tree_iter_init(&iter, &td->io_u_overlap_tree, io_u->offset,
+			    io_u->offset + io_u->buflen - 1);
+	n = prio_tree_next(&iter);
+	if (!n)
+		return false;
+
+	check_io_u = container_of(n, struct io_u, overlap_node);
+	dprint(FD_IO, "in-flight overlap: %llu/%llu, %llu/%llu\n",
+			io_u->offset, io_u->buflen,
+			check_io_u->offset, check_io_u->buflen);
+	return true;
+}
+
 static enum fio_q_status io_u_submit(struct thread_data *td, struct io_u *io_u)
 {
 	/*
@@ -598,7 +628,7 @@ static enum fio_q_status io_u_submit(struct thread_data *td, struct io_u *io_u)
 	 * at least one IO in flight besides this one.
 	 */
 	if (td->o.serialize_overlap && td->cur_depth > 1 &&
-	    in_flight_overlap(&td->io_u_all, io_u))
+	    in_flight_overlap(td, io_u))
 		return FIO_Q_BUSY;
 
 	return td_io_queue(td, io_u);
@@ -612,11 +642,22 @@ static void do_verify(struct thread_data *td, uint64_t verify_bytes)
 {
 	struct fio_file *f;
 	struct io_u *io_u;
+	uint64_t io_issues[DDIR_RWDIR_CNT], io_issue_bytes[DDIR_RWDIR_CNT];
 	int ret, min_events;
 	unsigned int i;
 
 	dprint(FD_VERIFY, "starting loop\n");
 
+	/*
+	 * experimental_verify replays the writes, which are accounted as
+	 * issued again. Don't let that eat into the budget or the numberio
+	 * sequence of the next loop, and only count what this loop verifies
+	 * against what it wrote.
+	 */
+	memcpy(io_issues, td->io_issues, sizeof(io_issues));
+	memcpy(io_issue_bytes, td->io_issue_bytes, sizeof(io_issue_bytes));
+	verify_bytes += td->bytes_verified;
+
 	/*
 	 * sync io first and invalidate cache, to make sure we really
 	 * read from disk.
@@ -757,6 +798,11 @@ reap:
 	} else
 		cleanup_pending_aio(td);
 
+	if (td->o.experimental_verify) {
+		memcpy(td->io_issues, io_issues, sizeof(io_issues));
+		memcpy(td->io_issue_bytes, io_issue_bytes, sizeof(io_issue_bytes));
+	}
+
 	td_set_runstate(td, TD_RUNNING);
 
 	dprint(FD_VERIFY, "exiting loop\n");
@@ -1111,7 +1157,7 @@ static void do_io(struct thread_data *td, uint64_t *bytes_done)
 				td->rate_io_issue_bytes[__ddir] += blen;
 			}
 
-			if (should_check_rate(td)) {
+			if (should_check_rate(td) && ddir_rw(__ddir)) {
 				td->rate_next_io_time[__ddir] = usec_for_io(td, __ddir);
 				fio_gettime(&comp_time, NULL);
 			}
@@ -1119,7 +1165,7 @@ static void do_io(struct thread_data *td, uint64_t *bytes_done)
 		} else {
 			ret = io_u_submit(td, io_u);
 
-			if (should_check_rate(td))
+			if (should_check_rate(td) && ddir_rw(ddir))
 				td->rate_next_io_time[ddir] = usec_for_io(td, ddir);
 
 			if (io_queue_event(td, io_u, &ret, ddir, &bytes_issued, 0, &comp_time))
@@ -1287,6 +1333,8 @@ static int init_io_u(struct thread_data *td)
 		return 1;
 	}
 
+	INIT_PRIO_TREE_ROOT(&td->io_u_overlap_tree);
+
 	cl_align = os_cache_line_size();
 
 	for (i = 0; i < max_units; i++) {
@@ -1846,12 +1894,18 @@ static void *thread_main(void *data)
 	if (init_io_u(td))
 		goto err;
 
+	if (content_pool_init(td))
+		goto err;
+
 	if (td->io_ops->post_init && td->io_ops->post_init(td))
 		goto err;
 
 	if (o->verify_async && verify_async_init(td))
 		goto err;
 
+	if (o->verify_journal && verify_journal_init(td))
+		goto err;
+
 	if (o->cgroup && cgroup_setup(td, cgroup_list, &cgroup_mnt))
 		goto err;
 
@@ -1870,6 +1924,14 @@ static void *thread_main(void *data)
 	if (!init_random_map(td))
 		goto err;
 
+	if (o->lat_heatmap && init_lat_heatmap(td))
+		goto err;
+
+	if (o->file_stats && init_file_stats(td))
+		goto err;
+
+	init_verify_map(td);
+
 	if (o->exec_prerun && exec_string(o, o->exec_prerun, "prerun"))
 		goto err;
 
@@ -1917,7 +1979,9 @@ static void *thread_main(void *data)
 
 		prune_io_piece_log(td);
 
-		if (td->o.verify_only && td_write(td))
+		if (verify_journal_check(td))
+			verify_bytes = verify_journal_load(td);
+		else if (td->o.verify_only && td_write(td))
 			verify_bytes = do_dry_run(td);
 		else {
 			if (!td->o.rand_repeatable)
@@ -2001,6 +2065,10 @@ static void *thread_main(void *data)
 
 		if (td->error || td->terminate)
 			break;
+
+		/* The journal covers all loops of the job that wrote it */
+		if (verify_journal_check(td))
+			break;
 	}
 
 	/*
@@ -2042,6 +2110,9 @@ static void *thread_main(void *data)
 
 	td_writeout_logs(td, true);
 
+	if (o->write_lat_heatmap)
+		write_lat_heatmap(td);
+
 	iolog_compress_exit(td);
 	rate_submit_exit(td);
 
@@ -2058,10 +2129,13 @@ err:
 
 	if (o->verify_async)
 		verify_async_exit(td);
+	verify_journal_exit(td);
+	file_stats_exit(td);
 
 	close_and_free_files(td);
 	cleanup_io_u(td);
 	close_ioengine(td);
+	content_pool_exit(td);
 	cgroup_shutdown(td, cgroup_mnt);
 	verify_free_state(td);
 	td_zone_free_index(td);
@@ -2652,6 +2726,8 @@ int fio_backend(struct sk_out *sk_out)
 		log_err("fio: failed to initialize global dedupe working set\n");
 		return 1;
 	}
+	if (init_dedupe_working_set_caches())
+		return 1;
 
 	startup_sem = fio_sem_init(FIO_SEM_LOCKED);
 	if (!sk_out)
@@ -2688,6 +2764,10 @@ int fio_backend(struct sk_out *sk_out)
 		struct thread_stat *ts = &td->ts;
 
 		free_clat_prio_stats(ts);
+		free_lat_outliers(ts);
+		free_lat_heatmap(ts);
+		free_file_stats(ts);
+		free_clat_depth(ts);
 		steadystate_free(td);
 		fio_options_free(td);
 		fio_dump_options_free(td);
@@ -2699,6 +2779,7 @@ int fio_backend(struct sk_out *sk_out)
 		td->sem = NULL;
 	} end_for_each();
 
+	free_dedupe_working_set_caches();
 	free_disk_util();
 	if (cgroup_list) {
 		cgroup_kill(cgroup_list);
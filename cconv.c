@@ -41,12 +41,16 @@ static void free_thread_options_to_cpu(struct thread_options *o)
 	free(o->lat_log_file);
 	free(o->iops_log_file);
 	free(o->hist_log_file);
+	free(o->pct_log_file);
+	free(o->lat_heatmap_file);
 	free(o->replay_redirect);
 	free(o->exec_prerun);
 	free(o->exec_postrun);
 	free(o->ioscheduler);
 	free(o->profile);
 	free(o->cgroup);
+	free(o->verify_journal);
+	free(o->buffer_pool_file);
 
 	free(o->verify_pattern);
 	free(o->buffer_pattern);
@@ -88,6 +92,8 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	string_to_cpu(&o->lat_log_file, top->lat_log_file);
 	string_to_cpu(&o->iops_log_file, top->iops_log_file);
 	string_to_cpu(&o->hist_log_file, top->hist_log_file);
+	string_to_cpu(&o->pct_log_file, top->pct_log_file);
+	string_to_cpu(&o->lat_heatmap_file, top->lat_heatmap_file);
 	string_to_cpu(&o->replay_redirect, top->replay_redirect);
 	string_to_cpu(&o->exec_prerun, top->exec_prerun);
 	string_to_cpu(&o->exec_postrun, top->exec_postrun);
@@ -95,6 +101,8 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	string_to_cpu(&o->profile, top->profile);
 	string_to_cpu(&o->cgroup, top->cgroup);
 	string_to_cpu(&o->dp_scheme_file, top->dp_scheme_file);
+	string_to_cpu(&o->verify_journal, top->verify_journal);
+	string_to_cpu(&o->buffer_pool_file, top->buffer_pool_file);
 
 	o->allow_create = le32_to_cpu(top->allow_create);
 	o->allow_mounted_write = le32_to_cpu(top->allow_mounted_write);
@@ -179,6 +187,7 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	o->verify = le32_to_cpu(top->verify);
 	o->do_verify = le32_to_cpu(top->do_verify);
 	o->experimental_verify = le32_to_cpu(top->experimental_verify);
+	o->verify_streaming = le32_to_cpu(top->verify_streaming);
 	o->verify_state = le32_to_cpu(top->verify_state);
 	o->verify_interval = le32_to_cpu(top->verify_interval);
 	o->verify_offset = le32_to_cpu(top->verify_offset);
@@ -219,6 +228,7 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	o->log_issue_time = le32_to_cpu(top->log_issue_time);
 	o->log_gz = le32_to_cpu(top->log_gz);
 	o->log_gz_store = le32_to_cpu(top->log_gz_store);
+	o->log_gz_type = le32_to_cpu(top->log_gz_type);
 	o->log_alternate_epoch = le32_to_cpu(top->log_alternate_epoch);
 	o->log_alternate_epoch_clock_id = le32_to_cpu(top->log_alternate_epoch_clock_id);
 	o->job_start_clock_id = le32_to_cpu(top->job_start_clock_id);
@@ -263,6 +273,10 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	o->zone_mode = le32_to_cpu(top->zone_mode);
 	o->max_open_zones = __le32_to_cpu(top->max_open_zones);
 	o->ignore_zone_limits = le32_to_cpu(top->ignore_zone_limits);
+	o->zone_emu = le32_to_cpu(top->zone_emu);
+	o->zone_emu_max_open = le32_to_cpu(top->zone_emu_max_open);
+	o->zone_emu_max_active = le32_to_cpu(top->zone_emu_max_active);
+	o->zone_append = le32_to_cpu(top->zone_append);
 	o->lockmem = le64_to_cpu(top->lockmem);
 	o->offset_increment_percent = le32_to_cpu(top->offset_increment_percent);
 	o->offset_increment = le64_to_cpu(top->offset_increment);
@@ -324,13 +338,24 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	o->latency_target = le64_to_cpu(top->latency_target);
 	o->latency_window = le64_to_cpu(top->latency_window);
 	o->latency_percentile.u.f = fio_uint64_to_double(le64_to_cpu(top->latency_percentile.u.i));
+	o->lat_outliers = le32_to_cpu(top->lat_outliers);
+	o->lat_outliers_window = le64_to_cpu(top->lat_outliers_window);
+	o->lat_heatmap = le32_to_cpu(top->lat_heatmap);
+	o->write_lat_heatmap = le32_to_cpu(top->write_lat_heatmap);
+	o->lat_heatmap_region_nz = le32_to_cpu(top->lat_heatmap_region_nz);
+	o->lat_heatmap_region = le64_to_cpu(top->lat_heatmap_region);
+	o->file_stats = le32_to_cpu(top->file_stats);
+	o->file_stats_sort = le32_to_cpu(top->file_stats_sort);
+	o->clat_depth_hist = le32_to_cpu(top->clat_depth_hist);
 	o->latency_run = le32_to_cpu(top->latency_run);
 	o->compress_percentage = le32_to_cpu(top->compress_percentage);
 	o->compress_chunk = le32_to_cpu(top->compress_chunk);
 	o->dedupe_percentage = le32_to_cpu(top->dedupe_percentage);
 	o->dedupe_mode = le32_to_cpu(top->dedupe_mode);
 	o->dedupe_working_set_percentage = le32_to_cpu(top->dedupe_working_set_percentage);
+	o->buffer_pool_size = le64_to_cpu(top->buffer_pool_size);
 	o->dedupe_global = le32_to_cpu(top->dedupe_global);
+	o->dedupe_working_set_cache = le32_to_cpu(top->dedupe_working_set_cache);
 	o->block_error_hist = le32_to_cpu(top->block_error_hist);
 	o->replay_align = le32_to_cpu(top->replay_align);
 	o->replay_scale = le32_to_cpu(top->replay_scale);
@@ -341,6 +366,9 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	o->write_lat_log = le32_to_cpu(top->write_lat_log);
 	o->write_iops_log = le32_to_cpu(top->write_iops_log);
 	o->write_hist_log = le32_to_cpu(top->write_hist_log);
+	o->write_pct_log = le32_to_cpu(top->write_pct_log);
+	o->log_pct_msec = le32_to_cpu(top->log_pct_msec);
+	o->log_pct_json = le32_to_cpu(top->log_pct_json);
 
 	o->trim_backlog = le64_to_cpu(top->trim_backlog);
 	o->rate_process = le32_to_cpu(top->rate_process);
@@ -355,12 +383,19 @@ int convert_thread_options_to_cpu(struct thread_options *o,
 	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++)
 		o->merge_blktrace_iters[i].u.f = fio_uint64_to_double(le64_to_cpu(top->merge_blktrace_iters[i].u.i));
 
+	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++)
+		o->log_pct_list[i].u.f = fio_uint64_to_double(le64_to_cpu(top->log_pct_list[i].u.i));
+
 	o->fdp = le32_to_cpu(top->fdp);
 	o->dp_type = le32_to_cpu(top->dp_type);
 	o->dp_id_select = le32_to_cpu(top->dp_id_select);
 	o->dp_nr_ids = le32_to_cpu(top->dp_nr_ids);
 	for (i = 0; i < o->dp_nr_ids; i++)
 		o->dp_ids[i] = le16_to_cpu(top->dp_ids[i]);
+	o->dp_emu = le32_to_cpu(top->dp_emu);
+	o->dp_emu_ru_size = le64_to_cpu(top->dp_emu_ru_size);
+	o->dp_emu_nr_ruhs = le32_to_cpu(top->dp_emu_nr_ruhs);
+	o->dp_emu_op = le32_to_cpu(top->dp_emu_op);
 #if 0
 	uint8_t cpumask[FIO_TOP_STR_MAX];
 	uint8_t verify_cpumask[FIO_TOP_STR_MAX];
@@ -394,6 +429,8 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	string_to_net(top->lat_log_file, o->lat_log_file);
 	string_to_net(top->iops_log_file, o->iops_log_file);
 	string_to_net(top->hist_log_file, o->hist_log_file);
+	string_to_net(top->pct_log_file, o->pct_log_file);
+	string_to_net(top->lat_heatmap_file, o->lat_heatmap_file);
 	string_to_net(top->replay_redirect, o->replay_redirect);
 	string_to_net(top->exec_prerun, o->exec_prerun);
 	string_to_net(top->exec_postrun, o->exec_postrun);
@@ -401,6 +438,8 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	string_to_net(top->profile, o->profile);
 	string_to_net(top->cgroup, o->cgroup);
 	string_to_net(top->dp_scheme_file, o->dp_scheme_file);
+	string_to_net(top->verify_journal, o->verify_journal);
+	string_to_net(top->buffer_pool_file, o->buffer_pool_file);
 
 	top->allow_create = cpu_to_le32(o->allow_create);
 	top->allow_mounted_write = cpu_to_le32(o->allow_mounted_write);
@@ -439,6 +478,7 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->verify = cpu_to_le32(o->verify);
 	top->do_verify = cpu_to_le32(o->do_verify);
 	top->experimental_verify = cpu_to_le32(o->experimental_verify);
+	top->verify_streaming = cpu_to_le32(o->verify_streaming);
 	top->verify_state = cpu_to_le32(o->verify_state);
 	top->verify_interval = cpu_to_le32(o->verify_interval);
 	top->verify_offset = cpu_to_le32(o->verify_offset);
@@ -462,6 +502,7 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->log_issue_time = cpu_to_le32(o->log_issue_time);
 	top->log_gz = cpu_to_le32(o->log_gz);
 	top->log_gz_store = cpu_to_le32(o->log_gz_store);
+	top->log_gz_type = cpu_to_le32(o->log_gz_type);
 	top->log_alternate_epoch = cpu_to_le32(o->log_alternate_epoch);
 	top->log_alternate_epoch_clock_id = cpu_to_le32(o->log_alternate_epoch_clock_id);
 	top->job_start_clock_id = cpu_to_le32(o->job_start_clock_id);
@@ -545,13 +586,24 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->latency_target = __cpu_to_le64(o->latency_target);
 	top->latency_window = __cpu_to_le64(o->latency_window);
 	top->latency_percentile.u.i = __cpu_to_le64(fio_double_to_uint64(o->latency_percentile.u.f));
+	top->lat_outliers = cpu_to_le32(o->lat_outliers);
+	top->lat_outliers_window = __cpu_to_le64(o->lat_outliers_window);
+	top->lat_heatmap = cpu_to_le32(o->lat_heatmap);
+	top->write_lat_heatmap = cpu_to_le32(o->write_lat_heatmap);
+	top->lat_heatmap_region_nz = cpu_to_le32(o->lat_heatmap_region_nz);
+	top->lat_heatmap_region = __cpu_to_le64(o->lat_heatmap_region);
+	top->file_stats = cpu_to_le32(o->file_stats);
+	top->file_stats_sort = cpu_to_le32(o->file_stats_sort);
+	top->clat_depth_hist = cpu_to_le32(o->clat_depth_hist);
 	top->latency_run = __cpu_to_le32(o->latency_run);
 	top->compress_percentage = cpu_to_le32(o->compress_percentage);
 	top->compress_chunk = cpu_to_le32(o->compress_chunk);
 	top->dedupe_percentage = cpu_to_le32(o->dedupe_percentage);
 	top->dedupe_mode = cpu_to_le32(o->dedupe_mode);
 	top->dedupe_working_set_percentage = cpu_to_le32(o->dedupe_working_set_percentage);
+	top->buffer_pool_size = __cpu_to_le64(o->buffer_pool_size);
 	top->dedupe_global = cpu_to_le32(o->dedupe_global);
+	top->dedupe_working_set_cache = cpu_to_le32(o->dedupe_working_set_cache);
 	top->block_error_hist = cpu_to_le32(o->block_error_hist);
 	top->replay_align = cpu_to_le32(o->replay_align);
 	top->replay_scale = cpu_to_le32(o->replay_scale);
@@ -562,6 +614,9 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->write_lat_log = cpu_to_le32(o->write_lat_log);
 	top->write_iops_log = cpu_to_le32(o->write_iops_log);
 	top->write_hist_log = cpu_to_le32(o->write_hist_log);
+	top->write_pct_log = cpu_to_le32(o->write_pct_log);
+	top->log_pct_msec = cpu_to_le32(o->log_pct_msec);
+	top->log_pct_json = cpu_to_le32(o->log_pct_json);
 
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		top->bs[i] = __cpu_to_le64(o->bs[i]);
@@ -633,6 +688,10 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->zone_mode = __cpu_to_le32(o->zone_mode);
 	top->max_open_zones = __cpu_to_le32(o->max_open_zones);
 	top->ignore_zone_limits = cpu_to_le32(o->ignore_zone_limits);
+	top->zone_emu = cpu_to_le32(o->zone_emu);
+	top->zone_emu_max_open = cpu_to_le32(o->zone_emu_max_open);
+	top->zone_emu_max_active = cpu_to_le32(o->zone_emu_max_active);
+	top->zone_append = cpu_to_le32(o->zone_append);
 	top->lockmem = __cpu_to_le64(o->lockmem);
 	top->ddir_seq_add = __cpu_to_le64(o->ddir_seq_add);
 	top->file_size_low = __cpu_to_le64(o->file_size_low);
@@ -656,12 +715,19 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++)
 		top->merge_blktrace_iters[i].u.i = __cpu_to_le64(fio_double_to_uint64(o->merge_blktrace_iters[i].u.f));
 
+	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++)
+		top->log_pct_list[i].u.i = __cpu_to_le64(fio_double_to_uint64(o->log_pct_list[i].u.f));
+
 	top->fdp = cpu_to_le32(o->fdp);
 	top->dp_type = cpu_to_le32(o->dp_type);
 	top->dp_id_select = cpu_to_le32(o->dp_id_select);
 	top->dp_nr_ids = cpu_to_le32(o->dp_nr_ids);
 	for (i = 0; i < o->dp_nr_ids; i++)
 		top->dp_ids[i] = cpu_to_le16(o->dp_ids[i]);
+	top->dp_emu = cpu_to_le32(o->dp_emu);
+	top->dp_emu_ru_size = __cpu_to_le64(o->dp_emu_ru_size);
+	top->dp_emu_nr_ruhs = cpu_to_le32(o->dp_emu_nr_ruhs);
+	top->dp_emu_op = cpu_to_le32(o->dp_emu_op);
 #if 0
 	uint8_t cpumask[FIO_TOP_STR_MAX];
 	uint8_t verify_cpumask[FIO_TOP_STR_MAX];
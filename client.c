@@ -73,6 +73,8 @@ static int error_clients;
 static struct flist_head client_hash[FIO_CLIENT_HASH_SZ];
 
 static struct cmd_iolog_pdu *convert_iolog(struct fio_net_cmd *, bool *);
+static int convert_iolog_gz(struct fio_net_cmd *, struct cmd_iolog_pdu *,
+			    FILE *);
 
 static void fio_client_add_hash(struct fio_client *client)
 {
@@ -1022,12 +1024,39 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 	dst->total_complete	= le64_to_cpu(src->total_complete);
 	dst->nr_zone_resets	= le64_to_cpu(src->nr_zone_resets);
 
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++) {
+		convert_io_stat(&dst->zone_mgmt_stat[i], &src->zone_mgmt_stat[i]);
+		for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+			dst->io_u_zone_mgmt_plat[i][j] = le64_to_cpu(src->io_u_zone_mgmt_plat[i][j]);
+	}
+
+	for (i = 0; i < FIO_MAX_DP_IDS; i++) {
+		dst->dp_io_bytes[i]	= le64_to_cpu(src->dp_io_bytes[i]);
+		convert_io_stat(&dst->dp_clat_stat[i], &src->dp_clat_stat[i]);
+		dst->dp_ru_reclaims[i]	= le64_to_cpu(src->dp_ru_reclaims[i]);
+		dst->dp_gc_bytes[i]	= le64_to_cpu(src->dp_gc_bytes[i]);
+	}
+	dst->dp_emu_host_bytes	= le64_to_cpu(src->dp_emu_host_bytes);
+	dst->dp_emu_gc_bytes	= le64_to_cpu(src->dp_emu_gc_bytes);
+
+	for (i = 0; i < FIO_VJ_CNT; i++)
+		dst->vj_blocks[i]	= le64_to_cpu(src->vj_blocks[i]);
+	dst->vj_violations	= le64_to_cpu(src->vj_violations);
+
+	dst->dedupe_bufs	= le64_to_cpu(src->dedupe_bufs);
+	dst->dedupe_dup_bufs	= le64_to_cpu(src->dedupe_dup_bufs);
+	dst->dedupe_percentage	= le32_to_cpu(src->dedupe_percentage);
+
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		dst->io_bytes[i]	= le64_to_cpu(src->io_bytes[i]);
 		dst->runtime[i]		= le64_to_cpu(src->runtime[i]);
 	}
 
 	dst->total_run_time	= le64_to_cpu(src->total_run_time);
+	dst->zc_bytes		= le64_to_cpu(src->zc_bytes);
+	dst->zc_copied_bytes	= le64_to_cpu(src->zc_copied_bytes);
+	dst->http_requests	= le64_to_cpu(src->http_requests);
+	dst->http_connects	= le64_to_cpu(src->http_connects);
 	dst->continue_on_error	= le16_to_cpu(src->continue_on_error);
 	dst->total_err_count	= le64_to_cpu(src->total_err_count);
 	dst->first_error	= le32_to_cpu(src->first_error);
@@ -1075,6 +1104,52 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 
 	dst->cachehit		= le64_to_cpu(src->cachehit);
 	dst->cachemiss		= le64_to_cpu(src->cachemiss);
+
+	dst->lat_outliers_slots	= le32_to_cpu(src->lat_outliers_slots);
+	dst->lat_outliers_per_window = le32_to_cpu(src->lat_outliers_per_window);
+	dst->lat_outliers_window = le64_to_cpu(src->lat_outliers_window);
+	for (i = 0; i < dst->lat_outliers_slots; i++) {
+		struct lat_outlier *e = &dst->lat_outliers[i];
+
+		e->lat		= le64_to_cpu(src->lat_outliers[i].lat);
+		e->offset	= le64_to_cpu(src->lat_outliers[i].offset);
+		e->start	= le64_to_cpu(src->lat_outliers[i].start);
+		e->issue	= le64_to_cpu(src->lat_outliers[i].issue);
+		e->complete	= le64_to_cpu(src->lat_outliers[i].complete);
+		e->window	= le32_to_cpu(src->lat_outliers[i].window);
+		e->fileno	= le32_to_cpu(src->lat_outliers[i].fileno);
+		e->len		= le32_to_cpu(src->lat_outliers[i].len);
+		e->depth	= le32_to_cpu(src->lat_outliers[i].depth);
+		e->ddir		= le16_to_cpu(src->lat_outliers[i].ddir);
+		e->ioprio	= le16_to_cpu(src->lat_outliers[i].ioprio);
+	}
+
+	dst->lat_heatmap_regions = le32_to_cpu(src->lat_heatmap_regions);
+	dst->lat_heatmap_region	= le64_to_cpu(src->lat_heatmap_region);
+	for (i = 0; i < dst->lat_heatmap_regions * FIO_LAT_HEATMAP_NR; i++)
+		dst->lat_heatmap[i] = le64_to_cpu(src->lat_heatmap[i]);
+
+	dst->nr_file_stats	= le32_to_cpu(src->nr_file_stats);
+	dst->file_stats_top	= le32_to_cpu(src->file_stats_top);
+	dst->file_stats_sort	= le32_to_cpu(src->file_stats_sort);
+	for (i = 0; i < dst->nr_file_stats; i++) {
+		struct file_stat *fs = &dst->file_stats[i].fs;
+
+		fs->bytes	= le64_to_cpu(src->file_stats[i].fs.bytes);
+		fs->lat_sum	= le64_to_cpu(src->file_stats[i].fs.lat_sum);
+		fs->lat_max	= le64_to_cpu(src->file_stats[i].fs.lat_max);
+		for (j = 0; j < FIO_FILE_STAT_NR; j++)
+			fs->lat_hist[j] = le32_to_cpu(src->file_stats[i].fs.lat_hist[j]);
+	}
+
+	dst->clat_depth_nr	= le32_to_cpu(src->clat_depth_nr);
+	for (i = 0; i < dst->clat_depth_nr; i++) {
+		struct clat_depth_stat *cd = &dst->clat_depth[i];
+
+		cd->lat_sum = le64_to_cpu(src->clat_depth[i].lat_sum);
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+			cd->hist[j] = le64_to_cpu(src->clat_depth[i].hist[j]);
+	}
 }
 
 static void convert_gs(struct group_run_stats *dst, struct group_run_stats *src)
@@ -1435,6 +1510,19 @@ static void client_flush_hist_samples(FILE *f, int hist_coarseness, void *sample
 	}
 }
 
+static void client_flush_samples(FILE *f, struct cmd_iolog_pdu *pdu,
+				 void *samples, uint64_t nr_samples)
+{
+	uint64_t sample_size = nr_samples *
+		__log_entry_sz(pdu->log_offset, pdu->log_issue_time);
+
+	if (pdu->log_type == IO_LOG_TYPE_HIST)
+		client_flush_hist_samples(f, pdu->log_hist_coarseness, samples,
+					  sample_size);
+	else
+		flush_samples(f, samples, sample_size);
+}
+
 static int fio_client_handle_iolog(struct fio_client *client,
 				   struct fio_net_cmd *cmd)
 {
@@ -1505,20 +1593,17 @@ static int fio_client_handle_iolog(struct fio_client *client,
 			goto out;
 		}
 
-		if (pdu->log_type == IO_LOG_TYPE_HIST) {
-			client_flush_hist_samples(f, pdu->log_hist_coarseness, pdu->samples,
-					   pdu->nr_samples * sizeof(struct io_sample));
-		} else {
-			flush_samples(f, pdu->samples,
-					pdu->nr_samples * sizeof(struct io_sample));
+		if (pdu->compressed == XMIT_COMPRESSED)
+			ret = convert_iolog_gz(cmd, pdu, f);
+		else {
+			client_flush_samples(f, pdu, pdu->samples,
+					     pdu->nr_samples);
+			ret = 0;
 		}
 		fclose(f);
-		ret = 0;
 	}
 
 out:
-	if (pdu && pdu != (void *) cmd->payload)
-		free(pdu);
 
 	if (log_pathname)
 		free(log_pathname);
@@ -1598,16 +1683,72 @@ static void convert_text(struct fio_net_cmd *cmd)
 	pdu->log_usec	= le64_to_cpu(pdu->log_usec);
 }
 
-static struct cmd_iolog_pdu *convert_iolog_gz(struct fio_net_cmd *cmd,
-					      struct cmd_iolog_pdu *pdu)
+/*
+ * Convert samples to host byte order. For histogram logs, every sample and
+ * its aux fields are followed by its io_u_plat_entry.
+ */
+static void convert_samples(struct cmd_iolog_pdu *pdu, void *samples,
+			    uint64_t nr_samples)
+{
+	uint64_t i;
+
+	for (i = 0; i < nr_samples; i++) {
+		struct io_sample *s;
+
+		s = __get_sample(samples, pdu->log_offset, pdu->log_issue_time, i);
+		if (pdu->log_type == IO_LOG_TYPE_HIST)
+			s = (struct io_sample *)((char *)s + sizeof(struct io_u_plat_entry) * i);
+
+		s->time		= le64_to_cpu(s->time);
+		if (pdu->log_type != IO_LOG_TYPE_HIST) {
+			s->data.val.val0	= le64_to_cpu(s->data.val.val0);
+			s->data.val.val1	= le64_to_cpu(s->data.val.val1);
+		}
+		s->__ddir	= __le32_to_cpu(s->__ddir);
+		s->bs		= le64_to_cpu(s->bs);
+		s->priority	= le16_to_cpu(s->priority);
+
+		if (pdu->log_offset)
+			s->aux[IOS_AUX_OFFSET_INDEX] =
+				le64_to_cpu(s->aux[IOS_AUX_OFFSET_INDEX]);
+
+		if (pdu->log_issue_time)
+			s->aux[IOS_AUX_ISSUE_TIME_INDEX] =
+				le64_to_cpu(s->aux[IOS_AUX_ISSUE_TIME_INDEX]);
+
+		if (pdu->log_type == IO_LOG_TYPE_HIST) {
+			s->data.plat_entry = (struct io_u_plat_entry *)(((char *)s) +
+				__log_entry_sz(pdu->log_offset, pdu->log_issue_time));
+			s->data.plat_entry->list.next = NULL;
+			s->data.plat_entry->list.prev = NULL;
+		}
+	}
+}
+
+#define IOLOG_INFLATE_WINDOW	(1024 * 1024)
+
+/*
+ * Inflate a log that the server compressed for transmission, and write out
+ * the samples as they come out. Only a window of samples is held at a time,
+ * not the whole inflated log.
+ */
+static int convert_iolog_gz(struct fio_net_cmd *cmd, struct cmd_iolog_pdu *pdu,
+			    FILE *f)
 {
 #ifdef CONFIG_ZLIB
-	struct cmd_iolog_pdu *ret;
+	size_t entry_sz, window, used = 0;
 	z_stream stream;
-	uint64_t nr_samples;
-	size_t total;
-	char *p;
-	size_t log_entry_size;
+	int err, ret = 0;
+	char *buf;
+
+	entry_sz = __log_entry_sz(pdu->log_offset, pdu->log_issue_time);
+	if (pdu->log_type == IO_LOG_TYPE_HIST)
+		entry_sz += sizeof(struct io_u_plat_entry);
+
+	window = IOLOG_INFLATE_WINDOW - IOLOG_INFLATE_WINDOW % entry_sz;
+	buf = malloc(window);
+	if (!buf)
+		return 1;
 
 	stream.zalloc = Z_NULL;
 	stream.zfree = Z_NULL;
@@ -1615,102 +1756,76 @@ static struct cmd_iolog_pdu *convert_iolog_gz(struct fio_net_cmd *cmd,
 	stream.avail_in = 0;
 	stream.next_in = Z_NULL;
 
-	if (inflateInit(&stream) != Z_OK)
-		return NULL;
-
-	/*
-	 * Get header first, it's not compressed
-	 */
-	nr_samples = le64_to_cpu(pdu->nr_samples);
-
-	log_entry_size = __log_entry_sz(le32_to_cpu(pdu->log_offset),
-					le32_to_cpu(pdu->log_issue_time));
-	if (pdu->log_type == IO_LOG_TYPE_HIST)
-		total = nr_samples * (log_entry_size +
-				      sizeof(struct io_u_plat_entry));
-	else
-		total = nr_samples * log_entry_size;
-	ret = malloc(total + sizeof(*pdu));
-	ret->nr_samples = nr_samples;
-
-	memcpy(ret, pdu, sizeof(*pdu));
-
-	p = (char *) ret + sizeof(*pdu);
+	if (inflateInit(&stream) != Z_OK) {
+		free(buf);
+		return 1;
+	}
 
 	stream.avail_in = cmd->pdu_len - sizeof(*pdu);
-	stream.next_in = (void *)((char *) pdu + sizeof(*pdu));
-	while (stream.avail_in) {
-		unsigned int this_chunk = 65536;
-		unsigned int this_len;
-		int err;
+	stream.next_in = (void *) pdu->samples;
 
-		if (this_chunk > total)
-			this_chunk = total;
+	/*
+	 * Z_BUF_ERROR means no progress was possible, which is where the
+	 * input runs out if the stream end was never sent.
+	 */
+	do {
+		uint64_t nr_samples;
 
-		stream.avail_out = this_chunk;
-		stream.next_out = (void *)p;
+		stream.avail_out = window - used;
+		stream.next_out = (void *) (buf + used);
 		err = inflate(&stream, Z_NO_FLUSH);
-		/* may be Z_OK, or Z_STREAM_END */
-		if (err < 0) {
-			/*
-			 * Z_STREAM_ERROR and Z_BUF_ERROR can safely be
-			 * ignored */
-			if (err == Z_STREAM_ERROR || err == Z_BUF_ERROR)
-				break;
+		if (err < 0 && err != Z_BUF_ERROR) {
 			log_err("fio: inflate error %d\n", err);
-			free(ret);
-			ret = NULL;
-			goto err;
+			ret = 1;
+			break;
 		}
 
-		this_len = this_chunk - stream.avail_out;
-		p += this_len;
-		total -= this_len;
-	}
+		used = window - stream.avail_out;
+		nr_samples = used / entry_sz;
+		if (!nr_samples)
+			continue;
+
+		convert_samples(pdu, buf, nr_samples);
+		client_flush_samples(f, pdu, buf, nr_samples);
+
+		used -= nr_samples * entry_sz;
+		memmove(buf, buf + nr_samples * entry_sz, used);
+	} while (err == Z_OK);
 
-err:
 	inflateEnd(&stream);
+	free(buf);
 	return ret;
 #else
-	return NULL;
+	return 1;
 #endif
 }
 
 /*
- * This has been compressed on the server side, since it can be big.
- * Uncompress here.
+ * Convert the log header to host byte order, and the samples too if they
+ * were sent plain. Logs compressed on the server side, since they can be
+ * big, are converted when they are inflated.
  */
 static struct cmd_iolog_pdu *convert_iolog(struct fio_net_cmd *cmd,
 					   bool *store_direct)
 {
-	struct cmd_iolog_pdu *pdu = (struct cmd_iolog_pdu *) cmd->payload;
-	struct cmd_iolog_pdu *ret;
-	uint64_t i;
+	struct cmd_iolog_pdu *ret = (struct cmd_iolog_pdu *) cmd->payload;
 	int compressed;
-	void *samples;
 
 	*store_direct = false;
 
 	/*
-	 * Convert if compressed and we support it. If it's not
-	 * compressed, we need not do anything.
+	 * A log compressed for transmission is inflated and converted as
+	 * it is written out. If it's stored compressed, we need not do
+	 * anything.
 	 */
-	compressed = le32_to_cpu(pdu->compressed);
+	compressed = le32_to_cpu(ret->compressed);
 	if (compressed == XMIT_COMPRESSED) {
 #ifndef CONFIG_ZLIB
 		log_err("fio: server sent compressed data by mistake\n");
 		return NULL;
 #endif
-		ret = convert_iolog_gz(cmd, pdu);
-		if (!ret) {
-			log_err("fio: failed decompressing log\n");
-			return NULL;
-		}
-	} else if (compressed == STORE_COMPRESSED) {
+	} else if (compressed == STORE_COMPRESSED)
 		*store_direct = true;
-		ret = pdu;
-	} else
-		ret = pdu;
 
 	ret->nr_samples		= le64_to_cpu(ret->nr_samples);
 	ret->thread_number	= le32_to_cpu(ret->thread_number);
@@ -1722,41 +1837,10 @@ static struct cmd_iolog_pdu *convert_iolog(struct fio_net_cmd *cmd,
 	ret->log_hist_coarseness = le32_to_cpu(ret->log_hist_coarseness);
 	ret->per_job_logs	= le32_to_cpu(ret->per_job_logs);
 
-	if (*store_direct)
+	if (compressed)
 		return ret;
 
-	samples = &ret->samples[0];
-	for (i = 0; i < ret->nr_samples; i++) {
-		struct io_sample *s;
-
-		s = __get_sample(samples, ret->log_offset, ret->log_issue_time, i);
-		if (ret->log_type == IO_LOG_TYPE_HIST)
-			s = (struct io_sample *)((char *)s + sizeof(struct io_u_plat_entry) * i);
-
-		s->time		= le64_to_cpu(s->time);
-		if (ret->log_type != IO_LOG_TYPE_HIST) {
-			s->data.val.val0	= le64_to_cpu(s->data.val.val0);
-			s->data.val.val1	= le64_to_cpu(s->data.val.val1);
-		}
-		s->__ddir	= __le32_to_cpu(s->__ddir);
-		s->bs		= le64_to_cpu(s->bs);
-		s->priority	= le16_to_cpu(s->priority);
-
-		if (ret->log_offset)
-			s->aux[IOS_AUX_OFFSET_INDEX] =
-				le64_to_cpu(s->aux[IOS_AUX_OFFSET_INDEX]);
-
-		if (ret->log_issue_time)
-			s->aux[IOS_AUX_ISSUE_TIME_INDEX] =
-				le64_to_cpu(s->aux[IOS_AUX_ISSUE_TIME_INDEX]);
-
-		if (ret->log_type == IO_LOG_TYPE_HIST) {
-			s->data.plat_entry = (struct io_u_plat_entry *)(((char *)s) + sizeof(*s));
-			s->data.plat_entry->list.next = NULL;
-			s->data.plat_entry->list.prev = NULL;
-		}
-	}
-
+	convert_samples(ret, ret->samples, ret->nr_samples);
 	return ret;
 }
 
@@ -1849,6 +1933,29 @@ int fio_handle_client(struct fio_client *client)
 			}
 		}
 
+		if (le32_to_cpu(p->ts.lat_outliers_slots)) {
+			offset = le64_to_cpu(p->ts.lat_outliers_offset);
+			p->ts.lat_outliers =
+				(struct lat_outlier *)((char *)p + offset);
+		}
+
+		if (le32_to_cpu(p->ts.lat_heatmap_regions)) {
+			offset = le64_to_cpu(p->ts.lat_heatmap_offset);
+			p->ts.lat_heatmap = (uint64_t *)((char *)p + offset);
+		}
+
+		if (le32_to_cpu(p->ts.nr_file_stats)) {
+			offset = le64_to_cpu(p->ts.file_stats_offset);
+			p->ts.file_stats =
+				(struct file_stat_entry *)((char *)p + offset);
+		}
+
+		if (le32_to_cpu(p->ts.clat_depth_nr)) {
+			offset = le64_to_cpu(p->ts.clat_depth_offset);
+			p->ts.clat_depth =
+				(struct clat_depth_stat *)((char *)p + offset);
+		}
+
 		dprint(FD_NET, "client: ts->ss_state = %u\n", (unsigned int) le32_to_cpu(p->ts.ss_state));
 		if (le32_to_cpu(p->ts.ss_state) & FIO_SS_DATA) {
 			dprint(FD_NET, "client: received steadystate ring buffers\n");
@@ -2209,6 +2316,10 @@ int fio_handle_clients(struct client_ops const *ops)
 	fio_client_json_fini();
 
 	free_clat_prio_stats(&client_ts);
+	free_lat_outliers(&client_ts);
+	free_lat_heatmap(&client_ts);
+	free_file_stats(&client_ts);
+	free_clat_depth(&client_ts);
 	free(pfds);
 	return retval || error_clients;
 }
@@ -0,0 +1,316 @@
+/*
+ * Content pool for writes
+ *
+ * With buffer_pool_size or buffer_pool_file set, write content is built
+ * once when the job starts instead of per I/O. Writes then point at a block
+ * aligned range of the pool, so filling a write buffer costs nothing.
+ *
+ * A generated pool is made of chunks of the minimum write block size. Each
+ * chunk starts out random, and then has runs copied from earlier in the
+ * chunk until buffer_compress_percentage of its bytes are copies. That is
+ * the kind of redundancy LZ style compressors find in real data, rather than
+ * a random head and a zero filled tail.
+ *
+ * The pool starts iomem_align bytes into its mapping, so write buffers
+ * taken from it are aligned the way the regular io_u buffers are.
+ *
+ * Dedupe is decided per write, like for regular buffers: dedupe_percentage
+ * of the writes repeat the range of the previous write, or with
+ * dedupe_mode=working_set take a range from the first
+ * dedupe_working_set_percentage of the pool, which other writes avoid.
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef CONFIG_ZLIB
+#include <zlib.h>
+#endif
+
+#include "fio.h"
+#include "content-pool.h"
+
+#define CP_RUN_MIN	16
+#define CP_RUN_MAX	256
+#define CP_WINDOW	32768
+
+/*
+ * Copy runs from earlier in the chunk while less than @perc percent of it
+ * has been copied
+ */
+static void content_pool_fill_chunk(struct thread_data *td, uint8_t *p,
+				    unsigned long long len, unsigned int perc)
+{
+	unsigned long long pos = 0, copied = 0;
+
+	fill_random_buf(&td->buf_state, p, len);
+	if (!perc)
+		return;
+
+	while (pos < len) {
+		unsigned long long run, src, lo;
+
+		run = rand_between(&td->buf_state, CP_RUN_MIN, CP_RUN_MAX);
+		if (run > len - pos)
+			run = len - pos;
+
+		if (pos >= run && copied * 100 < pos * perc) {
+			lo = pos > CP_WINDOW ? pos - CP_WINDOW : 0;
+			src = rand_between(&td->buf_state, lo, pos - run);
+			memcpy(p + pos, p + src, run);
+			copied += run;
+		}
+		pos += run;
+	}
+}
+
+#ifdef CONFIG_ZLIB
+/*
+ * Compress ratio of up to 8MiB of the pool, for the debug log
+ */
+static double content_pool_ratio(struct content_pool *cp)
+{
+	unsigned long long len = min((unsigned long long) cp->size, 8ULL << 20);
+	uLongf out_len = compressBound(len);
+	double ratio = 0.0;
+	void *out;
+
+	out = malloc(out_len);
+	if (!out)
+		return 0.0;
+	if (compress2(out, &out_len, cp->buf, len, Z_BEST_SPEED) == Z_OK)
+		ratio = (double) len / out_len;
+
+	free(out);
+	return ratio;
+}
+#else
+static double content_pool_ratio(struct content_pool *cp)
+{
+	return 0.0;
+}
+#endif
+
+/*
+ * Anonymous mapping for @cp->size bytes of content
+ */
+static int content_pool_alloc(struct thread_data *td, struct content_pool *cp)
+{
+	cp->map_size = cp->size + td->o.mem_align;
+	cp->map = mmap(NULL, cp->map_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (cp->map == MAP_FAILED) {
+		td_verror(td, errno, "mmap content pool");
+		cp->map = NULL;
+		return 1;
+	}
+
+	cp->buf = cp->map + td->o.mem_align;
+	return 0;
+}
+
+/*
+ * A file mapping starts on a page, so with iomem_align the file is read
+ * into an anonymous mapping instead
+ */
+static int content_pool_read_file(struct thread_data *td,
+				  struct content_pool *cp, int fd)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	if (content_pool_alloc(td, cp))
+		return 1;
+
+	while (done < cp->size) {
+		ret = pread(fd, cp->buf + done, cp->size - done, done);
+		if (ret <= 0) {
+			td_verror(td, ret < 0 ? errno : EIO,
+				  "read buffer_pool_file");
+			return 1;
+		}
+		done += ret;
+	}
+
+	return 0;
+}
+
+static int content_pool_generate(struct thread_data *td,
+				 struct content_pool *cp)
+{
+	struct thread_options *o = &td->o;
+	uint64_t i;
+
+	cp->nr_chunks = o->buffer_pool_size / cp->chunk;
+	cp->size = cp->nr_chunks * cp->chunk;
+	if (!cp->size)
+		return 0;
+
+	if (content_pool_alloc(td, cp))
+		return 1;
+
+	for (i = 0; i < cp->nr_chunks; i++)
+		content_pool_fill_chunk(td, cp->buf + i * cp->chunk, cp->chunk,
+					o->compress_percentage);
+
+	dprint(FD_MEM, "content pool: %llu chunks of %llu bytes, compress ratio %.2f\n",
+		(unsigned long long) cp->nr_chunks, cp->chunk,
+		content_pool_ratio(cp));
+	return 0;
+}
+
+static int content_pool_map_file(struct thread_data *td,
+				 struct content_pool *cp)
+{
+	struct thread_options *o = &td->o;
+	struct stat sb;
+	int fd;
+
+	fd = open(o->buffer_pool_file, O_RDONLY);
+	if (fd < 0) {
+		td_verror(td, errno, "open buffer_pool_file");
+		return 1;
+	}
+	if (fstat(fd, &sb) < 0) {
+		td_verror(td, errno, "fstat buffer_pool_file");
+		close(fd);
+		return 1;
+	}
+
+	cp->size = sb.st_size;
+	if (o->buffer_pool_size && o->buffer_pool_size < cp->size)
+		cp->size = o->buffer_pool_size;
+	cp->nr_chunks = cp->size / cp->chunk;
+	cp->size = cp->nr_chunks * cp->chunk;
+	if (!cp->size) {
+		log_err("fio: buffer_pool_file %s is smaller than the block size\n",
+			o->buffer_pool_file);
+		close(fd);
+		return 1;
+	}
+
+	if (o->mem_align) {
+		int ret = content_pool_read_file(td, cp, fd);
+
+		close(fd);
+		if (ret)
+			return 1;
+	} else {
+		cp->map_size = cp->size;
+		cp->map = mmap(NULL, cp->map_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (cp->map == MAP_FAILED) {
+			td_verror(td, errno, "mmap buffer_pool_file");
+			cp->map = NULL;
+			return 1;
+		}
+		cp->buf = cp->map;
+		cp->file_backed = true;
+	}
+
+	dprint(FD_MEM, "content pool: %llu chunks of %llu bytes from %s, compress ratio %.2f\n",
+		(unsigned long long) cp->nr_chunks, cp->chunk,
+		o->buffer_pool_file, content_pool_ratio(cp));
+	return 0;
+}
+
+int content_pool_init(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	struct content_pool *cp;
+	int ret;
+
+	if ((!o->buffer_pool_size && !o->buffer_pool_file) || !td_write(td))
+		return 0;
+
+	cp = calloc(1, sizeof(*cp));
+	if (!cp) {
+		td_verror(td, ENOMEM, "content pool");
+		return 1;
+	}
+
+	cp->chunk = o->min_bs[DDIR_WRITE];
+	if (o->buffer_pool_file)
+		ret = content_pool_map_file(td, cp);
+	else
+		ret = content_pool_generate(td, cp);
+
+	if (!ret && cp->size < o->max_bs[DDIR_WRITE]) {
+		log_err("fio: content pool of %llu bytes is smaller than the "
+			"largest write, %llu bytes\n",
+			(unsigned long long) cp->size, o->max_bs[DDIR_WRITE]);
+		ret = 1;
+	}
+
+	if (!ret && o->dedupe_percentage &&
+	    o->dedupe_mode == DEDUPE_MODE_WORKING_SET) {
+		cp->ws_chunks = cp->nr_chunks *
+				o->dedupe_working_set_percentage / 100;
+		if (cp->ws_chunks * cp->chunk < o->max_bs[DDIR_WRITE] ||
+		    (cp->nr_chunks - cp->ws_chunks) * cp->chunk <
+		     o->max_bs[DDIR_WRITE]) {
+			log_err("fio: dedupe working set must leave room for "
+				"the largest write in the content pool\n");
+			ret = 1;
+		}
+	}
+
+	td->content_pool = cp;
+	if (ret)
+		content_pool_exit(td);
+	return ret;
+}
+
+void content_pool_exit(struct thread_data *td)
+{
+	struct content_pool *cp = td->content_pool;
+
+	if (!cp)
+		return;
+
+	if (cp->map)
+		munmap(cp->map, cp->map_size);
+	free(cp);
+	td->content_pool = NULL;
+}
+
+static uint64_t content_pool_pick(struct thread_data *td, uint64_t lo,
+				  uint64_t hi, uint64_t span)
+{
+	if (lo + span >= hi)
+		return lo;
+
+	return rand_between(&td->buf_state, lo, hi - span);
+}
+
+/*
+ * Where a write of @len bytes should take its data from. Starts are chunk
+ * aligned, so repeated ranges land on block boundaries.
+ */
+void *content_pool_get(struct thread_data *td, unsigned long long len)
+{
+	struct content_pool *cp = td->content_pool;
+	struct thread_options *o = &td->o;
+	uint64_t span = (len + cp->chunk - 1) / cp->chunk;
+	uint64_t start;
+
+	if (o->dedupe_percentage)
+		td->ts.dedupe_bufs++;
+
+	if (o->dedupe_percentage && cp->have_last &&
+	    rand_between(&td->dedupe_state, 1, 100) <= o->dedupe_percentage) {
+		td->ts.dedupe_dup_bufs++;
+		if (cp->ws_chunks)
+			start = content_pool_pick(td, 0, cp->ws_chunks, span);
+		else if (cp->last_start + span <= cp->nr_chunks)
+			start = cp->last_start;
+		else
+			start = cp->nr_chunks - span;
+	} else
+		start = content_pool_pick(td, cp->ws_chunks, cp->nr_chunks,
+					  span);
+
+	cp->last_start = start;
+	cp->have_last = true;
+	return cp->buf + start * cp->chunk;
+}
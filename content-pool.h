@@ -0,0 +1,38 @@
+#ifndef FIO_CONTENT_POOL_H
+#define FIO_CONTENT_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct thread_data;
+
+/*
+ * Write content built once at job start, from generated chunks or from a
+ * sample file. Writes point into the pool instead of filling their own
+ * buffer.
+ */
+struct content_pool {
+	void *map;
+	size_t map_size;
+	void *buf;			/* iomem_align bytes into the mapping */
+	size_t size;			/* bytes of content */
+	unsigned long long chunk;	/* start alignment and unit of dedupe */
+	uint64_t nr_chunks;
+	uint64_t ws_chunks;		/* dedupe working set, at the start */
+	uint64_t last_start;		/* chunk the previous write started at */
+	bool have_last;
+	bool file_backed;
+};
+
+extern int content_pool_init(struct thread_data *);
+extern void content_pool_exit(struct thread_data *);
+extern void *content_pool_get(struct thread_data *, unsigned long long);
+
+static inline bool content_pool_contains(struct content_pool *cp,
+					 const void *buf)
+{
+	return cp && buf >= cp->buf && buf < cp->buf + cp->size;
+}
+
+#endif
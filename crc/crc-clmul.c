@@ -0,0 +1,300 @@
+#include "crc-clmul.h"
+#include "../arch/arch.h"
+#include "../compiler/compiler.h"
+#include "../os/os.h"
+
+/*
+ * Folding with carry-less multiplication, as described in "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Gopal
+ * et al, Intel, 2009).
+ *
+ * The buffer is read as 128-bit blocks. A block is moved D bits further
+ * along the message by multiplying it with x^D modulo the CRC polynomial,
+ * and added to the block that is there. Each 64-bit half is multiplied on
+ * its own, so the products fit in 128 bits. Four blocks are folded in
+ * parallel by 512 bits, then into one, then one block at a time. The block
+ * that is left leaves the same remainder as the data folded into it, so the
+ * caller finishes it and the tail of the buffer with its table. Leaving out
+ * the final Barrett reduction means one kernel serves every polynomial up to
+ * 64 bits, reflected or not.
+ */
+
+struct crc_clmul_consts {
+	uint64_t fold4[2];	/* x^D multipliers for the low and high half */
+	uint64_t fold1[2];
+	unsigned int width;
+	bool reflected;
+};
+
+static const struct {
+	uint64_t poly;		/* normal form, without the x^width term */
+	unsigned int width;
+	bool reflected;
+} crc_clmul_polys[CRC_CLMUL_NR] = {
+	[CRC_CLMUL_CRC64]	= { 0xad93d23594c935a9ULL, 64, true },
+	[CRC_CLMUL_CRC64_NVME]	= { 0xad93d23594c93659ULL, 64, true },
+	[CRC_CLMUL_CRC16]	= { 0x8005, 16, true },
+	[CRC_CLMUL_T10DIF]	= { 0x8bb7, 16, false },
+	[CRC_CLMUL_CRC7]	= { 0x09, 7, false },
+};
+
+static struct crc_clmul_consts crc_clmul_consts[CRC_CLMUL_NR];
+
+bool crc_clmul_available = false;
+
+/*
+ * x^n modulo the polynomial
+ */
+static uint64_t xpow_mod(unsigned int n, uint64_t poly, unsigned int width)
+{
+	const uint64_t top = 1ULL << (width - 1);
+	uint64_t r = 1;
+
+	while (n--) {
+		bool carry = (r & top) != 0;
+
+		r <<= 1;
+		if (width < 64)
+			r &= (1ULL << width) - 1;
+		if (carry)
+			r ^= poly;
+	}
+
+	return r;
+}
+
+static uint64_t bitrev64(uint64_t v)
+{
+	uint64_t r = 0;
+	int i;
+
+	for (i = 0; i < 64; i++, v >>= 1)
+		r = (r << 1) | (v & 1);
+
+	return r;
+}
+
+static void crc_clmul_init_consts(struct crc_clmul_consts *c, uint64_t poly,
+				  unsigned int width, bool reflected)
+{
+	c->width = width;
+	c->reflected = reflected;
+
+	if (reflected) {
+		/*
+		 * The low half holds the higher powers. The product of two
+		 * bit reflected values comes out one bit short, so multiply
+		 * by one power less.
+		 */
+		c->fold4[0] = bitrev64(xpow_mod(512 + 64 - 1, poly, width));
+		c->fold4[1] = bitrev64(xpow_mod(512 - 1, poly, width));
+		c->fold1[0] = bitrev64(xpow_mod(128 + 64 - 1, poly, width));
+		c->fold1[1] = bitrev64(xpow_mod(128 - 1, poly, width));
+	} else {
+		c->fold4[0] = xpow_mod(512, poly, width);
+		c->fold4[1] = xpow_mod(512 + 64, poly, width);
+		c->fold1[0] = xpow_mod(128, poly, width);
+		c->fold1[1] = xpow_mod(128 + 64, poly, width);
+	}
+}
+
+#if defined(ARCH_HAVE_PCLMUL)
+
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+
+#define CLMUL_TARGET	__attribute__((target("pclmul,ssse3")))
+
+static inline CLMUL_TARGET __m128i clmul_load(const unsigned char *p,
+					     bool swap, __m128i bswap)
+{
+	__m128i x = _mm_loadu_si128((const __m128i *) p);
+
+	if (swap)
+		x = _mm_shuffle_epi8(x, bswap);
+
+	return x;
+}
+
+static inline CLMUL_TARGET __m128i clmul_fold(__m128i x, __m128i k,
+					     __m128i next)
+{
+	__m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+	__m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+
+	return _mm_xor_si128(next, _mm_xor_si128(lo, hi));
+}
+
+static CLMUL_TARGET unsigned long
+crc_clmul_fold_arch(const struct crc_clmul_consts *c, const unsigned char *buf,
+		    unsigned long len, uint64_t crc, unsigned char *out)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+					   8, 9, 10, 11, 12, 13, 14, 15);
+	const bool swap = !c->reflected;
+	__m128i x0, x1, x2, x3, k;
+	unsigned long done;
+
+	x0 = clmul_load(buf, swap, bswap);
+	x1 = clmul_load(buf + 16, swap, bswap);
+	x2 = clmul_load(buf + 32, swap, bswap);
+	x3 = clmul_load(buf + 48, swap, bswap);
+	if (c->reflected)
+		x0 = _mm_xor_si128(x0, _mm_set_epi64x(0, crc));
+	else
+		x0 = _mm_xor_si128(x0, _mm_set_epi64x(crc << (64 - c->width), 0));
+
+	k = _mm_set_epi64x(c->fold4[1], c->fold4[0]);
+	for (done = 64; len - done >= 64; done += 64) {
+		x0 = clmul_fold(x0, k, clmul_load(buf + done, swap, bswap));
+		x1 = clmul_fold(x1, k, clmul_load(buf + done + 16, swap, bswap));
+		x2 = clmul_fold(x2, k, clmul_load(buf + done + 32, swap, bswap));
+		x3 = clmul_fold(x3, k, clmul_load(buf + done + 48, swap, bswap));
+	}
+
+	k = _mm_set_epi64x(c->fold1[1], c->fold1[0]);
+	x1 = clmul_fold(x0, k, x1);
+	x2 = clmul_fold(x1, k, x2);
+	x3 = clmul_fold(x2, k, x3);
+	for (; len - done >= 16; done += 16)
+		x3 = clmul_fold(x3, k, clmul_load(buf + done, swap, bswap));
+
+	if (swap)
+		x3 = _mm_shuffle_epi8(x3, bswap);
+	_mm_storeu_si128((__m128i *) out, x3);
+	return done;
+}
+
+static bool crc_clmul_probe(void)
+{
+	unsigned int eax, ebx, ecx = 0, edx;
+
+	eax = 1;
+	do_cpuid(&eax, &ebx, &ecx, &edx);
+
+	/* PCLMULQDQ and SSSE3 */
+	return (ecx & (1 << 1)) && (ecx & (1 << 9));
+}
+
+#elif defined(ARCH_HAVE_CRC_CRYPTO)
+
+#include <arm_neon.h>
+
+static inline uint64x2_t clmul_load(const unsigned char *p, bool swap)
+{
+	uint8x16_t x = vld1q_u8(p);
+
+	if (swap) {
+		x = vrev64q_u8(x);
+		x = vextq_u8(x, x, 8);
+	}
+
+	return vreinterpretq_u64_u8(x);
+}
+
+static inline uint64x2_t clmul_fold(uint64x2_t x, poly64x2_t k,
+				    uint64x2_t next)
+{
+	poly64x2_t p = vreinterpretq_p64_u64(x);
+	uint64x2_t lo, hi;
+
+	lo = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_p64(p, 0),
+					      vgetq_lane_p64(k, 0)));
+	hi = vreinterpretq_u64_p128(vmull_high_p64(p, k));
+
+	return veorq_u64(next, veorq_u64(lo, hi));
+}
+
+static unsigned long crc_clmul_fold_arch(const struct crc_clmul_consts *c,
+					 const unsigned char *buf,
+					 unsigned long len, uint64_t crc,
+					 unsigned char *out)
+{
+	const bool swap = !c->reflected;
+	uint64x2_t x0, x1, x2, x3;
+	poly64x2_t k;
+	unsigned long done;
+
+	x0 = clmul_load(buf, swap);
+	x1 = clmul_load(buf + 16, swap);
+	x2 = clmul_load(buf + 32, swap);
+	x3 = clmul_load(buf + 48, swap);
+	if (c->reflected)
+		x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(crc),
+						vcreate_u64(0)));
+	else
+		x0 = veorq_u64(x0, vcombine_u64(vcreate_u64(0),
+				vcreate_u64(crc << (64 - c->width))));
+
+	k = vreinterpretq_p64_u64(vld1q_u64(c->fold4));
+	for (done = 64; len - done >= 64; done += 64) {
+		x0 = clmul_fold(x0, k, clmul_load(buf + done, swap));
+		x1 = clmul_fold(x1, k, clmul_load(buf + done + 16, swap));
+		x2 = clmul_fold(x2, k, clmul_load(buf + done + 32, swap));
+		x3 = clmul_fold(x3, k, clmul_load(buf + done + 48, swap));
+	}
+
+	k = vreinterpretq_p64_u64(vld1q_u64(c->fold1));
+	x1 = clmul_fold(x0, k, x1);
+	x2 = clmul_fold(x1, k, x2);
+	x3 = clmul_fold(x2, k, x3);
+	for (; len - done >= 16; done += 16)
+		x3 = clmul_fold(x3, k, clmul_load(buf + done, swap));
+
+	if (swap) {
+		uint8x16_t b = vreinterpretq_u8_u64(x3);
+
+		b = vrev64q_u8(b);
+		x3 = vreinterpretq_u64_u8(vextq_u8(b, b, 8));
+	}
+	vst1q_u8(out, vreinterpretq_u8_u64(x3));
+	return done;
+}
+
+static bool crc_clmul_probe(void)
+{
+	return os_cpu_has(CPU_ARM64_PMULL);
+}
+
+#else
+
+static unsigned long crc_clmul_fold_arch(const struct crc_clmul_consts *c,
+					 const unsigned char *buf,
+					 unsigned long len, uint64_t crc,
+					 unsigned char *out)
+{
+	return 0;
+}
+
+static bool crc_clmul_probe(void)
+{
+	return false;
+}
+
+#endif
+
+/*
+ * Fold at least CRC_CLMUL_MIN_LEN bytes of @buf, starting from the CRC
+ * register value @crc. Returns how many bytes were consumed. The CRC of the
+ * 16 bytes stored in @out, from a zero register, is the register value
+ * after those bytes.
+ */
+unsigned long crc_clmul_fold(unsigned int type, const unsigned char *buf,
+			     unsigned long len, uint64_t crc,
+			     unsigned char *out)
+{
+	return crc_clmul_fold_arch(&crc_clmul_consts[type], buf, len, crc, out);
+}
+
+static void fio_init crc_clmul_init(void)
+{
+	int i;
+
+	for (i = 0; i < CRC_CLMUL_NR; i++)
+		crc_clmul_init_consts(&crc_clmul_consts[i],
+				      crc_clmul_polys[i].poly,
+				      crc_clmul_polys[i].width,
+				      crc_clmul_polys[i].reflected);
+
+	crc_clmul_available = crc_clmul_probe();
+}
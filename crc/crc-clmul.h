@@ -0,0 +1,34 @@
+#ifndef CRC_CLMUL_H
+#define CRC_CLMUL_H
+
+#include <inttypes.h>
+
+#include "../lib/types.h"
+
+/*
+ * CRCs that can be folded with carry-less multiplication (PCLMULQDQ on x86,
+ * PMULL on arm64)
+ */
+enum {
+	CRC_CLMUL_CRC64,
+	CRC_CLMUL_CRC64_NVME,
+	CRC_CLMUL_CRC16,
+	CRC_CLMUL_T10DIF,
+	CRC_CLMUL_CRC7,
+
+	CRC_CLMUL_NR,
+};
+
+/*
+ * Buffers shorter than this are left to the tables
+ */
+#define CRC_CLMUL_MIN_LEN	64
+
+extern bool crc_clmul_available;
+
+extern unsigned long crc_clmul_fold(unsigned int type,
+				    const unsigned char *buf,
+				    unsigned long len, uint64_t crc,
+				    unsigned char *out);
+
+#endif
@@ -6,6 +6,7 @@
  */
 
 #include "crc16.h"
+#include "crc-clmul.h"
 
 /** CRC table for the CRC-16. The poly is 0x8005 (x^16 + x^15 + x^2 + 1) */
 unsigned short const crc16_table[256] = {
@@ -43,12 +44,28 @@ unsigned short const crc16_table[256] = {
 	0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
 };
 
+static unsigned short crc16_sw(unsigned short crc, const unsigned char *cp,
+			       unsigned int len)
+{
+	while (len--)
+		crc = crc16_byte(crc, *cp++);
+	return crc;
+}
+
 unsigned short fio_crc16(const void *buffer, unsigned int len)
 {
 	const unsigned char *cp = (const unsigned char *) buffer;
 	unsigned short crc = 0;
 
-	while (len--)
-		crc = crc16_byte(crc, *cp++);
-	return crc;
+	if (crc_clmul_available && len >= CRC_CLMUL_MIN_LEN) {
+		unsigned char folded[16];
+		unsigned long done;
+
+		done = crc_clmul_fold(CRC_CLMUL_CRC16, cp, len, crc, folded);
+		crc = crc16_sw(0, folded, sizeof(folded));
+		cp += done;
+		len -= done;
+	}
+
+	return crc16_sw(crc, cp, len);
 }
@@ -11,6 +11,7 @@
 
 #include "crc64.h"
 #include "crc64table.h"
+#include "crc-clmul.h"
 
 /*
  * poly 0x95AC9329AC4BC9B5ULL and init 0xFFFFFFFFFFFFFFFFULL
@@ -104,16 +105,34 @@ static const unsigned long long crctab64[256] = {
   0x29b7d047efec8728ULL
 };
 
-unsigned long long fio_crc64(const unsigned char *buffer, unsigned long length)
+static unsigned long long crc64_sw(unsigned long long crc,
+				   const unsigned char *buffer,
+				   unsigned long length)
 {
-	unsigned long long crc = 0;
-
 	while (length--)
 		crc = crctab64[(crc ^ *(buffer++)) & 0xff] ^ (crc >> 8);
 
 	return crc;
 }
 
+unsigned long long fio_crc64(const unsigned char *buffer, unsigned long length)
+{
+	unsigned long long crc = 0;
+
+	if (crc_clmul_available && length >= CRC_CLMUL_MIN_LEN) {
+		unsigned char folded[16];
+		unsigned long done;
+
+		done = crc_clmul_fold(CRC_CLMUL_CRC64, buffer, length, crc,
+				      folded);
+		crc = crc64_sw(0, folded, sizeof(folded));
+		buffer += done;
+		length -= done;
+	}
+
+	return crc64_sw(crc, buffer, length);
+}
+
 /**
  * fio_crc64_nvme - Calculate bitwise NVMe CRC64
  * @crc: seed value for computation. 0 for a new CRC calculation, or the
@@ -129,6 +148,19 @@ unsigned long long fio_crc64_nvme(unsigned long long crc, const void *p,
 
 	crc = ~crc;
 
+	if (crc_clmul_available && len >= CRC_CLMUL_MIN_LEN) {
+		unsigned char folded[16];
+		unsigned long done;
+
+		done = crc_clmul_fold(CRC_CLMUL_CRC64_NVME, _p, len, crc,
+				      folded);
+		crc = 0;
+		for (i = 0; i < sizeof(folded); i++)
+			crc = (crc >> 8) ^ crc64nvmetable[(crc & 0xff) ^ folded[i]];
+		_p += done;
+		len -= done;
+	}
+
 	for (i = 0; i < len; i++)
 		crc = (crc >> 8) ^ crc64nvmetable[(crc & 0xff) ^ *_p++];
 
@@ -6,6 +6,7 @@
  */
 
 #include "crc7.h"
+#include "crc-clmul.h"
 
 /* Table for CRC-7 (polynomial x^7 + x^3 + 1) */
 const unsigned char crc7_syndrome_table[256] = {
@@ -43,11 +44,27 @@ const unsigned char crc7_syndrome_table[256] = {
 	0x46, 0x4f, 0x54, 0x5d, 0x62, 0x6b, 0x70, 0x79
 };
 
-unsigned char fio_crc7(const unsigned char *buffer, unsigned int len)
+static unsigned char crc7_sw(unsigned char crc, const unsigned char *buffer,
+			     unsigned int len)
 {
-	unsigned char crc = 0;
-
 	while (len--)
 		crc = crc7_byte(crc, *buffer++);
 	return crc;
 }
+
+unsigned char fio_crc7(const unsigned char *buffer, unsigned int len)
+{
+	unsigned char crc = 0;
+
+	if (crc_clmul_available && len >= CRC_CLMUL_MIN_LEN) {
+		unsigned char folded[16];
+		unsigned long done;
+
+		done = crc_clmul_fold(CRC_CLMUL_CRC7, buffer, len, crc, folded);
+		crc = crc7_sw(0, folded, sizeof(folded));
+		buffer += done;
+		len -= done;
+	}
+
+	return crc7_sw(crc, buffer, len);
+}
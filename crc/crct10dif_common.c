@@ -36,6 +36,7 @@ extern unsigned short fio_crc_t10dif(unsigned short crc,
 
 #else
 #include "crc-t10dif.h"
+#include "crc-clmul.h"
 
 /* Table generated using the following polynomium:
  * x^16 + x^15 + x^11 + x^9 + x^8 + x^7 + x^5 + x^4 + x^2 + x + 1
@@ -76,9 +77,9 @@ static const unsigned short t10_dif_crc_table[256] = {
 	0xF0D8, 0x7B6F, 0x6C01, 0xE7B6, 0x42DD, 0xC96A, 0xDE04, 0x55B3
 };
 
-extern unsigned short fio_crc_t10dif(unsigned short crc,
-				     const unsigned char *buffer,
-				     unsigned int len)
+static unsigned short crc_t10dif_sw(unsigned short crc,
+				    const unsigned char *buffer,
+				    unsigned int len)
 {
 	unsigned int i;
 
@@ -88,4 +89,22 @@ extern unsigned short fio_crc_t10dif(unsigned short crc,
 	return crc;
 }
 
+extern unsigned short fio_crc_t10dif(unsigned short crc,
+				     const unsigned char *buffer,
+				     unsigned int len)
+{
+	if (crc_clmul_available && len >= CRC_CLMUL_MIN_LEN) {
+		unsigned char folded[16];
+		unsigned long done;
+
+		done = crc_clmul_fold(CRC_CLMUL_T10DIF, buffer, len, crc,
+				      folded);
+		crc = crc_t10dif_sw(0, folded, sizeof(folded));
+		buffer += done;
+		len -= done;
+	}
+
+	return crc_t10dif_sw(crc, buffer, len);
+}
+
 #endif
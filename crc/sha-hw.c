@@ -0,0 +1,455 @@
+#include "sha-hw.h"
+#include "../arch/arch.h"
+#include "../compiler/compiler.h"
+#include "../os/os.h"
+
+/*
+ * SHA-1 and SHA-256 block functions using the SHA extensions of x86 (SHA-NI)
+ * and arm64 (ARMv8 crypto extensions). The callers in sha1.c and sha256.c
+ * keep doing the buffering and padding, only whole blocks come here.
+ */
+
+bool sha1_hw_available = false;
+bool sha256_hw_available = false;
+const char *sha_hw_name = NULL;
+
+#if defined(ARCH_HAVE_SHA_NI) || defined(ARCH_HAVE_CRC_CRYPTO)
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+#endif
+
+#if defined(ARCH_HAVE_SHA_NI)
+
+#include <immintrin.h>
+
+#define SHA_NI_TARGET	__attribute__((target("sha,sse4.1,ssse3")))
+
+/*
+ * Four rounds. The state is kept as ABEF and CDGH, the way the
+ * sha256rnds2 instruction wants it.
+ */
+static inline SHA_NI_TARGET void sha256_ni_rounds(__m128i *state0,
+						  __m128i *state1, __m128i msg,
+						  const uint32_t *k)
+{
+	msg = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *) k));
+	*state1 = _mm_sha256rnds2_epu32(*state1, *state0, msg);
+	msg = _mm_shuffle_epi32(msg, 0x0e);
+	*state0 = _mm_sha256rnds2_epu32(*state0, *state1, msg);
+}
+
+static inline SHA_NI_TARGET __m128i sha256_ni_sched(__m128i next,
+						    __m128i cur, __m128i prev)
+{
+	next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));
+	return _mm_sha256msg2_epu32(next, cur);
+}
+
+static SHA_NI_TARGET void sha256_ni_blocks(uint32_t *state,
+					   const uint8_t *data,
+					   unsigned long nblocks)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					     0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, tmp;
+	__m128i m0, m1, m2, m3;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	while (nblocks--) {
+		abef = state0;
+		cdgh = state1;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), bswap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), bswap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), bswap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), bswap);
+
+		sha256_ni_rounds(&state0, &state1, m0, &sha256_k[0]);
+		sha256_ni_rounds(&state0, &state1, m1, &sha256_k[4]);
+		m0 = _mm_sha256msg1_epu32(m0, m1);
+		sha256_ni_rounds(&state0, &state1, m2, &sha256_k[8]);
+		m1 = _mm_sha256msg1_epu32(m1, m2);
+		sha256_ni_rounds(&state0, &state1, m3, &sha256_k[12]);
+		m0 = sha256_ni_sched(m0, m3, m2);
+		m2 = _mm_sha256msg1_epu32(m2, m3);
+		sha256_ni_rounds(&state0, &state1, m0, &sha256_k[16]);
+		m1 = sha256_ni_sched(m1, m0, m3);
+		m3 = _mm_sha256msg1_epu32(m3, m0);
+		sha256_ni_rounds(&state0, &state1, m1, &sha256_k[20]);
+		m2 = sha256_ni_sched(m2, m1, m0);
+		m0 = _mm_sha256msg1_epu32(m0, m1);
+		sha256_ni_rounds(&state0, &state1, m2, &sha256_k[24]);
+		m3 = sha256_ni_sched(m3, m2, m1);
+		m1 = _mm_sha256msg1_epu32(m1, m2);
+		sha256_ni_rounds(&state0, &state1, m3, &sha256_k[28]);
+		m0 = sha256_ni_sched(m0, m3, m2);
+		m2 = _mm_sha256msg1_epu32(m2, m3);
+		sha256_ni_rounds(&state0, &state1, m0, &sha256_k[32]);
+		m1 = sha256_ni_sched(m1, m0, m3);
+		m3 = _mm_sha256msg1_epu32(m3, m0);
+		sha256_ni_rounds(&state0, &state1, m1, &sha256_k[36]);
+		m2 = sha256_ni_sched(m2, m1, m0);
+		m0 = _mm_sha256msg1_epu32(m0, m1);
+		sha256_ni_rounds(&state0, &state1, m2, &sha256_k[40]);
+		m3 = sha256_ni_sched(m3, m2, m1);
+		m1 = _mm_sha256msg1_epu32(m1, m2);
+		sha256_ni_rounds(&state0, &state1, m3, &sha256_k[44]);
+		m0 = sha256_ni_sched(m0, m3, m2);
+		m2 = _mm_sha256msg1_epu32(m2, m3);
+		sha256_ni_rounds(&state0, &state1, m0, &sha256_k[48]);
+		m1 = sha256_ni_sched(m1, m0, m3);
+		m3 = _mm_sha256msg1_epu32(m3, m0);
+		sha256_ni_rounds(&state0, &state1, m1, &sha256_k[52]);
+		m2 = sha256_ni_sched(m2, m1, m0);
+		sha256_ni_rounds(&state0, &state1, m2, &sha256_k[56]);
+		m3 = sha256_ni_sched(m3, m2, m1);
+		sha256_ni_rounds(&state0, &state1, m3, &sha256_k[60]);
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+		data += 64;
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *) &state[0], state0);
+	_mm_storeu_si128((__m128i *) &state[4], state1);
+}
+
+static SHA_NI_TARGET void sha1_ni_blocks(uint32_t *H, const uint8_t *data,
+					 unsigned long nblocks)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL,
+					     0x08090a0b0c0d0e0fULL);
+	__m128i abcd, abcd_save, e0, e0_save, e1;
+	__m128i m0, m1, m2, m3;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) H), 0x1b);
+	e0 = _mm_set_epi32(H[4], 0, 0, 0);
+
+	while (nblocks--) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), bswap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), bswap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), bswap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), bswap);
+
+		e0 = _mm_add_epi32(e0, m0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		m0 = _mm_sha1msg2_epu32(m0, m3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		m2 = _mm_sha1msg1_epu32(m2, m3);
+		m1 = _mm_xor_si128(m1, m3);
+
+		e0 = _mm_sha1nexte_epu32(e0, m0);
+		e1 = abcd;
+		m1 = _mm_sha1msg2_epu32(m1, m0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		m3 = _mm_sha1msg1_epu32(m3, m0);
+		m2 = _mm_xor_si128(m2, m0);
+
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+		m3 = _mm_xor_si128(m3, m1);
+
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		m0 = _mm_sha1msg2_epu32(m0, m3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		m2 = _mm_sha1msg1_epu32(m2, m3);
+		m1 = _mm_xor_si128(m1, m3);
+
+		e0 = _mm_sha1nexte_epu32(e0, m0);
+		e1 = abcd;
+		m1 = _mm_sha1msg2_epu32(m1, m0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		m3 = _mm_sha1msg1_epu32(m3, m0);
+		m2 = _mm_xor_si128(m2, m0);
+
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+		m3 = _mm_xor_si128(m3, m1);
+
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		m0 = _mm_sha1msg2_epu32(m0, m3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		m2 = _mm_sha1msg1_epu32(m2, m3);
+		m1 = _mm_xor_si128(m1, m3);
+
+		e0 = _mm_sha1nexte_epu32(e0, m0);
+		e1 = abcd;
+		m1 = _mm_sha1msg2_epu32(m1, m0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		m3 = _mm_sha1msg1_epu32(m3, m0);
+		m2 = _mm_xor_si128(m2, m0);
+
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		m0 = _mm_sha1msg1_epu32(m0, m1);
+		m3 = _mm_xor_si128(m3, m1);
+
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		m1 = _mm_sha1msg1_epu32(m1, m2);
+		m0 = _mm_xor_si128(m0, m2);
+
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		m0 = _mm_sha1msg2_epu32(m0, m3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		m2 = _mm_sha1msg1_epu32(m2, m3);
+		m1 = _mm_xor_si128(m1, m3);
+
+		e0 = _mm_sha1nexte_epu32(e0, m0);
+		e1 = abcd;
+		m1 = _mm_sha1msg2_epu32(m1, m0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+		m3 = _mm_sha1msg1_epu32(m3, m0);
+		m2 = _mm_xor_si128(m2, m0);
+
+		e1 = _mm_sha1nexte_epu32(e1, m1);
+		e0 = abcd;
+		m2 = _mm_sha1msg2_epu32(m2, m1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		m3 = _mm_xor_si128(m3, m1);
+
+		e0 = _mm_sha1nexte_epu32(e0, m2);
+		e1 = abcd;
+		m3 = _mm_sha1msg2_epu32(m3, m2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+		e1 = _mm_sha1nexte_epu32(e1, m3);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		data += 64;
+	}
+
+	_mm_storeu_si128((__m128i *) H, _mm_shuffle_epi32(abcd, 0x1b));
+	H[4] = _mm_extract_epi32(e0, 3);
+}
+
+void sha1_hw_blocks(uint32_t *H, const void *data, unsigned long nblocks)
+{
+	sha1_ni_blocks(H, data, nblocks);
+}
+
+void sha256_hw_blocks(uint32_t *state, const uint8_t *data,
+		      unsigned long nblocks)
+{
+	sha256_ni_blocks(state, data, nblocks);
+}
+
+static void sha_hw_probe(void)
+{
+	unsigned int eax, ebx, ecx = 0, edx;
+
+	eax = 0;
+	do_cpuid(&eax, &ebx, &ecx, &edx);
+	if (eax < 7)
+		return;
+
+	/* SSSE3 and SSE4.1 */
+	eax = 1;
+	ecx = 0;
+	do_cpuid(&eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1 << 9)) || !(ecx & (1 << 19)))
+		return;
+
+	/* SHA */
+	eax = 7;
+	ecx = 0;
+	do_cpuid(&eax, &ebx, &ecx, &edx);
+	if (!(ebx & (1 << 29)))
+		return;
+
+	sha1_hw_available = sha256_hw_available = true;
+	sha_hw_name = "sha-ni";
+}
+
+#elif defined(ARCH_HAVE_CRC_CRYPTO)
+
+#include <arm_neon.h>
+
+static const uint32_t sha1_k[4] = {
+	0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6,
+};
+
+static inline uint32x4_t sha_load_be(const uint8_t *p)
+{
+	return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+void sha1_hw_blocks(uint32_t *H, const void *buf, unsigned long nblocks)
+{
+	const uint8_t *data = buf;
+	uint32x4_t abcd, abcd_save, wk, m[4];
+	uint32_t e0, e0_save, e1;
+	int i;
+
+	abcd = vld1q_u32(H);
+	e0 = H[4];
+
+	while (nblocks--) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		for (i = 0; i < 4; i++)
+			m[i] = sha_load_be(data + 16 * i);
+
+		for (i = 0; i < 20; i++) {
+			wk = vaddq_u32(m[i & 3], vdupq_n_u32(sha1_k[i / 5]));
+			if (i < 16)
+				m[i & 3] = vsha1su1q_u32(vsha1su0q_u32(m[i & 3],
+						m[(i + 1) & 3], m[(i + 2) & 3]),
+						m[(i + 3) & 3]);
+
+			e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (i < 5)
+				abcd = vsha1cq_u32(abcd, e0, wk);
+			else if (i < 10 || i >= 15)
+				abcd = vsha1pq_u32(abcd, e0, wk);
+			else
+				abcd = vsha1mq_u32(abcd, e0, wk);
+			e0 = e1;
+		}
+
+		abcd = vaddq_u32(abcd, abcd_save);
+		e0 += e0_save;
+		data += 64;
+	}
+
+	vst1q_u32(H, abcd);
+	H[4] = e0;
+}
+
+void sha256_hw_blocks(uint32_t *state, const uint8_t *data,
+		      unsigned long nblocks)
+{
+	uint32x4_t state0, state1, abcd_save, efgh_save, abcd, wk, m[4];
+	int i;
+
+	state0 = vld1q_u32(&state[0]);
+	state1 = vld1q_u32(&state[4]);
+
+	while (nblocks--) {
+		abcd_save = state0;
+		efgh_save = state1;
+
+		for (i = 0; i < 4; i++)
+			m[i] = sha_load_be(data + 16 * i);
+
+		for (i = 0; i < 16; i++) {
+			wk = vaddq_u32(m[i & 3], vld1q_u32(&sha256_k[4 * i]));
+			if (i < 12)
+				m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3],
+						m[(i + 1) & 3]), m[(i + 2) & 3],
+						m[(i + 3) & 3]);
+
+			abcd = state0;
+			state0 = vsha256hq_u32(state0, state1, wk);
+			state1 = vsha256h2q_u32(state1, abcd, wk);
+		}
+
+		state0 = vaddq_u32(state0, abcd_save);
+		state1 = vaddq_u32(state1, efgh_save);
+		data += 64;
+	}
+
+	vst1q_u32(&state[0], state0);
+	vst1q_u32(&state[4], state1);
+}
+
+static void sha_hw_probe(void)
+{
+	sha1_hw_available = os_cpu_has(CPU_ARM64_SHA1);
+	sha256_hw_available = os_cpu_has(CPU_ARM64_SHA2);
+	if (sha1_hw_available || sha256_hw_available)
+		sha_hw_name = "armv8-ce";
+}
+
+#else
+
+void sha1_hw_blocks(uint32_t *H, const void *data, unsigned long nblocks)
+{
+}
+
+void sha256_hw_blocks(uint32_t *state, const uint8_t *data,
+		      unsigned long nblocks)
+{
+}
+
+static void sha_hw_probe(void)
+{
+}
+
+#endif
+
+static void fio_init sha_hw_init(void)
+{
+	sha_hw_probe();
+}
@@ -0,0 +1,19 @@
+#ifndef FIO_SHA_HW_H
+#define FIO_SHA_HW_H
+
+#include <inttypes.h>
+
+#include "../lib/types.h"
+
+/*
+ * Hardware SHA block functions, used by sha1.c and sha256.c when the CPU
+ * has them. sha_hw_name names the implementation, if any.
+ */
+extern bool sha1_hw_available;
+extern bool sha256_hw_available;
+extern const char *sha_hw_name;
+
+extern void sha1_hw_blocks(uint32_t *, const void *, unsigned long);
+extern void sha256_hw_blocks(uint32_t *, const uint8_t *, unsigned long);
+
+#endif
@@ -20,6 +20,7 @@
 
 #include "../lib/bswap.h"
 #include "sha256.h"
+#include "sha-hw.h"
 
 #define SHA256_DIGEST_SIZE	32
 #define SHA256_HMAC_BLOCK_SIZE	64
@@ -226,6 +227,20 @@ static void sha256_transform(uint32_t *state, const uint8_t *input)
 	memset(W, 0, 64 * sizeof(uint32_t));
 }
 
+static void sha256_blocks(uint32_t *state, const uint8_t *input,
+			  unsigned int nblocks)
+{
+	if (sha256_hw_available) {
+		sha256_hw_blocks(state, input, nblocks);
+		return;
+	}
+
+	while (nblocks--) {
+		sha256_transform(state, input);
+		input += 64;
+	}
+}
+
 void fio_sha256_init(struct fio_sha256_ctx *sctx)
 {
 	sctx->state[0] = H0;
@@ -242,7 +257,7 @@ void fio_sha256_init(struct fio_sha256_ctx *sctx)
 void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 		       unsigned int len)
 {
-	unsigned int partial, done;
+	unsigned int partial, done, nblocks;
 	const uint8_t *src;
 
 	partial = sctx->count & 0x3f;
@@ -254,14 +269,14 @@ void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 		if (partial) {
 			done = -partial;
 			memcpy(sctx->buf + partial, data, done + 64);
-			src = sctx->buf;
+			sha256_blocks(sctx->state, sctx->buf, 1);
+			done += 64;
 		}
 
-		do {
-			sha256_transform(sctx->state, src);
-			done += 64;
-			src = data + done;
-		} while (done + 63 < len);
+		nblocks = (len - done) / 64;
+		sha256_blocks(sctx->state, data + done, nblocks);
+		done += nblocks * 64;
+		src = data + done;
 
 		partial = 0;
 	}
@@ -14,11 +14,15 @@
 #include "../crc/crc32c.h"
 #include "../crc/crc16.h"
 #include "../crc/crc7.h"
+#include "../crc/crc-t10dif.h"
+#include "../crc/crc-clmul.h"
+#include "../crc/sha-hw.h"
 #include "../crc/sha1.h"
 #include "../crc/sha256.h"
 #include "../crc/sha512.h"
 #include "../crc/sha3.h"
 #include "../crc/xxhash.h"
+#include "../crc/xxh3.h"
 #include "../crc/murmur3.h"
 #include "../crc/fnv.h"
 #include "../hash.h"
@@ -53,6 +57,14 @@ enum {
 	T_SHA3_256	= 1U << 14,
 	T_SHA3_384	= 1U << 15,
 	T_SHA3_512	= 1U << 16,
+	T_CRC64_NVME	= 1U << 17,
+	T_CRC_T10DIF	= 1U << 18,
+	T_XXH3		= 1U << 19,
+	T_XXH128	= 1U << 20,
+
+	/* hashes with a carry-less multiply kernel */
+	T_CLMUL		= T_CRC64 | T_CRC16 | T_CRC7 | T_CRC64_NVME |
+			  T_CRC_T10DIF,
 };
 
 static void t_md5(struct test_type *t, void *buf, size_t size)
@@ -77,6 +89,14 @@ static void t_crc64(struct test_type *t, void *buf, size_t size)
 		t->output += fio_crc64(buf, size);
 }
 
+static void t_crc64_nvme(struct test_type *t, void *buf, size_t size)
+{
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		t->output += fio_crc64_nvme(0, buf, size);
+}
+
 static void t_crc32(struct test_type *t, void *buf, size_t size)
 {
 	int i;
@@ -109,6 +129,14 @@ static void t_crc7(struct test_type *t, void *buf, size_t size)
 		t->output += fio_crc7(buf, size);
 }
 
+static void t_crc_t10dif(struct test_type *t, void *buf, size_t size)
+{
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		t->output += fio_crc_t10dif(0, buf, size);
+}
+
 static void t_sha1(struct test_type *t, void *buf, size_t size)
 {
 	uint32_t sha[5];
@@ -242,6 +270,31 @@ static void t_xxhash(struct test_type *t, void *buf, size_t size)
 	t->output = XXH32_digest(state);
 }
 
+static void t_xxh3(struct test_type *t, void *buf, size_t size)
+{
+	uint64_t hash = 0;
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		hash ^= fio_xxh3_64(buf, size);
+
+	t->output = hash;
+}
+
+static void t_xxh128(struct test_type *t, void *buf, size_t size)
+{
+	uint64_t hash[2];
+	uint32_t out = 0;
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++) {
+		fio_xxh3_128(buf, size, hash);
+		out ^= hash[0] ^ hash[1];
+	}
+
+	t->output = out;
+}
+
 static struct test_type t[] = {
 	{
 		.name = "md5",
@@ -253,6 +306,11 @@ static struct test_type t[] = {
 		.mask = T_CRC64,
 		.fn = t_crc64,
 	},
+	{
+		.name = "crc64-nvme",
+		.mask = T_CRC64_NVME,
+		.fn = t_crc64_nvme,
+	},
 	{
 		.name = "crc32",
 		.mask = T_CRC32,
@@ -273,6 +331,11 @@ static struct test_type t[] = {
 		.mask = T_CRC7,
 		.fn = t_crc7,
 	},
+	{
+		.name = "crc-t10dif",
+		.mask = T_CRC_T10DIF,
+		.fn = t_crc_t10dif,
+	},
 	{
 		.name = "sha1",
 		.mask = T_SHA1,
@@ -293,6 +356,16 @@ static struct test_type t[] = {
 		.mask = T_XXHASH,
 		.fn = t_xxhash,
 	},
+	{
+		.name = "xxh3",
+		.mask = T_XXH3,
+		.fn = t_xxh3,
+	},
+	{
+		.name = "xxh128",
+		.mask = T_XXH128,
+		.fn = t_xxh128,
+	},
 	{
 		.name = "murmur3",
 		.mask = T_MURMUR3,
@@ -365,6 +438,176 @@ static int list_types(void)
 	return 1;
 }
 
+/*
+ * The carry-less multiply kernels must agree with the tables for every
+ * length and alignment
+ */
+static int check_clmul(void *buf)
+{
+	unsigned char *p = buf;
+	unsigned int len, off;
+
+	for (len = 0; len <= 1024; len++) {
+		for (off = 0; off < 16; off += 5) {
+			unsigned long long c64[2], n64[2];
+			unsigned short c16[2], t10[2];
+			unsigned char c7[2];
+			int i;
+
+			for (i = 0; i < 2; i++) {
+				crc_clmul_available = !i;
+				c64[i] = fio_crc64(p + off, len);
+				n64[i] = fio_crc64_nvme(0x8989, p + off, len);
+				c16[i] = fio_crc16(p + off, len);
+				t10[i] = fio_crc_t10dif(0x8989, p + off, len);
+				c7[i] = fio_crc7(p + off, len);
+			}
+			crc_clmul_available = true;
+
+			if (c64[0] != c64[1] || n64[0] != n64[1] ||
+			    c16[0] != c16[1] || t10[0] != t10[1] ||
+			    c7[0] != c7[1]) {
+				fprintf(stderr, "fio: carry-less multiply CRC mismatch, len=%u, offset=%u\n", len, off);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Likewise for the SHA extensions and the portable code
+ */
+static int check_sha_hw(void *buf)
+{
+	unsigned char *p = buf;
+	unsigned int len, off;
+
+	for (len = 0; len <= 1024; len++) {
+		for (off = 0; off < 16; off += 5) {
+			uint32_t sha1[2][5];
+			uint8_t sha256_buf[64];
+			uint32_t sha256[2][8];
+			int i;
+
+			for (i = 0; i < 2; i++) {
+				struct fio_sha1_ctx ctx1 = { .H = sha1[i] };
+				struct fio_sha256_ctx ctx256 = { .buf = sha256_buf };
+
+				sha1_hw_available = sha256_hw_available = !i;
+
+				fio_sha1_init(&ctx1);
+				fio_sha1_update(&ctx1, p + off, len);
+				fio_sha1_final(&ctx1);
+
+				fio_sha256_init(&ctx256);
+				fio_sha256_update(&ctx256, p + off, len);
+				fio_sha256_final(&ctx256);
+				memcpy(sha256[i], ctx256.state, sizeof(sha256[i]));
+			}
+			sha1_hw_available = sha256_hw_available = true;
+
+			if (memcmp(sha1[0], sha1[1], sizeof(sha1[0])) ||
+			    memcmp(sha256[0], sha256[1], sizeof(sha256[0]))) {
+				fprintf(stderr, "fio: %s SHA mismatch, len=%u, offset=%u\n", sha_hw_name, len, off);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * XXH3 must give the reference results, and the SIMD loop must agree with
+ * the portable one for every length and alignment. The known answers are
+ * for the xxHash sanity buffer.
+ */
+static const struct {
+	unsigned int len;
+	uint64_t xxh3;
+	uint64_t xxh128[2];
+} xxh3_known[] = {
+	{    0, 0x2d06800538d394c2ULL, { 0x6001c324468d497fULL, 0x99aa06d3014798d8ULL } },
+	{    3, 0x54247382a8d6b94dULL, { 0x54247382a8d6b94dULL, 0x20efc49ff02422eaULL } },
+	{    7, 0x9941e0007f555e50ULL, { 0x081c22dd284a2f0aULL, 0xdd9b6039f79ec416ULL } },
+	{   13, 0x2eb03c6e66ba6524ULL, { 0x4cb46e6932d0bce2ULL, 0x30d4b04dda0e2514ULL } },
+	{  100, 0x93cd95432b7d483fULL, { 0x5fcbc2e3295f2476ULL, 0x9b50b05817ab158eULL } },
+	{  200, 0xbddca58935d7c038ULL, { 0xeb060f1bb3126f5aULL, 0xe76ff4780fe18439ULL } },
+	{ 1000, 0xaca2dde0f1951b9aULL, { 0xaca2dde0f1951b9aULL, 0x9b857abf662e5a25ULL } },
+	{ 2048, 0xdd59e2c3a5f038e0ULL, { 0xdd59e2c3a5f038e0ULL, 0xf736557fd47073a5ULL } },
+};
+
+static int check_xxh3(void)
+{
+	unsigned char p[2048 + 16];
+	uint64_t gen = 2654435761U;
+	unsigned int len, off, i;
+
+	for (len = 0; len < sizeof(p); len++) {
+		p[len] = gen >> 56;
+		gen *= 11400714785074694797ULL;
+	}
+
+	for (i = 0; i < FIO_ARRAY_SIZE(xxh3_known); i++) {
+		uint64_t h128[2];
+
+		fio_xxh3_128(p, xxh3_known[i].len, h128);
+		if (fio_xxh3_64(p, xxh3_known[i].len) != xxh3_known[i].xxh3 ||
+		    memcmp(h128, xxh3_known[i].xxh128, sizeof(h128))) {
+			fprintf(stderr, "fio: xxh3 wrong result, len=%u\n", xxh3_known[i].len);
+			return 1;
+		}
+	}
+
+	if (!xxh3_simd_available)
+		return 0;
+
+	for (len = 0; len <= 2048; len++) {
+		for (off = 0; off < 16; off += 5) {
+			uint64_t h64[2], h128[2][2];
+
+			for (i = 0; i < 2; i++) {
+				xxh3_simd_available = !i;
+				h64[i] = fio_xxh3_64(p + off, len);
+				fio_xxh3_128(p + off, len, h128[i]);
+			}
+			xxh3_simd_available = true;
+
+			if (h64[0] != h64[1] ||
+			    memcmp(h128[0], h128[1], sizeof(h128[0]))) {
+				fprintf(stderr, "fio: %s xxh3 mismatch, len=%u, offset=%u\n", xxh3_simd_name, len, off);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Which implementation a hash ends up using, if not the portable one
+ */
+static const char *test_impl(struct test_type *t)
+{
+	if (t->mask & T_CLMUL)
+		return crc_clmul_available ? "carry-less multiply" : NULL;
+	if (t->mask == T_CRC32C) {
+		if (crc32c_arm64_available)
+			return "arm64";
+		if (crc32c_intel_available)
+			return "sse4.2";
+	}
+	if ((t->mask == T_SHA1 && sha1_hw_available) ||
+	    (t->mask == T_SHA256 && sha256_hw_available))
+		return sha_hw_name;
+	if (t->mask & (T_XXH3 | T_XXH128))
+		return xxh3_simd_name;
+
+	return NULL;
+}
+
 int fio_crctest(const char *type)
 {
 	unsigned int test_mask = 0;
@@ -392,8 +635,31 @@ int fio_crctest(const char *type)
 	init_rand_seed(&state, 0x8989, 0);
 	fill_random_buf(&state, buf, CHUNK);
 
+	if ((test_mask & T_CLMUL) && crc_clmul_available) {
+		if (check_clmul(buf)) {
+			free(buf);
+			return 1;
+		}
+	}
+
+	if ((test_mask & (T_SHA1 | T_SHA256)) && sha1_hw_available &&
+	    sha256_hw_available) {
+		if (check_sha_hw(buf)) {
+			free(buf);
+			return 1;
+		}
+	}
+
+	if (test_mask & (T_XXH3 | T_XXH128)) {
+		if (check_xxh3()) {
+			free(buf);
+			return 1;
+		}
+	}
+
 	for (i = 0; t[i].name; i++) {
 		struct timespec ts;
+		const char *impl;
 		double mb_sec;
 		uint64_t usec;
 		char pre[3];
@@ -421,9 +687,14 @@ int fio_crctest(const char *type)
 				sprintf(pre, "\t");
 			else
 				sprintf(pre, "\t\t");
-			printf("%s:%s%8.2f MiB/sec\n", t[i].name, pre, mb_sec);
+			printf("%s:%s%8.2f MiB/sec", t[i].name, pre, mb_sec);
 		} else
-			printf("%s:inf MiB/sec\n", t[i].name);
+			printf("%s:inf MiB/sec", t[i].name);
+
+		impl = test_impl(&t[i]);
+		if (impl)
+			printf(" (%s)", impl);
+		printf("\n");
 		first = 0;
 	}
 
@@ -0,0 +1,625 @@
+/*
+ * XXH3 - 64-bit and 128-bit variants of xxHash
+ *
+ * Based on the description and reference implementation of XXH3 in the
+ * xxHash library, Copyright (C) 2019-2021 Yann Collet, BSD 2-Clause License.
+ * Only the default secret and a zero seed are supported, which is all
+ * verify needs.
+ *
+ * Short inputs go through a few multiply and fold steps. Inputs longer than
+ * 240 bytes are split into 64-byte stripes that are mixed into eight 64-bit
+ * accumulators, which is the part that runs with SIMD.
+ */
+#include <string.h>
+
+#include "xxh3.h"
+#include "../arch/arch.h"
+#include "../compiler/compiler.h"
+#include "../os/os.h"
+
+#define PRIME32_1	0x9E3779B1U
+#define PRIME32_2	0x85EBCA77U
+#define PRIME32_3	0xC2B2AE3DU
+
+#define PRIME64_1	0x9E3779B185EBCA87ULL
+#define PRIME64_2	0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3	0x165667B19E3779F9ULL
+#define PRIME64_4	0x85EBCA77C2B2AE63ULL
+#define PRIME64_5	0x27D4EB2F165667C5ULL
+
+#define PRIME_MX1	0x165667919E3779F9ULL
+#define PRIME_MX2	0x9FB21C651E98DF25ULL
+
+#define XXH3_SECRET_SIZE	192
+#define XXH3_SECRET_SIZE_MIN	136
+#define XXH3_STRIPE_LEN		64
+#define XXH3_SECRET_CONSUME	8
+#define XXH3_STRIPES_PER_BLOCK	((XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME)
+#define XXH3_BLOCK_LEN		(XXH3_STRIPE_LEN * XXH3_STRIPES_PER_BLOCK)
+#define XXH3_MIDSIZE_MAX	240
+#define XXH3_MIDSIZE_START	3
+#define XXH3_MIDSIZE_LAST	17
+#define XXH3_MERGEACCS_START	11
+
+static const uint8_t xxh3_secret[XXH3_SECRET_SIZE] __attribute__((aligned(64))) = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+bool xxh3_simd_available = false;
+const char *xxh3_simd_name = NULL;
+
+static void (*xxh3_long_simd)(uint64_t *acc, const uint8_t *in, size_t len);
+
+static inline uint32_t read32(const void *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return le32_to_cpu(v);
+}
+
+static inline uint64_t read64(const void *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return le64_to_cpu(v);
+}
+
+static inline uint32_t rotl32(uint32_t v, unsigned int r)
+{
+	return (v << r) | (v >> (32 - r));
+}
+
+static inline uint64_t rotl64(uint64_t v, unsigned int r)
+{
+	return (v << r) | (v >> (64 - r));
+}
+
+static inline void mul128(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128) a * b;
+
+	*lo = (uint64_t) p;
+	*hi = (uint64_t) (p >> 64);
+#else
+	uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+	uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+	uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+	uint64_t hi_hi = (a >> 32) * (b >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+
+	*hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	*lo = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+	uint64_t lo, hi;
+
+	mul128(a, b, &lo, &hi);
+	return lo ^ hi;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len)
+{
+	h ^= rotl64(h, 49) ^ rotl64(h, 24);
+	h *= PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= PRIME_MX2;
+	h ^= h >> 28;
+	return h;
+}
+
+static inline uint64_t xxh3_mix16(const uint8_t *in, const uint8_t *sec,
+				  uint64_t seed)
+{
+	return mul128_fold64(read64(in) ^ (read64(sec) + seed),
+			     read64(in + 8) ^ (read64(sec + 8) - seed));
+}
+
+/*
+ * Stripe accumulation and scrambling, in portable C and with SIMD. Every
+ * version works on the same eight 64-bit lanes.
+ */
+static inline void xxh3_accumulate_512(uint64_t *acc, const uint8_t *in,
+				       const uint8_t *sec)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		uint64_t data = read64(in + 8 * i);
+		uint64_t key = data ^ read64(sec + 8 * i);
+
+		acc[i ^ 1] += data;
+		acc[i] += (key & 0xffffffff) * (key >> 32);
+	}
+}
+
+static inline void xxh3_scramble(uint64_t *acc, const uint8_t *sec)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		uint64_t a = acc[i];
+
+		a ^= a >> 47;
+		a ^= read64(sec + 8 * i);
+		a *= PRIME32_1;
+		acc[i] = a;
+	}
+}
+
+/*
+ * The long input loop. Each block of stripes walks the secret 8 bytes at a
+ * time and then scrambles the accumulators. The last, possibly partial,
+ * stripe is taken from the end of the input.
+ */
+#define XXH3_LONG_LOOP(acc, in, len, accumulate, scramble)		\
+do {									\
+	size_t __nb_blocks = ((len) - 1) / XXH3_BLOCK_LEN;		\
+	size_t __n, __s, __nb_stripes;					\
+									\
+	for (__n = 0; __n < __nb_blocks; __n++) {			\
+		const uint8_t *__b = (in) + __n * XXH3_BLOCK_LEN;	\
+									\
+		for (__s = 0; __s < XXH3_STRIPES_PER_BLOCK; __s++)	\
+			accumulate(acc, __b + __s * XXH3_STRIPE_LEN,	\
+				   xxh3_secret + __s * XXH3_SECRET_CONSUME); \
+		scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN); \
+	}								\
+									\
+	__nb_stripes = (((len) - 1) - __nb_blocks * XXH3_BLOCK_LEN) /	\
+			XXH3_STRIPE_LEN;				\
+	for (__s = 0; __s < __nb_stripes; __s++)			\
+		accumulate(acc, (in) + __nb_blocks * XXH3_BLOCK_LEN +	\
+			   __s * XXH3_STRIPE_LEN,			\
+			   xxh3_secret + __s * XXH3_SECRET_CONSUME);	\
+									\
+	accumulate(acc, (in) + (len) - XXH3_STRIPE_LEN,			\
+		   xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 7); \
+} while (0)
+
+static void xxh3_long_scalar(uint64_t *acc, const uint8_t *in, size_t len)
+{
+	XXH3_LONG_LOOP(acc, in, len, xxh3_accumulate_512, xxh3_scramble);
+}
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+static inline void xxh3_accumulate_512_sse2(__m128i *acc, const uint8_t *in,
+					    const uint8_t *sec)
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		__m128i data = _mm_loadu_si128((const __m128i *) in + i);
+		__m128i key = _mm_xor_si128(data,
+				_mm_loadu_si128((const __m128i *) sec + i));
+		__m128i prod = _mm_mul_epu32(key, _mm_shuffle_epi32(key, 0x31));
+		__m128i swap = _mm_shuffle_epi32(data, 0x4e);
+
+		acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(prod, swap));
+	}
+}
+
+static inline void xxh3_scramble_sse2(__m128i *acc, const uint8_t *sec)
+{
+	const __m128i prime = _mm_set1_epi32(PRIME32_1);
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		__m128i a = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+		__m128i lo, hi;
+
+		a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *) sec + i));
+		lo = _mm_mul_epu32(a, prime);
+		hi = _mm_mul_epu32(_mm_shuffle_epi32(a, 0x31), prime);
+		acc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+	}
+}
+
+static void xxh3_long_sse2(uint64_t *acc64, const uint8_t *in, size_t len)
+{
+	__m128i acc[4];
+	int i;
+
+	for (i = 0; i < 4; i++)
+		acc[i] = _mm_loadu_si128((const __m128i *) acc64 + i);
+
+	XXH3_LONG_LOOP(acc, in, len, xxh3_accumulate_512_sse2,
+			xxh3_scramble_sse2);
+
+	for (i = 0; i < 4; i++)
+		_mm_storeu_si128((__m128i *) acc64 + i, acc[i]);
+}
+
+#endif
+
+#if defined(ARCH_HAVE_AVX2)
+
+#include <immintrin.h>
+
+#define AVX2_TARGET	__attribute__((target("avx2")))
+
+static inline AVX2_TARGET void
+xxh3_accumulate_512_avx2(__m256i *acc, const uint8_t *in, const uint8_t *sec)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		__m256i data = _mm256_loadu_si256((const __m256i *) in + i);
+		__m256i key = _mm256_xor_si256(data,
+				_mm256_loadu_si256((const __m256i *) sec + i));
+		__m256i prod = _mm256_mul_epu32(key,
+					_mm256_shuffle_epi32(key, 0x31));
+		__m256i swap = _mm256_shuffle_epi32(data, 0x4e);
+
+		acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(prod, swap));
+	}
+}
+
+static inline AVX2_TARGET void xxh3_scramble_avx2(__m256i *acc,
+						  const uint8_t *sec)
+{
+	const __m256i prime = _mm256_set1_epi32(PRIME32_1);
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		__m256i a = _mm256_xor_si256(acc[i],
+					     _mm256_srli_epi64(acc[i], 47));
+		__m256i lo, hi;
+
+		a = _mm256_xor_si256(a,
+			_mm256_loadu_si256((const __m256i *) sec + i));
+		lo = _mm256_mul_epu32(a, prime);
+		hi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, 0x31), prime);
+		acc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+	}
+}
+
+static AVX2_TARGET void xxh3_long_avx2(uint64_t *acc64, const uint8_t *in,
+				       size_t len)
+{
+	__m256i acc[2];
+	int i;
+
+	for (i = 0; i < 2; i++)
+		acc[i] = _mm256_loadu_si256((const __m256i *) acc64 + i);
+
+	XXH3_LONG_LOOP(acc, in, len, xxh3_accumulate_512_avx2,
+			xxh3_scramble_avx2);
+
+	for (i = 0; i < 2; i++)
+		_mm256_storeu_si256((__m256i *) acc64 + i, acc[i]);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+static inline void xxh3_accumulate_512_neon(uint64x2_t *acc, const uint8_t *in,
+					    const uint8_t *sec)
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(in + 16 * i));
+		uint64x2_t key = veorq_u64(data,
+				vreinterpretq_u64_u8(vld1q_u8(sec + 16 * i)));
+		uint64x2_t prod = vmull_u32(vmovn_u64(key),
+					    vshrn_n_u64(key, 32));
+
+		acc[i] = vaddq_u64(acc[i], vextq_u64(data, data, 1));
+		acc[i] = vaddq_u64(acc[i], prod);
+	}
+}
+
+static inline void xxh3_scramble_neon(uint64x2_t *acc, const uint8_t *sec)
+{
+	const uint32x2_t prime = vdup_n_u32(PRIME32_1);
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		uint64x2_t a = veorq_u64(acc[i], vshrq_n_u64(acc[i], 47));
+		uint64x2_t hi;
+
+		a = veorq_u64(a, vreinterpretq_u64_u8(vld1q_u8(sec + 16 * i)));
+		hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+		acc[i] = vmlal_u32(hi, vmovn_u64(a), prime);
+	}
+}
+
+static void xxh3_long_neon(uint64_t *acc64, const uint8_t *in, size_t len)
+{
+	uint64x2_t acc[4];
+	int i;
+
+	for (i = 0; i < 4; i++)
+		acc[i] = vld1q_u64(acc64 + 2 * i);
+
+	XXH3_LONG_LOOP(acc, in, len, xxh3_accumulate_512_neon,
+			xxh3_scramble_neon);
+
+	for (i = 0; i < 4; i++)
+		vst1q_u64(acc64 + 2 * i, acc[i]);
+}
+
+#endif
+
+static void xxh3_long(uint64_t *acc, const uint8_t *in, size_t len)
+{
+	acc[0] = PRIME32_3;
+	acc[1] = PRIME64_1;
+	acc[2] = PRIME64_2;
+	acc[3] = PRIME64_3;
+	acc[4] = PRIME64_4;
+	acc[5] = PRIME32_2;
+	acc[6] = PRIME64_5;
+	acc[7] = PRIME32_1;
+
+	if (xxh3_simd_available)
+		xxh3_long_simd(acc, in, len);
+	else
+		xxh3_long_scalar(acc, in, len);
+}
+
+static uint64_t xxh3_merge_accs(const uint64_t *acc, const uint8_t *sec,
+				uint64_t start)
+{
+	uint64_t h = start;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		h += mul128_fold64(acc[2 * i] ^ read64(sec + 16 * i),
+				   acc[2 * i + 1] ^ read64(sec + 16 * i + 8));
+
+	return xxh3_avalanche(h);
+}
+
+static uint64_t xxh3_64_short(const uint8_t *in, size_t len)
+{
+	const uint8_t *sec = xxh3_secret;
+
+	if (len > 8) {
+		uint64_t lo = read64(in) ^ (read64(sec + 24) ^ read64(sec + 32));
+		uint64_t hi = read64(in + len - 8) ^
+				(read64(sec + 40) ^ read64(sec + 48));
+
+		return xxh3_avalanche(len + fio_swap64(lo) + hi +
+				      mul128_fold64(lo, hi));
+	} else if (len >= 4) {
+		uint64_t v = read32(in + len - 4) +
+				((uint64_t) read32(in) << 32);
+
+		return xxh3_rrmxmx(v ^ (read64(sec + 8) ^ read64(sec + 16)),
+				   len);
+	} else if (len) {
+		uint32_t c = ((uint32_t) in[0] << 16) |
+				((uint32_t) in[len >> 1] << 24) |
+				in[len - 1] | ((uint32_t) len << 8);
+
+		return xxh64_avalanche(c ^ (read32(sec) ^ read32(sec + 4)));
+	}
+
+	return xxh64_avalanche(read64(sec + 56) ^ read64(sec + 64));
+}
+
+uint64_t fio_xxh3_64(const void *buf, size_t len)
+{
+	const uint8_t *sec = xxh3_secret;
+	const uint8_t *in = buf;
+	uint64_t acc;
+	size_t i;
+
+	if (len <= 16)
+		return xxh3_64_short(in, len);
+
+	if (len > XXH3_MIDSIZE_MAX) {
+		uint64_t accs[8];
+
+		xxh3_long(accs, in, len);
+		return xxh3_merge_accs(accs, sec + XXH3_MERGEACCS_START,
+				       len * PRIME64_1);
+	}
+
+	acc = len * PRIME64_1;
+	if (len > 128) {
+		for (i = 0; i < 8; i++)
+			acc += xxh3_mix16(in + 16 * i, sec + 16 * i, 0);
+		acc = xxh3_avalanche(acc);
+		for (i = 8; i < len / 16; i++)
+			acc += xxh3_mix16(in + 16 * i, sec + 16 * (i - 8) +
+					  XXH3_MIDSIZE_START, 0);
+		acc += xxh3_mix16(in + len - 16, sec + XXH3_SECRET_SIZE_MIN -
+				  XXH3_MIDSIZE_LAST, 0);
+		return xxh3_avalanche(acc);
+	}
+
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc += xxh3_mix16(in + 48, sec + 96, 0);
+				acc += xxh3_mix16(in + len - 64, sec + 112, 0);
+			}
+			acc += xxh3_mix16(in + 32, sec + 64, 0);
+			acc += xxh3_mix16(in + len - 48, sec + 80, 0);
+		}
+		acc += xxh3_mix16(in + 16, sec + 32, 0);
+		acc += xxh3_mix16(in + len - 32, sec + 48, 0);
+	}
+	acc += xxh3_mix16(in, sec, 0);
+	acc += xxh3_mix16(in + len - 16, sec + 16, 0);
+	return xxh3_avalanche(acc);
+}
+
+static void xxh3_128_short(const uint8_t *in, size_t len, uint64_t hash[2])
+{
+	const uint8_t *sec = xxh3_secret;
+	uint64_t lo, hi;
+
+	if (len > 8) {
+		uint64_t in_lo = read64(in);
+		uint64_t in_hi = read64(in + len - 8);
+		uint64_t h_lo, h_hi;
+
+		mul128(in_lo ^ in_hi ^ (read64(sec + 32) ^ read64(sec + 40)),
+		       PRIME64_1, &lo, &hi);
+		lo += (uint64_t) (len - 1) << 54;
+		in_hi ^= read64(sec + 48) ^ read64(sec + 56);
+		hi += in_hi + (in_hi & 0xffffffff) * (PRIME32_2 - 1);
+		lo ^= fio_swap64(hi);
+
+		mul128(lo, PRIME64_2, &h_lo, &h_hi);
+		h_hi += hi * PRIME64_2;
+		hash[0] = xxh3_avalanche(h_lo);
+		hash[1] = xxh3_avalanche(h_hi);
+	} else if (len >= 4) {
+		uint64_t v = read32(in) + ((uint64_t) read32(in + len - 4) << 32);
+
+		v ^= read64(sec + 16) ^ read64(sec + 24);
+		mul128(v, PRIME64_1 + (len << 2), &lo, &hi);
+		hi += lo << 1;
+		lo ^= hi >> 3;
+		lo ^= lo >> 35;
+		lo *= PRIME_MX2;
+		lo ^= lo >> 28;
+		hash[0] = lo;
+		hash[1] = xxh3_avalanche(hi);
+	} else if (len) {
+		uint32_t c = ((uint32_t) in[0] << 16) |
+				((uint32_t) in[len >> 1] << 24) |
+				in[len - 1] | ((uint32_t) len << 8);
+		uint32_t ch = rotl32(fio_swap32(c), 13);
+
+		hash[0] = xxh64_avalanche(c ^ (read32(sec) ^ read32(sec + 4)));
+		hash[1] = xxh64_avalanche(ch ^ (read32(sec + 8) ^
+						read32(sec + 12)));
+	} else {
+		hash[0] = xxh64_avalanche(read64(sec + 64) ^ read64(sec + 72));
+		hash[1] = xxh64_avalanche(read64(sec + 80) ^ read64(sec + 88));
+	}
+}
+
+static inline void xxh3_mix32(uint64_t *acc, const uint8_t *in1,
+			      const uint8_t *in2, const uint8_t *sec,
+			      uint64_t seed)
+{
+	acc[0] += xxh3_mix16(in1, sec, seed);
+	acc[0] ^= read64(in2) + read64(in2 + 8);
+	acc[1] += xxh3_mix16(in2, sec + 16, seed);
+	acc[1] ^= read64(in1) + read64(in1 + 8);
+}
+
+void fio_xxh3_128(const void *buf, size_t len, uint64_t hash[2])
+{
+	const uint8_t *sec = xxh3_secret;
+	const uint8_t *in = buf;
+	uint64_t acc[2];
+	size_t i;
+
+	if (len <= 16) {
+		xxh3_128_short(in, len, hash);
+		return;
+	}
+
+	if (len > XXH3_MIDSIZE_MAX) {
+		uint64_t accs[8];
+
+		xxh3_long(accs, in, len);
+		hash[0] = xxh3_merge_accs(accs, sec + XXH3_MERGEACCS_START,
+					  len * PRIME64_1);
+		hash[1] = xxh3_merge_accs(accs, sec + XXH3_SECRET_SIZE -
+					  XXH3_STRIPE_LEN - XXH3_MERGEACCS_START,
+					  ~(len * PRIME64_2));
+		return;
+	}
+
+	acc[0] = len * PRIME64_1;
+	acc[1] = 0;
+	if (len > 128) {
+		for (i = 0; i < 4; i++)
+			xxh3_mix32(acc, in + 32 * i, in + 32 * i + 16,
+				   sec + 32 * i, 0);
+		acc[0] = xxh3_avalanche(acc[0]);
+		acc[1] = xxh3_avalanche(acc[1]);
+		for (i = 4; i < len / 32; i++)
+			xxh3_mix32(acc, in + 32 * i, in + 32 * i + 16,
+				   sec + XXH3_MIDSIZE_START + 32 * (i - 4), 0);
+		xxh3_mix32(acc, in + len - 16, in + len - 32,
+			   sec + XXH3_SECRET_SIZE_MIN - XXH3_MIDSIZE_LAST - 16,
+			   0);
+	} else {
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96)
+					xxh3_mix32(acc, in + 48, in + len - 64,
+						   sec + 96, 0);
+				xxh3_mix32(acc, in + 32, in + len - 48,
+					   sec + 64, 0);
+			}
+			xxh3_mix32(acc, in + 16, in + len - 32, sec + 32, 0);
+		}
+		xxh3_mix32(acc, in, in + len - 16, sec, 0);
+	}
+
+	hash[0] = xxh3_avalanche(acc[0] + acc[1]);
+	hash[1] = -xxh3_avalanche(acc[0] * PRIME64_1 + acc[1] * PRIME64_4 +
+				  len * PRIME64_2);
+}
+
+static void fio_init xxh3_init(void)
+{
+#if defined(ARCH_HAVE_AVX2)
+	if (arch_cpu_has_avx2()) {
+		xxh3_long_simd = xxh3_long_avx2;
+		xxh3_simd_name = "avx2";
+	}
+#endif
+#if defined(__SSE2__)
+	if (!xxh3_long_simd) {
+		xxh3_long_simd = xxh3_long_sse2;
+		xxh3_simd_name = "sse2";
+	}
+#elif defined(__aarch64__)
+	xxh3_long_simd = xxh3_long_neon;
+	xxh3_simd_name = "neon";
+#endif
+
+	xxh3_simd_available = xxh3_long_simd != NULL;
+}
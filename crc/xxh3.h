@@ -0,0 +1,24 @@
+#ifndef FIO_XXH3_H
+#define FIO_XXH3_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "../lib/types.h"
+
+/*
+ * XXH3 64-bit and 128-bit hashes, with the default secret and a zero seed.
+ * The results match XXH3_64bits() and XXH3_128bits() of the reference
+ * xxHash library. hash[0] holds the low and hash[1] the high 64 bits of the
+ * 128-bit result.
+ *
+ * Inputs longer than 240 bytes are hashed with SSE2, AVX2 or NEON when the
+ * CPU has them. xxh3_simd_name names that implementation, if any.
+ */
+extern bool xxh3_simd_available;
+extern const char *xxh3_simd_name;
+
+extern uint64_t fio_xxh3_64(const void *buf, size_t len);
+extern void fio_xxh3_128(const void *buf, size_t len, uint64_t hash[2]);
+
+#endif
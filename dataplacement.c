@@ -15,11 +15,259 @@
 #include "pshared.h"
 #include "dataplacement.h"
 
+#define DP_EMU_UNMAPPED	UINT32_MAX
+#define DP_EMU_GC_PLID	UINT16_MAX
+
+/*
+ * State of an emulated reclaim unit (RU).
+ */
+struct dp_emu_ru {
+	uint32_t valid;		/* blocks holding current data */
+	uint32_t wp;		/* next block to write */
+	uint16_t plid;		/* placement ID the RU is written through */
+	uint16_t open;		/* a handle or garbage collection writes here */
+};
+
+/*
+ * Emulated data placement device. Logical blocks of the file are mapped to
+ * blocks of RUs, and each reclaim unit handle fills its own RU. Once the
+ * device runs low on empty RUs it reclaims the RU holding the least valid
+ * data, and relocates that data to an RU written by garbage collection only.
+ * The amount of relocated data is a proxy for the write amplification that
+ * a placement policy causes.
+ */
+struct dp_emu {
+	uint64_t bs;		/* mapping granularity */
+	uint32_t nr_blocks;	/* logical blocks */
+	uint32_t ru_blocks;	/* blocks per RU */
+	uint32_t nr_rus;
+	uint32_t nr_free;
+	uint32_t nr_ruhs;
+	uint32_t gc_ru;		/* RU receiving relocated data */
+	uint32_t *l2p;		/* logical block to RU block */
+	uint32_t *p2l;		/* RU block to logical block */
+	uint32_t *free_rus;
+	struct dp_emu_ru *rus;
+	uint32_t ruh_ru[];	/* RU written through each handle */
+};
+
+static int dp_emu_init(struct thread_data *td, struct fio_file *f)
+{
+	uint64_t bs = td->o.min_bs[DDIR_WRITE];
+	uint64_t nr_blocks, ru_blocks, data_rus, nr_rus;
+	unsigned int nr_ruhs = td->o.dp_emu_nr_ruhs;
+	struct dp_emu *emu;
+	uint32_t i;
+
+	/* Keep the device state if the files are set up again */
+	if (f->dp_emu || !bs)
+		return 0;
+
+	ru_blocks = td->o.dp_emu_ru_size / bs;
+	if (!ru_blocks) {
+		log_err("fio: dp_emulation_ru_size must be at least the block size\n");
+		return -EINVAL;
+	}
+
+	nr_blocks = f->real_file_size / bs;
+	data_rus = (nr_blocks + ru_blocks - 1) / ru_blocks;
+	/*
+	 * One open RU per handle, one for garbage collection, one kept empty
+	 * so that garbage collection can always proceed, and one more so that
+	 * there is always an RU with invalid data to reclaim.
+	 */
+	nr_rus = data_rus + data_rus * td->o.dp_emu_op / 100 + nr_ruhs + 3;
+	if (nr_rus * ru_blocks >= DP_EMU_UNMAPPED) {
+		log_err("fio: %s is too large for dp_emulation with bs=%llu\n",
+			f->file_name, (unsigned long long) bs);
+		return -EINVAL;
+	}
+
+	emu = calloc(1, sizeof(*emu) + nr_ruhs * sizeof(emu->ruh_ru[0]));
+	if (!emu)
+		return -ENOMEM;
+	emu->bs = bs;
+	emu->nr_blocks = nr_blocks;
+	emu->ru_blocks = ru_blocks;
+	emu->nr_rus = nr_rus;
+	emu->nr_ruhs = nr_ruhs;
+	emu->gc_ru = DP_EMU_UNMAPPED;
+	for (i = 0; i < nr_ruhs; i++)
+		emu->ruh_ru[i] = DP_EMU_UNMAPPED;
+
+	emu->l2p = malloc(nr_blocks * sizeof(*emu->l2p));
+	emu->p2l = malloc(nr_rus * ru_blocks * sizeof(*emu->p2l));
+	emu->free_rus = malloc(nr_rus * sizeof(*emu->free_rus));
+	emu->rus = calloc(nr_rus, sizeof(*emu->rus));
+	if (!emu->l2p || !emu->p2l || !emu->free_rus || !emu->rus) {
+		f->dp_emu = emu;
+		return -ENOMEM;
+	}
+	memset(emu->l2p, 0xff, nr_blocks * sizeof(*emu->l2p));
+	memset(emu->p2l, 0xff, nr_rus * ru_blocks * sizeof(*emu->p2l));
+	/* Hand out RU 0 first */
+	for (i = 0; i < nr_rus; i++)
+		emu->free_rus[emu->nr_free++] = nr_rus - 1 - i;
+
+	dprint(FD_FILE, "%s: emulating %u RUs of %"PRIu64" blocks of %"PRIu64" bytes\n",
+	       f->file_name, emu->nr_rus, ru_blocks, bs);
+
+	f->dp_emu = emu;
+	return 0;
+}
+
+static void dp_emu_free(struct fio_file *f)
+{
+	struct dp_emu *emu = f->dp_emu;
+
+	if (!emu)
+		return;
+
+	free(emu->l2p);
+	free(emu->p2l);
+	free(emu->free_rus);
+	free(emu->rus);
+	free(emu);
+	f->dp_emu = NULL;
+}
+
+static void dp_emu_invalidate(struct dp_emu *emu, uint32_t lba)
+{
+	uint32_t pba = emu->l2p[lba];
+
+	if (pba == DP_EMU_UNMAPPED)
+		return;
+
+	emu->rus[pba / emu->ru_blocks].valid--;
+	emu->p2l[pba] = DP_EMU_UNMAPPED;
+	emu->l2p[lba] = DP_EMU_UNMAPPED;
+}
+
+static void dp_emu_map(struct thread_data *td, struct dp_emu *emu,
+		       uint32_t *ru, uint16_t plid, uint32_t lba);
+
+/*
+ * Reclaim the full RU holding the least valid data. Must be called with at
+ * least one empty RU, which relocation may use up and reclaiming replaces.
+ */
+static void dp_emu_reclaim(struct thread_data *td, struct dp_emu *emu)
+{
+	struct dp_emu_ru *victim = NULL;
+	uint32_t i, ru = 0, pba, moved = 0;
+
+	for (i = 0; i < emu->nr_rus; i++) {
+		struct dp_emu_ru *r = &emu->rus[i];
+
+		if (r->open || r->wp < emu->ru_blocks)
+			continue;
+		if (!victim || r->valid < victim->valid) {
+			victim = r;
+			ru = i;
+		}
+	}
+	assert(victim && victim->valid < emu->ru_blocks);
+
+	pba = ru * emu->ru_blocks;
+	for (i = 0; i < emu->ru_blocks && victim->valid; i++, pba++) {
+		uint32_t lba = emu->p2l[pba];
+
+		if (lba == DP_EMU_UNMAPPED)
+			continue;
+		dp_emu_invalidate(emu, lba);
+		dp_emu_map(td, emu, &emu->gc_ru, DP_EMU_GC_PLID, lba);
+		moved++;
+	}
+
+	td->ts.dp_emu_gc_bytes += moved * emu->bs;
+	if (victim->plid < FIO_MAX_DP_IDS) {
+		td->ts.dp_ru_reclaims[victim->plid]++;
+		td->ts.dp_gc_bytes[victim->plid] += moved * emu->bs;
+	}
+
+	victim->wp = 0;
+	emu->free_rus[emu->nr_free++] = ru;
+}
+
+/*
+ * Map @lba to the next block of the RU *@ru, switching to an empty RU when
+ * it is full. Host writes reclaim RUs first if needed, garbage collection
+ * takes the empty RU kept for it.
+ */
+static void dp_emu_map(struct thread_data *td, struct dp_emu *emu,
+		       uint32_t *ru, uint16_t plid, uint32_t lba)
+{
+	struct dp_emu_ru *r = NULL;
+	uint32_t pba;
+
+	if (*ru != DP_EMU_UNMAPPED)
+		r = &emu->rus[*ru];
+	if (!r || r->wp == emu->ru_blocks) {
+		if (r)
+			r->open = 0;
+		if (plid != DP_EMU_GC_PLID) {
+			while (emu->nr_free < 2)
+				dp_emu_reclaim(td, emu);
+		}
+		assert(emu->nr_free);
+		*ru = emu->free_rus[--emu->nr_free];
+		r = &emu->rus[*ru];
+		r->plid = plid;
+		r->open = 1;
+	}
+
+	pba = *ru * emu->ru_blocks + r->wp++;
+	r->valid++;
+	emu->l2p[lba] = pba;
+	emu->p2l[pba] = lba;
+}
+
+/*
+ * Account a completed write or trim to the emulated device.
+ */
+void dp_emu_io_u(struct thread_data *td, struct io_u *io_u,
+		 unsigned long long bytes)
+{
+	struct dp_emu *emu = io_u->file->dp_emu;
+	unsigned long long lba, end;
+
+	if (io_u->ddir == DDIR_TRIM) {
+		/* Only blocks trimmed as a whole lose their data */
+		lba = (io_u->offset + emu->bs - 1) / emu->bs;
+		end = min((io_u->offset + bytes) / emu->bs,
+			  (unsigned long long) emu->nr_blocks);
+		for (; lba < end; lba++)
+			dp_emu_invalidate(emu, lba);
+		return;
+	}
+
+	lba = io_u->offset / emu->bs;
+	end = min((io_u->offset + bytes + emu->bs - 1) / emu->bs,
+		  (unsigned long long) emu->nr_blocks);
+	for (; lba < end; lba++) {
+		dp_emu_invalidate(emu, lba);
+		dp_emu_map(td, emu, &emu->ruh_ru[io_u->dspec % emu->nr_ruhs],
+			   io_u->dspec, lba);
+	}
+	td->ts.dp_emu_host_bytes += bytes;
+}
+
 static int fdp_ruh_info(struct thread_data *td, struct fio_file *f,
 			struct fio_ruhs_info *ruhs)
 {
 	int ret = -EINVAL;
 
+	/* The emulated device has placement IDs 0 .. dp_emulation_nr_ruhs-1 */
+	if (td->o.dp_emu) {
+		uint32_t i;
+
+		if (ruhs->nr_ruhs >= td->o.dp_emu_nr_ruhs) {
+			for (i = 0; i < td->o.dp_emu_nr_ruhs; i++)
+				ruhs->plis[i] = i;
+		}
+		ruhs->nr_ruhs = td->o.dp_emu_nr_ruhs;
+		return 0;
+	}
+
 	if (!td->io_ops) {
 		log_err("fio: no ops set in fdp init?!\n");
 		return ret;
@@ -198,12 +446,20 @@ int dp_init(struct thread_data *td)
 		ret = init_ruh_scheme(td, f);
 		if (ret)
 			break;
+
+		if (td->o.dp_emu) {
+			ret = dp_emu_init(td, f);
+			if (ret)
+				break;
+		}
 	}
 	return ret;
 }
 
 void fdp_free_ruhs_info(struct fio_file *f)
 {
+	dp_emu_free(f);
+
 	if (!f->ruhs_info)
 		return;
 	sfree(f->ruhs_info);
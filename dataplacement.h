@@ -44,5 +44,7 @@ struct fio_ruhs_scheme {
 int dp_init(struct thread_data *td);
 void fdp_free_ruhs_info(struct fio_file *f);
 void dp_fill_dspec_data(struct thread_data *td, struct io_u *io_u);
+void dp_emu_io_u(struct thread_data *td, struct io_u *io_u,
+		 unsigned long long bytes);
 
 #endif /* FIO_DATAPLACEMENT_H */
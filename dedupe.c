@@ -1,5 +1,9 @@
+#include <sys/mman.h>
+
 #include "fio.h"
 
+static struct dedupe_cache *global_dedupe_cache;
+
 /**
  * initializes the global dedup workset.
  * this needs to be called after all jobs' seeds
@@ -69,3 +73,225 @@ int init_dedupe_working_set_seeds(struct thread_data *td, bool global_dedup)
 
 	return 0;
 }
+
+/*
+ * Generate @nr working set pages into @buf from @state, the same way
+ * fill_io_buffer() would
+ */
+static void dedupe_cache_fill(struct thread_data *td, struct frand_state *state,
+			      void *buf, unsigned long long nr)
+{
+	unsigned long long page = td->o.min_bs[DDIR_WRITE];
+	unsigned long long chunk = min_not_zero(page,
+				(unsigned long long) td->o.compress_chunk);
+	unsigned long long left = nr * page;
+
+	while (left) {
+		unsigned long long this_write = min(chunk, left);
+
+		fill_random_buf_percentage(state, buf, td->o.compress_percentage,
+					   this_write, this_write,
+					   td->o.buffer_pattern,
+					   td->o.buffer_pattern_bytes);
+		buf += this_write;
+		left -= this_write;
+	}
+}
+
+static struct dedupe_cache *dedupe_cache_alloc(unsigned long long page_size,
+					       unsigned long long nr_pages)
+{
+	struct dedupe_cache *cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	cache->page_size = page_size;
+	cache->size = page_size * nr_pages;
+	cache->buf = mmap(NULL, cache->size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (cache->buf == MAP_FAILED) {
+		log_err("fio: could not allocate dedupe working set cache of "
+			"%llu bytes\n", (unsigned long long) cache->size);
+		free(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+static void dedupe_cache_free(struct dedupe_cache *cache)
+{
+	munmap(cache->buf, cache->size);
+	free(cache);
+}
+
+static bool dedupe_cache_wanted(struct thread_data *td)
+{
+	return td->o.dedupe_working_set_cache && td->o.dedupe_percentage &&
+		td->o.dedupe_mode == DEDUPE_MODE_WORKING_SET &&
+		td->num_unique_pages;
+}
+
+/*
+ * Global jobs can share a cache if their pages are generated alike
+ */
+static bool dedupe_cache_compatible(struct thread_data *a,
+				    struct thread_data *b)
+{
+	return a->num_unique_pages == b->num_unique_pages &&
+		a->o.min_bs[DDIR_WRITE] == b->o.min_bs[DDIR_WRITE] &&
+		a->o.compress_percentage == b->o.compress_percentage &&
+		a->o.compress_chunk == b->o.compress_chunk &&
+		a->o.buffer_pattern_bytes == b->o.buffer_pattern_bytes &&
+		!memcmp(a->o.buffer_pattern, b->o.buffer_pattern,
+			a->o.buffer_pattern_bytes);
+}
+
+static int init_global_dedupe_cache(void)
+{
+	struct thread_data *first = NULL;
+	unsigned long long pps;
+	int i;
+
+	for_each_td(td) {
+		if (!td->o.dedupe_global || !dedupe_cache_wanted(td))
+			continue;
+		if (!first)
+			first = td;
+		else if (!dedupe_cache_compatible(first, td))
+			return 0;
+	} end_for_each();
+
+	if (!first)
+		return 0;
+
+	pps = max(first->num_unique_pages / thread_number, 1ull);
+	global_dedupe_cache = dedupe_cache_alloc(first->o.min_bs[DDIR_WRITE],
+						 pps * thread_number);
+	if (!global_dedupe_cache)
+		return 1;
+
+	global_dedupe_cache->pages_per_seed = pps;
+	global_dedupe_cache->shared = true;
+	for (i = 0; i < thread_number; i++) {
+		struct frand_state state;
+
+		frand_copy(&state, &tnumber_to_td(i)->buf_state);
+		dedupe_cache_fill(first, &state, global_dedupe_cache->buf +
+				  i * pps * global_dedupe_cache->page_size, pps);
+	}
+
+	dprint(FD_MEM, "dedupe: shared working set cache of %llu pages\n",
+		pps * thread_number);
+	return 0;
+}
+
+/**
+ * builds the working set caches of jobs that asked for one.
+ * this needs to be called after all working set seeds
+ * have been initialized
+ */
+int init_dedupe_working_set_caches(void)
+{
+	if (init_global_dedupe_cache())
+		return 1;
+
+	for_each_td(td) {
+		struct dedupe_cache *cache;
+		unsigned long long i;
+
+		if (!dedupe_cache_wanted(td))
+			continue;
+		if (td->o.dedupe_global && global_dedupe_cache) {
+			td->dedupe_cache = global_dedupe_cache;
+			continue;
+		}
+
+		cache = dedupe_cache_alloc(td->o.min_bs[DDIR_WRITE],
+					   td->num_unique_pages);
+		if (!cache)
+			return 1;
+
+		for (i = 0; i < td->num_unique_pages; i++) {
+			struct frand_state state;
+
+			frand_copy(&state, &td->dedupe_working_set_states[i]);
+			dedupe_cache_fill(td, &state,
+					  cache->buf + i * cache->page_size, 1);
+		}
+		td->dedupe_cache = cache;
+	} end_for_each();
+
+	return 0;
+}
+
+void free_dedupe_working_set_caches(void)
+{
+	for_each_td(td) {
+		if (td->dedupe_cache && !td->dedupe_cache->shared)
+			dedupe_cache_free(td->dedupe_cache);
+		td->dedupe_cache = NULL;
+	} end_for_each();
+
+	if (global_dedupe_cache) {
+		dedupe_cache_free(global_dedupe_cache);
+		global_dedupe_cache = NULL;
+	}
+}
+
+static void *dedupe_cache_page(struct thread_data *td,
+			       unsigned long long index)
+{
+	struct dedupe_cache *cache = td->dedupe_cache;
+	unsigned long long page = index;
+
+	if (cache->shared) {
+		unsigned long long pps = cache->pages_per_seed;
+		unsigned int seed;
+
+		seed = (td->thread_number - 1 + index / pps) % thread_number;
+		page = seed * pps + index % pps;
+	}
+
+	return cache->buf + page * cache->page_size;
+}
+
+/*
+ * Copy working set pages into @buf, starting at working set page @index,
+ * instead of generating them again
+ */
+void fill_from_dedupe_cache(struct thread_data *td, void *buf,
+			    unsigned long long index, unsigned long long len)
+{
+	while (len) {
+		unsigned long long this_len;
+
+		this_len = min(len, td->dedupe_cache->page_size);
+		memcpy(buf, dedupe_cache_page(td, index), this_len);
+		buf += this_len;
+		len -= this_len;
+		index = (index + 1) % td->num_unique_pages;
+	}
+}
+
+/*
+ * The cached copy of @len bytes of working set pages from @index on, if
+ * they are contiguous in the cache
+ */
+void *dedupe_cache_range(struct thread_data *td, unsigned long long index,
+			 unsigned long long len)
+{
+	struct dedupe_cache *cache = td->dedupe_cache;
+	unsigned long long pages;
+
+	pages = (len + cache->page_size - 1) / cache->page_size;
+	if (index + pages > td->num_unique_pages)
+		return NULL;
+	if (cache->shared &&
+	    index % cache->pages_per_seed + pages > cache->pages_per_seed)
+		return NULL;
+
+	return dedupe_cache_page(td, index);
+}
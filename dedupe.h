@@ -1,7 +1,34 @@
 #ifndef DEDUPE_H
 #define DEDUPE_H
 
+/*
+ * Precomputed working set pages, see dedupe_working_set_cache. A cache is
+ * either private to one job and indexed by its working set index, or shared
+ * by all dedupe_global jobs. In the latter case page (seed, offset) holds the
+ * offset'th page generated from the buf_state of job 'seed', which is what
+ * every global job's working set is made of.
+ */
+struct dedupe_cache {
+	void *buf;
+	size_t size;
+	unsigned long long page_size;
+	unsigned long long pages_per_seed;	/* shared cache only */
+	bool shared;
+};
+
 int init_dedupe_working_set_seeds(struct thread_data *td, bool global_dedupe);
 int init_global_dedupe_working_set_seeds(void);
+int init_dedupe_working_set_caches(void);
+void free_dedupe_working_set_caches(void);
+void fill_from_dedupe_cache(struct thread_data *td, void *buf,
+			    unsigned long long index, unsigned long long len);
+void *dedupe_cache_range(struct thread_data *td, unsigned long long index,
+			 unsigned long long len);
+
+static inline bool dedupe_cache_contains(struct dedupe_cache *cache,
+					 const void *buf)
+{
+	return cache && buf >= cache->buf && buf < cache->buf + cache->size;
+}
 
 #endif
@@ -1,7 +1,7 @@
 /*
  * HTTP GET/PUT IO engine
  *
- * IO engine to perform HTTP(S) GET/PUT requests via libcurl-easy.
+ * IO engine to perform HTTP(S) GET/PUT requests via libcurl-multi.
  *
  * Copyright (C) 2018 SUSE LLC
  *
@@ -44,8 +44,34 @@ enum {
 	FIO_HTTPS_INSECURE  = 2,
 };
 
-struct http_data {
+struct http_curl_stream {
+	char *buf;
+	size_t pos;
+	size_t max;
+};
+
+/*
+ * One easy handle per in-flight request. All of them share the multi
+ * handle's connection cache, so connections are kept alive and reused
+ * across requests.
+ */
+struct http_req {
 	CURL *curl;
+	struct io_u *io_u;
+	struct curl_slist *slist;
+	struct http_curl_stream stream;
+};
+
+struct http_data {
+	CURLM *multi;
+	struct http_req *reqs;
+	struct http_req **free_reqs;
+	unsigned int nr_free;
+	unsigned int nr_reqs;
+	int running;
+
+	struct io_u **events;
+	unsigned int nr_events;
 };
 
 struct http_options {
@@ -65,12 +91,6 @@ struct http_options {
 	unsigned int mode;
 };
 
-struct http_curl_stream {
-	char *buf;
-	size_t pos;
-	size_t max;
-};
-
 static struct fio_option options[] = {
 	{
 		.name     = "https",
@@ -410,7 +430,8 @@ static int _curl_trace(CURL *handle, curl_infotype type,
 /* https://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
  * https://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-authenticating-requests.html#signing-request-intro
  */
-static void _add_aws_auth_header(CURL *curl, struct curl_slist *slist, struct http_options *o,
+static struct curl_slist *_add_aws_auth_header(CURL *curl,
+		struct curl_slist *slist, struct http_options *o,
 		int op, const char *uri, char *buf, size_t len)
 {
 	char date_short[16];
@@ -555,9 +576,12 @@ static void _add_aws_auth_header(CURL *curl, struct curl_slist *slist, struct ht
 		free(sse_key_base64);
 		free(sse_key_md5_base64);
 	}
+
+	return slist;
 }
 
-static void _add_swift_header(CURL *curl, struct curl_slist *slist, struct http_options *o,
+static struct curl_slist *_add_swift_header(CURL *curl,
+		struct curl_slist *slist, struct http_options *o,
 		int op, const char *uri, char *buf, size_t len)
 {
 	char *dsha = NULL;
@@ -578,16 +602,35 @@ static void _add_swift_header(CURL *curl, struct curl_slist *slist, struct http_
 	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, slist);
 
 	free(dsha);
+	return slist;
 }
 
 static void fio_http_cleanup(struct thread_data *td)
 {
 	struct http_data *http = td->io_ops_data;
+	unsigned int i;
+
+	if (!http)
+		return;
+
+	for (i = 0; i < http->nr_reqs; i++) {
+		struct http_req *req = &http->reqs[i];
 
-	if (http) {
-		curl_easy_cleanup(http->curl);
-		free(http);
+		if (!req->curl)
+			continue;
+		if (req->io_u)
+			curl_multi_remove_handle(http->multi, req->curl);
+		curl_slist_free_all(req->slist);
+		curl_easy_cleanup(req->curl);
 	}
+	if (http->multi)
+		curl_multi_cleanup(http->multi);
+
+	free(http->reqs);
+	free(http->free_reqs);
+	free(http->events);
+	free(http);
+	td->io_ops_data = NULL;
 }
 
 static size_t _http_read(void *ptr, size_t size, size_t nmemb, void *stream)
@@ -634,107 +677,250 @@ static enum fio_q_status fio_http_queue(struct thread_data *td,
 {
 	struct http_data *http = td->io_ops_data;
 	struct http_options *o = td->eo;
-	struct http_curl_stream _curl_stream;
-	struct curl_slist *slist = NULL;
+	struct http_req *req;
 	char object[512];
 	char url[1024];
-	long status;
-	CURLcode res;
+	CURLMcode mres;
 
 	fio_ro_check(td, io_u);
-	memset(&_curl_stream, 0, sizeof(_curl_stream));
+
+	if (!ddir_rw(io_u->ddir) && io_u->ddir != DDIR_TRIM) {
+		log_err("WARNING: Only DDIR_READ/DDIR_WRITE/DDIR_TRIM are supported!\n");
+		io_u->error = EINVAL;
+		td_verror(td, io_u->error, "transfer");
+		return FIO_Q_COMPLETED;
+	}
+
+	if (!http->nr_free)
+		return FIO_Q_BUSY;
+
+	req = http->free_reqs[--http->nr_free];
+	req->io_u = io_u;
+	io_u->engine_data = req;
+
 	snprintf(object, sizeof(object), "%s_%llu_%llu", td->files[0]->file_name,
 		io_u->offset, io_u->xfer_buflen);
 	if (o->https == FIO_HTTPS_OFF)
 		snprintf(url, sizeof(url), "http://%s%s", o->host, object);
 	else
 		snprintf(url, sizeof(url), "https://%s%s", o->host, object);
-	curl_easy_setopt(http->curl, CURLOPT_URL, url);
-	_curl_stream.buf = io_u->xfer_buf;
-	_curl_stream.max = io_u->xfer_buflen;
-	curl_easy_setopt(http->curl, CURLOPT_SEEKDATA, &_curl_stream);
-	curl_easy_setopt(http->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)io_u->xfer_buflen);
+	curl_easy_setopt(req->curl, CURLOPT_URL, url);
+
+	memset(&req->stream, 0, sizeof(req->stream));
+	req->stream.buf = io_u->xfer_buf;
+	req->stream.max = io_u->xfer_buflen;
+	curl_easy_setopt(req->curl, CURLOPT_SEEKDATA, &req->stream);
+	curl_easy_setopt(req->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)io_u->xfer_buflen);
 
 	if (o->mode == FIO_HTTP_S3)
-		_add_aws_auth_header(http->curl, slist, o, io_u->ddir, object,
-			io_u->xfer_buf, io_u->xfer_buflen);
+		req->slist = _add_aws_auth_header(req->curl, NULL, o,
+			io_u->ddir, object, io_u->xfer_buf, io_u->xfer_buflen);
 	else if (o->mode == FIO_HTTP_SWIFT)
-		_add_swift_header(http->curl, slist, o, io_u->ddir, object,
-			io_u->xfer_buf, io_u->xfer_buflen);
+		req->slist = _add_swift_header(req->curl, NULL, o,
+			io_u->ddir, object, io_u->xfer_buf, io_u->xfer_buflen);
 
 	if (io_u->ddir == DDIR_WRITE) {
-		curl_easy_setopt(http->curl, CURLOPT_READDATA, &_curl_stream);
-		curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, NULL);
-		curl_easy_setopt(http->curl, CURLOPT_UPLOAD, 1L);
-		res = curl_easy_perform(http->curl);
-		if (res == CURLE_OK) {
-			curl_easy_getinfo(http->curl, CURLINFO_RESPONSE_CODE, &status);
-			if (status == 100 || (status >= 200 && status <= 204))
-				goto out;
-			log_err("DDIR_WRITE failed with HTTP status code %ld\n", status);
-		}
-		goto err;
+		curl_easy_setopt(req->curl, CURLOPT_CUSTOMREQUEST, NULL);
+		curl_easy_setopt(req->curl, CURLOPT_READDATA, &req->stream);
+		curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, NULL);
+		curl_easy_setopt(req->curl, CURLOPT_UPLOAD, 1L);
 	} else if (io_u->ddir == DDIR_READ) {
-		curl_easy_setopt(http->curl, CURLOPT_READDATA, NULL);
-		curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, &_curl_stream);
-		curl_easy_setopt(http->curl, CURLOPT_HTTPGET, 1L);
-		res = curl_easy_perform(http->curl);
-		if (res == CURLE_OK) {
-			curl_easy_getinfo(http->curl, CURLINFO_RESPONSE_CODE, &status);
-			if (status == 200)
-				goto out;
-			else if (status == 404) {
-				/* Object doesn't exist. Pretend we read
-				 * zeroes */
-				memset(io_u->xfer_buf, 0, io_u->xfer_buflen);
-				goto out;
-			}
-			log_err("DDIR_READ failed with HTTP status code %ld\n", status);
-		}
-		goto err;
-	} else if (io_u->ddir == DDIR_TRIM) {
-		curl_easy_setopt(http->curl, CURLOPT_HTTPGET, 1L);
-		curl_easy_setopt(http->curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-		curl_easy_setopt(http->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)0);
-		curl_easy_setopt(http->curl, CURLOPT_READDATA, NULL);
-		curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, NULL);
-		res = curl_easy_perform(http->curl);
-		if (res == CURLE_OK) {
-			curl_easy_getinfo(http->curl, CURLINFO_RESPONSE_CODE, &status);
-			if (status == 200 || status == 202 || status == 204 || status == 404)
-				goto out;
-			log_err("DDIR_TRIM failed with HTTP status code %ld\n", status);
+		curl_easy_setopt(req->curl, CURLOPT_CUSTOMREQUEST, NULL);
+		curl_easy_setopt(req->curl, CURLOPT_READDATA, NULL);
+		curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, &req->stream);
+		curl_easy_setopt(req->curl, CURLOPT_HTTPGET, 1L);
+	} else {
+		curl_easy_setopt(req->curl, CURLOPT_HTTPGET, 1L);
+		curl_easy_setopt(req->curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+		curl_easy_setopt(req->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)0);
+		curl_easy_setopt(req->curl, CURLOPT_READDATA, NULL);
+		curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, NULL);
+	}
+
+	mres = curl_multi_add_handle(http->multi, req->curl);
+	if (mres != CURLM_OK) {
+		log_err("fio: curl_multi_add_handle: %s\n",
+			curl_multi_strerror(mres));
+		curl_slist_free_all(req->slist);
+		req->slist = NULL;
+		req->io_u = NULL;
+		http->free_reqs[http->nr_free++] = req;
+		io_u->error = EIO;
+		td_verror(td, io_u->error, "transfer");
+		return FIO_Q_COMPLETED;
+	}
+
+	/*
+	 * Get the request going right away, the transfer itself is driven
+	 * from ->getevents().
+	 */
+	curl_multi_perform(http->multi, &http->running);
+	return FIO_Q_QUEUED;
+}
+
+/*
+ * Map the HTTP status of a finished transfer to the io_u
+ */
+static void fio_http_complete(struct thread_data *td, struct http_req *req,
+			      CURLcode res)
+{
+	struct io_u *io_u = req->io_u;
+	long status = 0, connects = 0;
+	const char *ddir_str;
+
+	td->ts.http_requests++;
+	if (curl_easy_getinfo(req->curl, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK)
+		td->ts.http_connects += connects;
+
+	if (res == CURLE_OK)
+		curl_easy_getinfo(req->curl, CURLINFO_RESPONSE_CODE, &status);
+
+	if (io_u->ddir == DDIR_WRITE) {
+		ddir_str = "DDIR_WRITE";
+		if (status == 100 || (status >= 200 && status <= 204))
+			return;
+	} else if (io_u->ddir == DDIR_READ) {
+		ddir_str = "DDIR_READ";
+		if (status == 200)
+			return;
+		else if (status == 404) {
+			/* Object doesn't exist. Pretend we read
+			 * zeroes */
+			memset(io_u->xfer_buf, 0, io_u->xfer_buflen);
+			return;
 		}
-		goto err;
+	} else {
+		ddir_str = "DDIR_TRIM";
+		if (status == 200 || status == 202 || status == 204 || status == 404)
+			return;
 	}
 
-	log_err("WARNING: Only DDIR_READ/DDIR_WRITE/DDIR_TRIM are supported!\n");
+	if (res == CURLE_OK)
+		log_err("%s failed with HTTP status code %ld\n", ddir_str, status);
+	else
+		log_err("%s failed: %s\n", ddir_str, curl_easy_strerror(res));
 
-err:
 	io_u->error = EIO;
 	td_verror(td, io_u->error, "transfer");
-out:
-	curl_slist_free_all(slist);
-	return FIO_Q_COMPLETED;
+}
+
+static void fio_http_reap(struct thread_data *td, unsigned int max)
+{
+	struct http_data *http = td->io_ops_data;
+	struct http_req *req;
+	CURLMsg *msg;
+	int left;
+
+	while (http->nr_events < max &&
+	       (msg = curl_multi_info_read(http->multi, &left)) != NULL) {
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **) &req);
+		fio_http_complete(td, req, msg->data.result);
+
+		curl_multi_remove_handle(http->multi, req->curl);
+		curl_slist_free_all(req->slist);
+		req->slist = NULL;
+
+		http->events[http->nr_events++] = req->io_u;
+		req->io_u = NULL;
+		http->free_reqs[http->nr_free++] = req;
+	}
+}
+
+static int fio_http_getevents(struct thread_data *td, unsigned int min,
+			      unsigned int max, const struct timespec *t)
+{
+	struct http_data *http = td->io_ops_data;
+	uint64_t timeout_ms = 1000, elapsed;
+	struct timespec start;
+	CURLMcode mres;
+
+	if (t) {
+		timeout_ms = t->tv_sec * 1000 + t->tv_nsec / 1000000;
+		fio_gettime(&start, NULL);
+	}
+
+	http->nr_events = 0;
+	for (;;) {
+		mres = curl_multi_perform(http->multi, &http->running);
+		if (mres != CURLM_OK) {
+			log_err("fio: curl_multi_perform: %s\n",
+				curl_multi_strerror(mres));
+			return -EIO;
+		}
+
+		fio_http_reap(td, max);
+		if (http->nr_events >= min)
+			break;
+
+		/*
+		 * With a timeout, only wait for what is left of it
+		 */
+		elapsed = 0;
+		if (t) {
+			elapsed = mtime_since_now(&start);
+			if (elapsed >= timeout_ms)
+				break;
+		}
+
+		mres = curl_multi_wait(http->multi, NULL, 0,
+				       timeout_ms - elapsed, NULL);
+		if (mres != CURLM_OK) {
+			log_err("fio: curl_multi_wait: %s\n",
+				curl_multi_strerror(mres));
+			return -EIO;
+		}
+	}
+
+	return http->nr_events;
 }
 
 static struct io_u *fio_http_event(struct thread_data *td, int event)
 {
-	/* sync IO engine - never any outstanding events */
-	return NULL;
+	struct http_data *http = td->io_ops_data;
+
+	return http->events[event];
 }
 
-int fio_http_getevents(struct thread_data *td, unsigned int min,
-	unsigned int max, const struct timespec *t)
+static CURL *fio_http_easy_init(struct http_options *o)
 {
-	/* sync IO engine - never any outstanding events */
-	return 0;
+	CURL *curl;
+
+	curl = curl_easy_init();
+	if (!curl)
+		return NULL;
+
+	if (o->verbose)
+		curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+	if (o->verbose > 1)
+		curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, &_curl_trace);
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP|CURLPROTO_HTTPS);
+	if (o->https == FIO_HTTPS_INSECURE) {
+		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+	}
+	curl_easy_setopt(curl, CURLOPT_READFUNCTION, _http_read);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _http_write);
+	curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, &_http_seek);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	if (o->user && o->pass) {
+		curl_easy_setopt(curl, CURLOPT_USERNAME, o->user);
+		curl_easy_setopt(curl, CURLOPT_PASSWORD, o->pass);
+		curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
+	}
+
+	return curl;
 }
 
 static int fio_http_setup(struct thread_data *td)
 {
 	struct http_data *http = NULL;
 	struct http_options *o = td->eo;
+	unsigned int i;
 
 	/* allocate engine specific structure to deal with libhttp. */
 	http = calloc(1, sizeof(*http));
@@ -742,29 +928,38 @@ static int fio_http_setup(struct thread_data *td)
 		log_err("calloc failed.\n");
 		goto cleanup;
 	}
+	td->io_ops_data = http;
 
-	http->curl = curl_easy_init();
-	if (o->verbose)
-		curl_easy_setopt(http->curl, CURLOPT_VERBOSE, 1L);
-	if (o->verbose > 1)
-		curl_easy_setopt(http->curl, CURLOPT_DEBUGFUNCTION, &_curl_trace);
-	curl_easy_setopt(http->curl, CURLOPT_NOPROGRESS, 1L);
-	curl_easy_setopt(http->curl, CURLOPT_FOLLOWLOCATION, 1L);
-	curl_easy_setopt(http->curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP|CURLPROTO_HTTPS);
-	if (o->https == FIO_HTTPS_INSECURE) {
-		curl_easy_setopt(http->curl, CURLOPT_SSL_VERIFYPEER, 0L);
-		curl_easy_setopt(http->curl, CURLOPT_SSL_VERIFYHOST, 0L);
+	http->multi = curl_multi_init();
+	if (!http->multi) {
+		log_err("fio: curl_multi_init failed\n");
+		goto cleanup;
 	}
-	curl_easy_setopt(http->curl, CURLOPT_READFUNCTION, _http_read);
-	curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, _http_write);
-	curl_easy_setopt(http->curl, CURLOPT_SEEKFUNCTION, &_http_seek);
-	if (o->user && o->pass) {
-		curl_easy_setopt(http->curl, CURLOPT_USERNAME, o->user);
-		curl_easy_setopt(http->curl, CURLOPT_PASSWORD, o->pass);
-		curl_easy_setopt(http->curl, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
+
+	/*
+	 * One request per unit of iodepth, all in flight at the same time
+	 * on as many connections as needed.
+	 */
+	http->nr_reqs = td->o.iodepth;
+	http->reqs = calloc(http->nr_reqs, sizeof(*http->reqs));
+	http->free_reqs = calloc(http->nr_reqs, sizeof(*http->free_reqs));
+	http->events = calloc(http->nr_reqs, sizeof(*http->events));
+	if (!http->reqs || !http->free_reqs || !http->events) {
+		log_err("calloc failed.\n");
+		goto cleanup;
 	}
 
-	td->io_ops_data = http;
+	for (i = 0; i < http->nr_reqs; i++) {
+		struct http_req *req = &http->reqs[i];
+
+		req->curl = fio_http_easy_init(o);
+		if (!req->curl) {
+			log_err("fio: curl_easy_init failed\n");
+			goto cleanup;
+		}
+		curl_easy_setopt(req->curl, CURLOPT_PRIVATE, req);
+		http->free_reqs[http->nr_free++] = req;
+	}
 
 	/* Force single process mode. */
 	td->o.use_thread = 1;
@@ -787,7 +982,7 @@ static int fio_http_invalidate(struct thread_data *td, struct fio_file *f)
 FIO_STATIC struct ioengine_ops ioengine = {
 	.name = "http",
 	.version		= FIO_IOOPS_VERSION,
-	.flags			= FIO_DISKLESSIO | FIO_SYNCIO,
+	.flags			= FIO_DISKLESSIO,
 	.setup			= fio_http_setup,
 	.queue			= fio_http_queue,
 	.getevents		= fio_http_getevents,
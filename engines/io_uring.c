@@ -19,6 +19,7 @@
 #include "../lib/fls.h"
 #include "../lib/roundup.h"
 #include "../verify.h"
+#include "../content-pool.h"
 
 #ifdef ARCH_HAVE_IOURING
 
@@ -89,6 +90,7 @@ struct ioring_data {
 	int cq_ring_off;
 	unsigned iodepth;
 	int prepped;
+	bool ext_registered;	/* external write buffers are fixed buffer 'iodepth' */
 
 	struct ioring_mmap mmap[3];
 
@@ -408,10 +410,22 @@ static int fio_ioring_prep(struct thread_data *td, struct io_u *io_u)
 
 	if (io_u->ddir == DDIR_READ || io_u->ddir == DDIR_WRITE) {
 		if (o->fixedbufs) {
+			sqe->buf_index = io_u->index;
+			if (content_pool_contains(td->content_pool,
+						  io_u->xfer_buf) ||
+			    dedupe_cache_contains(td->dedupe_cache,
+						  io_u->xfer_buf)) {
+				if (ld->ext_registered) {
+					sqe->buf_index = ld->iodepth;
+				} else {
+					memcpy(io_u->buf, io_u->xfer_buf,
+						io_u->xfer_buflen);
+					io_u->xfer_buf = io_u->buf;
+				}
+			}
 			sqe->opcode = fixed_ddir_to_op[io_u->ddir];
 			sqe->addr = (unsigned long) io_u->xfer_buf;
 			sqe->len = io_u->xfer_buflen;
-			sqe->buf_index = io_u->index;
 		} else {
 			struct iovec *iov = &ld->iovecs[io_u->index];
 
@@ -550,7 +564,7 @@ static int fio_ioring_cmd_prep(struct thread_data *td, struct io_u *io_u)
 	return fio_nvme_uring_cmd_prep(cmd, io_u,
 			o->nonvectored ? NULL : &ld->iovecs[io_u->index],
 			dsm, read_opcode, ld->write_opcode,
-			ld->cdw12_flags[io_u->ddir]);
+			ddir_rw(io_u->ddir) ? ld->cdw12_flags[io_u->ddir] : 0);
 }
 
 static struct io_u *fio_ioring_event(struct thread_data *td, int event)
@@ -614,6 +628,14 @@ static struct io_u *fio_ioring_cmd_event(struct thread_data *td, int event)
 			if (ret)
 				io_u->error = ret;
 		}
+
+		/* The command result holds the LBA a zone append landed at */
+		if (io_u->flags & IO_U_F_ZONE_APPEND) {
+			if (data->lba_ext)
+				io_u->offset = cqe->big_cqe[0] * data->lba_ext;
+			else
+				io_u->offset = cqe->big_cqe[0] << data->lba_shift;
+		}
 	}
 
 ret:
@@ -733,7 +755,7 @@ static inline void fio_ioring_cmd_nvme_pi(struct thread_data *td,
 	struct nvme_cmd_ext_io_opts ext_opts = {0};
 	struct nvme_data *data = FILE_ENG_DATA(io_u->file);
 
-	if (io_u->ddir == DDIR_TRIM)
+	if (io_u->ddir == DDIR_TRIM || ddir_zone_mgmt(io_u->ddir))
 		return;
 
 	sqe = &ld->sqes[(io_u->index) << 1];
@@ -1075,7 +1097,18 @@ retry:
 
 	if (o->fixedbufs) {
 		ret = syscall(__NR_io_uring_register, ld->ring_fd,
-				IORING_REGISTER_BUFFERS, ld->iovecs, depth);
+				IORING_REGISTER_BUFFERS, ld->iovecs,
+				depth + ld->ext_registered);
+		if (ret < 0 && ld->ext_registered) {
+			/*
+			 * Most likely RLIMIT_MEMLOCK. Writes will copy into
+			 * their io_u buffer instead.
+			 */
+			ld->ext_registered = false;
+			ret = syscall(__NR_io_uring_register, ld->ring_fd,
+					IORING_REGISTER_BUFFERS, ld->iovecs,
+					depth);
+		}
 		if (ret < 0)
 			return ret;
 	}
@@ -1222,6 +1255,25 @@ static int fio_ioring_post_init(struct thread_data *td)
 		iov->iov_len = td_max_bs(td);
 	}
 
+	/*
+	 * Register a generated content pool or a dedupe working set cache as
+	 * one more fixed buffer, so writes from it need no copy. The kernel
+	 * limits a fixed buffer to 1GiB.
+	 */
+	if (o->fixedbufs) {
+		struct iovec *iov = &ld->iovecs[ld->iodepth];
+
+		if (td->content_pool && !td->content_pool->file_backed) {
+			iov->iov_base = td->content_pool->buf;
+			iov->iov_len = td->content_pool->size;
+		} else if (td->dedupe_cache) {
+			iov->iov_base = td->dedupe_cache->buf;
+			iov->iov_len = td->dedupe_cache->size;
+		}
+		ld->ext_registered = iov->iov_len &&
+				     iov->iov_len <= 1024 * 1024 * 1024;
+	}
+
 	err = fio_ioring_queue_init(td);
 	if (err) {
 		int init_err = errno;
@@ -1367,7 +1419,7 @@ static int fio_ioring_init(struct thread_data *td)
 	}
 	parse_prchk_flags(o);
 
-	ld->iovecs = calloc(ld->iodepth, sizeof(struct iovec));
+	ld->iovecs = calloc(ld->iodepth + 1, sizeof(struct iovec));
 
 	td->io_ops_data = ld;
 
@@ -1552,6 +1604,15 @@ static int fio_ioring_cmd_open_file(struct thread_data *td, struct fio_file *f)
 			td_verror(td, EINVAL, "fio_ioring_cmd_open_file");
 			return 1;
 		}
+
+		if (td->o.zone_append &&
+		    (o->write_mode != FIO_URING_CMD_WMODE_WRITE ||
+		     data->pi_type)) {
+			log_err("%s: zone_append requires write_mode=write and no end to end data protection\n",
+				f->file_name);
+			td_verror(td, EINVAL, "fio_ioring_cmd_open_file");
+			return 1;
+		}
 	}
 	if (!ld || !o->registerfiles)
 		return generic_open_file(td, f);
@@ -1677,7 +1738,7 @@ static struct ioengine_ops ioengine_uring = {
 	.name			= "io_uring",
 	.version		= FIO_IOOPS_VERSION,
 	.flags			= FIO_NO_OFFLOAD | FIO_ASYNCIO_SETS_ISSUE_TIME |
-				  FIO_ATOMICWRITES,
+				  FIO_ATOMICWRITES | FIO_EXT_WRITE_BUF,
 	.init			= fio_ioring_init,
 	.post_init		= fio_ioring_post_init,
 	.io_u_init		= fio_ioring_io_u_init,
@@ -1699,7 +1760,8 @@ static struct ioengine_ops ioengine_uring_cmd = {
 	.version		= FIO_IOOPS_VERSION,
 	.flags			= FIO_NO_OFFLOAD | FIO_MEMALIGN | FIO_RAWIO |
 					FIO_ASYNCIO_SETS_ISSUE_TIME |
-					FIO_MULTI_RANGE_TRIM,
+					FIO_MULTI_RANGE_TRIM | FIO_ZONE_APPEND |
+					FIO_ZONE_MGMT,
 	.init			= fio_ioring_init,
 	.post_init		= fio_ioring_cmd_post_init,
 	.io_u_init		= fio_ioring_io_u_init,
@@ -28,10 +28,29 @@ struct sockaddr_vm {
 #endif
 #endif
 
+#ifdef CONFIG_NET_ZEROCOPY
+#include <linux/errqueue.h>
+#endif
+
 #include "../fio.h"
 #include "../verify.h"
 #include "../optgroup.h"
 
+/*
+ * A zero-copy send that the kernel still holds buffer references for.
+ * The io_u can't be completed (and its buffer reused) until notifications
+ * for all the send calls [seq, seq + nr) have been reaped from the error
+ * queue.
+ */
+struct netio_zc_pending {
+	struct io_u *io_u;
+	unsigned int fileno;
+	uint32_t seq;
+	uint32_t nr;
+	uint32_t left;
+	unsigned int copied;
+};
+
 struct netio_data {
 	int listenfd;
 	int use_splice;
@@ -43,6 +62,17 @@ struct netio_data {
 	struct sockaddr_vm addr_vm;
 	uint64_t udp_send_seq;
 	uint64_t udp_recv_seq;
+
+	/*
+	 * MSG_ZEROCOPY state. zc_seq mirrors, for each file, the per-socket
+	 * counter the kernel uses to number zero-copy send calls.
+	 */
+	uint32_t *zc_seq;
+	struct pollfd *zc_pfds;
+	struct netio_zc_pending *zc_pending;
+	unsigned int zc_nr_pending;
+	struct io_u **zc_events;
+	unsigned int zc_nr_events;
 };
 
 struct netio_options {
@@ -55,6 +85,7 @@ struct netio_options {
 	unsigned int ttl;
 	unsigned int window_size;
 	unsigned int mss;
+	unsigned int zerocopy;
 	char *intfc;
 };
 
@@ -218,6 +249,18 @@ static struct fio_option options[] = {
 		.category = FIO_OPT_C_ENGINE,
 		.group	= FIO_OPT_G_NETIO,
 	},
+#endif
+#ifdef CONFIG_NET_ZEROCOPY
+	{
+		.name	= "zerocopy",
+		.lname	= "Zero-copy send",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct netio_options, zerocopy),
+		.help	= "Transmit with MSG_ZEROCOPY instead of copying the buffer",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NETIO,
+	},
 #endif
 	{
 		.name	= NULL,
@@ -302,6 +345,30 @@ static int set_mss(struct thread_data *td, int fd)
 #endif
 }
 
+static int set_zerocopy(struct thread_data *td, struct fio_file *f)
+{
+#ifdef CONFIG_NET_ZEROCOPY
+	struct netio_data *nd = td->io_ops_data;
+	struct netio_options *o = td->eo;
+	int optval = 1;
+	int ret;
+
+	if (!o->zerocopy || !td_write(td))
+		return 0;
+
+	/* A new socket numbers its zero-copy sends from 0 again */
+	nd->zc_seq[f->fileno] = 0;
+
+	ret = setsockopt(f->fd, SOL_SOCKET, SO_ZEROCOPY, (void *) &optval,
+				sizeof(optval));
+	if (ret < 0)
+		td_verror(td, errno, "setsockopt SO_ZEROCOPY");
+
+	return ret;
+#else
+	return 0;
+#endif
+}
 
 /*
  * Return -1 for error and 'nr events' for a positive number
@@ -549,6 +616,11 @@ static int fio_netio_send(struct thread_data *td, struct io_u *io_u)
 	struct netio_options *o = td->eo;
 	int ret, flags = 0;
 
+#ifdef CONFIG_NET_ZEROCOPY
+	if (o->zerocopy)
+		flags |= MSG_ZEROCOPY;
+#endif
+
 	do {
 		if (is_udp(o)) {
 			const struct sockaddr *to;
@@ -590,6 +662,189 @@ static int fio_netio_send(struct thread_data *td, struct io_u *io_u)
 	return ret;
 }
 
+#ifdef CONFIG_NET_ZEROCOPY
+/*
+ * Park a (partially) sent io_u until the kernel tells us it has released
+ * the buffer pages. Every successful MSG_ZEROCOPY send call consumes one
+ * notification sequence number.
+ */
+static void fio_netio_zc_queue(struct netio_data *nd, struct io_u *io_u,
+			       uint32_t seq, uint32_t nr)
+{
+	struct netio_zc_pending *zp = &nd->zc_pending[nd->zc_nr_pending++];
+
+	zp->io_u = io_u;
+	zp->fileno = io_u->file->fileno;
+	zp->seq = seq;
+	zp->nr = nr;
+	zp->left = nr;
+	zp->copied = 0;
+}
+
+/*
+ * Apply a notification covering send calls [lo, hi] on a file to the
+ * pending io_us of that file
+ */
+static void fio_netio_zc_complete(struct netio_data *nd, unsigned int fileno,
+				  uint32_t lo, uint32_t hi, int copied)
+{
+	unsigned int i;
+
+	for (i = 0; i < nd->zc_nr_pending; i++) {
+		struct netio_zc_pending *zp = &nd->zc_pending[i];
+		uint32_t j;
+
+		if (zp->fileno != fileno)
+			continue;
+		for (j = 0; j < zp->nr; j++) {
+			/* unsigned compare handles counter wrap */
+			if (zp->seq + j - lo <= hi - lo) {
+				zp->left--;
+				if (copied)
+					zp->copied = 1;
+			}
+		}
+	}
+}
+
+/*
+ * Move up to 'max' fully acknowledged io_us to the completion list
+ */
+static void fio_netio_zc_collect(struct thread_data *td, unsigned int max)
+{
+	struct netio_data *nd = td->io_ops_data;
+	unsigned int i = 0;
+
+	while (i < nd->zc_nr_pending && nd->zc_nr_events < max) {
+		struct netio_zc_pending *zp = &nd->zc_pending[i];
+		struct io_u *io_u = zp->io_u;
+
+		if (zp->left) {
+			i++;
+			continue;
+		}
+
+		if (zp->copied)
+			td->ts.zc_copied_bytes += io_u->xfer_buflen - io_u->resid;
+		else
+			td->ts.zc_bytes += io_u->xfer_buflen - io_u->resid;
+
+		nd->zc_events[nd->zc_nr_events++] = io_u;
+		*zp = nd->zc_pending[--nd->zc_nr_pending];
+	}
+}
+
+/*
+ * Drain zero-copy completion notifications from the socket error queue.
+ * Returns the number of notifications seen, or -1 on error.
+ */
+static int fio_netio_zc_reap(struct thread_data *td, struct fio_file *f)
+{
+	struct netio_data *nd = td->io_ops_data;
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + 64];
+	struct sock_extended_err *serr;
+	struct msghdr msg;
+	struct cmsghdr *cm;
+	int ret, seen = 0;
+
+	do {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		ret = recvmsg(f->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+		if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK ||
+			    errno == EINTR)
+				break;
+			td_verror(td, errno, "recvmsg MSG_ERRQUEUE");
+			return -1;
+		}
+
+		for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			if (!((cm->cmsg_level == SOL_IP &&
+			       cm->cmsg_type == IP_RECVERR) ||
+			      (cm->cmsg_level == SOL_IPV6 &&
+			       cm->cmsg_type == IPV6_RECVERR)))
+				continue;
+
+			serr = (struct sock_extended_err *) CMSG_DATA(cm);
+			if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY ||
+			    serr->ee_errno != 0)
+				continue;
+
+			fio_netio_zc_complete(nd, f->fileno, serr->ee_info,
+				serr->ee_data,
+				serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+			seen++;
+		}
+	} while (nd->zc_nr_pending);
+
+	return seen;
+}
+
+static int fio_netio_getevents(struct thread_data *td, unsigned int min,
+			       unsigned int max, const struct timespec *t)
+{
+	struct netio_data *nd = td->io_ops_data;
+	int timeout = -1;
+	struct fio_file *f;
+	unsigned int i, nr_pfds;
+
+	if (t)
+		timeout = t->tv_sec * 1000 + t->tv_nsec / 1000000;
+
+	nd->zc_nr_events = 0;
+
+	while (!td->terminate) {
+		for_each_file(td, f, i) {
+			if (f->fd == -1)
+				continue;
+			if (fio_netio_zc_reap(td, f) < 0)
+				return -1;
+		}
+
+		fio_netio_zc_collect(td, max);
+		if (nd->zc_nr_events >= min || nd->zc_nr_events == max ||
+		    !nd->zc_nr_pending)
+			break;
+
+		/*
+		 * Pending notifications raise POLLERR, which poll() always
+		 * reports without having to ask for it. Wait on every open
+		 * socket, a notification on any of them may be the one that
+		 * completes enough io_us.
+		 */
+		nr_pfds = 0;
+		for_each_file(td, f, i) {
+			if (f->fd == -1)
+				continue;
+			nd->zc_pfds[nr_pfds].fd = f->fd;
+			nd->zc_pfds[nr_pfds].events = 0;
+			nr_pfds++;
+		}
+		if (!nr_pfds)
+			break;
+		if (poll(nd->zc_pfds, nr_pfds, timeout) < 0 && errno != EINTR) {
+			td_verror(td, errno, "poll");
+			return -1;
+		}
+
+		if (!timeout)
+			break;
+	}
+
+	return nd->zc_nr_events;
+}
+
+static struct io_u *fio_netio_event(struct thread_data *td, int event)
+{
+	struct netio_data *nd = td->io_ops_data;
+
+	return nd->zc_events[event];
+}
+#endif
+
 static int is_close_msg(struct io_u *io_u, int len)
 {
 	struct udp_close_msg *msg;
@@ -672,11 +927,34 @@ static enum fio_q_status __fio_netio_queue(struct thread_data *td,
 	int ret;
 
 	if (ddir == DDIR_WRITE) {
+#ifdef CONFIG_NET_ZEROCOPY
+		uint32_t *zc_seq = NULL, seq = 0;
+
+		if (o->zerocopy) {
+			zc_seq = &nd->zc_seq[io_u->file->fileno];
+			seq = *zc_seq;
+		}
+#endif
+
 		if (!nd->use_splice || is_udp(o) ||
 		    o->proto == FIO_TYPE_UNIX)
 			ret = fio_netio_send(td, io_u);
 		else
 			ret = fio_netio_splice_out(td, io_u);
+
+#ifdef CONFIG_NET_ZEROCOPY
+		if (o->zerocopy && ret > 0) {
+			/*
+			 * The kernel still references the buffer, it can't
+			 * be completed before the notification is reaped.
+			 */
+			(*zc_seq)++;
+			io_u->resid = io_u->xfer_buflen - ret;
+			io_u->error = 0;
+			fio_netio_zc_queue(nd, io_u, seq, *zc_seq - seq);
+			return FIO_Q_QUEUED;
+		}
+#endif
 	} else if (ddir == DDIR_READ) {
 		if (!nd->use_splice || is_udp(o) ||
 		    o->proto == FIO_TYPE_UNIX)
@@ -698,6 +976,13 @@ static enum fio_q_status __fio_netio_queue(struct thread_data *td,
 
 			if (ddir == DDIR_WRITE && err == EMSGSIZE)
 				return FIO_Q_BUSY;
+			/*
+			 * Out of optmem for zero-copy notifications, reap
+			 * some completions and try again.
+			 */
+			if (ddir == DDIR_WRITE && err == ENOBUFS &&
+			    o->zerocopy && nd->zc_nr_pending)
+				return FIO_Q_BUSY;
 
 			io_u->error = err;
 		}
@@ -787,6 +1072,10 @@ static int fio_netio_connect(struct thread_data *td, struct fio_file *f)
 		close(f->fd);
 		return 1;
 	}
+	if (set_zerocopy(td, f)) {
+		close(f->fd);
+		return 1;
+	}
 
 	if (is_udp(o)) {
 		if (!fio_netio_is_multicast(td->o.filename))
@@ -904,6 +1193,9 @@ static int fio_netio_accept(struct thread_data *td, struct fio_file *f)
 	}
 #endif
 
+	if (set_zerocopy(td, f))
+		return 1;
+
 	reset_all_stats(td);
 	td_set_runstate(td, state);
 	return 0;
@@ -1446,6 +1738,38 @@ static int fio_netio_init(struct thread_data *td)
 
 	o->port += td->subjob_number;
 
+	if (o->zerocopy) {
+		struct netio_data *nd = td->io_ops_data;
+
+		if (nd->use_splice) {
+			log_err("fio: zerocopy not valid with netsplice\n");
+			return 1;
+		}
+		if (o->pingpong) {
+			log_err("fio: zerocopy not valid with pingpong\n");
+			return 1;
+		}
+		if (o->proto == FIO_TYPE_UNIX || is_vsock(o)) {
+			log_err("fio: zerocopy only valid for TCP or UDP\n");
+			return 1;
+		}
+
+		/*
+		 * Writes complete asynchronously once the kernel releases
+		 * the buffer, so allow them to queue up to iodepth.
+		 */
+		nd->zc_pending = calloc(td->o.iodepth, sizeof(*nd->zc_pending));
+		nd->zc_events = calloc(td->o.iodepth, sizeof(struct io_u *));
+		nd->zc_seq = calloc(td->o.nr_files, sizeof(*nd->zc_seq));
+		nd->zc_pfds = calloc(td->o.nr_files, sizeof(*nd->zc_pfds));
+		if (!nd->zc_pending || !nd->zc_events || !nd->zc_seq ||
+		    !nd->zc_pfds) {
+			log_err("fio: failed to allocate zerocopy state\n");
+			return 1;
+		}
+		td->flags &= ~((unsigned long long) FIO_SYNCIO << TD_ENG_FLAG_SHIFT);
+	}
+
 	if (!is_tcp(o) && !is_vsock(o)) {
 		if (o->listen) {
 			log_err("fio: listen only valid for TCP proto IO\n");
@@ -1483,6 +1807,10 @@ static void fio_netio_cleanup(struct thread_data *td)
 		if (nd->pipes[1] != -1)
 			close(nd->pipes[1]);
 
+		free(nd->zc_pending);
+		free(nd->zc_events);
+		free(nd->zc_seq);
+		free(nd->zc_pfds);
 		free(nd);
 	}
 }
@@ -1554,6 +1882,10 @@ static struct ioengine_ops ioengine_rw = {
 	.version		= FIO_IOOPS_VERSION,
 	.prep			= fio_netio_prep,
 	.queue			= fio_netio_queue,
+#ifdef CONFIG_NET_ZEROCOPY
+	.getevents		= fio_netio_getevents,
+	.event			= fio_netio_event,
+#endif
 	.setup			= fio_netio_setup,
 	.init			= fio_netio_init,
 	.cleanup		= fio_netio_cleanup,
@@ -173,7 +173,7 @@ static struct ioengine_ops ioengine = {
 	.init		= fio_null_init,
 	.cleanup	= fio_null_cleanup,
 	.open_file	= fio_null_open,
-	.flags		= FIO_DISKLESSIO | FIO_FAKEIO,
+	.flags		= FIO_DISKLESSIO | FIO_FAKEIO | FIO_EXT_WRITE_BUF,
 };
 
 static void fio_init fio_null_register(void)
@@ -5,6 +5,7 @@
  */
 
 #include "nvme.h"
+#include "../zbd.h"
 #include "../crc/crc-t10dif.h"
 #include "../crc/crc64.h"
 
@@ -361,6 +362,20 @@ void fio_nvme_uring_cmd_trim_prep(struct nvme_uring_cmd *cmd, struct io_u *io_u,
 	}
 }
 
+static void fio_nvme_uring_cmd_zone_mgmt_prep(struct nvme_uring_cmd *cmd,
+					      struct io_u *io_u)
+{
+	struct nvme_data *data = FILE_ENG_DATA(io_u->file);
+	__u64 slba = get_slba(data, io_u->offset);
+
+	cmd->opcode = nvme_zns_cmd_mgmt_send;
+	cmd->nsid = data->nsid;
+	cmd->cdw10 = slba & 0xffffffff;
+	cmd->cdw11 = slba >> 32;
+	cmd->cdw13 = io_u->ddir == DDIR_ZONE_RESET ? NVME_ZNS_ZSA_RESET :
+						     NVME_ZNS_ZSA_FINISH;
+}
+
 int fio_nvme_uring_cmd_prep(struct nvme_uring_cmd *cmd, struct io_u *io_u,
 			    struct iovec *iov, struct nvme_dsm *dsm,
 			    uint8_t read_opcode, uint8_t write_opcode,
@@ -378,6 +393,8 @@ int fio_nvme_uring_cmd_prep(struct nvme_uring_cmd *cmd, struct io_u *io_u,
 		break;
 	case DDIR_WRITE:
 		cmd->opcode = write_opcode;
+		if (io_u->flags & IO_U_F_ZONE_APPEND)
+			cmd->opcode = nvme_zns_cmd_append;
 		break;
 	case DDIR_TRIM:
 		fio_nvme_uring_cmd_trim_prep(cmd, io_u, dsm);
@@ -387,11 +404,19 @@ int fio_nvme_uring_cmd_prep(struct nvme_uring_cmd *cmd, struct io_u *io_u,
 		cmd->opcode = nvme_cmd_flush;
 		cmd->nsid = data->nsid;
 		return 0;
+	case DDIR_ZONE_RESET:
+	case DDIR_ZONE_FINISH:
+		fio_nvme_uring_cmd_zone_mgmt_prep(cmd, io_u);
+		return 0;
 	default:
 		return -ENOTSUP;
 	}
 
-	slba = get_slba(data, io_u->offset);
+	/* Zone appends are addressed to the start of the target zone */
+	if (io_u->flags & IO_U_F_ZONE_APPEND)
+		slba = get_slba(data, zbd_zone_start(io_u->file, io_u->offset));
+	else
+		slba = get_slba(data, io_u->offset);
 	nlb = get_nlb(data, io_u->xfer_buflen);
 
 	/* cdw10 and cdw11 represent starting lba */
@@ -844,6 +869,8 @@ int fio_nvme_reset_wp(struct thread_data *td, struct fio_file *f,
 		};
 
 		ret = ioctl(fd, NVME_IOCTL_IO_CMD, &cmd);
+		if (ret)
+			break;
 	}
 
 	if (f->fd < 0)
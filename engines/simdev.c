@@ -0,0 +1,521 @@
+/*
+ * simdev engine
+ *
+ * IO engine that doesn't transfer any data, but completes IO after a delay
+ * sampled from a simple device model. It's meant for testing fio behavior
+ * that depends on device timing (rate limiting, latency_target,
+ * steadystate, zbd) without real hardware.
+ *
+ * The model consists of:
+ *
+ * - a per data direction latency distribution
+ * - an optional IOPS and/or bandwidth cap, modeled as a device that
+ *   services one IO at a time at the capped rate
+ * - a queue depth penalty, where each IO already in flight adds a
+ *   percentage to the service time of a new one
+ * - periodic stalls (think garbage collection), where nothing completes
+ *   until the stall is over
+ *
+ * Pending IOs are kept on a hashed timer wheel, so queueing and reaping
+ * are O(1) per IO.
+ */
+#include <stdlib.h>
+#include <math.h>
+
+#include "../fio.h"
+#include "../optgroup.h"
+#include "../lib/rand.h"
+
+/*
+ * 4096 slots of 4.096 usec each, so one rotation covers ~16.7 msec. IOs
+ * that expire further out stay on their slot until a later rotation.
+ */
+#define SIMDEV_SLOT_SHIFT	12
+#define SIMDEV_WHEEL_SLOTS	4096
+#define SIMDEV_WHEEL_MASK	(SIMDEV_WHEEL_SLOTS - 1)
+
+enum {
+	SIMDEV_LAT_FIXED	= 0,
+	SIMDEV_LAT_UNIFORM,
+	SIMDEV_LAT_EXP,
+	SIMDEV_LAT_NORMAL,
+};
+
+struct simdev_options {
+	void *pad;
+	unsigned int lat_dist;
+	unsigned long long lat[DDIR_RWDIR_CNT];
+	unsigned long long lat_dev[DDIR_RWDIR_CNT];
+	unsigned int iops;
+	unsigned long long bw;
+	unsigned int qd_penalty;
+	unsigned long long gc_interval;
+	unsigned long long gc_duration;
+};
+
+struct simdev_io {
+	struct flist_head list;
+	struct io_u *io_u;
+	uint64_t expire;
+};
+
+struct simdev_data {
+	struct flist_head wheel[SIMDEV_WHEEL_SLOTS];
+	uint64_t cursor;
+	unsigned int nr_pending;
+
+	struct io_u **events;
+	unsigned int nr_events;
+
+	struct timespec epoch;
+	uint64_t busy_until;
+	struct frand_state rand;
+
+	uint64_t nr_gc_delayed;
+};
+
+static struct fio_option options[] = {
+	{
+		.name	= "simdev_lat_dist",
+		.lname	= "simdev latency distribution",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct simdev_options, lat_dist),
+		.help	= "Distribution of simulated IO latencies",
+		.def	= "fixed",
+		.posval = {
+			  { .ival = "fixed",
+			    .oval = SIMDEV_LAT_FIXED,
+			    .help = "Always use the mean latency",
+			  },
+			  { .ival = "uniform",
+			    .oval = SIMDEV_LAT_UNIFORM,
+			    .help = "Uniform within mean +/- simdev_lat_dev",
+			  },
+			  { .ival = "exponential",
+			    .oval = SIMDEV_LAT_EXP,
+			    .help = "Exponential with the given mean",
+			  },
+			  { .ival = "normal",
+			    .oval = SIMDEV_LAT_NORMAL,
+			    .help = "Normal with stddev simdev_lat_dev",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_lat",
+		.lname	= "simdev mean latency",
+		.type	= FIO_OPT_ULL,
+		.off1	= offsetof(struct simdev_options, lat[DDIR_READ]),
+		.off2	= offsetof(struct simdev_options, lat[DDIR_WRITE]),
+		.off3	= offsetof(struct simdev_options, lat[DDIR_TRIM]),
+		.help	= "Mean simulated IO latency (usec)",
+		.is_time = 1,
+		.def	= "100",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_lat_dev",
+		.lname	= "simdev latency deviation",
+		.type	= FIO_OPT_ULL,
+		.off1	= offsetof(struct simdev_options, lat_dev[DDIR_READ]),
+		.off2	= offsetof(struct simdev_options, lat_dev[DDIR_WRITE]),
+		.off3	= offsetof(struct simdev_options, lat_dev[DDIR_TRIM]),
+		.help	= "Spread of the simulated IO latency (usec)",
+		.is_time = 1,
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_iops",
+		.lname	= "simdev IOPS cap",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct simdev_options, iops),
+		.help	= "Maximum IOPS of the simulated device",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_bw",
+		.lname	= "simdev bandwidth cap",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct simdev_options, bw),
+		.help	= "Maximum bandwidth of the simulated device (bytes/sec)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_qd_penalty",
+		.lname	= "simdev queue depth penalty",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct simdev_options, qd_penalty),
+		.help	= "Latency increase per IO already in flight (percent)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_gc_interval",
+		.lname	= "simdev GC stall interval",
+		.type	= FIO_OPT_STR_VAL_TIME,
+		.off1	= offsetof(struct simdev_options, gc_interval),
+		.help	= "Time between simulated GC stalls (usec)",
+		.def	= "0",
+		.is_time = 1,
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "simdev_gc_duration",
+		.lname	= "simdev GC stall duration",
+		.type	= FIO_OPT_STR_VAL_TIME,
+		.off1	= offsetof(struct simdev_options, gc_duration),
+		.help	= "Duration of each simulated GC stall (usec)",
+		.def	= "0",
+		.is_time = 1,
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+static uint64_t simdev_now(struct simdev_data *sd)
+{
+	struct timespec now;
+
+	fio_gettime(&now, NULL);
+	return ntime_since(&sd->epoch, &now);
+}
+
+/*
+ * Sample a latency in nsec for the given data direction
+ */
+static uint64_t simdev_sample_lat(struct simdev_options *o,
+				  struct simdev_data *sd, enum fio_ddir ddir)
+{
+	double mean = (double) o->lat[ddir] * 1000.0;
+	double dev = (double) o->lat_dev[ddir] * 1000.0;
+	double u, v, lat;
+
+	switch (o->lat_dist) {
+	case SIMDEV_LAT_UNIFORM:
+		lat = mean - dev + 2.0 * dev * __rand_0_1(&sd->rand);
+		break;
+	case SIMDEV_LAT_EXP:
+		lat = -mean * log(1.0 - __rand_0_1(&sd->rand));
+		break;
+	case SIMDEV_LAT_NORMAL:
+		/* Box-Muller */
+		u = __rand_0_1(&sd->rand);
+		v = __rand_0_1(&sd->rand);
+		if (u < 1e-12)
+			u = 1e-12;
+		lat = mean + dev * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+		break;
+	case SIMDEV_LAT_FIXED:
+	default:
+		lat = mean;
+		break;
+	}
+
+	if (lat < 0.0)
+		return 0;
+
+	return (uint64_t) lat;
+}
+
+/*
+ * If 'expire' falls into a stall window, push it out to the end of it.
+ * Stall windows start at every multiple of the interval.
+ */
+static uint64_t simdev_gc_delay(struct simdev_options *o,
+				struct simdev_data *sd, uint64_t expire)
+{
+	uint64_t interval = o->gc_interval * 1000;
+	uint64_t duration = o->gc_duration * 1000;
+	uint64_t start;
+
+	if (!interval || !duration || expire < interval)
+		return expire;
+
+	start = expire - (expire % interval);
+	if (expire - start >= duration)
+		return expire;
+
+	sd->nr_gc_delayed++;
+	return start + duration;
+}
+
+static void simdev_wheel_add(struct simdev_data *sd, struct simdev_io *sio)
+{
+	uint64_t slot = sio->expire >> SIMDEV_SLOT_SHIFT;
+
+	if (slot < sd->cursor)
+		slot = sd->cursor;
+
+	flist_add_tail(&sio->list, &sd->wheel[slot & SIMDEV_WHEEL_MASK]);
+	sd->nr_pending++;
+}
+
+/*
+ * Move IOs that expired by 'now' to the event list, up to 'max' of them
+ */
+static void simdev_wheel_expire(struct simdev_data *sd, uint64_t now,
+				unsigned int max)
+{
+	uint64_t now_slot = now >> SIMDEV_SLOT_SHIFT;
+	unsigned int walked = 0;
+
+	if (!sd->nr_pending) {
+		sd->cursor = now_slot;
+		return;
+	}
+
+	while (sd->nr_events < max) {
+		struct flist_head *head = &sd->wheel[sd->cursor & SIMDEV_WHEEL_MASK];
+		struct flist_head *entry, *tmp;
+
+		flist_for_each_safe(entry, tmp, head) {
+			struct simdev_io *sio;
+
+			sio = flist_entry(entry, struct simdev_io, list);
+			if (sio->expire > now)
+				continue;
+
+			flist_del(&sio->list);
+			sd->nr_pending--;
+			sd->events[sd->nr_events++] = sio->io_u;
+			if (sd->nr_events == max)
+				return;
+		}
+
+		if (sd->cursor >= now_slot)
+			break;
+
+		/*
+		 * After a full rotation, every slot has been checked
+		 * against 'now', so the cursor can catch up directly.
+		 */
+		if (++walked == SIMDEV_WHEEL_SLOTS) {
+			sd->cursor = now_slot;
+			break;
+		}
+		sd->cursor++;
+	}
+}
+
+/*
+ * Earliest time anything on the wheel can expire
+ */
+static uint64_t simdev_wheel_next(struct simdev_data *sd)
+{
+	unsigned int i;
+
+	for (i = 0; i < SIMDEV_WHEEL_SLOTS; i++) {
+		uint64_t slot = sd->cursor + i;
+
+		if (!flist_empty(&sd->wheel[slot & SIMDEV_WHEEL_MASK]))
+			return slot << SIMDEV_SLOT_SHIFT;
+	}
+
+	return (sd->cursor + SIMDEV_WHEEL_SLOTS) << SIMDEV_SLOT_SHIFT;
+}
+
+static enum fio_q_status fio_simdev_queue(struct thread_data *td,
+					  struct io_u *io_u)
+{
+	struct simdev_options *o = td->eo;
+	struct simdev_data *sd = td->io_ops_data;
+	struct simdev_io *sio = io_u->engine_data;
+	uint64_t now, lat, svc, start, expire;
+	struct timespec ts;
+
+	fio_ro_check(td, io_u);
+
+	if (!ddir_rw(io_u->ddir) && io_u->ddir != DDIR_TRIM)
+		return FIO_Q_COMPLETED;
+
+	/*
+	 * The simulated latency starts now, so that's the issue time too.
+	 * If fio stamped it after we return, the reported completion
+	 * latency would come up short of the modeled one.
+	 */
+	fio_gettime(&ts, NULL);
+	if (fio_fill_issue_time(td))
+		memcpy(&io_u->issue_time, &ts, sizeof(ts));
+	now = ntime_since(&sd->epoch, &ts);
+
+	lat = simdev_sample_lat(o, sd, io_u->ddir);
+	if (o->qd_penalty)
+		lat += lat * o->qd_penalty * sd->nr_pending / 100;
+
+	/*
+	 * The throughput cap is modeled as a device that services one IO
+	 * at a time, each taking the larger of its IOPS and bandwidth time.
+	 */
+	svc = 0;
+	if (o->iops)
+		svc = 1000000000ULL / o->iops;
+	if (o->bw) {
+		uint64_t bw_svc = io_u->xfer_buflen * 1000000000ULL / o->bw;
+
+		if (bw_svc > svc)
+			svc = bw_svc;
+	}
+
+	expire = now + lat;
+	if (svc) {
+		start = max(now, sd->busy_until);
+		sd->busy_until = start + svc;
+		if (sd->busy_until > expire)
+			expire = sd->busy_until;
+	}
+
+	sio->expire = simdev_gc_delay(o, sd, expire);
+	simdev_wheel_add(sd, sio);
+	return FIO_Q_QUEUED;
+}
+
+static int fio_simdev_getevents(struct thread_data *td, unsigned int min,
+				unsigned int max, const struct timespec *t)
+{
+	struct simdev_data *sd = td->io_ops_data;
+	uint64_t now, next, deadline = -1ULL;
+
+	sd->nr_events = 0;
+
+	now = simdev_now(sd);
+	if (t)
+		deadline = now + t->tv_sec * 1000000000ULL + t->tv_nsec;
+
+	do {
+		simdev_wheel_expire(sd, now, max);
+		if (sd->nr_events >= min || !sd->nr_pending)
+			break;
+
+		next = simdev_wheel_next(sd);
+		if (next > deadline)
+			next = deadline;
+		if (next > now)
+			usec_sleep(td, (next - now + 999) / 1000);
+
+		now = simdev_now(sd);
+	} while (now < deadline && !td->terminate);
+
+	return sd->nr_events;
+}
+
+static struct io_u *fio_simdev_event(struct thread_data *td, int event)
+{
+	struct simdev_data *sd = td->io_ops_data;
+
+	return sd->events[event];
+}
+
+static int fio_simdev_io_u_init(struct thread_data *td, struct io_u *io_u)
+{
+	struct simdev_io *sio;
+
+	sio = calloc(1, sizeof(*sio));
+	if (!sio)
+		return 1;
+
+	INIT_FLIST_HEAD(&sio->list);
+	sio->io_u = io_u;
+	io_u->engine_data = sio;
+	return 0;
+}
+
+static void fio_simdev_io_u_free(struct thread_data *td, struct io_u *io_u)
+{
+	free(io_u->engine_data);
+	io_u->engine_data = NULL;
+}
+
+static int fio_simdev_open(struct thread_data fio_unused *td,
+			   struct fio_file fio_unused *f)
+{
+	return 0;
+}
+
+static void fio_simdev_cleanup(struct thread_data *td)
+{
+	struct simdev_data *sd = td->io_ops_data;
+
+	if (sd) {
+		if (sd->nr_gc_delayed)
+			log_info("fio: %s: simdev delayed %llu IOs for GC "
+				 "stalls\n", td->o.name,
+				 (unsigned long long) sd->nr_gc_delayed);
+		free(sd->events);
+		free(sd);
+	}
+}
+
+static int fio_simdev_init(struct thread_data *td)
+{
+	struct simdev_options *o = td->eo;
+	struct simdev_data *sd;
+	int i;
+
+	if (o->gc_duration && o->gc_duration >= o->gc_interval) {
+		log_err("fio: simdev_gc_duration must be smaller than "
+			"simdev_gc_interval\n");
+		return 1;
+	}
+
+	sd = calloc(1, sizeof(*sd));
+	if (!sd)
+		return 1;
+
+	for (i = 0; i < SIMDEV_WHEEL_SLOTS; i++)
+		INIT_FLIST_HEAD(&sd->wheel[i]);
+
+	sd->events = calloc(td->o.iodepth, sizeof(struct io_u *));
+	if (!sd->events) {
+		free(sd);
+		return 1;
+	}
+
+	init_rand_seed(&sd->rand, td->rand_seeds[FIO_RAND_BLOCK_OFF] ^
+			0x73696d646576ULL, td->o.random_generator ==
+			FIO_RAND_GEN_TAUSWORTHE64);
+	fio_gettime(&sd->epoch, NULL);
+
+	td->io_ops_data = sd;
+	return 0;
+}
+
+static struct ioengine_ops ioengine = {
+	.name		= "simdev",
+	.version	= FIO_IOOPS_VERSION,
+	.init		= fio_simdev_init,
+	.queue		= fio_simdev_queue,
+	.getevents	= fio_simdev_getevents,
+	.event		= fio_simdev_event,
+	.cleanup	= fio_simdev_cleanup,
+	.open_file	= fio_simdev_open,
+	.io_u_init	= fio_simdev_io_u_init,
+	.io_u_free	= fio_simdev_io_u_free,
+	.flags		= FIO_DISKLESSIO | FIO_FAKEIO |
+			  FIO_ASYNCIO_SETS_ISSUE_TIME,
+	.options	= options,
+	.option_struct_size = sizeof(struct simdev_options),
+};
+
+static void fio_init fio_simdev_register(void)
+{
+	register_ioengine(&ioengine);
+}
+
+static void fio_exit fio_simdev_unregister(void)
+{
+	unregister_ioengine(&ioengine);
+}
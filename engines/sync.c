@@ -426,7 +426,7 @@ static struct ioengine_ops ioengine_rw = {
 	.open_file	= generic_open_file,
 	.close_file	= generic_close_file,
 	.get_file_size	= generic_get_file_size,
-	.flags		= FIO_SYNCIO,
+	.flags		= FIO_SYNCIO | FIO_EXT_WRITE_BUF,
 };
 
 static struct ioengine_ops ioengine_prw = {
@@ -436,7 +436,7 @@ static struct ioengine_ops ioengine_prw = {
 	.open_file	= generic_open_file,
 	.close_file	= generic_close_file,
 	.get_file_size	= generic_get_file_size,
-	.flags		= FIO_SYNCIO,
+	.flags		= FIO_SYNCIO | FIO_EXT_WRITE_BUF,
 };
 
 static struct ioengine_ops ioengine_vrw = {
@@ -451,7 +451,7 @@ static struct ioengine_ops ioengine_vrw = {
 	.open_file	= generic_open_file,
 	.close_file	= generic_close_file,
 	.get_file_size	= generic_get_file_size,
-	.flags		= FIO_SYNCIO,
+	.flags		= FIO_SYNCIO | FIO_EXT_WRITE_BUF,
 };
 
 #ifdef CONFIG_PWRITEV
@@ -464,7 +464,7 @@ static struct ioengine_ops ioengine_pvrw = {
 	.open_file	= generic_open_file,
 	.close_file	= generic_close_file,
 	.get_file_size	= generic_get_file_size,
-	.flags		= FIO_SYNCIO,
+	.flags		= FIO_SYNCIO | FIO_EXT_WRITE_BUF,
 };
 #endif
 
@@ -479,7 +479,7 @@ static struct ioengine_ops ioengine_pvrw2 = {
 	.close_file	= generic_close_file,
 	.get_file_size	= generic_get_file_size,
 	.flags		= FIO_SYNCIO |
-			  FIO_ATOMICWRITES,
+			  FIO_ATOMICWRITES | FIO_EXT_WRITE_BUF,
 	.options	= options,
 	.option_struct_size	= sizeof(struct psyncv2_options),
 };
@@ -12,6 +12,7 @@
 
 /* Forward declarations */
 struct zoned_block_device_info;
+struct zbd_emu;
 struct fdp_ruh_info;
 
 /*
@@ -104,14 +105,21 @@ struct fio_file {
 
 	struct fio_ruhs_info *ruhs_info;
 	struct fio_ruhs_scheme *ruhs_scheme;
+	/* Emulated data placement device state, see also dp_emulation. */
+	struct dp_emu *dp_emu;
 
 	/*
 	 * Zoned block device information. See also zonemode=zbd.
 	 */
 	struct zoned_block_device_info *zbd_info;
+	/* Emulated zoned block device state, see also zone_emulation. */
+	struct zbd_emu *zbd_emu;
 	/* zonemode=zbd working area */
 	uint32_t min_zone;	/* inclusive */
 	uint32_t max_zone;	/* exclusive */
+	/* zones marked by zbd_reset_zones() that still need a reset */
+	uint32_t zbd_reset_next;
+	uint32_t zbd_reset_end;
 
 	/*
 	 * Track last end and last start of IO for a given data direction
@@ -155,6 +163,9 @@ struct fio_file {
 		struct fio_lfsr lfsr;
 	};
 
+	/* Verify write history, see init_verify_map() */
+	struct verify_map *verify_map;
+
 	/*
 	 * Used for zipf random distribution
 	 */
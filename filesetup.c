@@ -1593,6 +1593,10 @@ void fio_file_free(struct fio_file *f)
 {
 	if (fio_file_axmap(f))
 		axmap_free(f->io_axmap);
+	if (f->verify_map) {
+		free(f->verify_map->journal);
+		free(f->verify_map);
+	}
 	if (f->ruhs_info)
 		sfree(f->ruhs_info);
 	if (!fio_file_smalloc(f)) {
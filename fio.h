@@ -70,6 +70,7 @@
 #endif
 
 struct fio_sem;
+struct verify_journal;
 
 #define MAX_TRIM_RANGE	256
 
@@ -210,6 +211,7 @@ struct thread_data {
 	struct io_log *slat_log;
 	struct io_log *clat_log;
 	struct io_log *clat_hist_log;
+	struct pct_log *pct_log;
 	struct io_log *lat_log;
 	struct io_log *bw_log;
 	struct io_log *iops_log;
@@ -284,8 +286,11 @@ struct thread_data {
 	struct frand_state prio_state;
 	struct frand_state dedupe_working_set_index_state;
 	struct frand_state *dedupe_working_set_states;
+	struct dedupe_cache *dedupe_cache;
+	struct content_pool *content_pool;
 
 	unsigned long long num_unique_pages;
+	unsigned long long dedupe_working_set_index;	/* of the last dedupe hit */
 
 	struct zone_split_index **zone_state_index;
 	unsigned int num_write_zones;
@@ -338,6 +343,14 @@ struct thread_data {
 	pthread_mutex_t io_u_lock;
 	pthread_cond_t free_cond;
 
+	/*
+	 * In-flight io_u ranges, if serialize_overlap is set. Those that are
+	 * not on the tree are counted, in_flight_overlap() scans all io_us
+	 * while there are any.
+	 */
+	struct prio_tree_root io_u_overlap_tree;
+	unsigned int io_u_overlap_scan;
+
 	/*
 	 * async verify offload
 	 */
@@ -347,6 +360,11 @@ struct thread_data {
 	pthread_cond_t verify_cond;
 	int verify_thread_exit;
 
+	/*
+	 * Journal of acknowledged writes and flushes, see verify_journal
+	 */
+	struct verify_journal *vjournal;
+
 	/*
 	 * Rate state
 	 */
@@ -421,6 +439,22 @@ struct thread_data {
 	uint64_t latency_ios;
 	int latency_end_run;
 
+	/*
+	 * lat_outliers state for the current window: how full its heap is,
+	 * the latency an I/O must beat to get in, and when the window ends
+	 */
+	unsigned int lat_outliers_cur;
+	unsigned int lat_outliers_fill;
+	unsigned long long lat_outliers_min;
+	bool lat_outliers_timed;
+	struct timespec lat_outliers_end;
+
+	/*
+	 * file_stats counters, indexed by fileno
+	 */
+	struct file_stat *file_stats;
+	unsigned int nr_file_stats;
+
 	/*
 	 * read/write mixed workload state
 	 */
@@ -933,7 +967,7 @@ enum {
 extern void exec_trigger(const char *);
 extern void check_trigger_file(void);
 
-extern bool in_flight_overlap(struct io_u_queue *q, struct io_u *io_u);
+extern bool in_flight_overlap(struct thread_data *td, struct io_u *io_u);
 extern pthread_mutex_t overlap_check;
 
 static inline void *fio_memalign(size_t alignment, size_t size, bool shared)
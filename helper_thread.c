@@ -343,6 +343,7 @@ static void *helper_thread_main(void *data)
 		next_log = calc_log_samples();
 		if (!next_log)
 			next_log = DISK_UTIL_MSEC;
+		next_log = min_not_zero(next_log, calc_pct_log_samples());
 
 		msec_to_next_event = min(next_log, msec_to_next_event);
 		dprint(FD_HELPERTHREAD,
@@ -358,6 +359,7 @@ static void *helper_thread_main(void *data)
 		timerfd = -1;
 	}
 
+	pct_log_exit();
 	fio_writeout_logs(false);
 
 	sk_out_drop();
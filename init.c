@@ -858,6 +858,70 @@ static int fixup_options(struct thread_data *td)
 			o->verify_write_sequence = 0;
 	}
 
+	/*
+	 * Streaming verify regenerates the blocks the job wrote from its
+	 * random state, rather than logging every write. That only holds if
+	 * the offsets replay exactly and no block is written twice in a pass.
+	 */
+	if (o->verify_streaming && td_write(td) && o->verify != VERIFY_NONE) {
+		if (td_read(td) || td_trim(td) || o->trim_percentage) {
+			log_err("fio: verify_streaming needs a write only job\n");
+			ret |= 1;
+		}
+		if (td_random(td) &&
+		    (o->random_generator != FIO_RAND_GEN_LFSR ||
+		     o->random_distribution != FIO_RAND_DIST_RANDOM ||
+		     o->perc_rand[DDIR_WRITE] != 100 ||
+		     o->min_bs[DDIR_WRITE] != o->max_bs[DDIR_WRITE])) {
+			log_err("fio: verify_streaming needs sequential writes or uniform LFSR offsets with a fixed block size\n");
+			ret |= 1;
+		}
+		if (!o->rand_repeatable) {
+			log_err("fio: verify_streaming needs randrepeat\n");
+			ret |= 1;
+		}
+		if (o->time_based || o->number_ios ||
+		    (o->io_size && o->size && o->io_size > o->size)) {
+			log_err("fio: verify_streaming cannot verify blocks that are overwritten\n");
+			ret |= 1;
+		}
+		if (o->verify_backlog || o->verify_journal ||
+		    o->zone_mode != ZONE_MODE_NONE || o->zone_append ||
+		    o->io_submit_mode == IO_MODE_OFFLOAD ||
+		    (o->continue_on_error & ERROR_TYPE_WRITE)) {
+			log_err("fio: verify_streaming does not support verify_backlog, verify_journal, zones, offloaded I/O or ignored write errors\n");
+			ret |= 1;
+		}
+
+		/*
+		 * The replay itself is the one experimental_verify does
+		 */
+		o->experimental_verify = 1;
+	}
+
+	/*
+	 * Checking a verify journal needs a header in every block and goes
+	 * through the verify map
+	 */
+	if (o->verify_journal && td_write(td)) {
+		if (o->verify == VERIFY_NONE || o->verify == VERIFY_NULL ||
+		    o->verify == VERIFY_PATTERN_NO_HDR ||
+		    (o->verify_only && !o->do_verify)) {
+			log_err("fio: verify_journal needs verify with headers\n");
+			ret |= 1;
+		}
+		if (o->min_bs[DDIR_WRITE] != o->max_bs[DDIR_WRITE]) {
+			log_err("fio: verify_journal needs a fixed write block size\n");
+			ret |= 1;
+		}
+		if (o->verify_backlog || o->trim_percentage ||
+		    o->experimental_verify || o->zone_mode == ZONE_MODE_ZBD ||
+		    o->zone_append || o->io_submit_mode == IO_MODE_OFFLOAD) {
+			log_err("fio: verify_journal does not support verify_backlog, trims, zoned block devices or offloaded I/O\n");
+			ret |= 1;
+		}
+	}
+
 	if (td->o.oatomic) {
 		if (!td_ioengine_flagged(td, FIO_ATOMICWRITES)) {
 			log_err("fio: engine does not support atomic writes\n");
@@ -1011,6 +1075,23 @@ static int fixup_options(struct thread_data *td)
 		}
 	}
 
+	/*
+	 * Writes from a content pool don't carry verify headers, and the
+	 * pool lives in host memory
+	 */
+	if (o->buffer_pool_size || o->buffer_pool_file) {
+		if (o->verify != VERIFY_NONE) {
+			log_err("fio: buffer_pool_size and buffer_pool_file "
+					"do not support verify\n");
+			ret |= 1;
+		}
+		if (o->mem_type == MEM_CUDA_MALLOC) {
+			log_err("fio: buffer_pool_size and buffer_pool_file "
+					"do not support mem=cudamalloc\n");
+			ret |= 1;
+		}
+	}
+
 	for_each_td(td2) {
 		if (td->o.ss_check_interval != td2->o.ss_check_interval) {
 			log_err("fio: conflicting ss_check_interval: %llu and %llu, must be globally equal\n",
@@ -1038,6 +1119,11 @@ static int fixup_options(struct thread_data *td)
 			td->o.dp_type = FIO_DP_FDP;
 		}
 	}
+
+	if (td->o.dp_emu && td->o.dp_type == FIO_DP_NONE) {
+		log_err("fio: dp_emulation requires dataplacement={fdp, streams}\n");
+		ret |= 1;
+	}
 	return ret;
 }
 
@@ -1638,6 +1724,7 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_issue_time = o->log_issue_time,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_gz_type = o->log_gz_type,
 		};
 		const char *pre = make_log_name(o->lat_log_file, o->name);
 		const char *suf;
@@ -1687,6 +1774,7 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_issue_time = o->log_issue_time,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_gz_type = o->log_gz_type,
 		};
 		const char *pre = make_log_name(o->hist_log_file, o->name);
 		const char *suf;
@@ -1720,6 +1808,7 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_issue_time = o->log_issue_time,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_gz_type = o->log_gz_type,
 		};
 		const char *pre = make_log_name(o->bw_log_file, o->name);
 		const char *suf;
@@ -1753,6 +1842,7 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_issue_time = o->log_issue_time,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_gz_type = o->log_gz_type,
 		};
 		const char *pre = make_log_name(o->iops_log_file, o->name);
 		const char *suf;
@@ -1774,6 +1864,50 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 				td->thread_number, suf, o->per_job_logs);
 		setup_log(&td->iops_log, &p, logname);
 	}
+	if (o->lat_outliers) {
+		if (o->disable_lat) {
+			log_err("fio: lat_outliers requires disable_lat=0\n");
+			goto err;
+		}
+		if (init_lat_outliers(td))
+			goto err;
+	}
+	if (o->lat_heatmap) {
+		if (o->disable_clat) {
+			log_err("fio: lat_heatmap requires disable_clat=0\n");
+			goto err;
+		}
+		if (o->lat_heatmap_region_nz && o->zone_mode == ZONE_MODE_NONE) {
+			log_err("fio: lat_heatmap_region in zones requires a zonemode\n");
+			goto err;
+		}
+	}
+	if (o->file_stats && o->disable_clat) {
+		log_err("fio: file_stats requires disable_clat=0\n");
+		goto err;
+	}
+	if (o->clat_depth_hist) {
+		if (o->disable_clat) {
+			log_err("fio: clat_depth_hist requires disable_clat=0\n");
+			goto err;
+		}
+		if (init_clat_depth(&td->ts))
+			goto err;
+	}
+	if (o->write_pct_log) {
+		const char *pre = make_log_name(o->pct_log_file, o->name);
+
+		if (!o->clat_percentiles && !o->lat_percentiles) {
+			log_err("fio: write_pct_log requires clat_percentiles or lat_percentiles\n");
+			goto err;
+		}
+
+		gen_log_name(logname, sizeof(logname),
+				o->lat_percentiles ? "lat_pct" : "clat_pct",
+				pre, td->thread_number, "log", o->per_job_logs);
+		if (pct_log_init(td, logname))
+			goto err;
+	}
 
 	if (!o->name)
 		o->name = strdup(jobname);
@@ -9,6 +9,8 @@ enum fio_ddir {
 	DDIR_DATASYNC,
 	DDIR_SYNC_FILE_RANGE,
 	DDIR_WAIT,
+	DDIR_ZONE_RESET,
+	DDIR_ZONE_FINISH,
 	DDIR_LAST,
 	DDIR_INVAL = -1,
 	DDIR_TIMEOUT = -2,
@@ -23,7 +25,7 @@ static inline const char *io_ddir_name(enum fio_ddir ddir)
 {
 	static const char *name[] = { "read", "write", "trim", "sync",
 					"datasync", "sync_file_range",
-					"wait", };
+					"wait", "zone_reset", "zone_finish", };
 
 	if (ddir >= 0 && ddir < DDIR_LAST)
 		return name[ddir];
@@ -62,6 +64,11 @@ static inline int ddir_sync(enum fio_ddir ddir)
 	       ddir == DDIR_SYNC_FILE_RANGE;
 }
 
+static inline int ddir_zone_mgmt(enum fio_ddir ddir)
+{
+	return ddir == DDIR_ZONE_RESET || ddir == DDIR_ZONE_FINISH;
+}
+
 static inline int ddir_rw(enum fio_ddir ddir)
 {
 	return ddir == DDIR_READ || ddir == DDIR_WRITE || ddir == DDIR_TRIM;
@@ -11,6 +11,8 @@
 #include "lib/pow2.h"
 #include "minmax.h"
 #include "zbd.h"
+#include "verify-journal.h"
+#include "content-pool.h"
 
 struct io_completion_data {
 	int nr;				/* input */
@@ -871,10 +873,78 @@ void put_io_u(struct thread_data *td, struct io_u *io_u)
 
 void clear_io_u(struct thread_data *td, struct io_u *io_u)
 {
+	io_u_overlap_del(td, io_u);
 	io_u_clear(td, io_u, IO_U_F_FLIGHT);
 	put_io_u(td, io_u);
 }
 
+/*
+ * Track the range of an io_u while it is in flight, so that
+ * in_flight_overlap() does not have to look at every io_u of the job. The
+ * tree belongs to the job that owns the io_u, in offload mode other jobs
+ * look at it with overlap_check held.
+ */
+void io_u_overlap_add(struct thread_data *td, struct io_u *io_u)
+{
+	struct thread_data *owner = td->parent ? td->parent : td;
+	struct prio_tree_node *n = &io_u->overlap_node;
+
+	if (!io_u->buflen)
+		return;
+
+	/*
+	 * The tree indexes unsigned long ranges, which cannot hold offsets
+	 * beyond 4GiB on 32-bit platforms. It also cannot hold two io_us
+	 * covering the exact same range, which are only in flight together
+	 * if queued without checking for overlap. Such io_us are left to a
+	 * scan of all io_us.
+	 */
+	if (sizeof(unsigned long) >= sizeof(uint64_t)) {
+		INIT_PRIO_TREE_NODE(n);
+		n->start = io_u->offset;
+		n->last = io_u->offset + io_u->buflen - 1;
+
+		if (prio_tree_insert(&owner->io_u_overlap_tree, n) == n) {
+			io_u_set(td, io_u, IO_U_F_OVERLAP);
+			return;
+		}
+	}
+
+	owner->io_u_overlap_scan++;
+	io_u_set(td, io_u, IO_U_F_OVERLAP_SCAN);
+}
+
+void io_u_overlap_del(struct thread_data *td, struct io_u *io_u)
+{
+	struct thread_data *owner = td->parent ? td->parent : td;
+	int res;
+
+	if (!(io_u->flags & (IO_U_F_OVERLAP | IO_U_F_OVERLAP_SCAN)))
+		return;
+
+	if (td_offload_overlap(td)) {
+		res = pthread_mutex_lock(&overlap_check);
+		if (fio_unlikely(res != 0)) {
+			log_err("failed to lock overlap check mutex, err: %i:%s", errno, strerror(errno));
+			abort();
+		}
+	}
+
+	if (io_u->flags & IO_U_F_OVERLAP)
+		prio_tree_remove(&owner->io_u_overlap_tree, &io_u->overlap_node);
+	else
+		owner->io_u_overlap_scan--;
+	io_u_clear(td, io_u, IO_U_F_OVERLAP | IO_U_F_OVERLAP_SCAN);
+
+	if (td_offload_overlap(td)) {
+		res = pthread_mutex_unlock(&overlap_check);
+		if (fio_unlikely(res != 0)) {
+			log_err("failed to unlock overlap check mutex, err: %i:%s", errno, strerror(errno));
+			abort();
+		}
+	}
+}
+
 void requeue_io_u(struct thread_data *td, struct io_u **io_u)
 {
 	const bool needs_lock = td_async_processing(td);
@@ -893,6 +963,7 @@ void requeue_io_u(struct thread_data *td, struct io_u **io_u)
 	if ((__io_u->flags & IO_U_F_FLIGHT) && ddir_rw(ddir))
 		td->io_issues[ddir]--;
 
+	io_u_overlap_del(td, __io_u);
 	io_u_clear(td, __io_u, IO_U_F_FLIGHT);
 	if (__io_u->flags & IO_U_F_IN_CUR_DEPTH) {
 		td->cur_depth--;
@@ -1063,6 +1134,9 @@ static int fill_io_u(struct thread_data *td, struct io_u *io_u)
 			dprint(FD_IO, "zbd_adjust_block() returned io_u_eof\n");
 			return 1;
 		}
+		/* or into a zone reset */
+		if (!ddir_rw(io_u->ddir))
+			goto out;
 	}
 
 	if (td->o.dp_type != FIO_DP_NONE)
@@ -1085,7 +1159,9 @@ static int fill_io_u(struct thread_data *td, struct io_u *io_u)
 out:
 	if (!multi_range_trim(td, io_u))
 		dprint_io_u(io_u, "fill");
-	io_u->verify_offset = io_u->offset;
+	/* zbd_adjust_block() may have turned this into a verify read */
+	if (!(io_u->flags & IO_U_F_VER_LIST))
+		io_u->verify_offset = io_u->offset;
 	td->zone_bytes += io_u->buflen;
 	return 0;
 }
@@ -1717,7 +1793,9 @@ again:
 		assert(io_u->flags & IO_U_F_FREE);
 		io_u_clear(td, io_u, IO_U_F_FREE | IO_U_F_NO_FILE_PUT |
 				 IO_U_F_TRIMMED | IO_U_F_BARRIER |
-				 IO_U_F_VER_LIST);
+				 IO_U_F_VER_LIST | IO_U_F_ZONE_APPEND |
+				 IO_U_F_ZONE_PLACED | IO_U_F_VER_MAP |
+				 IO_U_F_VER_JOURNAL);
 
 		io_u->error = 0;
 		io_u->acct_ddir = -1;
@@ -1850,6 +1928,7 @@ struct io_u *get_io_u(struct thread_data *td)
 {
 	struct fio_file *f;
 	struct io_u *io_u;
+	void *ext_buf = NULL;
 	int do_scramble = 0;
 	long ret = 0;
 
@@ -1900,8 +1979,14 @@ struct io_u *get_io_u(struct thread_data *td)
 		f->last_pos[io_u->ddir] = io_u->offset + io_u->buflen;
 
 		if (io_u->ddir == DDIR_WRITE) {
-			if (td->flags & TD_F_REFILL_BUFFERS) {
-				io_u_fill_buffer(td, io_u,
+			if (td->content_pool) {
+				ext_buf = content_pool_get(td, io_u->buflen);
+				if (!td_ioengine_flagged(td, FIO_EXT_WRITE_BUF)) {
+					memcpy(io_u->buf, ext_buf, io_u->buflen);
+					ext_buf = NULL;
+				}
+			} else if (td->flags & TD_F_REFILL_BUFFERS) {
+				ext_buf = io_u_fill_write_buffer(td, io_u,
 					td->o.min_bs[DDIR_WRITE],
 					io_u->buflen);
 			} else if ((td->flags & TD_F_SCRAMBLE_BUFFERS) &&
@@ -1921,7 +2006,7 @@ struct io_u *get_io_u(struct thread_data *td)
 	/*
 	 * Set io data pointers.
 	 */
-	io_u->xfer_buf = io_u->buf;
+	io_u->xfer_buf = ext_buf ? ext_buf : io_u->buf;
 	io_u->xfer_buflen = io_u->buflen;
 
 	/*
@@ -1999,6 +2084,25 @@ static void trim_block_info(struct thread_data *td, struct io_u *io_u)
 	*info = BLOCK_INFO(BLOCK_STATE_TRIMMED, BLOCK_INFO_TRIMS(*info) + 1);
 }
 
+/*
+ * An I/O is only worth a closer look for lat_outliers if it is slower than
+ * the fastest one kept for the current window, or if that window is over.
+ */
+static inline bool lat_outlier_candidate(struct thread_data *td,
+					 const struct timespec *now,
+					 unsigned long long nsec)
+{
+	const struct timespec *end = &td->lat_outliers_end;
+
+	if (nsec > td->lat_outliers_min)
+		return true;
+	if (!td->lat_outliers_timed)
+		return false;
+
+	return now->tv_sec > end->tv_sec ||
+		(now->tv_sec == end->tv_sec && now->tv_nsec >= end->tv_nsec);
+}
+
 static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 				  struct io_completion_data *icd,
 				  const enum fio_ddir idx, unsigned int bytes)
@@ -2021,6 +2125,10 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 		tnsec = ntime_since(&io_u->start_time, &icd->time);
 		add_lat_sample(td, idx, tnsec, bytes, io_u);
 
+		if (td->ts.lat_outliers && ddir_rw(idx) &&
+		    lat_outlier_candidate(td, &icd->time, tnsec))
+			add_lat_outlier(td, io_u, idx, &icd->time, tnsec);
+
 		if (td->flags & TD_F_PROFILE_OPS) {
 			struct prof_io_ops *ops = &td->prof_io_ops;
 
@@ -2042,8 +2150,19 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 		if (!td->o.disable_clat) {
 			add_clat_sample(td, idx, llnsec, bytes, io_u);
 			io_u_mark_latency(td, llnsec);
+			if (td->ts.lat_heatmap)
+				add_lat_heatmap_sample(&td->ts, io_u->offset,
+						       llnsec);
+			if (td->file_stats && io_u->file)
+				add_file_stat(td, io_u->file, bytes, llnsec);
+			if (td->ts.clat_depth)
+				add_clat_depth_sample(&td->ts, idx,
+						      io_u->submit_depth, llnsec);
 		}
 
+		if (io_u->dtype)
+			add_dp_sample(td, io_u->dspec, llnsec, bytes);
+
 		if (!td->o.disable_bw && per_unit_log(td->bw_log))
 			add_bw_sample(td, io_u, bytes, llnsec);
 
@@ -2051,6 +2170,9 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 			add_iops_sample(td, io_u, bytes);
 	} else if (ddir_sync(idx) && !td->o.disable_clat)
 		add_sync_clat_sample(&td->ts, llnsec);
+	else if (ddir_zone_mgmt(idx) && !td->o.disable_clat)
+		add_zone_mgmt_sample(&td->ts, idx == DDIR_ZONE_RESET ?
+				     FIO_ZONE_RESET : FIO_ZONE_FINISH, llnsec);
 
 	if (td->ts.nr_block_infos && io_u->ddir == DDIR_TRIM)
 		trim_block_info(td, io_u);
@@ -2094,6 +2216,7 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 	dprint_io_u(io_u, "complete");
 
 	assert(io_u->flags & IO_U_F_FLIGHT);
+	io_u_overlap_del(td, io_u);
 	io_u_clear(td, io_u, IO_U_F_FLIGHT | IO_U_F_BUSY_OK | IO_U_F_PATTERN_DONE);
 
 	/*
@@ -2106,14 +2229,32 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 		if (io_u->error)
 			unlog_io_piece(td, io_u);
 		else {
+			if (io_u->flags & IO_U_F_ZONE_APPEND)
+				place_io_piece(td, io_u);
 			atomic_store_release(&io_u->ipo->flags,
 					io_u->ipo->flags & ~IP_F_IN_FLIGHT);
 		}
+	} else if (io_u->flags & IO_U_F_VER_MAP) {
+		if (io_u->error)
+			unlog_io_piece(td, io_u);
+		else
+			verify_map_complete(td, io_u);
+	}
+
+	if (ddir_zone_mgmt(ddir)) {
+		zbd_end_zone_mgmt(td, io_u);
+		if (io_u->error)
+			goto error;
+		if (should_account(td))
+			account_io_completion(td, io_u, icd, ddir, 0);
+		return;
 	}
 
 	if (ddir_sync(ddir)) {
 		if (io_u->error)
 			goto error;
+		if (td->vjournal)
+			verify_journal_flush(td, io_u, true);
 		if (f) {
 			f->first_write = -1ULL;
 			f->last_write = -1ULL;
@@ -2152,8 +2293,13 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 			td->this_io_bytes[ddir] += bytes;
 		}
 
-		if (ddir == DDIR_WRITE)
+		if (ddir == DDIR_WRITE) {
 			file_log_write_comp(td, f, io_u->offset, bytes);
+			if (td->vjournal)
+				verify_journal_write(td, io_u);
+		}
+		if (f->dp_emu && ddir != DDIR_READ)
+			dp_emu_io_u(td, io_u, bytes);
 
 		if (should_account(td))
 			account_io_completion(td, io_u, icd, ddir, bytes);
@@ -2309,23 +2455,32 @@ void io_u_queued(struct thread_data *td, struct io_u *io_u)
 }
 
 /*
- * See if we should reuse the last seed, if dedupe is enabled
+ * See if we should reuse the last seed, if dedupe is enabled. Only buffers
+ * filled for a write count towards the achieved dedupe, not those filled
+ * to lay out files or to initialize the io_us.
  */
-static struct frand_state *get_buf_state(struct thread_data *td)
+static struct frand_state *get_buf_state(struct thread_data *td, bool write)
 {
 	unsigned int v;
 	unsigned long long i;
 
 	if (!td->o.dedupe_percentage)
 		return &td->buf_state;
-	else if (td->o.dedupe_percentage == 100) {
+
+	if (write)
+		td->ts.dedupe_bufs++;
+	if (td->o.dedupe_percentage == 100) {
+		if (write)
+			td->ts.dedupe_dup_bufs++;
 		frand_copy(&td->buf_state_prev, &td->buf_state);
 		return &td->buf_state;
 	}
 
 	v = rand_between(&td->dedupe_state, 1, 100);
 
-	if (v <= td->o.dedupe_percentage)
+	if (v <= td->o.dedupe_percentage) {
+		if (write)
+			td->ts.dedupe_dup_bufs++;
 		switch (td->o.dedupe_mode) {
 		case DEDUPE_MODE_REPEAT:
 			/*
@@ -2339,11 +2494,13 @@ static struct frand_state *get_buf_state(struct thread_data *td)
 		case DEDUPE_MODE_WORKING_SET:
 			i = rand_between(&td->dedupe_working_set_index_state, 0, td->num_unique_pages - 1);
 			frand_copy(&td->buf_state_ret, &td->dedupe_working_set_states[i]);
+			td->dedupe_working_set_index = i;
 			return &td->buf_state_ret;
 		default:
 			log_err("unexpected dedupe mode %u\n", td->o.dedupe_mode);
 			assert(0);
 		}
+	}
 
 	return &td->buf_state;
 }
@@ -2356,51 +2513,74 @@ static void save_buf_state(struct thread_data *td, struct frand_state *rs)
 		frand_copy(&td->buf_state_prev, rs);
 }
 
-void fill_io_buffer(struct thread_data *td, void *buf, unsigned long long min_write,
-		    unsigned long long max_bs)
+/*
+ * Fill a compressible and/or dedupable buffer from @rs, as returned by
+ * get_buf_state()
+ */
+static void fill_io_buffer_state(struct thread_data *td, void *buf,
+				 unsigned long long min_write,
+				 unsigned long long max_bs,
+				 struct frand_state *rs)
 {
 	struct thread_options *o = &td->o;
+	unsigned int perc = o->compress_percentage;
+	unsigned long long left = max_bs;
+	unsigned long long this_write;
 
-	if (o->mem_type == MEM_CUDA_MALLOC)
+	if (rs == &td->buf_state_ret && td->dedupe_cache) {
+		fill_from_dedupe_cache(td, buf, td->dedupe_working_set_index,
+				       max_bs);
 		return;
+	}
 
-	if (o->compress_percentage || o->dedupe_percentage) {
-		unsigned int perc = td->o.compress_percentage;
-		struct frand_state *rs = NULL;
-		unsigned long long left = max_bs;
-		unsigned long long this_write;
+	do {
+		min_write = min(min_write, left);
 
-		do {
-			/*
-			 * Buffers are either entirely dedupe-able or not.
-			 * If we choose to dedup, the buffer should undergo
-			 * the same manipulation as the original write. Which
-			 * means we should retrack the steps we took for compression
-			 * as well.
-			 */
-			if (!rs)
-				rs = get_buf_state(td);
+		this_write = min_not_zero(min_write,
+					(unsigned long long) o->compress_chunk);
+
+		fill_random_buf_percentage(rs, buf, perc,
+			this_write, this_write,
+			o->buffer_pattern,
+			o->buffer_pattern_bytes);
 
-			min_write = min(min_write, left);
+		buf += this_write;
+		left -= this_write;
+		save_buf_state(td, rs);
+	} while (left);
+}
 
-			this_write = min_not_zero(min_write,
-						(unsigned long long) td->o.compress_chunk);
+static void __fill_io_buffer(struct thread_data *td, void *buf,
+			     unsigned long long min_write,
+			     unsigned long long max_bs, bool write)
+{
+	struct thread_options *o = &td->o;
 
-			fill_random_buf_percentage(rs, buf, perc,
-				this_write, this_write,
-				o->buffer_pattern,
-				o->buffer_pattern_bytes);
+	if (o->mem_type == MEM_CUDA_MALLOC)
+		return;
 
-			buf += this_write;
-			left -= this_write;
-			save_buf_state(td, rs);
-		} while (left);
-	} else if (o->buffer_pattern_bytes)
+	/*
+	 * Buffers are either entirely dedupe-able or not.
+	 * If we choose to dedup, the buffer should undergo
+	 * the same manipulation as the original write. Which
+	 * means we should retrack the steps we took for compression
+	 * as well.
+	 */
+	if (o->compress_percentage || o->dedupe_percentage)
+		fill_io_buffer_state(td, buf, min_write, max_bs,
+					get_buf_state(td, write));
+	else if (o->buffer_pattern_bytes)
 		fill_buffer_pattern(td, buf, max_bs);
 	else if (o->zero_buffers)
 		memset(buf, 0, max_bs);
 	else
-		fill_random_buf(get_buf_state(td), buf, max_bs);
+		fill_random_buf(get_buf_state(td, write), buf, max_bs);
+}
+
+void fill_io_buffer(struct thread_data *td, void *buf, unsigned long long min_write,
+		    unsigned long long max_bs)
+{
+	__fill_io_buffer(td, buf, min_write, max_bs, false);
 }
 
 /*
@@ -2413,6 +2593,37 @@ void io_u_fill_buffer(struct thread_data *td, struct io_u *io_u,
 	fill_io_buffer(td, io_u->buf, min_write, max_bs);
 }
 
+/*
+ * Like io_u_fill_buffer(), but a write that repeats a dedupe working set
+ * page may instead be pointed at the cached copy of it. Returns that copy,
+ * or NULL if the io_u buffer was filled.
+ */
+void *io_u_fill_write_buffer(struct thread_data *td, struct io_u *io_u,
+			     unsigned long long min_write,
+			     unsigned long long max_bs)
+{
+	struct frand_state *rs;
+	void *p;
+
+	if (!td->dedupe_cache || td->o.verify != VERIFY_NONE ||
+	    !td_ioengine_flagged(td, FIO_EXT_WRITE_BUF)) {
+		io_u->buf_filled_len = 0;
+		__fill_io_buffer(td, io_u->buf, min_write, max_bs, true);
+		return NULL;
+	}
+
+	rs = get_buf_state(td, true);
+	if (rs == &td->buf_state_ret) {
+		p = dedupe_cache_range(td, td->dedupe_working_set_index, max_bs);
+		if (p)
+			return p;
+	}
+
+	io_u->buf_filled_len = 0;
+	fill_io_buffer_state(td, io_u->buf, min_write, max_bs, rs);
+	return NULL;
+}
+
 static int do_sync_file_range(const struct thread_data *td,
 			      struct fio_file *f)
 {
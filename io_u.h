@@ -7,6 +7,7 @@
 #include "debug.h"
 #include "file.h"
 #include "workqueue.h"
+#include "lib/prio_tree.h"
 
 #ifdef CONFIG_LIBAIO
 #include <libaio.h>
@@ -24,6 +25,12 @@ enum {
 	IO_U_F_PATTERN_DONE	= 1 << 8,
 	IO_U_F_DEVICE_ERROR	= 1 << 9,
 	IO_U_F_VER_IN_DEV	= 1 << 10, /* Verify data in device */
+	IO_U_F_ZONE_APPEND	= 1 << 11, /* Write is a zone append */
+	IO_U_F_ZONE_PLACED	= 1 << 12, /* Emulated zone accepted the write */
+	IO_U_F_VER_MAP		= 1 << 13, /* Write logged in the verify map */
+	IO_U_F_OVERLAP		= 1 << 14, /* On the in-flight overlap tree */
+	IO_U_F_OVERLAP_SCAN	= 1 << 15, /* In flight, not on the overlap tree */
+	IO_U_F_VER_JOURNAL	= 1 << 16, /* Verify a block of the verify journal */
 };
 
 /*
@@ -59,6 +66,11 @@ struct io_u {
 	 */
 	unsigned int number_trim;
 
+	/*
+	 * Queue depth when this IO was submitted.
+	 */
+	unsigned int submit_depth;
+
 	/*
 	 * Allocated/set buffer and length
 	 */
@@ -104,6 +116,11 @@ struct io_u {
 		struct workqueue_work work;
 	};
 
+	/*
+	 * In-flight range, for serialize_overlap
+	 */
+	struct prio_tree_node overlap_node;
+
 	/*
 	 * ZBD mode zbd_queue_io callback: called after engine->queue operation
 	 * to advance a zone write pointer and eventually unlock the I/O zone.
@@ -156,6 +173,8 @@ extern struct io_u *get_io_u(struct thread_data *);
 extern void put_io_u(struct thread_data *, struct io_u *);
 extern void clear_io_u(struct thread_data *, struct io_u *);
 extern void requeue_io_u(struct thread_data *, struct io_u **);
+extern void io_u_overlap_add(struct thread_data *, struct io_u *);
+extern void io_u_overlap_del(struct thread_data *, struct io_u *);
 extern int __must_check io_u_sync_complete(struct thread_data *, struct io_u *);
 extern int __must_check io_u_queued_complete(struct thread_data *, int);
 extern void io_u_queued(struct thread_data *, struct io_u *);
@@ -164,6 +183,7 @@ extern void io_u_log_error(struct thread_data *, struct io_u *);
 extern void io_u_mark_depth(struct thread_data *, unsigned int);
 extern void fill_io_buffer(struct thread_data *, void *, unsigned long long, unsigned long long);
 extern void io_u_fill_buffer(struct thread_data *td, struct io_u *, unsigned long long, unsigned long long);
+extern void *io_u_fill_write_buffer(struct thread_data *td, struct io_u *, unsigned long long, unsigned long long);
 void io_u_mark_complete(struct thread_data *, unsigned int);
 void io_u_mark_submit(struct thread_data *, unsigned int);
 bool queue_full(const struct thread_data *);
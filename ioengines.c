@@ -22,6 +22,8 @@
 #include "fio.h"
 #include "diskutil.h"
 #include "zbd.h"
+#include "zbd_emu.h"
+#include "verify-journal.h"
 
 static FLIST_HEAD(engine_list);
 
@@ -32,6 +34,16 @@ static inline bool async_ioengine_sync_trim(struct thread_data *td,
 		io_u->ddir == DDIR_TRIM;
 }
 
+/*
+ * Zone reset and finish commands are only queued to engines that support
+ * them, everything else issues them synchronously on behalf of the engine.
+ */
+static inline bool sync_zone_mgmt(struct thread_data *td, struct io_u *io_u)
+{
+	return ddir_zone_mgmt(io_u->ddir) &&
+		(io_u->file->zbd_emu || !td_ioengine_flagged(td, FIO_ZONE_MGMT));
+}
+
 static bool check_engine_ops(struct thread_data *td, struct ioengine_ops *ops)
 {
 	if (ops->version != FIO_IOOPS_VERSION) {
@@ -268,7 +280,7 @@ int td_io_prep(struct thread_data *td, struct io_u *io_u)
 
 	lock_file(td, io_u->file, io_u->ddir);
 
-	if (td->io_ops->prep) {
+	if (td->io_ops->prep && !sync_zone_mgmt(td, io_u)) {
 		int ret = td->io_ops->prep(td, io_u);
 
 		dprint(FD_IO, "prep: io_u %p: ret=%d\n", io_u, ret);
@@ -335,6 +347,8 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 
 	assert((io_u->flags & IO_U_F_FLIGHT) == 0);
 	io_u_set(td, io_u, IO_U_F_FLIGHT);
+	if (td->o.serialize_overlap)
+		io_u_overlap_add(td, io_u);
 
 	/*
 	 * If overlap checking was enabled in offload mode we
@@ -355,15 +369,19 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 	assert(fio_file_open(io_u->file));
 
 	/*
-	 * If using a write iolog, store this entry.
+	 * If using a write iolog, store this entry. Zone management commands
+	 * are issued again by zonemode=zbd when the log is replayed.
 	 */
-	log_io_u(td, io_u);
+	if (!ddir_zone_mgmt(io_u->ddir))
+		log_io_u(td, io_u);
 
 	io_u->error = 0;
 	io_u->resid = 0;
+	io_u->submit_depth = td->cur_depth;
 
 	if (td_ioengine_flagged(td, FIO_SYNCIO) ||
-		async_ioengine_sync_trim(td, io_u)) {
+		async_ioengine_sync_trim(td, io_u) ||
+		sync_zone_mgmt(td, io_u)) {
 		if (fio_fill_issue_time(td)) {
 			fio_gettime(&io_u->issue_time, NULL);
 
@@ -383,9 +401,21 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 			td->io_issue_bytes[ddir] += buflen;
 		}
 		td->rate_io_issue_bytes[ddir] += buflen;
-	}
-
-	ret = td->io_ops->queue(td, io_u);
+	} else if (td->vjournal && ddir_sync(ddir))
+		verify_journal_flush(td, io_u, false);
+
+	if (fio_unlikely(sync_zone_mgmt(td, io_u))) {
+		zbd_do_io_u_zone_mgmt(td, io_u);
+		if (td->io_ops->commit) {
+			io_u_mark_submit(td, 1);
+			io_u_mark_complete(td, 1);
+		}
+		ret = FIO_Q_COMPLETED;
+	} else if (fio_unlikely(io_u->file->zbd_emu) &&
+		   !zbd_emu_accept_io_u(td, io_u))
+		ret = FIO_Q_COMPLETED;
+	else
+		ret = td->io_ops->queue(td, io_u);
 	zbd_queue_io_u(td, io_u, ret);
 
 	unlock_file(td, io_u->file);
@@ -394,6 +424,7 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 		td->io_issues[ddir]--;
 		td->io_issue_bytes[ddir] -= buflen;
 		td->rate_io_issue_bytes[ddir] -= buflen;
+		io_u_overlap_del(td, io_u);
 		io_u_clear(td, io_u, IO_U_F_FLIGHT);
 	}
 
@@ -452,7 +483,8 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 	}
 
 	if (!td_ioengine_flagged(td, FIO_SYNCIO) &&
-		!async_ioengine_sync_trim(td, io_u)) {
+		!async_ioengine_sync_trim(td, io_u) &&
+		!sync_zone_mgmt(td, io_u)) {
 		if (fio_fill_issue_time(td) &&
 			!td_ioengine_flagged(td, FIO_ASYNCIO_SETS_ISSUE_TIME)) {
 			fio_gettime(&io_u->issue_time, NULL);
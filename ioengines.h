@@ -97,6 +97,9 @@ enum {
 					   affects ioengines using generic_open_file */
 	__FIO_MULTI_RANGE_TRIM,		/* ioengine supports trim with more than one range */
 	__FIO_ATOMICWRITES,		/* ioengine supports atomic writes */
+	__FIO_ZONE_APPEND,		/* ioengine supports zone append writes */
+	__FIO_ZONE_MGMT,		/* ioengine queues zone reset and finish commands */
+	__FIO_EXT_WRITE_BUF,		/* writes may use an xfer_buf outside io_u memory */
 	__FIO_IOENGINE_F_LAST,		/* not a real bit; used to count number of bits */
 };
 
@@ -122,6 +125,9 @@ enum fio_ioengine_flags {
 	FIO_RO_NEEDS_RW_OPEN		= 1 << __FIO_RO_NEEDS_RW_OPEN,
 	FIO_MULTI_RANGE_TRIM		= 1 << __FIO_MULTI_RANGE_TRIM,
 	FIO_ATOMICWRITES		= 1 << __FIO_ATOMICWRITES,
+	FIO_ZONE_APPEND			= 1 << __FIO_ZONE_APPEND,
+	FIO_ZONE_MGMT			= 1 << __FIO_ZONE_MGMT,
+	FIO_EXT_WRITE_BUF		= 1 << __FIO_EXT_WRITE_BUF,
 };
 
 /*
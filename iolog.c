@@ -11,6 +11,12 @@
 #ifdef CONFIG_ZLIB
 #include <zlib.h>
 #endif
+#ifdef CONFIG_ZSTD
+#include <zstd.h>
+#endif
+#ifdef CONFIG_LZ4
+#include <lz4frame.h>
+#endif
 
 #include "flist.h"
 #include "fio.h"
@@ -18,6 +24,8 @@
 #include "filelock.h"
 #include "smalloc.h"
 #include "blktrace.h"
+#include "verify.h"
+#include "verify-journal.h"
 #include "pshared.h"
 #include "lib/roundup.h"
 
@@ -255,6 +263,24 @@ int read_iolog_get(struct thread_data *td, struct io_u *io_u)
 	return 1;
 }
 
+static void verify_map_reset(struct thread_data *td)
+{
+	struct fio_file *f;
+	unsigned int i;
+
+	for_each_file(td, f, i) {
+		struct verify_map *map = f->verify_map;
+
+		if (!map || !map->nr_logged)
+			continue;
+
+		memset(map->blocks, 0, map->nr_blocks * sizeof(map->blocks[0]));
+		td->io_hist_len -= map->nr_logged;
+		map->nr_logged = 0;
+		map->cursor = 0;
+	}
+}
+
 void prune_io_piece_log(struct thread_data *td)
 {
 	struct io_piece *ipo;
@@ -275,49 +301,21 @@ void prune_io_piece_log(struct thread_data *td)
 		td->io_hist_len--;
 		free(ipo);
 	}
+
+	verify_map_reset(td);
 }
 
 /*
- * log a successful write, so we can unwind the log for verify
+ * Sort a logged write into the verification tree, dropping older entries
+ * that it overwrites.
  */
-void log_io_piece(struct thread_data *td, struct io_u *io_u)
+static void insert_io_piece(struct thread_data *td, struct io_piece *ipo)
 {
 	struct fio_rb_node **p, *parent;
-	struct io_piece *ipo, *__ipo;
-
-	ipo = calloc(1, sizeof(struct io_piece));
-	init_ipo(ipo);
-	ipo->file = io_u->file;
-	ipo->offset = io_u->offset;
-	ipo->len = io_u->buflen;
-	ipo->numberio = io_u->numberio;
-	ipo->flags = IP_F_IN_FLIGHT;
-
-	io_u->ipo = ipo;
-
-	if (io_u_should_trim(td, io_u)) {
-		flist_add_tail(&ipo->trim_list, &td->trim_list);
-		td->trim_entries++;
-	}
-
-	/*
-	 * Only sort writes if we don't have a random map in which case we need
-	 * to check for duplicate blocks and drop the old one, which we rely on
-	 * the rb insert/lookup for handling.
-	 */
-	if (file_randommap(td, ipo->file)) {
-		INIT_FLIST_HEAD(&ipo->list);
-		flist_add_tail(&ipo->list, &td->io_hist_list);
-		ipo->flags |= IP_F_ONLIST;
-		td->io_hist_len++;
-		return;
-	}
+	struct io_piece *__ipo;
 
 	RB_CLEAR_NODE(&ipo->rb_node);
 
-	/*
-	 * Sort the entry into the verification list
-	 */
 restart:
 	p = &td->io_hist_tree.rb_node;
 	parent = NULL;
@@ -360,6 +358,267 @@ restart:
 	td->io_hist_len++;
 }
 
+/*
+ * Look up the verify map entry of a write. Writes that do not cover exactly
+ * one block of the map are logged as io_pieces instead.
+ */
+static struct verify_map_block *verify_map_block(struct verify_map *map,
+						 struct io_u *io_u,
+						 uint64_t *idx)
+{
+	unsigned long long offset = io_u->verify_offset;
+
+	if (offset < map->start || io_u->buflen != map->bs)
+		return NULL;
+
+	offset -= map->start;
+	if (offset % map->bs)
+		return NULL;
+
+	*idx = offset / map->bs;
+	if (*idx >= map->nr_blocks)
+		return NULL;
+
+	return &map->blocks[*idx];
+}
+
+static bool verify_map_log(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_map *map = io_u->file->verify_map;
+	struct verify_map_block *b;
+	uint64_t idx;
+
+	b = verify_map_block(map, io_u, &idx);
+	if (!b || (b->state & VMAP_INFLIGHT_MASK) == VMAP_INFLIGHT_MASK)
+		return false;
+
+	if (!(b->state & VMAP_F_LOGGED)) {
+		b->state |= VMAP_F_LOGGED;
+		map->nr_logged++;
+		td->io_hist_len++;
+		if (idx < map->cursor)
+			map->cursor = idx;
+	}
+	b->state++;
+	b->numberio = io_u->numberio;
+
+	io_u_set(td, io_u, IO_U_F_VER_MAP);
+	return true;
+}
+
+/*
+ * Drop a failed write from the verify map, unless a later write to the same
+ * block has been issued since.
+ */
+static void verify_map_unlog(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_map *map = io_u->file->verify_map;
+	struct verify_map_block *b;
+	uint64_t idx;
+
+	io_u_clear(td, io_u, IO_U_F_VER_MAP);
+
+	b = verify_map_block(map, io_u, &idx);
+	b->state--;
+	if (b->numberio == io_u->numberio && (b->state & VMAP_F_LOGGED)) {
+		b->state &= ~VMAP_F_LOGGED;
+		map->nr_logged--;
+		td->io_hist_len--;
+	}
+}
+
+/*
+ * Mark a write logged in the verify map ok to verify
+ */
+void verify_map_complete(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_map_block *b;
+	uint64_t idx;
+
+	io_u_clear(td, io_u, IO_U_F_VER_MAP);
+
+	b = verify_map_block(io_u->file->verify_map, io_u, &idx);
+	b->state--;
+}
+
+/*
+ * Hand out the next logged block in file and offset order. Returns false
+ * if there is nothing left to verify, or if the next block to verify is
+ * still being written.
+ */
+bool verify_map_next(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f;
+	unsigned int i;
+
+	for_each_file(td, f, i) {
+		struct verify_map *map = f->verify_map;
+
+		if (!map || !map->nr_logged)
+			continue;
+
+		while (map->cursor < map->nr_blocks) {
+			struct verify_map_block *b = &map->blocks[map->cursor];
+
+			if (!(b->state & VMAP_F_LOGGED)) {
+				map->cursor++;
+				continue;
+			}
+			if (b->state & VMAP_INFLIGHT_MASK)
+				return false;
+
+			b->state = 0;
+			map->nr_logged--;
+			td->io_hist_len--;
+
+			io_u->offset = map->start + map->cursor * map->bs;
+			io_u->verify_offset = io_u->offset;
+			io_u->buflen = map->bs;
+			io_u->numberio = b->numberio;
+			io_u->file = f;
+			if (map->journal) {
+				io_u->rand_seed = map->journal[map->cursor].rand_seed;
+				io_u_set(td, io_u, IO_U_F_VER_JOURNAL);
+			}
+			map->cursor++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * init_verify_map - set up the dense verify write history
+ * @td: fio thread data.
+ *
+ * Writes that do not go through a random map are sorted into io_hist_tree,
+ * so that overwritten blocks are verified only once. That takes an io_piece
+ * and a tree insert per write. For fixed block size writes, keep the number
+ * of the last write to each block in a flat array indexed by block number
+ * instead: the memory used depends on the file size rather than on the
+ * number of writes, and logging a write takes constant time. Verifying walks
+ * the array in offset order, like it walks io_hist_tree.
+ *
+ * Verify backlogs, trims and zoned block devices interleave verifies with
+ * writes and keep using io_pieces.
+ *
+ * Checking a verify journal always uses the verify map, see
+ * verify_journal_load().
+ */
+void init_verify_map(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	unsigned long long bs = o->min_bs[DDIR_WRITE];
+	struct fio_file *f;
+	unsigned int i;
+
+	if (!td_write(td) || !o->do_verify || o->verify == VERIFY_NONE ||
+	    o->experimental_verify)
+		return;
+	if (!bs || bs != o->max_bs[DDIR_WRITE])
+		return;
+	if ((td->flags & TD_F_VER_BACKLOG) || o->trim_percentage ||
+	    o->zone_mode == ZONE_MODE_ZBD || o->zone_append ||
+	    o->io_submit_mode == IO_MODE_OFFLOAD)
+		return;
+
+	for_each_file(td, f, i) {
+		struct verify_map *map;
+		uint64_t nr_blocks;
+
+		if (f->verify_map ||
+		    (file_randommap(td, f) && !verify_journal_check(td)))
+			continue;
+
+		nr_blocks = f->io_size / bs;
+		if (!nr_blocks)
+			continue;
+
+		map = calloc(1, sizeof(*map) + nr_blocks * sizeof(map->blocks[0]));
+		if (!map) {
+			dprint(FD_VERIFY, "%s: no memory for a verify map of %"PRIu64" blocks\n",
+			       f->file_name, nr_blocks);
+			continue;
+		}
+
+		map->start = f->file_offset;
+		map->bs = bs;
+		map->nr_blocks = nr_blocks;
+		f->verify_map = map;
+	}
+}
+
+/*
+ * log a successful write, so we can unwind the log for verify
+ */
+void log_io_piece(struct thread_data *td, struct io_u *io_u)
+{
+	struct io_piece *ipo;
+
+	if (io_u->file->verify_map && verify_map_log(td, io_u))
+		return;
+
+	ipo = calloc(1, sizeof(struct io_piece));
+	init_ipo(ipo);
+	ipo->file = io_u->file;
+	ipo->offset = io_u->offset;
+	ipo->verify_offset = io_u->verify_offset;
+	ipo->len = io_u->buflen;
+	ipo->numberio = io_u->numberio;
+	ipo->flags = IP_F_IN_FLIGHT;
+
+	io_u->ipo = ipo;
+
+	if (io_u_should_trim(td, io_u)) {
+		flist_add_tail(&ipo->trim_list, &td->trim_list);
+		td->trim_entries++;
+	}
+
+	/*
+	 * Only sort writes if we don't have a random map in which case we need
+	 * to check for duplicate blocks and drop the old one, which we rely on
+	 * the rb insert/lookup for handling.
+	 */
+	if (file_randommap(td, ipo->file)) {
+		INIT_FLIST_HEAD(&ipo->list);
+		flist_add_tail(&ipo->list, &td->io_hist_list);
+		ipo->flags |= IP_F_ONLIST;
+		td->io_hist_len++;
+		return;
+	}
+
+	/*
+	 * The device decides where zone appends land, sort them in once
+	 * they have completed. See place_io_piece().
+	 */
+	if (io_u->flags & IO_U_F_ZONE_APPEND) {
+		td->io_hist_len++;
+		return;
+	}
+
+	insert_io_piece(td, ipo);
+}
+
+/*
+ * Record where a zone append write actually landed. The data still carries
+ * the verify header generated for the offset it was logged with.
+ */
+void place_io_piece(struct thread_data *td, struct io_u *io_u)
+{
+	struct io_piece *ipo = io_u->ipo;
+
+	dprint(FD_IO, "iolog: place %llu -> %llu\n", ipo->offset,
+	       io_u->offset);
+
+	ipo->offset = io_u->offset;
+	if (ipo->flags & IP_F_ONLIST)
+		return;
+
+	td->io_hist_len--;
+	insert_io_piece(td, ipo);
+}
+
 void unlog_io_piece(struct thread_data *td, struct io_u *io_u)
 {
 	struct io_piece *ipo = io_u->ipo;
@@ -376,6 +635,11 @@ void unlog_io_piece(struct thread_data *td, struct io_u *io_u)
 		}
 	}
 
+	if (io_u->flags & IO_U_F_VER_MAP) {
+		verify_map_unlog(td, io_u);
+		return;
+	}
+
 	if (!ipo)
 		return;
 
@@ -848,6 +1112,7 @@ void setup_log(struct io_log **log, struct log_params *p,
 	l->log_issue_time = p->log_issue_time;
 	l->log_gz = p->log_gz;
 	l->log_gz_store = p->log_gz_store;
+	l->log_gz_type = p->log_gz_type;
 	l->avg_msec = p->avg_msec;
 	l->hist_msec = p->hist_msec;
 	l->hist_coarseness = p->hist_coarseness;
@@ -1119,18 +1384,28 @@ struct iolog_flush_data {
 	struct io_log *log;
 	void *samples;
 	uint32_t nr_samples;
+	unsigned int seq;
 	bool free;
 };
 
 #define GZ_CHUNK	131072
 
-static struct iolog_compress *get_new_chunk(unsigned int seq)
+/*
+ * Little endian magic at the start of zstd and lz4 frames. zlib streams
+ * start with a different first byte, so stored logs can mix all three.
+ */
+#define ZSTD_FRAME_MAGIC	0xFD2FB528U
+#define LZ4_FRAME_MAGIC		0x184D2204U
+
+#define ZSTD_LOG_LEVEL		1
+
+static struct iolog_compress *get_new_chunk(unsigned int seq, size_t size)
 {
 	struct iolog_compress *c;
 
 	c = malloc(sizeof(*c));
 	INIT_FLIST_HEAD(&c->list);
-	c->buf = malloc(GZ_CHUNK);
+	c->buf = malloc(size);
 	c->len = 0;
 	c->seq = seq;
 	return c;
@@ -1251,6 +1526,157 @@ static size_t inflate_chunk(struct iolog_compress *ic, int gz_hdr, FILE *f,
 	return ret;
 }
 
+static unsigned int frame_type(const void *buf, size_t len)
+{
+	uint32_t magic;
+
+	if (len < sizeof(magic))
+		return IO_LOG_COMP_ZLIB;
+
+	memcpy(&magic, buf, sizeof(magic));
+	magic = le32_to_cpu(magic);
+	if (magic == ZSTD_FRAME_MAGIC)
+		return IO_LOG_COMP_ZSTD;
+	if (magic == LZ4_FRAME_MAGIC)
+		return IO_LOG_COMP_LZ4;
+
+	return IO_LOG_COMP_ZLIB;
+}
+
+#ifdef CONFIG_ZSTD
+/*
+ * The frame header has the inflated size, so a zstd frame is inflated with
+ * one call into a buffer of the right size. Returns the compressed size of
+ * the frame, or 0 on error.
+ */
+static size_t inflate_zstd_frame(const void *buf, size_t len, FILE *f)
+{
+	unsigned long long out_len;
+	size_t in_len, ret;
+	void *out;
+
+	in_len = ZSTD_findFrameCompressedSize(buf, len);
+	if (ZSTD_isError(in_len)) {
+		log_err("fio: bad zstd log frame: %s\n",
+				ZSTD_getErrorName(in_len));
+		return 0;
+	}
+
+	out_len = ZSTD_getFrameContentSize(buf, in_len);
+	if (out_len == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    out_len == ZSTD_CONTENTSIZE_ERROR) {
+		log_err("fio: zstd log frame has no content size\n");
+		return 0;
+	}
+
+	out = malloc(out_len ? out_len : 1);
+	if (!out)
+		return 0;
+
+	ret = ZSTD_decompress(out, out_len, buf, in_len);
+	if (ZSTD_isError(ret)) {
+		log_err("fio: failed inflating zstd log: %s\n",
+				ZSTD_getErrorName(ret));
+		free(out);
+		return 0;
+	}
+
+	dprint(FD_COMPRESS, "zstd frame size=%lu, inflated to size=%lu\n",
+				(unsigned long) in_len, (unsigned long) ret);
+
+	flush_samples(f, out, ret);
+	free(out);
+	return in_len;
+}
+#else
+static size_t inflate_zstd_frame(const void *buf, size_t len, FILE *f)
+{
+	log_err("fio: log has zstd frames, but fio was built without zstd\n");
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_LZ4
+/*
+ * Inflate the lz4 frame at the start of @buf. Returns the compressed size
+ * of the frame, or 0 on error.
+ */
+static size_t inflate_lz4_frame(const void *buf, size_t len, FILE *f)
+{
+	LZ4F_decompressionContext_t ctx;
+	LZ4F_frameInfo_t info;
+	size_t in_used, out_len, out_used = 0, ret;
+	void *out = NULL;
+
+	ret = LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+	if (LZ4F_isError(ret))
+		return 0;
+
+	in_used = len;
+	ret = LZ4F_getFrameInfo(ctx, &info, buf, &in_used);
+	if (LZ4F_isError(ret))
+		goto err;
+
+	out_len = info.contentSize ? info.contentSize : GZ_CHUNK;
+	out = malloc(out_len);
+	if (!out)
+		goto err_out;
+
+	do {
+		size_t in = len - in_used, this_out = out_len - out_used;
+
+		if (!in) {
+			log_err("fio: truncated lz4 log frame\n");
+			goto err_out;
+		}
+
+		ret = LZ4F_decompress(ctx, out + out_used, &this_out,
+					buf + in_used, &in, NULL);
+		if (LZ4F_isError(ret))
+			goto err;
+
+		in_used += in;
+		out_used += this_out;
+
+		if (ret && out_used == out_len) {
+			out_len <<= 1;
+			out = realloc(out, out_len);
+			if (!out)
+				goto err_out;
+		}
+	} while (ret);
+
+	dprint(FD_COMPRESS, "lz4 frame size=%lu, inflated to size=%lu\n",
+				(unsigned long) in_used, (unsigned long) out_used);
+
+	flush_samples(f, out, out_used);
+	free(out);
+	LZ4F_freeDecompressionContext(ctx);
+	return in_used;
+err:
+	log_err("fio: failed inflating lz4 log: %s\n", LZ4F_getErrorName(ret));
+err_out:
+	free(out);
+	LZ4F_freeDecompressionContext(ctx);
+	return 0;
+}
+#else
+static size_t inflate_lz4_frame(const void *buf, size_t len, FILE *f)
+{
+	log_err("fio: log has lz4 frames, but fio was built without lz4\n");
+	return 0;
+}
+#endif
+
+static size_t inflate_frame(unsigned int type, const void *buf, size_t len,
+			    FILE *f)
+{
+	if (type == IO_LOG_COMP_ZSTD)
+		return inflate_zstd_frame(buf, len, f);
+
+	return inflate_lz4_frame(buf, len, f);
+}
+
 /*
  * Inflate stored compressed chunks, or write them directly to the log
  * file if so instructed.
@@ -1277,8 +1703,10 @@ static int inflate_gz_chunks(struct io_log *log, FILE *f)
 				iter.err = errno;
 				log_err("fio: error writing compressed log\n");
 			}
-		} else
+		} else if (log->log_gz_type == IO_LOG_COMP_ZLIB)
 			inflate_chunk(ic, log->log_gz_store, f, &stream, &iter);
+		else if (!inflate_frame(log->log_gz_type, ic->buf, ic->len, f))
+			iter.err = EINVAL;
 
 		free_chunk(ic);
 	}
@@ -1294,7 +1722,9 @@ static int inflate_gz_chunks(struct io_log *log, FILE *f)
 /*
  * Open compressed log file and decompress the stored chunks and
  * write them to stdout. The chunks are stored sequentially in the
- * file, so we iterate over them and do them one-by-one.
+ * file, so we iterate over them and do them one-by-one. Each chunk is
+ * a zlib stream, zstd frame or lz4 frame of its own, told apart by
+ * the frame magic.
  */
 int iolog_file_inflate(const char *file)
 {
@@ -1303,7 +1733,6 @@ int iolog_file_inflate(const char *file)
 	z_stream stream;
 	struct stat sb;
 	size_t ret;
-	size_t total;
 	void *buf;
 	FILE *f;
 
@@ -1339,30 +1768,30 @@ int iolog_file_inflate(const char *file)
 	fclose(f);
 
 	/*
-	 * Each chunk will return Z_STREAM_END. We don't know how many
-	 * chunks are in the file, so we just keep looping and incrementing
-	 * the sequence number until we have consumed the whole compressed
-	 * file.
+	 * Each zlib chunk will return Z_STREAM_END, and zstd and lz4 frames
+	 * know their own size. We don't know how many chunks are in the
+	 * file, so we just keep looping until we have consumed the whole
+	 * compressed file. Every chunk is flushed before the next one is
+	 * started, so samples come out in order.
 	 */
-	total = ic.len;
-	do {
+	while (ic.len && !iter.err) {
+		unsigned int type = frame_type(ic.buf, ic.len);
 		size_t iret;
 
-		iret = inflate_chunk(&ic,  1, stdout, &stream, &iter);
-		total -= iret;
-		if (!total)
-			break;
-		if (iter.err)
+		if (type == IO_LOG_COMP_ZLIB) {
+			iret = inflate_chunk(&ic, 1, stdout, &stream, &iter);
+			finish_chunk(&stream, stdout, &iter);
+			iter.seq = 0;
+		} else
+			iret = inflate_frame(type, ic.buf, ic.len, stdout);
+
+		if (!iret) {
+			iter.err = EINVAL;
 			break;
+		}
 
-		ic.seq++;
 		ic.len -= iret;
 		ic.buf += iret;
-	} while (1);
-
-	if (iter.seq) {
-		finish_chunk(&stream, stdout, &iter);
-		free(iter.buf);
 	}
 
 	free(buf);
@@ -1507,17 +1936,15 @@ static void iolog_free_deferred(struct io_log *log)
 	pthread_mutex_unlock(&log->deferred_free_lock);
 }
 
-static int gz_work(struct iolog_flush_data *data)
+static int deflate_chunks(struct iolog_flush_data *data,
+			  struct flist_head *list)
 {
 	struct iolog_compress *c = NULL;
-	struct flist_head list;
-	unsigned int seq;
+	unsigned int seq = data->seq;
 	z_stream stream;
 	size_t total = 0;
 	int ret;
 
-	INIT_FLIST_HEAD(&list);
-
 	memset(&stream, 0, sizeof(stream));
 	stream.zalloc = Z_NULL;
 	stream.zfree = Z_NULL;
@@ -1526,11 +1953,9 @@ static int gz_work(struct iolog_flush_data *data)
 	ret = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
 	if (ret != Z_OK) {
 		log_err("fio: failed to init gz stream\n");
-		goto err;
+		return 1;
 	}
 
-	seq = ++data->log->chunk_seq;
-
 	stream.next_in = (void *) data->samples;
 	stream.avail_in = data->nr_samples * log_entry_sz(data->log);
 
@@ -1541,7 +1966,7 @@ static int gz_work(struct iolog_flush_data *data)
 		if (c)
 			dprint(FD_COMPRESS, "seq=%d, chunk=%lu\n", seq,
 				(unsigned long) c->len);
-		c = get_new_chunk(seq);
+		c = get_new_chunk(seq, GZ_CHUNK);
 		stream.avail_out = GZ_CHUNK;
 		stream.next_out = c->buf;
 		ret = deflate(&stream, Z_NO_FLUSH);
@@ -1552,7 +1977,7 @@ static int gz_work(struct iolog_flush_data *data)
 		}
 
 		c->len = GZ_CHUNK - stream.avail_out;
-		flist_add_tail(&c->list, &list);
+		flist_add_tail(&c->list, list);
 		total += c->len;
 	} while (stream.avail_in);
 
@@ -1568,8 +1993,6 @@ static int gz_work(struct iolog_flush_data *data)
 		 */
 		if (ret != Z_BUF_ERROR) {
 			log_err("fio: deflate log (%d)\n", ret);
-			flist_del(&c->list);
-			free_chunk(c);
 			goto err;
 		}
 	}
@@ -1581,13 +2004,13 @@ static int gz_work(struct iolog_flush_data *data)
 
 	if (ret != Z_STREAM_END) {
 		do {
-			c = get_new_chunk(seq);
+			c = get_new_chunk(seq, GZ_CHUNK);
 			stream.avail_out = GZ_CHUNK;
 			stream.next_out = c->buf;
 			ret = deflate(&stream, Z_FINISH);
 			c->len = GZ_CHUNK - stream.avail_out;
 			total += c->len;
-			flist_add_tail(&c->list, &list);
+			flist_add_tail(&c->list, list);
 			dprint(FD_COMPRESS, "seq=%d, chunk=%lu\n", seq,
 				(unsigned long) c->len);
 		} while (ret != Z_STREAM_END);
@@ -1599,27 +2022,131 @@ static int gz_work(struct iolog_flush_data *data)
 	if (ret != Z_OK)
 		log_err("fio: deflateEnd %d\n", ret);
 
-	iolog_put_deferred(data->log, data->samples);
+	return 0;
+err:
+	deflateEnd(&stream);
+	return 1;
+}
 
-	if (!flist_empty(&list)) {
-		pthread_mutex_lock(&data->log->chunk_lock);
-		flist_splice_tail(&list, &data->log->chunk_list);
-		pthread_mutex_unlock(&data->log->chunk_lock);
+#ifdef CONFIG_ZSTD
+static int zstd_chunk(struct iolog_flush_data *data, struct flist_head *list)
+{
+	size_t len = data->nr_samples * log_entry_sz(data->log);
+	size_t bound = ZSTD_compressBound(len);
+	struct iolog_compress *c;
+	size_t ret;
+
+	c = get_new_chunk(data->seq, bound);
+	ret = ZSTD_compress(c->buf, bound, data->samples, len, ZSTD_LOG_LEVEL);
+	if (ZSTD_isError(ret)) {
+		log_err("fio: zstd log: %s\n", ZSTD_getErrorName(ret));
+		free_chunk(c);
+		return 1;
+	}
+
+	dprint(FD_COMPRESS, "zstd input size=%lu, seq=%u, output size=%lu\n",
+				(unsigned long) len, data->seq,
+				(unsigned long) ret);
+
+	c->buf = realloc(c->buf, ret);
+	c->len = ret;
+	flist_add_tail(&c->list, list);
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_LZ4
+static int lz4_chunk(struct iolog_flush_data *data, struct flist_head *list)
+{
+	size_t len = data->nr_samples * log_entry_sz(data->log);
+	LZ4F_preferences_t prefs = {
+		.frameInfo = { .contentSize = len, },
+	};
+	size_t bound = LZ4F_compressFrameBound(len, &prefs);
+	struct iolog_compress *c;
+	size_t ret;
+
+	c = get_new_chunk(data->seq, bound);
+	ret = LZ4F_compressFrame(c->buf, bound, data->samples, len, &prefs);
+	if (LZ4F_isError(ret)) {
+		log_err("fio: lz4 log: %s\n", LZ4F_getErrorName(ret));
+		free_chunk(c);
+		return 1;
+	}
+
+	dprint(FD_COMPRESS, "lz4 input size=%lu, seq=%u, output size=%lu\n",
+				(unsigned long) len, data->seq,
+				(unsigned long) ret);
+
+	c->buf = realloc(c->buf, ret);
+	c->len = ret;
+	flist_add_tail(&c->list, list);
+	return 0;
+}
+#endif
+
+/*
+ * With more than one compression worker, chunks can finish out of order.
+ * Keep the chunk list sorted by sequence, so the log comes out in the
+ * order it was logged in.
+ */
+static void add_chunks(struct io_log *log, struct flist_head *list,
+		       unsigned int seq)
+{
+	struct flist_head *pos;
+
+	pthread_mutex_lock(&log->chunk_lock);
+	for (pos = log->chunk_list.prev; pos != &log->chunk_list;
+	     pos = pos->prev) {
+		struct iolog_compress *c;
+
+		c = flist_entry(pos, struct iolog_compress, list);
+		if (c->seq < seq)
+			break;
+	}
+	flist_splice_init(list, pos);
+	pthread_mutex_unlock(&log->chunk_lock);
+}
+
+static int gz_work(struct iolog_flush_data *data)
+{
+	struct flist_head list;
+	int ret;
+
+	INIT_FLIST_HEAD(&list);
+
+	switch (data->log->log_gz_type) {
+#ifdef CONFIG_ZSTD
+	case IO_LOG_COMP_ZSTD:
+		ret = zstd_chunk(data, &list);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IO_LOG_COMP_LZ4:
+		ret = lz4_chunk(data, &list);
+		break;
+#endif
+	default:
+		ret = deflate_chunks(data, &list);
+		break;
+	}
+
+	if (!ret) {
+		iolog_put_deferred(data->log, data->samples);
+		add_chunks(data->log, &list, data->seq);
 	}
 
-	ret = 0;
-done:
-	if (data->free)
-		sfree(data);
-	return ret;
-err:
 	while (!flist_empty(&list)) {
-		c = flist_first_entry(list.next, struct iolog_compress, list);
+		struct iolog_compress *c;
+
+		c = flist_first_entry(&list, struct iolog_compress, list);
 		flist_del(&c->list);
 		free_chunk(c);
 	}
-	ret = 1;
-	goto done;
+
+	if (data->free)
+		sfree(data);
+	return ret;
 }
 
 /*
@@ -1653,12 +2180,24 @@ static struct workqueue_ops log_compress_wq_ops = {
 	.nice		= 1,
 };
 
+/*
+ * Chunks are compressed independently, so use a worker for each CPU in
+ * log_compression_cpus.
+ */
 int iolog_compress_init(struct thread_data *td, struct sk_out *sk_out)
 {
+	unsigned int workers = 1;
+
 	if (!(td->flags & TD_F_COMPRESS_LOG))
 		return 0;
 
-	workqueue_init(td, &td->log_compress_wq, &log_compress_wq_ops, 1, sk_out);
+#ifdef FIO_HAVE_CPU_AFFINITY
+	if (fio_option_is_set(&td->o, log_gz_cpumask))
+		workers = max(fio_cpu_count(&td->o.log_gz_cpumask), 1);
+#endif
+
+	workqueue_init(td, &td->log_compress_wq, &log_compress_wq_ops, workers,
+			sk_out);
 	return 0;
 }
 
@@ -1697,6 +2236,7 @@ static int iolog_flush(struct io_log *log)
 
 		data->samples = cur_log->log;
 		data->nr_samples = cur_log->nr_samples;
+		data->seq = ++log->chunk_seq;
 
 		sfree(cur_log);
 
@@ -1719,6 +2259,7 @@ int iolog_cur_flush(struct io_log *log, struct io_logs *cur_log)
 
 	data->samples = cur_log->log;
 	data->nr_samples = cur_log->nr_samples;
+	data->seq = ++log->chunk_seq;
 	data->free = true;
 
 	cur_log->nr_samples = cur_log->max_samples = 0;
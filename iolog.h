@@ -74,6 +74,16 @@ enum {
 	IO_LOG_TYPE_HIST,
 };
 
+/*
+ * Compressors for log_compression. Each compressed chunk is one
+ * self-contained zlib stream, zstd frame or lz4 frame.
+ */
+enum {
+	IO_LOG_COMP_ZLIB = 0,
+	IO_LOG_COMP_ZSTD,
+	IO_LOG_COMP_LZ4,
+};
+
 #define DEF_LOG_ENTRIES		1024
 #define MAX_LOG_ENTRIES		(1024 * DEF_LOG_ENTRIES)
 
@@ -138,6 +148,11 @@ struct io_log {
 	 */
 	unsigned int log_gz_store;
 
+	/*
+	 * Compressor, IO_LOG_COMP_*
+	 */
+	unsigned int log_gz_type;
+
 	/*
 	 * Windowed average, for logging single entries average over some
 	 * period of time.
@@ -260,6 +275,7 @@ struct io_piece {
 		struct fio_file *file;
 	};
 	unsigned long long offset;
+	unsigned long long verify_offset;
 	unsigned short numberio;
 	unsigned long len;
 	unsigned int flags;
@@ -268,6 +284,33 @@ struct io_piece {
 	unsigned int file_action;
 };
 
+/*
+ * Dense write history for verify. Jobs with a fixed write block size that
+ * would otherwise sort every write into io_hist_tree log their writes here
+ * instead, one entry per block of the file. See init_verify_map().
+ */
+enum {
+	VMAP_F_LOGGED		= 1 << 15,
+	VMAP_INFLIGHT_MASK	= VMAP_F_LOGGED - 1,
+};
+
+struct verify_map_block {
+	unsigned short numberio;
+	unsigned short state;	/* VMAP_F_LOGGED | writes in flight */
+};
+
+struct vj_block;
+
+struct verify_map {
+	uint64_t start;
+	unsigned long long bs;
+	uint64_t nr_blocks;
+	uint64_t nr_logged;
+	uint64_t cursor;	/* no logged block before this one */
+	struct vj_block *journal;	/* verify journal check, per block */
+	struct verify_map_block blocks[0];
+};
+
 /*
  * Log exports
  */
@@ -285,7 +328,11 @@ extern void log_file(struct thread_data *, struct fio_file *, enum file_log_act)
 extern bool __must_check init_iolog(struct thread_data *td);
 extern void log_io_piece(struct thread_data *, struct io_u *);
 extern void unlog_io_piece(struct thread_data *, struct io_u *);
+extern void place_io_piece(struct thread_data *, struct io_u *);
 extern void trim_io_piece(const struct io_u *);
+extern void init_verify_map(struct thread_data *);
+extern void verify_map_complete(struct thread_data *, struct io_u *);
+extern bool verify_map_next(struct thread_data *, struct io_u *);
 extern void queue_io_piece(struct thread_data *, struct io_piece *);
 extern void prune_io_piece_log(struct thread_data *);
 extern void write_iolog_close(struct thread_data *);
@@ -315,6 +362,7 @@ struct log_params {
 	int log_issue_time;
 	int log_gz;
 	int log_gz_store;
+	int log_gz_type;
 	int log_compress;
 };
 
@@ -38,6 +38,10 @@
 #include "pattern.h"
 #include "../hash.h"
 
+#if defined(ARCH_HAVE_AVX2)
+#include <immintrin.h>
+#endif
+
 int arch_random;
 
 static inline uint64_t __seed(uint64_t x, uint64_t m)
@@ -110,6 +114,79 @@ void __fill_random_buf_small(void *buf, unsigned int len, uint64_t seed)
 		__builtin_memcpy(e, &seed, rest);
 }
 
+#if defined(ARCH_HAVE_AVX2)
+
+static bool fill_random_avx2;
+
+#define AVX2_TARGET	__attribute__((target("avx2")))
+
+/*
+ * Low 64 bits of a * k, with k_hi holding the upper half of k
+ */
+static inline AVX2_TARGET __m256i mul64_avx2(__m256i a, __m256i k,
+					     __m256i k_hi)
+{
+	__m256i lo = _mm256_mul_epu32(a, k);
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(a, k_hi),
+				_mm256_mul_epu32(_mm256_srli_epi64(a, 32), k));
+
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+/*
+ * Each row of seed buckets is the previous row multiplied by
+ * GOLDEN_RATIO_64. Keep four rows in CONFIG_SEED_BUCKETS vectors and move
+ * them on by GOLDEN_RATIO_64^4 at a time, which writes the same bytes as
+ * the scalar loop. Returns where the scalar loop should carry on, with @s
+ * holding the next row.
+ */
+static AVX2_TARGET uint64_t *fill_random_rows_avx2(uint64_t *b, uint64_t *e,
+						   uint64_t *s)
+{
+	const uint64_t step = GOLDEN_RATIO_64 * GOLDEN_RATIO_64 *
+				GOLDEN_RATIO_64 * GOLDEN_RATIO_64;
+	const __m256i k = _mm256_set1_epi64x(step);
+	const __m256i k_hi = _mm256_set1_epi64x(step >> 32);
+	uint64_t rows[4 * CONFIG_SEED_BUCKETS];
+	__m256i v[CONFIG_SEED_BUCKETS];
+	int p;
+
+	if (e - b < 4 * CONFIG_SEED_BUCKETS)
+		return b;
+
+	for (p = 0; p < CONFIG_SEED_BUCKETS; p++) {
+		rows[p] = s[p];
+		rows[p + CONFIG_SEED_BUCKETS] = __hash_u64(rows[p]);
+		rows[p + 2 * CONFIG_SEED_BUCKETS] =
+				__hash_u64(rows[p + CONFIG_SEED_BUCKETS]);
+		rows[p + 3 * CONFIG_SEED_BUCKETS] =
+				__hash_u64(rows[p + 2 * CONFIG_SEED_BUCKETS]);
+	}
+	for (p = 0; p < CONFIG_SEED_BUCKETS; p++)
+		v[p] = _mm256_loadu_si256((__m256i *) rows + p);
+
+	for (; e - b >= 4 * CONFIG_SEED_BUCKETS; b += 4 * CONFIG_SEED_BUCKETS) {
+		for (p = 0; p < CONFIG_SEED_BUCKETS; p++) {
+			_mm256_storeu_si256((__m256i *) b + p, v[p]);
+			v[p] = mul64_avx2(v[p], k, k_hi);
+		}
+	}
+
+	for (p = 0; p < CONFIG_SEED_BUCKETS; p++)
+		_mm256_storeu_si256((__m256i *) rows + p, v[p]);
+	for (p = 0; p < CONFIG_SEED_BUCKETS; p++)
+		s[p] = rows[p];
+
+	return b;
+}
+
+static void fio_init fill_random_init(void)
+{
+	fill_random_avx2 = arch_cpu_has_avx2();
+}
+
+#endif
+
 void __fill_random_buf(void *buf, unsigned int len, uint64_t seed)
 {
 	static uint64_t prime[] = {1, 2, 3, 5, 7, 11, 13, 17,
@@ -131,6 +208,11 @@ void __fill_random_buf(void *buf, unsigned int len, uint64_t seed)
 	for (p = 0; p < CONFIG_SEED_BUCKETS; p++)
 		s[p] = seed * prime[p];
 
+#if defined(ARCH_HAVE_AVX2)
+	if (fill_random_avx2)
+		b = fill_random_rows_avx2(b, e, s);
+#endif
+
 	for (; b != e; b += CONFIG_SEED_BUCKETS) {
 		for (p = 0; p < CONFIG_SEED_BUCKETS; ++p) {
 			b[p] = s[p];
@@ -1806,6 +1806,34 @@ static int str_zoneskip_cb(void *data, long long *__val)
 	return 0;
 }
 
+static int str_lat_heatmap_region_cb(void *data, long long *__val)
+{
+	struct thread_data *td = cb_data_to_td(data);
+	unsigned long long v = *__val;
+
+	if (parse_is_zone(v)) {
+		td->o.lat_heatmap_region = 0;
+		td->o.lat_heatmap_region_nz = v - ZONE_BASE_VAL;
+	} else {
+		td->o.lat_heatmap_region = v;
+		td->o.lat_heatmap_region_nz = 0;
+	}
+
+	return 0;
+}
+
+static int str_write_lat_heatmap_cb(void *data, const char *str)
+{
+	struct thread_data *td = cb_data_to_td(data);
+
+	if (str)
+		td->o.lat_heatmap_file = strdup(str);
+
+	td->o.write_lat_heatmap = 1;
+	td->o.lat_heatmap = 1;
+	return 0;
+}
+
 static int str_write_bw_log_cb(void *data, const char *str)
 {
 	struct thread_data *td = cb_data_to_td(data);
@@ -1850,6 +1878,17 @@ static int str_write_hist_log_cb(void *data, const char *str)
 	return 0;
 }
 
+static int str_write_pct_log_cb(void *data, const char *str)
+{
+	struct thread_data *td = cb_data_to_td(data);
+
+	if (str)
+		td->o.pct_log_file = strdup(str);
+
+	td->o.write_pct_log = 1;
+	return 0;
+}
+
 /*
  * str is supposed to be a substring of the strdup'd original string,
  * and is valid only if it's a regular file path.
@@ -3205,6 +3244,14 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 			    .oval = VERIFY_XXHASH,
 			    .help = "Use xxhash checksums for verification",
 			  },
+			  { .ival = "xxh3",
+			    .oval = VERIFY_XXH3,
+			    .help = "Use 64-bit xxh3 checksums for verification",
+			  },
+			  { .ival = "xxh128",
+			    .oval = VERIFY_XXH128,
+			    .help = "Use 128-bit xxh3 checksums for verification",
+			  },
 			  /* Meta information was included into verify_header,
 			   * 'meta' verification is implied by default. */
 			  { .ival = "meta",
@@ -3376,6 +3423,17 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_VERIFY,
 	},
+	{
+		.name	= "verify_streaming",
+		.lname	= "Streaming verify",
+		.off1	= offsetof(struct thread_options, verify_streaming),
+		.type	= FIO_OPT_BOOL,
+		.help	= "Regenerate written blocks for verify instead of logging them",
+		.def	= "0",
+		.parent	= "verify",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_VERIFY,
+	},
 	{
 		.name	= "verify_state_load",
 		.lname	= "Load verify state",
@@ -3408,6 +3466,17 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_VERIFY,
 	},
+	{
+		.name	= "verify_journal",
+		.lname	= "Verify journal",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct thread_options, verify_journal),
+		.maxlen	= PATH_MAX,
+		.help	= "Journal acknowledged writes and flushes, for verifying after a power failure",
+		.parent	= "verify",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_VERIFY,
+	},
 #ifdef FIO_HAVE_TRIM
 	{
 		.name	= "trim_percentage",
@@ -3759,6 +3828,49 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "zone_emulation",
+		.lname	= "Emulate a host-managed zoned device on regular files",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, zone_emu),
+		.def	= "0",
+		.help	= "Present regular files as host-managed zoned block devices with zonemode=zbd",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "zone_emulation_max_open",
+		.lname	= "Emulated maximum number of open zones",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, zone_emu_max_open),
+		.maxval	= ZBD_MAX_WRITE_ZONES,
+		.def	= "0",
+		.help	= "Open zone limit of the emulated zoned block device",
+		.parent	= "zone_emulation",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "zone_emulation_max_active",
+		.lname	= "Emulated maximum number of active zones",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, zone_emu_max_active),
+		.def	= "0",
+		.help	= "Active zone limit of the emulated zoned block device",
+		.parent	= "zone_emulation",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "zone_append",
+		.lname	= "Issue writes as zone append commands",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, zone_append),
+		.def	= "0",
+		.help	= "Let the device place writes within the target zone (zonemode=zbd)",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
 	{
 		.name	= "zone_reset_threshold",
 		.lname	= "Zone reset threshold",
@@ -3866,6 +3978,53 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "dp_emulation",
+		.lname	= "Emulate data placement",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, dp_emu),
+		.def	= "0",
+		.help	= "Emulate a data placement capable device and track its reclaim units",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "dp_emulation_ru_size",
+		.lname	= "Emulated reclaim unit size",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct thread_options, dp_emu_ru_size),
+		.def	= "64M",
+		.help	= "Size of a reclaim unit of the emulated device",
+		.parent	= "dp_emulation",
+		.interval = 1024 * 1024,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "dp_emulation_nr_ruhs",
+		.lname	= "Emulated number of reclaim unit handles",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, dp_emu_nr_ruhs),
+		.minval	= 1,
+		.maxval	= FIO_MAX_DP_IDS,
+		.def	= "8",
+		.help	= "Number of reclaim unit handles of the emulated device",
+		.parent	= "dp_emulation",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "dp_emulation_op",
+		.lname	= "Emulated over-provisioning",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, dp_emu_op),
+		.maxval	= 100,
+		.def	= "7",
+		.help	= "Over-provisioning of the emulated device in percent",
+		.parent	= "dp_emulation",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
 	{
 		.name	= "lockmem",
 		.lname	= "Lock memory",
@@ -4676,6 +4835,50 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_LOG,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "write_pct_log",
+		.lname	= "Write latency percentile logs",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct thread_options, pct_log_file),
+		.cb	= str_write_pct_log_cb,
+		.help	= "Write log of per-interval latency percentiles during run",
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "log_pct_msec",
+		.lname	= "Log percentiles (msec)",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, log_pct_msec),
+		.help	= "Interval at which latency percentiles are logged",
+		.def	= "1000",
+		.minval	= 1,
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "log_pct_list",
+		.lname	= "Logged percentile list",
+		.type	= FIO_OPT_FLOAT_LIST,
+		.off1	= offsetof(struct thread_options, log_pct_list),
+		.help	= "Percentiles to write to the latency percentile log",
+		.def	= "50:90:99:99.9:99.99",
+		.maxlen	= FIO_IO_U_LIST_MAX_LEN,
+		.minfp	= 0.0,
+		.maxfp	= 100.0,
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "log_pct_json",
+		.lname	= "Log percentiles as JSON",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, log_pct_json),
+		.help	= "Write the latency percentile log as JSON lines",
+		.def	= "0",
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
 	{
 		.name	= "log_window_value",
 		.alias  = "log_max_value",
@@ -4772,6 +4975,35 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.help	= "Your platform does not support CPU affinities",
 	},
 #endif
+	{
+		.name	= "log_compression_type",
+		.lname	= "Log compression type",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct thread_options, log_gz_type),
+		.help	= "Compressor to use for log chunks",
+		.def	= "zlib",
+		.parent = "log_compression",
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+		.posval	= {
+			  { .ival = "zlib",
+			    .oval = IO_LOG_COMP_ZLIB,
+			    .help = "zlib deflate",
+			  },
+#ifdef CONFIG_ZSTD
+			  { .ival = "zstd",
+			    .oval = IO_LOG_COMP_ZSTD,
+			    .help = "Zstandard frames",
+			  },
+#endif
+#ifdef CONFIG_LZ4
+			  { .ival = "lz4",
+			    .oval = IO_LOG_COMP_LZ4,
+			    .help = "LZ4 frames",
+			  },
+#endif
+		},
+	},
 	{
 		.name	= "log_store_compressed",
 		.lname	= "Log store compressed",
@@ -4788,6 +5020,12 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.type	= FIO_OPT_UNSUPPORTED,
 		.help	= "Install libz-dev(el) to get compression support",
 	},
+	{
+		.name	= "log_compression_type",
+		.lname	= "Log compression type",
+		.type	= FIO_OPT_UNSUPPORTED,
+		.help	= "Install libz-dev(el) to get compression support",
+	},
 	{
 		.name	= "log_store_compressed",
 		.lname	= "Log store compressed",
@@ -4957,6 +5195,16 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_IO_BUF,
 	},
+	{
+		.name	= "dedupe_working_set_cache",
+		.lname	= "Dedupe working set cache",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, dedupe_working_set_cache),
+		.help	= "Precompute the dedupe working set in shared memory",
+		.def	= "0",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
 	{
 		.name	= "dedupe_mode",
 		.lname	= "Dedupe mode",
@@ -4991,6 +5239,26 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_IO_BUF,
 	},
+	{
+		.name	= "buffer_pool_size",
+		.lname	= "Buffer content pool size",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct thread_options, buffer_pool_size),
+		.help	= "Size of the pool of pre-generated write content",
+		.def	= "0",
+		.interval = 1024 * 1024,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
+	{
+		.name	= "buffer_pool_file",
+		.lname	= "Buffer content pool file",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct thread_options, buffer_pool_file),
+		.help	= "Take write content from this sample file",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
 	{
 		.name	= "clat_percentiles",
 		.lname	= "Completion latency percentiles",
@@ -5036,6 +5304,101 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_STAT,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "lat_outliers",
+		.lname	= "Latency outliers",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, lat_outliers),
+		.help	= "Report the slowest I/Os, this many per window",
+		.def	= "0",
+		.maxval	= FIO_LAT_OUTLIERS_MAX,
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "lat_outliers_window",
+		.lname	= "Latency outliers window",
+		.type	= FIO_OPT_STR_VAL_TIME,
+		.off1	= offsetof(struct thread_options, lat_outliers_window),
+		.help	= "Keep the slowest I/Os per window of this length",
+		.def	= "0",
+		.is_time = 1,
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "lat_heatmap",
+		.lname	= "Latency heatmap",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, lat_heatmap),
+		.help	= "Keep a completion latency histogram per device region",
+		.def	= "0",
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "lat_heatmap_region",
+		.lname	= "Latency heatmap region size",
+		.type	= FIO_OPT_STR_VAL_ZONE,
+		.cb	= str_lat_heatmap_region_cb,
+		.off1	= offsetof(struct thread_options, lat_heatmap_region),
+		.help	= "Size of each latency heatmap region",
+		.def	= "1g",
+		.minval	= 1,
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "write_lat_heatmap",
+		.lname	= "Write latency heatmap",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct thread_options, lat_heatmap_file),
+		.cb	= str_write_lat_heatmap_cb,
+		.help	= "Write the latency heatmap to a binary file",
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "file_stats",
+		.lname	= "Per-file stats",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, file_stats),
+		.help	= "Report this many files with the highest latency or bandwidth",
+		.def	= "0",
+		.maxval	= FIO_FILE_STATS_MAX,
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "file_stats_sort",
+		.lname	= "Per-file stats sort order",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct thread_options, file_stats_sort),
+		.help	= "Rank files by mean latency or by bandwidth",
+		.def	= "lat",
+		.posval	= {
+			  { .ival = "lat",
+			    .oval = FIO_FILE_STATS_LAT,
+			    .help = "Highest mean completion latency",
+			  },
+			  { .ival = "bw",
+			    .oval = FIO_FILE_STATS_BW,
+			    .help = "Highest bandwidth",
+			  },
+		},
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "clat_depth_hist",
+		.lname	= "Completion latency by queue depth",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, clat_depth_hist),
+		.help	= "Split completion latency by queue depth at submit",
+		.def	= "0",
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
 	{
 		.name	= "significant_figures",
 		.lname	= "Significant figures",
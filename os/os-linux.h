@@ -32,6 +32,12 @@
 #ifndef HWCAP_PMULL
 #define HWCAP_PMULL             (1 << 4)
 #endif /* HWCAP_PMULL */
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1              (1 << 5)
+#endif /* HWCAP_SHA1 */
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2              (1 << 6)
+#endif /* HWCAP_SHA2 */
 #ifndef HWCAP_CRC32
 #define HWCAP_CRC32             (1 << 7)
 #endif /* HWCAP_CRC32 */
@@ -422,6 +428,18 @@ static inline bool os_cpu_has(cpu_features feature)
 		have_feature = (hwcap & (HWCAP_PMULL | HWCAP_CRC32)) ==
 			       (HWCAP_PMULL | HWCAP_CRC32);
 		break;
+	case CPU_ARM64_PMULL:
+		hwcap = getauxval(AT_HWCAP);
+		have_feature = (hwcap & HWCAP_PMULL) != 0;
+		break;
+	case CPU_ARM64_SHA1:
+		hwcap = getauxval(AT_HWCAP);
+		have_feature = (hwcap & HWCAP_SHA1) != 0;
+		break;
+	case CPU_ARM64_SHA2:
+		hwcap = getauxval(AT_HWCAP);
+		have_feature = (hwcap & HWCAP_SHA2) != 0;
+		break;
 #endif
 	default:
 		have_feature = false;
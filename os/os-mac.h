@@ -110,10 +110,16 @@ static inline bool fio_fallocate(struct fio_file *f, uint64_t offset, uint64_t l
 
 static inline bool os_cpu_has(cpu_features feature)
 {
-	/* just check for arm on OSX for now, we know that has it */
-	if (feature != CPU_ARM64_CRC32C)
+	/* just check for arm on OSX for now, we know that has these */
+	switch (feature) {
+	case CPU_ARM64_CRC32C:
+	case CPU_ARM64_PMULL:
+	case CPU_ARM64_SHA1:
+	case CPU_ARM64_SHA2:
+		return FIO_ARCH == arch_aarch64;
+	default:
 		return false;
-	return FIO_ARCH == arch_aarch64;
+	}
 }
 
 #endif
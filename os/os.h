@@ -31,6 +31,9 @@ enum {
 
 typedef enum {
         CPU_ARM64_CRC32C,
+        CPU_ARM64_PMULL,
+        CPU_ARM64_SHA1,
+        CPU_ARM64_SHA2,
 } cpu_features;
 
 /* IWYU pragma: begin_exports */
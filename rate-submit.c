@@ -43,7 +43,7 @@ retry:
 		    td->o.io_submit_mode != IO_MODE_OFFLOAD)
 			continue;
 
-		if (!in_flight_overlap(&td->io_u_all, io_u))
+		if (!in_flight_overlap(td, io_u))
 			continue;
 
 		res = pthread_mutex_unlock(&overlap_check);
@@ -86,6 +86,7 @@ static int io_workqueue_fn(struct submit_worker *sw,
 			td->cur_depth -= ret;
 		else if (ret < 0)
 			break;
+		io_u_overlap_del(td, io_u);
 		io_u_clear(td, io_u, IO_U_F_FLIGHT);
 	} while (1);
 
@@ -1689,6 +1689,10 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	struct cmd_ts_pdu p;
 	int i, j, k;
 	size_t clat_prio_stats_extra_size = 0;
+	size_t lat_outliers_extra_size = 0;
+	size_t lat_heatmap_extra_size = 0;
+	size_t file_stats_extra_size = 0;
+	size_t clat_depth_extra_size = 0;
 	size_t ss_extra_size = 0;
 	size_t extended_buf_size = 0;
 	void *extended_buf;
@@ -1772,12 +1776,39 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	p.ts.total_complete	= cpu_to_le64(ts->total_complete);
 	p.ts.nr_zone_resets	= cpu_to_le64(ts->nr_zone_resets);
 
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++) {
+		convert_io_stat(&p.ts.zone_mgmt_stat[i], &ts->zone_mgmt_stat[i]);
+		for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+			p.ts.io_u_zone_mgmt_plat[i][j] = cpu_to_le64(ts->io_u_zone_mgmt_plat[i][j]);
+	}
+
+	for (i = 0; i < FIO_MAX_DP_IDS; i++) {
+		p.ts.dp_io_bytes[i]	= cpu_to_le64(ts->dp_io_bytes[i]);
+		convert_io_stat(&p.ts.dp_clat_stat[i], &ts->dp_clat_stat[i]);
+		p.ts.dp_ru_reclaims[i]	= cpu_to_le64(ts->dp_ru_reclaims[i]);
+		p.ts.dp_gc_bytes[i]	= cpu_to_le64(ts->dp_gc_bytes[i]);
+	}
+	p.ts.dp_emu_host_bytes	= cpu_to_le64(ts->dp_emu_host_bytes);
+	p.ts.dp_emu_gc_bytes	= cpu_to_le64(ts->dp_emu_gc_bytes);
+
+	for (i = 0; i < FIO_VJ_CNT; i++)
+		p.ts.vj_blocks[i]	= cpu_to_le64(ts->vj_blocks[i]);
+	p.ts.vj_violations	= cpu_to_le64(ts->vj_violations);
+
+	p.ts.dedupe_bufs	= cpu_to_le64(ts->dedupe_bufs);
+	p.ts.dedupe_dup_bufs	= cpu_to_le64(ts->dedupe_dup_bufs);
+	p.ts.dedupe_percentage	= cpu_to_le32(ts->dedupe_percentage);
+
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		p.ts.io_bytes[i]	= cpu_to_le64(ts->io_bytes[i]);
 		p.ts.runtime[i]		= cpu_to_le64(ts->runtime[i]);
 	}
 
 	p.ts.total_run_time	= cpu_to_le64(ts->total_run_time);
+	p.ts.zc_bytes		= cpu_to_le64(ts->zc_bytes);
+	p.ts.zc_copied_bytes	= cpu_to_le64(ts->zc_copied_bytes);
+	p.ts.http_requests	= cpu_to_le64(ts->http_requests);
+	p.ts.http_connects	= cpu_to_le64(ts->http_connects);
 	p.ts.continue_on_error	= cpu_to_le16(ts->continue_on_error);
 	p.ts.total_err_count	= cpu_to_le64(ts->total_err_count);
 	p.ts.first_error	= cpu_to_le32(ts->first_error);
@@ -1806,6 +1837,12 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	p.ts.cachehit		= cpu_to_le64(ts->cachehit);
 	p.ts.cachemiss		= cpu_to_le64(ts->cachemiss);
 
+	p.ts.lat_outliers_per_window = cpu_to_le32(ts->lat_outliers_per_window);
+	p.ts.lat_outliers_window = cpu_to_le64(ts->lat_outliers_window);
+	p.ts.lat_heatmap_region	= cpu_to_le64(ts->lat_heatmap_region);
+	p.ts.file_stats_top	= cpu_to_le32(ts->file_stats_top);
+	p.ts.file_stats_sort	= cpu_to_le32(ts->file_stats_sort);
+
 	convert_gs(&p.rs, rs);
 
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
@@ -1814,6 +1851,23 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	}
 	extended_buf_size += clat_prio_stats_extra_size;
 
+	if (ts->lat_outliers)
+		lat_outliers_extra_size = ts->lat_outliers_slots * sizeof(*ts->lat_outliers);
+	extended_buf_size += lat_outliers_extra_size;
+
+	if (ts->lat_heatmap)
+		lat_heatmap_extra_size = ts->lat_heatmap_regions *
+			FIO_LAT_HEATMAP_NR * sizeof(*ts->lat_heatmap);
+	extended_buf_size += lat_heatmap_extra_size;
+
+	if (ts->file_stats)
+		file_stats_extra_size = ts->nr_file_stats * sizeof(*ts->file_stats);
+	extended_buf_size += file_stats_extra_size;
+
+	if (ts->clat_depth)
+		clat_depth_extra_size = ts->clat_depth_nr * sizeof(*ts->clat_depth);
+	extended_buf_size += clat_depth_extra_size;
+
 	dprint(FD_NET, "ts->ss_state = %d\n", ts->ss_state);
 	if (ts->ss_state & FIO_SS_DATA)
 		ss_extra_size = 2 * ts->ss_dur * sizeof(uint64_t);
@@ -1860,6 +1914,83 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 		}
 	}
 
+	if (lat_outliers_extra_size) {
+		struct lat_outlier *dst = extended_buf_wp;
+		struct cmd_ts_pdu *ptr = extended_buf;
+		uint64_t offset = (char *)extended_buf_wp - (char *)extended_buf;
+
+		for (i = 0; i < ts->lat_outliers_slots; i++) {
+			struct lat_outlier *src = &ts->lat_outliers[i];
+
+			dst[i].lat = cpu_to_le64(src->lat);
+			dst[i].offset = cpu_to_le64(src->offset);
+			dst[i].start = cpu_to_le64(src->start);
+			dst[i].issue = cpu_to_le64(src->issue);
+			dst[i].complete = cpu_to_le64(src->complete);
+			dst[i].window = cpu_to_le32(src->window);
+			dst[i].fileno = cpu_to_le32(src->fileno);
+			dst[i].len = cpu_to_le32(src->len);
+			dst[i].depth = cpu_to_le32(src->depth);
+			dst[i].ddir = cpu_to_le16(src->ddir);
+			dst[i].ioprio = cpu_to_le16(src->ioprio);
+		}
+
+		ptr->ts.lat_outliers_offset = cpu_to_le64(offset);
+		ptr->ts.lat_outliers_slots = cpu_to_le32(ts->lat_outliers_slots);
+		extended_buf_wp = dst + ts->lat_outliers_slots;
+	}
+
+	if (lat_heatmap_extra_size) {
+		uint64_t *dst = extended_buf_wp;
+		struct cmd_ts_pdu *ptr = extended_buf;
+		uint64_t offset = (char *)extended_buf_wp - (char *)extended_buf;
+		unsigned int nr = ts->lat_heatmap_regions * FIO_LAT_HEATMAP_NR;
+
+		for (i = 0; i < nr; i++)
+			dst[i] = cpu_to_le64(ts->lat_heatmap[i]);
+
+		ptr->ts.lat_heatmap_offset = cpu_to_le64(offset);
+		ptr->ts.lat_heatmap_regions = cpu_to_le32(ts->lat_heatmap_regions);
+		extended_buf_wp = dst + nr;
+	}
+
+	if (file_stats_extra_size) {
+		struct file_stat_entry *dst = extended_buf_wp;
+		struct cmd_ts_pdu *ptr = extended_buf;
+		uint64_t offset = (char *)extended_buf_wp - (char *)extended_buf;
+
+		for (i = 0; i < ts->nr_file_stats; i++) {
+			struct file_stat_entry *src = &ts->file_stats[i];
+
+			memcpy(dst[i].name, src->name, sizeof(dst[i].name));
+			dst[i].fs.bytes = cpu_to_le64(src->fs.bytes);
+			dst[i].fs.lat_sum = cpu_to_le64(src->fs.lat_sum);
+			dst[i].fs.lat_max = cpu_to_le64(src->fs.lat_max);
+			for (j = 0; j < FIO_FILE_STAT_NR; j++)
+				dst[i].fs.lat_hist[j] = cpu_to_le32(src->fs.lat_hist[j]);
+		}
+
+		ptr->ts.file_stats_offset = cpu_to_le64(offset);
+		ptr->ts.nr_file_stats = cpu_to_le32(ts->nr_file_stats);
+		extended_buf_wp = dst + ts->nr_file_stats;
+	}
+
+	if (clat_depth_extra_size) {
+		struct clat_depth_stat *dst = extended_buf_wp;
+		struct cmd_ts_pdu *ptr = extended_buf;
+		uint64_t offset = (char *)extended_buf_wp - (char *)extended_buf;
+
+		for (i = 0; i < ts->clat_depth_nr; i++) {
+			dst[i].lat_sum = cpu_to_le64(ts->clat_depth[i].lat_sum);
+			for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+				dst[i].hist[j] = cpu_to_le64(ts->clat_depth[i].hist[j]);
+		}
+
+		ptr->ts.clat_depth_offset = cpu_to_le64(offset);
+		ptr->ts.clat_depth_nr = cpu_to_le32(ts->clat_depth_nr);
+		extended_buf_wp = dst + ts->clat_depth_nr;
+	}
+
 	if (ss_extra_size) {
 		uint64_t *ss_iops, *ss_bw;
 		uint64_t offset;
@@ -2258,6 +2389,9 @@ int fio_send_iolog(struct thread_data *td, struct io_log *log, const char *name)
 		.nr_samples		= cpu_to_le64(iolog_nr_samples(log)),
 		.thread_number		= cpu_to_le32(td->thread_number),
 		.log_type		= cpu_to_le32(log->log_type),
+		.log_offset		= cpu_to_le32(log->log_offset),
+		.log_prio		= cpu_to_le32(log->log_prio),
+		.log_issue_time		= cpu_to_le32(log->log_issue_time),
 		.log_hist_coarseness	= cpu_to_le32(log->hist_coarseness),
 		.per_job_logs		= cpu_to_le32(td->o.per_job_logs),
 	};
@@ -526,6 +526,108 @@ static double convert_agg_kbytes_percent(struct group_run_stats *rs,
 	return p_of_agg;
 }
 
+static const char *zone_mgmt_name[FIO_ZONE_MGMT_CNT] = {
+	"reset", "finish",
+};
+
+static void show_zone_mgmt_status(struct thread_stat *ts,
+				  struct buf_output *out)
+{
+	unsigned long long min, max;
+	double mean, dev;
+	int i;
+
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++) {
+		if (!calc_lat(&ts->zone_mgmt_stat[i], &min, &max, &mean, &dev))
+			continue;
+
+		log_buf(out, "  zone %s: cmds=%llu\n", zone_mgmt_name[i],
+			(unsigned long long) ts->zone_mgmt_stat[i].samples);
+		display_lat("lat", min, max, mean, dev, out);
+		show_clat_percentiles(ts->io_u_zone_mgmt_plat[i],
+					ts->zone_mgmt_stat[i].samples,
+					ts->percentile_list,
+					ts->percentile_precision,
+					"lat", out);
+	}
+}
+
+static void show_dp_status(struct group_run_stats *rs, struct thread_stat *ts,
+			   struct buf_output *out)
+{
+	unsigned long runt = ts->runtime[DDIR_WRITE];
+	unsigned long long min, max;
+	double mean, dev;
+	int i2p = is_power_of_2(rs->kb_base);
+	int i;
+
+	for (i = 0; i < FIO_MAX_DP_IDS; i++) {
+		char *io_p, *bw_p, *bw_p_alt, *iops_p, *post_st = NULL;
+		uint64_t bw, iops;
+
+		if (!calc_lat(&ts->dp_clat_stat[i], &min, &max, &mean, &dev))
+			continue;
+
+		bw = runt ? (1000 * ts->dp_io_bytes[i]) / runt : 0;
+		iops = runt ? (1000 * ts->dp_clat_stat[i].samples) / runt : 0;
+		io_p = num2str(ts->dp_io_bytes[i], ts->sig_figs, 1, i2p, N2S_BYTE);
+		bw_p = num2str(bw, ts->sig_figs, 1, i2p, ts->unit_base);
+		bw_p_alt = num2str(bw, ts->sig_figs, 1, !i2p, ts->unit_base);
+		iops_p = num2str(iops, ts->sig_figs, 1, 0, N2S_NONE);
+		if (ts->dp_emu_host_bytes) {
+			char *gc_p = num2str(ts->dp_gc_bytes[i], ts->sig_figs,
+					     1, i2p, N2S_BYTE);
+
+			if (asprintf(&post_st, "; %llu RU reclaims, %s relocated",
+				     (unsigned long long) ts->dp_ru_reclaims[i],
+				     gc_p) < 0)
+				post_st = NULL;
+			free(gc_p);
+		}
+
+		log_buf(out, "  plid %d: IOPS=%s, BW=%s (%s)(%s)%s\n", i,
+			iops_p, bw_p, bw_p_alt, io_p, post_st ? : "");
+		display_lat("clat", min, max, mean, dev, out);
+
+		free(post_st);
+		free(io_p);
+		free(bw_p);
+		free(bw_p_alt);
+		free(iops_p);
+	}
+
+	if (ts->dp_emu_host_bytes) {
+		char *gc_p = num2str(ts->dp_emu_gc_bytes, ts->sig_figs, 1, i2p,
+				     N2S_BYTE);
+
+		log_buf(out, "  dp emulation: %s relocated, waf=%.2f\n", gc_p,
+			(double) (ts->dp_emu_host_bytes + ts->dp_emu_gc_bytes) /
+			ts->dp_emu_host_bytes);
+		free(gc_p);
+	}
+}
+
+static const char *vj_state_name[FIO_VJ_CNT] = {
+	"durable", "torn", "lost",
+};
+
+static void show_vj_status(struct thread_stat *ts, struct buf_output *out)
+{
+	int i;
+
+	for (i = 0; i < FIO_VJ_CNT; i++)
+		if (ts->vj_blocks[i])
+			break;
+	if (i == FIO_VJ_CNT)
+		return;
+
+	log_buf(out, "  verify journal: durable=%llu, torn=%llu, lost=%llu, flushed but not durable=%llu\n",
+		(unsigned long long) ts->vj_blocks[FIO_VJ_DURABLE],
+		(unsigned long long) ts->vj_blocks[FIO_VJ_TORN],
+		(unsigned long long) ts->vj_blocks[FIO_VJ_LOST],
+		(unsigned long long) ts->vj_violations);
+}
+
 static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 			     enum fio_ddir ddir, struct buf_output *out)
 {
@@ -716,6 +818,10 @@ static void show_mixed_ddir_status(struct group_run_stats *rs,
 		show_ddir_status(rs, ts_lcl, DDIR_READ, out);
 
 	free_clat_prio_stats(ts_lcl);
+	free_lat_outliers(ts_lcl);
+	free_lat_heatmap(ts_lcl);
+	free_file_stats(ts_lcl);
+	free_clat_depth(ts_lcl);
 	free(ts_lcl);
 }
 
@@ -1228,6 +1334,10 @@ static void show_thread_status_normal(struct thread_stat *ts,
 	if (ts->sync_stat.samples)
 		show_ddir_status(rs, ts, DDIR_SYNC, out);
 
+	show_zone_mgmt_status(ts, out);
+	show_dp_status(rs, ts, out);
+	show_vj_status(ts, out);
+
 	runtime = ts->total_run_time;
 	if (runtime) {
 		double runt = (double) runtime;
@@ -1283,6 +1393,12 @@ static void show_thread_status_normal(struct thread_stat *ts,
 					ts->first_error,
 					strerror(ts->first_error));
 	}
+	if (ts->dedupe_bufs) {
+		log_buf(out, "     dedupe    : requested=%u%%, achieved=%.2f%% of %llu buffers\n",
+					ts->dedupe_percentage,
+					100.0 * ts->dedupe_dup_bufs / ts->dedupe_bufs,
+					(unsigned long long)ts->dedupe_bufs);
+	}
 	if (ts->latency_depth) {
 		log_buf(out, "     latency   : target=%llu, window=%llu, percentile=%.2f%%, depth=%u\n",
 					(unsigned long long)ts->latency_target,
@@ -1290,6 +1406,21 @@ static void show_thread_status_normal(struct thread_stat *ts,
 					ts->latency_percentile.u.f,
 					ts->latency_depth);
 	}
+	if (ts->zc_bytes || ts->zc_copied_bytes) {
+		char *zc = num2str(ts->zc_bytes, ts->sig_figs, 1, 1, N2S_BYTE);
+		char *copied = num2str(ts->zc_copied_bytes, ts->sig_figs, 1, 1, N2S_BYTE);
+
+		log_buf(out, "     zerocopy  : sent=%s, copied=%s\n", zc, copied);
+		free(zc);
+		free(copied);
+	}
+	if (ts->http_requests) {
+		log_buf(out, "     http      : requests=%llu, connections=%llu, reused=%llu\n",
+					(unsigned long long)ts->http_requests,
+					(unsigned long long)ts->http_connects,
+					(unsigned long long)(ts->http_requests -
+						min(ts->http_connects, ts->http_requests)));
+	}
 
 	if (ts->nr_block_infos)
 		show_block_infos(ts->nr_block_infos, ts->block_infos,
@@ -1402,6 +1533,10 @@ static void show_mixed_ddir_status_terse(struct thread_stat *ts,
 		show_ddir_status_terse(ts_lcl, rs, DDIR_READ, ver, out);
 
 	free_clat_prio_stats(ts_lcl);
+	free_lat_outliers(ts_lcl);
+	free_lat_heatmap(ts_lcl);
+	free_file_stats(ts_lcl);
+	free_clat_depth(ts_lcl);
 	free(ts_lcl);
 }
 
@@ -1457,6 +1592,200 @@ static struct json_object *add_ddir_lat_json(struct thread_stat *ts,
 	return lat_object;
 }
 
+static void add_zone_mgmt_json(struct thread_stat *ts,
+			       struct json_object *parent)
+{
+	struct json_object *zone_object = NULL, *op_object, *tmp_object;
+	int i;
+
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++) {
+		if (!ts->zone_mgmt_stat[i].samples)
+			continue;
+
+		if (!zone_object) {
+			zone_object = json_create_object();
+			json_object_add_value_object(parent, "zone_mgmt",
+						     zone_object);
+		}
+
+		op_object = json_create_object();
+		json_object_add_value_object(zone_object, zone_mgmt_name[i],
+					     op_object);
+		json_object_add_value_int(op_object, "total_cmds",
+					  ts->zone_mgmt_stat[i].samples);
+		tmp_object = add_ddir_lat_json(ts, 1, &ts->zone_mgmt_stat[i],
+					       ts->io_u_zone_mgmt_plat[i]);
+		json_object_add_value_object(op_object, "lat_ns", tmp_object);
+	}
+}
+
+static void add_dp_json(struct thread_stat *ts, struct json_object *parent)
+{
+	unsigned long runt = ts->runtime[DDIR_WRITE];
+	struct json_object *dp_object, *obj, *tmp_object;
+	struct json_array *array;
+	int i;
+
+	if (!ts->dp_emu_host_bytes) {
+		for (i = 0; i < FIO_MAX_DP_IDS; i++)
+			if (ts->dp_clat_stat[i].samples)
+				break;
+		if (i == FIO_MAX_DP_IDS)
+			return;
+	}
+
+	dp_object = json_create_object();
+	json_object_add_value_object(parent, "dataplacement", dp_object);
+	array = json_create_array();
+	json_object_add_value_array(dp_object, "plids", array);
+
+	for (i = 0; i < FIO_MAX_DP_IDS; i++) {
+		struct io_stat *stat = &ts->dp_clat_stat[i];
+
+		if (!stat->samples)
+			continue;
+
+		obj = json_create_object();
+		json_array_add_value_object(array, obj);
+		json_object_add_value_int(obj, "plid", i);
+		json_object_add_value_int(obj, "io_bytes", ts->dp_io_bytes[i]);
+		json_object_add_value_int(obj, "bw_bytes",
+				runt ? (1000 * ts->dp_io_bytes[i]) / runt : 0);
+		json_object_add_value_float(obj, "iops",
+				runt ? (1000.0 * stat->samples) / runt : 0.0);
+		tmp_object = add_ddir_lat_json(ts, 0, stat, NULL);
+		json_object_add_value_object(obj, "clat_ns", tmp_object);
+		if (ts->dp_emu_host_bytes) {
+			json_object_add_value_int(obj, "ru_reclaims",
+						  ts->dp_ru_reclaims[i]);
+			json_object_add_value_int(obj, "gc_bytes",
+						  ts->dp_gc_bytes[i]);
+		}
+	}
+
+	if (ts->dp_emu_host_bytes) {
+		obj = json_create_object();
+		json_object_add_value_object(dp_object, "emulation", obj);
+		json_object_add_value_int(obj, "host_bytes",
+					  ts->dp_emu_host_bytes);
+		json_object_add_value_int(obj, "gc_bytes", ts->dp_emu_gc_bytes);
+		json_object_add_value_float(obj, "waf",
+			(double) (ts->dp_emu_host_bytes + ts->dp_emu_gc_bytes) /
+			ts->dp_emu_host_bytes);
+	}
+}
+
+static void add_vj_json(struct thread_stat *ts, struct json_object *parent)
+{
+	struct json_object *vj_object;
+	int i;
+
+	for (i = 0; i < FIO_VJ_CNT; i++)
+		if (ts->vj_blocks[i])
+			break;
+	if (i == FIO_VJ_CNT)
+		return;
+
+	vj_object = json_create_object();
+	json_object_add_value_object(parent, "verify_journal", vj_object);
+	for (i = 0; i < FIO_VJ_CNT; i++)
+		json_object_add_value_int(vj_object, vj_state_name[i],
+					  ts->vj_blocks[i]);
+	json_object_add_value_int(vj_object, "violations", ts->vj_violations);
+}
+
+static void add_dedupe_json(struct thread_stat *ts, struct json_object *parent)
+{
+	struct json_object *obj;
+
+	if (!ts->dedupe_bufs)
+		return;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "dedupe", obj);
+	json_object_add_value_int(obj, "requested", ts->dedupe_percentage);
+	json_object_add_value_float(obj, "achieved",
+		100.0 * ts->dedupe_dup_bufs / ts->dedupe_bufs);
+	json_object_add_value_int(obj, "buffers", ts->dedupe_bufs);
+	json_object_add_value_int(obj, "duplicates", ts->dedupe_dup_bufs);
+}
+
+/*
+ * lat_heatmap keeps a coarse completion latency histogram for each region
+ * of lat_heatmap_region bytes, so hot spots on the device show up by
+ * offset. Each region has FIO_LAT_HEATMAP_NR log-linear buckets.
+ * clat_depth_hist uses the same buckets.
+ */
+static unsigned int lat_heatmap_idx(unsigned long long usec)
+{
+	unsigned int msb, idx;
+
+	if (usec < FIO_LAT_HEATMAP_VAL)
+		return usec;
+
+	msb = (sizeof(usec) * 8) - __builtin_clzll(usec) - 1;
+	idx = (msb - FIO_LAT_HEATMAP_BITS + 1) * FIO_LAT_HEATMAP_VAL +
+		((usec >> (msb - FIO_LAT_HEATMAP_BITS)) & (FIO_LAT_HEATMAP_VAL - 1));
+
+	if (idx >= FIO_LAT_HEATMAP_NR)
+		idx = FIO_LAT_HEATMAP_NR - 1;
+
+	return idx;
+}
+
+/*
+ * Lowest latency in usec that lands in bucket idx
+ */
+static uint64_t lat_heatmap_bucket_usec(unsigned int idx)
+{
+	unsigned int group = idx / FIO_LAT_HEATMAP_VAL;
+	unsigned int sub = idx % FIO_LAT_HEATMAP_VAL;
+
+	if (!group)
+		return sub;
+
+	return (uint64_t) (FIO_LAT_HEATMAP_VAL + sub) << (group - 1);
+}
+
+static void add_clat_depth_json(struct thread_stat *ts, enum fio_ddir ddir,
+				struct json_object *parent)
+{
+	struct json_object *obj, *depth_obj, *bins;
+	char buf[64];
+	unsigned int i, j;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "depth_bins", obj);
+
+	for (i = 0; i < FIO_CLAT_DEPTH_NR; i++) {
+		struct clat_depth_stat *cd;
+		uint64_t samples = 0;
+
+		cd = &ts->clat_depth[ddir * FIO_CLAT_DEPTH_NR + i];
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+			samples += cd->hist[j];
+		if (!samples)
+			continue;
+
+		depth_obj = json_create_object();
+		snprintf(buf, sizeof(buf), "%u", 1U << i);
+		json_object_add_value_object(obj, buf, depth_obj);
+		json_object_add_value_int(depth_obj, "N", samples);
+		json_object_add_value_float(depth_obj, "mean",
+					    (double) cd->lat_sum / samples);
+
+		bins = json_create_object();
+		json_object_add_value_object(depth_obj, "bins", bins);
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++) {
+			if (!cd->hist[j])
+				continue;
+			snprintf(buf, sizeof(buf), "%llu", (unsigned long long)
+				 lat_heatmap_bucket_usec(j) * 1000);
+			json_object_add_value_int(bins, buf, cd->hist[j]);
+		}
+	}
+}
+
 static void add_ddir_status_json(struct thread_stat *ts,
 				 struct group_run_stats *rs, enum fio_ddir ddir,
 				 struct json_object *parent)
@@ -1505,6 +1834,8 @@ static void add_ddir_status_json(struct thread_stat *ts,
 		tmp_object = add_ddir_lat_json(ts, ts->clat_percentiles,
 				&ts->clat_stat[ddir], ts->io_u_plat[FIO_CLAT][ddir]);
 		json_object_add_value_object(dir_object, "clat_ns", tmp_object);
+		if (ts->clat_depth && (output_format & FIO_OUTPUT_JSON_PLUS))
+			add_clat_depth_json(ts, ddir, tmp_object);
 
 		tmp_object = add_ddir_lat_json(ts, ts->lat_percentiles,
 				&ts->lat_stat[ddir], ts->io_u_plat[FIO_LAT][ddir]);
@@ -1603,6 +1934,10 @@ static void add_mixed_ddir_status_json(struct thread_stat *ts,
 		add_ddir_status_json(ts_lcl, rs, DDIR_READ, parent);
 
 	free_clat_prio_stats(ts_lcl);
+	free_lat_outliers(ts_lcl);
+	free_lat_heatmap(ts_lcl);
+	free_file_stats(ts_lcl);
+	free_clat_depth(ts_lcl);
 	free(ts_lcl);
 }
 
@@ -1685,6 +2020,34 @@ static void show_thread_status_terse_all(struct thread_stat *ts,
 	log_buf(out, "\n");
 }
 
+static void add_zerocopy_json(struct thread_stat *ts, struct json_object *parent)
+{
+	struct json_object *obj;
+
+	if (!ts->zc_bytes && !ts->zc_copied_bytes)
+		return;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "zerocopy", obj);
+	json_object_add_value_int(obj, "sent_bytes", ts->zc_bytes);
+	json_object_add_value_int(obj, "copied_bytes", ts->zc_copied_bytes);
+}
+
+static void add_http_json(struct thread_stat *ts, struct json_object *parent)
+{
+	struct json_object *obj;
+
+	if (!ts->http_requests)
+		return;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "http", obj);
+	json_object_add_value_int(obj, "requests", ts->http_requests);
+	json_object_add_value_int(obj, "connections", ts->http_connects);
+	json_object_add_value_int(obj, "reused", ts->http_requests -
+				  min(ts->http_connects, ts->http_requests));
+}
+
 static void json_add_job_opts(struct json_object *root, const char *name,
 			      struct flist_head *opt_list)
 {
@@ -1704,6 +2067,180 @@ static void json_add_job_opts(struct json_object *root, const char *name,
 	}
 }
 
+/*
+ * Entries in use are packed at the start of a lat_outliers heap, unused
+ * ones are zero
+ */
+static unsigned int lat_outlier_count(const struct lat_outlier *heap,
+				      unsigned int size)
+{
+	unsigned int nr = 0;
+
+	while (nr < size && heap[nr].lat)
+		nr++;
+
+	return nr;
+}
+
+static int lat_outlier_cmp(const void *p1, const void *p2)
+{
+	const struct lat_outlier *e1 = p1, *e2 = p2;
+
+	if (e1->lat > e2->lat)
+		return -1;
+
+	return e1->lat < e2->lat;
+}
+
+static void add_lat_outliers_json(struct thread_stat *ts,
+				  struct json_object *parent)
+{
+	unsigned int size = ts->lat_outliers_per_window, i, j;
+	struct json_object *obj;
+	struct json_array *array;
+	struct lat_outlier *sorted;
+
+	sorted = malloc(size * sizeof(*sorted));
+	if (!sorted)
+		return;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "lat_outliers", obj);
+	json_object_add_value_int(obj, "per_window", size);
+	json_object_add_value_int(obj, "window_us", ts->lat_outliers_window);
+	array = json_create_array();
+	json_object_add_value_array(obj, "ios", array);
+
+	for (i = 0; i < ts->lat_outliers_slots; i += size) {
+		unsigned int nr = lat_outlier_count(&ts->lat_outliers[i], size);
+
+		memcpy(sorted, &ts->lat_outliers[i], nr * sizeof(*sorted));
+		qsort(sorted, nr, sizeof(*sorted), lat_outlier_cmp);
+
+		for (j = 0; j < nr; j++) {
+			struct lat_outlier *e = &sorted[j];
+			struct json_object *io = json_create_object();
+
+			json_object_add_value_int(io, "window", e->window);
+			json_object_add_value_string(io, "ddir",
+						     io_ddir_name(e->ddir));
+			json_object_add_value_int(io, "lat_ns", e->lat);
+			json_object_add_value_int(io, "offset", e->offset);
+			json_object_add_value_int(io, "bytes", e->len);
+			json_object_add_value_int(io, "file", e->fileno);
+			json_object_add_value_int(io, "depth", e->depth);
+			json_object_add_value_int(io, "prioclass",
+						  ioprio_class(e->ioprio));
+			json_object_add_value_int(io, "prio", ioprio(e->ioprio));
+			json_object_add_value_int(io, "start_ns", e->start);
+			json_object_add_value_int(io, "issue_ns", e->issue);
+			json_object_add_value_int(io, "complete_ns", e->complete);
+			json_array_add_value_object(array, io);
+		}
+	}
+
+	free(sorted);
+}
+
+static void add_lat_heatmap_json(struct thread_stat *ts,
+				 struct json_object *parent)
+{
+	struct json_object *obj;
+	struct json_array *array, *counts;
+	unsigned int i, j;
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "lat_heatmap", obj);
+	json_object_add_value_int(obj, "region_bytes", ts->lat_heatmap_region);
+	json_object_add_value_int(obj, "regions", ts->lat_heatmap_regions);
+
+	array = json_create_array();
+	json_object_add_value_array(obj, "bucket_us", array);
+	for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+		json_array_add_value_int(array, lat_heatmap_bucket_usec(j));
+
+	/* regions without any I/O are left out */
+	array = json_create_array();
+	json_object_add_value_array(obj, "map", array);
+	for (i = 0; i < ts->lat_heatmap_regions; i++) {
+		uint64_t *map = &ts->lat_heatmap[i * FIO_LAT_HEATMAP_NR];
+		struct json_object *region;
+		uint64_t samples = 0;
+
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+			samples += map[j];
+		if (!samples)
+			continue;
+
+		region = json_create_object();
+		json_object_add_value_int(region, "region", i);
+		json_object_add_value_int(region, "offset",
+					  i * ts->lat_heatmap_region);
+		json_object_add_value_int(region, "samples", samples);
+		counts = json_create_array();
+		json_object_add_value_array(region, "counts", counts);
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+			json_array_add_value_int(counts, map[j]);
+		json_array_add_value_object(array, region);
+	}
+}
+
+static uint64_t file_stat_ios(const struct file_stat *fs)
+{
+	uint64_t ios = 0;
+	int i;
+
+	for (i = 0; i < FIO_FILE_STAT_NR; i++)
+		ios += fs->lat_hist[i];
+
+	return ios;
+}
+
+static void add_file_stats_json(struct thread_stat *ts,
+				struct json_object *parent)
+{
+	struct json_object *obj;
+	struct json_array *array, *hist;
+	uint64_t runtime = 0;
+	unsigned int i, j;
+
+	for (i = 0; i < DDIR_RWDIR_CNT; i++)
+		runtime = max(runtime, ts->runtime[i]);
+
+	obj = json_create_object();
+	json_object_add_value_object(parent, "file_stats", obj);
+	json_object_add_value_string(obj, "sort",
+		ts->file_stats_sort == FIO_FILE_STATS_BW ? "bw" : "lat");
+
+	array = json_create_array();
+	json_object_add_value_array(obj, "bucket_us", array);
+	json_array_add_value_int(array, 0);
+	for (j = 1; j < FIO_FILE_STAT_NR; j++)
+		json_array_add_value_int(array, 1ULL << (2 * (j - 1)));
+
+	array = json_create_array();
+	json_object_add_value_array(obj, "files", array);
+	for (i = 0; i < ts->nr_file_stats; i++) {
+		struct file_stat_entry *e = &ts->file_stats[i];
+		uint64_t ios = file_stat_ios(&e->fs);
+		struct json_object *file = json_create_object();
+
+		json_object_add_value_string(file, "name", e->name);
+		json_object_add_value_int(file, "ios", ios);
+		json_object_add_value_int(file, "bytes", e->fs.bytes);
+		json_object_add_value_int(file, "bw_bytes",
+			runtime ? e->fs.bytes * 1000 / runtime : 0);
+		json_object_add_value_int(file, "lat_mean_ns",
+			ios ? e->fs.lat_sum / ios : 0);
+		json_object_add_value_int(file, "lat_max_ns", e->fs.lat_max);
+		hist = json_create_array();
+		json_object_add_value_array(file, "lat_hist", hist);
+		for (j = 0; j < FIO_FILE_STAT_NR; j++)
+			json_array_add_value_int(hist, e->fs.lat_hist[j]);
+		json_array_add_value_object(array, file);
+	}
+}
+
 static struct json_object *show_thread_status_json(struct thread_stat *ts,
 						   struct group_run_stats *rs,
 						   struct flist_head *opt_list)
@@ -1739,10 +2276,17 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 	add_ddir_status_json(ts, rs, DDIR_WRITE, root);
 	add_ddir_status_json(ts, rs, DDIR_TRIM, root);
 	add_ddir_status_json(ts, rs, DDIR_SYNC, root);
+	add_zone_mgmt_json(ts, root);
+	add_dp_json(ts, root);
+	add_vj_json(ts, root);
+	add_dedupe_json(ts, root);
 
 	if (ts->unified_rw_rep == UNIFIED_BOTH)
 		add_mixed_ddir_status_json(ts, rs, root);
 
+	add_zerocopy_json(ts, root);
+	add_http_json(ts, root);
+
 	/* CPU Usage */
 	if (ts->total_run_time) {
 		double runt = (double) ts->total_run_time;
@@ -1851,6 +2395,13 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 		json_object_add_value_int(root, "latency_window", ts->latency_window);
 	}
 
+	if (ts->lat_outliers)
+		add_lat_outliers_json(ts, root);
+	if (ts->lat_heatmap)
+		add_lat_heatmap_json(ts, root);
+	if (ts->file_stats)
+		add_file_stats_json(ts, root);
+
 	/* Additional output if description is set */
 	if (strlen(ts->description))
 		json_object_add_value_string(root, "desc", ts->description);
@@ -1945,126 +2496,809 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 		json_object_add_value_array(data, "bw", bw);
 	}
 
-	return root;
+	return root;
+}
+
+static void show_thread_status_terse(struct thread_stat *ts,
+				     struct group_run_stats *rs,
+				     struct buf_output *out)
+{
+	if (terse_version >= 2 && terse_version <= 5)
+		show_thread_status_terse_all(ts, rs, terse_version, out);
+	else
+		log_err("fio: bad terse version!? %d\n", terse_version);
+}
+
+struct json_object *show_thread_status(struct thread_stat *ts,
+				       struct group_run_stats *rs,
+				       struct flist_head *opt_list,
+				       struct buf_output *out)
+{
+	struct json_object *ret = NULL;
+
+	if (output_format & FIO_OUTPUT_TERSE)
+		show_thread_status_terse(ts, rs,  out);
+	if (output_format & FIO_OUTPUT_JSON)
+		ret = show_thread_status_json(ts, rs, opt_list);
+	if (output_format & FIO_OUTPUT_NORMAL)
+		show_thread_status_normal(ts, rs,  out);
+
+	return ret;
+}
+
+static void __sum_stat(struct io_stat *dst, struct io_stat *src, bool first)
+{
+	double mean, S;
+
+	dst->min_val = min(dst->min_val, src->min_val);
+	dst->max_val = max(dst->max_val, src->max_val);
+
+	/*
+	 * Compute new mean and S after the merge
+	 * <http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
+	 *  #Parallel_algorithm>
+	 */
+	if (first) {
+		mean = src->mean.u.f;
+		S = src->S.u.f;
+	} else {
+		double delta = src->mean.u.f - dst->mean.u.f;
+
+		mean = ((src->mean.u.f * src->samples) +
+			(dst->mean.u.f * dst->samples)) /
+			(dst->samples + src->samples);
+
+		S =  src->S.u.f + dst->S.u.f + pow(delta, 2.0) *
+			(dst->samples * src->samples) /
+			(dst->samples + src->samples);
+	}
+
+	dst->samples += src->samples;
+	dst->mean.u.f = mean;
+	dst->S.u.f = S;
+
+}
+
+/*
+ * We sum two kinds of stats - one that is time based, in which case we
+ * apply the proper summing technique, and then one that is iops/bw
+ * numbers. For group_reporting, we should just add those up, not make
+ * them the mean of everything.
+ */
+static void sum_stat(struct io_stat *dst, struct io_stat *src, bool pure_sum)
+{
+	bool first = dst->samples == 0;
+
+	if (src->samples == 0)
+		return;
+
+	if (!pure_sum) {
+		__sum_stat(dst, src, first);
+		return;
+	}
+
+	if (first) {
+		dst->min_val = src->min_val;
+		dst->max_val = src->max_val;
+		dst->samples = src->samples;
+		dst->mean.u.f = src->mean.u.f;
+		dst->S.u.f = src->S.u.f;
+	} else {
+		dst->min_val += src->min_val;
+		dst->max_val += src->max_val;
+		dst->samples += src->samples;
+		dst->mean.u.f += src->mean.u.f;
+		dst->S.u.f += src->S.u.f;
+	}
+}
+
+void sum_group_stats(struct group_run_stats *dst, struct group_run_stats *src)
+{
+	int i;
+
+	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
+		if (dst->max_run[i] < src->max_run[i])
+			dst->max_run[i] = src->max_run[i];
+		if (dst->min_run[i] && dst->min_run[i] > src->min_run[i])
+			dst->min_run[i] = src->min_run[i];
+		if (dst->max_bw[i] < src->max_bw[i])
+			dst->max_bw[i] = src->max_bw[i];
+		if (dst->min_bw[i] && dst->min_bw[i] > src->min_bw[i])
+			dst->min_bw[i] = src->min_bw[i];
+
+		dst->iobytes[i] += src->iobytes[i];
+		dst->agg[i] += src->agg[i];
+	}
+
+	if (!dst->kb_base)
+		dst->kb_base = src->kb_base;
+	if (!dst->unit_base)
+		dst->unit_base = src->unit_base;
+	if (!dst->sig_figs)
+		dst->sig_figs = src->sig_figs;
+}
+
+/*
+ * lat_outliers keeps one min-heap of the slowest I/Os per window. The root
+ * is the fastest I/O kept, so a completion only has to beat that one to
+ * get in, and only the root is replaced when it does.
+ */
+static void lat_outlier_sift_up(struct lat_outlier *heap, unsigned int i)
+{
+	struct lat_outlier e = heap[i];
+
+	while (i) {
+		unsigned int parent = (i - 1) / 2;
+
+		if (heap[parent].lat <= e.lat)
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = e;
+}
+
+static void lat_outlier_sift_down(struct lat_outlier *heap, unsigned int nr)
+{
+	struct lat_outlier e = heap[0];
+	unsigned int i = 0;
+
+	for (;;) {
+		unsigned int child = 2 * i + 1;
+
+		if (child >= nr)
+			break;
+		if (child + 1 < nr && heap[child + 1].lat < heap[child].lat)
+			child++;
+		if (heap[child].lat >= e.lat)
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = e;
+}
+
+/*
+ * Add @e to a heap of @size entries, @nr of which are in use. Returns the
+ * new number of entries in use.
+ */
+static unsigned int lat_outlier_push(struct lat_outlier *heap,
+				     unsigned int size, unsigned int nr,
+				     const struct lat_outlier *e)
+{
+	if (nr < size) {
+		heap[nr] = *e;
+		lat_outlier_sift_up(heap, nr);
+		return nr + 1;
+	}
+
+	if (e->lat > heap[0].lat) {
+		heap[0] = *e;
+		lat_outlier_sift_down(heap, nr);
+	}
+
+	return nr;
+}
+
+static void lat_outliers_set_end(struct thread_data *td)
+{
+	struct thread_stat *ts = &td->ts;
+	unsigned int windows = ts->lat_outliers_slots / ts->lat_outliers_per_window;
+	uint64_t usec;
+
+	td->lat_outliers_timed = td->lat_outliers_cur + 1 < windows;
+	if (!td->lat_outliers_timed)
+		return;
+
+	usec = (td->lat_outliers_cur + 1) * ts->lat_outliers_window;
+	td->lat_outliers_end = td->epoch;
+	td->lat_outliers_end.tv_sec += usec / 1000000;
+	td->lat_outliers_end.tv_nsec += (usec % 1000000) * 1000;
+	if (td->lat_outliers_end.tv_nsec >= 1000000000) {
+		td->lat_outliers_end.tv_sec++;
+		td->lat_outliers_end.tv_nsec -= 1000000000;
+	}
+}
+
+static void reset_lat_outliers(struct thread_data *td)
+{
+	struct thread_stat *ts = &td->ts;
+
+	if (!ts->lat_outliers)
+		return;
+
+	memset(ts->lat_outliers, 0,
+	       ts->lat_outliers_slots * sizeof(*ts->lat_outliers));
+	td->lat_outliers_cur = 0;
+	td->lat_outliers_fill = 0;
+	td->lat_outliers_min = 0;
+	lat_outliers_set_end(td);
+}
+
+int init_lat_outliers(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	struct thread_stat *ts = &td->ts;
+	unsigned long long windows = 1;
+
+	if (o->lat_outliers_window) {
+		windows = FIO_LAT_OUTLIERS_SLOTS / o->lat_outliers;
+		if (o->timeout)
+			windows = min(windows, (o->timeout +
+				o->lat_outliers_window - 1) / o->lat_outliers_window);
+	}
+
+	ts->lat_outliers = scalloc(windows * o->lat_outliers,
+				   sizeof(*ts->lat_outliers));
+	if (!ts->lat_outliers) {
+		log_err("fio: failed to allocate lat_outliers\n");
+		return 1;
+	}
+
+	ts->lat_outliers_slots = windows * o->lat_outliers;
+	ts->lat_outliers_per_window = o->lat_outliers;
+	ts->lat_outliers_window = o->lat_outliers_window;
+	reset_lat_outliers(td);
+	return 0;
+}
+
+void free_lat_outliers(struct thread_stat *ts)
+{
+	sfree(ts->lat_outliers);
+	ts->lat_outliers = NULL;
+	ts->lat_outliers_slots = 0;
+}
+
+void add_lat_outlier(struct thread_data *td, struct io_u *io_u,
+		     enum fio_ddir ddir, const struct timespec *now,
+		     unsigned long long nsec)
+{
+	struct thread_stat *ts = &td->ts;
+	unsigned int size = ts->lat_outliers_per_window;
+	struct lat_outlier e, *heap;
+
+	if (td->lat_outliers_timed) {
+		unsigned int windows = ts->lat_outliers_slots / size;
+		uint64_t cur;
+
+		cur = utime_since(&td->epoch, now) / ts->lat_outliers_window;
+		if (cur > td->lat_outliers_cur) {
+			td->lat_outliers_cur = min(cur, (uint64_t) windows - 1);
+			td->lat_outliers_fill = 0;
+			td->lat_outliers_min = 0;
+		}
+
+		/* also fixes up the end if the epoch moved since the reset */
+		lat_outliers_set_end(td);
+
+		if (nsec <= td->lat_outliers_min)
+			return;
+	}
+
+	e.lat = nsec;
+	e.offset = io_u->offset;
+	e.start = ntime_since(&td->epoch, &io_u->start_time);
+	e.issue = ntime_since(&td->epoch, &io_u->issue_time);
+	e.complete = ntime_since(&td->epoch, now);
+	e.window = td->lat_outliers_cur;
+	e.fileno = io_u->file ? io_u->file->fileno : 0;
+	e.len = io_u->xfer_buflen;
+	e.depth = io_u->submit_depth;
+	e.ddir = ddir;
+	e.ioprio = io_u->ioprio;
+	e.pad = 0;
+
+	heap = &ts->lat_outliers[td->lat_outliers_cur * size];
+	td->lat_outliers_fill = lat_outlier_push(heap, size,
+						 td->lat_outliers_fill, &e);
+	if (td->lat_outliers_fill == size)
+		td->lat_outliers_min = heap[0].lat;
+}
+
+static void sum_lat_outliers(struct thread_stat *dst, struct thread_stat *src)
+{
+	unsigned int size, i;
+
+	if (!src->lat_outliers)
+		return;
+
+	if (!dst->lat_outliers) {
+		dst->lat_outliers = scalloc(src->lat_outliers_slots,
+					    sizeof(*src->lat_outliers));
+		if (!dst->lat_outliers) {
+			log_err("fio: failed to allocate lat_outliers\n");
+			return;
+		}
+		dst->lat_outliers_slots = src->lat_outliers_slots;
+		dst->lat_outliers_per_window = src->lat_outliers_per_window;
+		dst->lat_outliers_window = src->lat_outliers_window;
+	}
+
+	size = dst->lat_outliers_per_window;
+	for (i = 0; i < src->lat_outliers_slots; i++) {
+		struct lat_outlier *e = &src->lat_outliers[i], *heap;
+
+		if (!e->lat || (e->window + 1) * size > dst->lat_outliers_slots)
+			continue;
+
+		heap = &dst->lat_outliers[e->window * size];
+		lat_outlier_push(heap, size, lat_outlier_count(heap, size), e);
+	}
+}
+
+/*
+ * Number of regions needed to cover span bytes. The region size is doubled
+ * until that fits in FIO_LAT_HEATMAP_MAX_REGIONS, to bound the memory used
+ * on large devices.
+ */
+static unsigned int lat_heatmap_regions(uint64_t *region, uint64_t span)
+{
+	uint64_t regions;
+
+	while ((regions = (span + *region - 1) / *region) >
+	       FIO_LAT_HEATMAP_MAX_REGIONS)
+		*region *= 2;
+
+	return max(regions, (uint64_t) 1);
+}
+
+int init_lat_heatmap(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	struct thread_stat *ts = &td->ts;
+	uint64_t region = o->lat_heatmap_region, span = 0;
+	struct fio_file *f;
+	unsigned int i, regions;
+
+	for_each_file(td, f, i) {
+		if (o->lat_heatmap_region_nz && !region) {
+			/* zonemode=strided doesn't get per-file zone size. */
+			region = f->zbd_info ? f->zbd_info->zone_size :
+				o->zone_size;
+			region *= o->lat_heatmap_region_nz;
+		}
+		span = max(span, f->file_offset + f->io_size);
+		if (f->real_file_size != -1ULL)
+			span = max(span, f->real_file_size);
+	}
+
+	if (!region) {
+		log_err("fio: lat_heatmap_region in zones requires a zonemode\n");
+		return 1;
+	}
+
+	regions = lat_heatmap_regions(&region, span);
+
+	ts->lat_heatmap = scalloc(regions * FIO_LAT_HEATMAP_NR,
+				  sizeof(*ts->lat_heatmap));
+	if (!ts->lat_heatmap) {
+		log_err("fio: failed to allocate lat_heatmap\n");
+		return 1;
+	}
+
+	ts->lat_heatmap_regions = regions;
+	ts->lat_heatmap_region = region;
+	return 0;
+}
+
+static void reset_lat_heatmap(struct thread_stat *ts)
+{
+	if (!ts->lat_heatmap)
+		return;
+
+	memset(ts->lat_heatmap, 0, ts->lat_heatmap_regions *
+	       FIO_LAT_HEATMAP_NR * sizeof(*ts->lat_heatmap));
+}
+
+void free_lat_heatmap(struct thread_stat *ts)
+{
+	sfree(ts->lat_heatmap);
+	ts->lat_heatmap = NULL;
+	ts->lat_heatmap_regions = 0;
+}
+
+void add_lat_heatmap_sample(struct thread_stat *ts, uint64_t offset,
+			    unsigned long long nsec)
+{
+	uint64_t region = offset / ts->lat_heatmap_region;
+
+	if (region >= ts->lat_heatmap_regions)
+		region = ts->lat_heatmap_regions - 1;
+
+	ts->lat_heatmap[region * FIO_LAT_HEATMAP_NR +
+			lat_heatmap_idx(nsec / 1000)]++;
+}
+
+/*
+ * Add the src regions into dst, by offset. dst regions must not be
+ * smaller than the src ones.
+ */
+static void lat_heatmap_add(uint64_t *dst, uint64_t dst_region,
+			    unsigned int dst_regions, const uint64_t *src,
+			    uint64_t src_region, unsigned int src_regions)
+{
+	unsigned int i, j, k;
+
+	for (i = 0; i < src_regions; i++) {
+		j = min((uint64_t) i * src_region / dst_region,
+			(uint64_t) dst_regions - 1);
+
+		for (k = 0; k < FIO_LAT_HEATMAP_NR; k++)
+			dst[j * FIO_LAT_HEATMAP_NR + k] +=
+				src[i * FIO_LAT_HEATMAP_NR + k];
+	}
+}
+
+static void sum_lat_heatmap(struct thread_stat *dst, struct thread_stat *src)
+{
+	uint64_t region, span, *map;
+	unsigned int regions;
+
+	if (!src->lat_heatmap)
+		return;
+
+	if (dst->lat_heatmap &&
+	    dst->lat_heatmap_region == src->lat_heatmap_region &&
+	    dst->lat_heatmap_regions >= src->lat_heatmap_regions)
+		goto add;
+
+	/*
+	 * Jobs with different region sizes or devices are merged into a
+	 * map that covers both, at the coarser region size.
+	 */
+	region = src->lat_heatmap_region;
+	span = region * src->lat_heatmap_regions;
+	if (dst->lat_heatmap) {
+		region = max(region, dst->lat_heatmap_region);
+		span = max(span, dst->lat_heatmap_region *
+				 dst->lat_heatmap_regions);
+	}
+	regions = lat_heatmap_regions(&region, span);
+
+	map = scalloc(regions * FIO_LAT_HEATMAP_NR, sizeof(*map));
+	if (!map) {
+		log_err("fio: failed to allocate lat_heatmap\n");
+		return;
+	}
+
+	if (dst->lat_heatmap) {
+		lat_heatmap_add(map, region, regions, dst->lat_heatmap,
+				dst->lat_heatmap_region,
+				dst->lat_heatmap_regions);
+		sfree(dst->lat_heatmap);
+	}
+
+	dst->lat_heatmap = map;
+	dst->lat_heatmap_region = region;
+	dst->lat_heatmap_regions = regions;
+add:
+	lat_heatmap_add(dst->lat_heatmap, dst->lat_heatmap_region,
+			dst->lat_heatmap_regions, src->lat_heatmap,
+			src->lat_heatmap_region, src->lat_heatmap_regions);
+}
+
+/*
+ * Binary heatmap file, all fields little endian. The header is followed
+ * by the lowest latency in usec of each bucket, and then the bucket
+ * counts of each region in turn, all as 64-bit values.
+ */
+struct lat_heatmap_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t buckets;
+	uint32_t regions;
+	uint32_t pad;
+	uint64_t region_size;
+};
+
+#define LAT_HEATMAP_MAGIC	"fiohmap"
+#define LAT_HEATMAP_VERSION	1
+
+int write_lat_heatmap(struct thread_data *td)
+{
+	struct thread_stat *ts = &td->ts;
+	const char *name = td->o.lat_heatmap_file;
+	struct lat_heatmap_header hdr;
+	uint64_t buf[FIO_LAT_HEATMAP_NR];
+	unsigned int i, j;
+	char fname[PATH_MAX];
+	FILE *f;
+	int err;
+
+	if (!ts->lat_heatmap)
+		return 0;
+
+	if (!name || !strcmp(name, ""))
+		name = td->o.name;
+	snprintf(fname, sizeof(fname), "%s_lat_heatmap.%d.bin", name,
+		 td->thread_number);
+
+	f = fopen(fname, "w");
+	if (!f) {
+		log_err("fio: failed to open lat_heatmap file %s: %s\n",
+			fname, strerror(errno));
+		return 1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, LAT_HEATMAP_MAGIC, sizeof(LAT_HEATMAP_MAGIC));
+	hdr.version = cpu_to_le32((uint32_t) LAT_HEATMAP_VERSION);
+	hdr.buckets = cpu_to_le32((uint32_t) FIO_LAT_HEATMAP_NR);
+	hdr.regions = cpu_to_le32(ts->lat_heatmap_regions);
+	hdr.region_size = cpu_to_le64(ts->lat_heatmap_region);
+	fwrite(&hdr, sizeof(hdr), 1, f);
+
+	for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+		buf[j] = cpu_to_le64(lat_heatmap_bucket_usec(j));
+	fwrite(buf, sizeof(buf), 1, f);
+
+	for (i = 0; i < ts->lat_heatmap_regions; i++) {
+		uint64_t *counts = &ts->lat_heatmap[i * FIO_LAT_HEATMAP_NR];
+
+		for (j = 0; j < FIO_LAT_HEATMAP_NR; j++)
+			buf[j] = cpu_to_le64(counts[j]);
+		fwrite(buf, sizeof(buf), 1, f);
+	}
+
+	err = ferror(f);
+	if (fclose(f) || err) {
+		log_err("fio: failed to write lat_heatmap file %s\n", fname);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * file_stats counts the I/O of each file of a job in a struct file_stat,
+ * and copies the top files into the thread_stat when the job is done.
+ */
+int init_file_stats(struct thread_data *td)
+{
+	td->file_stats = calloc(td->files_index, sizeof(*td->file_stats));
+	if (!td->file_stats) {
+		log_err("fio: failed to allocate file_stats\n");
+		return 1;
+	}
+
+	td->nr_file_stats = td->files_index;
+	return 0;
 }
 
-static void show_thread_status_terse(struct thread_stat *ts,
-				     struct group_run_stats *rs,
-				     struct buf_output *out)
+static void reset_file_stats(struct thread_data *td)
 {
-	if (terse_version >= 2 && terse_version <= 5)
-		show_thread_status_terse_all(ts, rs, terse_version, out);
+	if (!td->file_stats)
+		return;
+
+	memset(td->file_stats, 0, td->nr_file_stats * sizeof(*td->file_stats));
+}
+
+void add_file_stat(struct thread_data *td, struct fio_file *f,
+		   unsigned int bytes, unsigned long long nsec)
+{
+	unsigned long long usec = nsec / 1000;
+	struct file_stat *fs;
+	unsigned int idx = 0;
+
+	if (f->fileno >= td->nr_file_stats)
+		return;
+
+	fs = &td->file_stats[f->fileno];
+	fs->bytes += bytes;
+	fs->lat_sum += nsec;
+	if (nsec > fs->lat_max)
+		fs->lat_max = nsec;
+
+	if (usec) {
+		idx = ((sizeof(usec) * 8) - __builtin_clzll(usec) - 1) / 2 + 1;
+		if (idx >= FIO_FILE_STAT_NR)
+			idx = FIO_FILE_STAT_NR - 1;
+	}
+	fs->lat_hist[idx]++;
+}
+
+struct file_stat_rank {
+	uint64_t key;
+	unsigned int idx;
+};
+
+static void file_stat_rank(struct file_stat_rank *r, const struct file_stat *fs,
+			   unsigned int sort, unsigned int idx)
+{
+	if (sort == FIO_FILE_STATS_BW)
+		r->key = fs->bytes;
 	else
-		log_err("fio: bad terse version!? %d\n", terse_version);
+		r->key = fs->lat_sum / file_stat_ios(fs);
+	r->idx = idx;
 }
 
-struct json_object *show_thread_status(struct thread_stat *ts,
-				       struct group_run_stats *rs,
-				       struct flist_head *opt_list,
-				       struct buf_output *out)
+static int file_stat_rank_cmp(const void *p1, const void *p2)
 {
-	struct json_object *ret = NULL;
+	const struct file_stat_rank *r1 = p1, *r2 = p2;
 
-	if (output_format & FIO_OUTPUT_TERSE)
-		show_thread_status_terse(ts, rs,  out);
-	if (output_format & FIO_OUTPUT_JSON)
-		ret = show_thread_status_json(ts, rs, opt_list);
-	if (output_format & FIO_OUTPUT_NORMAL)
-		show_thread_status_normal(ts, rs,  out);
+	if (r1->key != r2->key)
+		return r1->key > r2->key ? -1 : 1;
 
-	return ret;
+	return (r1->idx > r2->idx) - (r1->idx < r2->idx);
 }
 
-static void __sum_stat(struct io_stat *dst, struct io_stat *src, bool first)
+static struct file_stat_entry *alloc_file_stats(struct thread_stat *ts,
+						unsigned int top)
 {
-	double mean, S;
+	ts->file_stats = scalloc(top, sizeof(*ts->file_stats));
+	if (!ts->file_stats) {
+		log_err("fio: failed to allocate file_stats\n");
+		return NULL;
+	}
 
-	dst->min_val = min(dst->min_val, src->min_val);
-	dst->max_val = max(dst->max_val, src->max_val);
+	ts->file_stats_top = top;
+	ts->nr_file_stats = 0;
+	return ts->file_stats;
+}
 
-	/*
-	 * Compute new mean and S after the merge
-	 * <http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
-	 *  #Parallel_algorithm>
-	 */
-	if (first) {
-		mean = src->mean.u.f;
-		S = src->S.u.f;
-	} else {
-		double delta = src->mean.u.f - dst->mean.u.f;
+void file_stats_exit(struct thread_data *td)
+{
+	struct thread_stat *ts = &td->ts;
+	struct file_stat_rank *rank;
+	struct fio_file *f;
+	unsigned int i, nr = 0;
 
-		mean = ((src->mean.u.f * src->samples) +
-			(dst->mean.u.f * dst->samples)) /
-			(dst->samples + src->samples);
+	if (!td->file_stats)
+		return;
 
-		S =  src->S.u.f + dst->S.u.f + pow(delta, 2.0) *
-			(dst->samples * src->samples) /
-			(dst->samples + src->samples);
+	rank = malloc(td->nr_file_stats * sizeof(*rank));
+	if (!rank)
+		goto out;
+
+	for (i = 0; i < td->nr_file_stats; i++) {
+		if (file_stat_ios(&td->file_stats[i]))
+			file_stat_rank(&rank[nr++], &td->file_stats[i],
+				       td->o.file_stats_sort, i);
 	}
+	qsort(rank, nr, sizeof(*rank), file_stat_rank_cmp);
 
-	dst->samples += src->samples;
-	dst->mean.u.f = mean;
-	dst->S.u.f = S;
+	if (!ts->file_stats && !alloc_file_stats(ts, td->o.file_stats))
+		goto out_free;
+
+	ts->file_stats_sort = td->o.file_stats_sort;
+	ts->nr_file_stats = min(nr, ts->file_stats_top);
+	for (i = 0; i < ts->nr_file_stats; i++) {
+		struct file_stat_entry *e = &ts->file_stats[i];
+
+		f = td->files[rank[i].idx];
+		snprintf(e->name, sizeof(e->name), "%s", f->file_name);
+		e->fs = td->file_stats[rank[i].idx];
+	}
 
+out_free:
+	free(rank);
+out:
+	free(td->file_stats);
+	td->file_stats = NULL;
+	td->nr_file_stats = 0;
+}
+
+void free_file_stats(struct thread_stat *ts)
+{
+	sfree(ts->file_stats);
+	ts->file_stats = NULL;
+	ts->nr_file_stats = 0;
 }
 
 /*
- * We sum two kinds of stats - one that is time based, in which case we
- * apply the proper summing technique, and then one that is iops/bw
- * numbers. For group_reporting, we should just add those up, not make
- * them the mean of everything.
+ * Merge the top files of src into those of dst, for group_reporting
  */
-static void sum_stat(struct io_stat *dst, struct io_stat *src, bool pure_sum)
+static void sum_file_stats(struct thread_stat *dst, struct thread_stat *src)
 {
-	bool first = dst->samples == 0;
+	struct file_stat_entry *all;
+	struct file_stat_rank *rank;
+	unsigned int i, nr;
 
-	if (src->samples == 0)
+	if (!src->file_stats)
 		return;
 
-	if (!pure_sum) {
-		__sum_stat(dst, src, first);
-		return;
+	if (!dst->file_stats) {
+		if (!alloc_file_stats(dst, src->file_stats_top))
+			return;
+		dst->file_stats_sort = src->file_stats_sort;
 	}
 
-	if (first) {
-		dst->min_val = src->min_val;
-		dst->max_val = src->max_val;
-		dst->samples = src->samples;
-		dst->mean.u.f = src->mean.u.f;
-		dst->S.u.f = src->S.u.f;
-	} else {
-		dst->min_val += src->min_val;
-		dst->max_val += src->max_val;
-		dst->samples += src->samples;
-		dst->mean.u.f += src->mean.u.f;
-		dst->S.u.f += src->S.u.f;
+	nr = dst->nr_file_stats + src->nr_file_stats;
+	all = malloc(nr * sizeof(*all));
+	rank = malloc(nr * sizeof(*rank));
+	if (!all || !rank)
+		goto out;
+
+	memcpy(all, dst->file_stats, dst->nr_file_stats * sizeof(*all));
+	memcpy(&all[dst->nr_file_stats], src->file_stats,
+	       src->nr_file_stats * sizeof(*all));
+	for (i = 0; i < nr; i++)
+		file_stat_rank(&rank[i], &all[i].fs, dst->file_stats_sort, i);
+	qsort(rank, nr, sizeof(*rank), file_stat_rank_cmp);
+
+	dst->nr_file_stats = min(nr, dst->file_stats_top);
+	for (i = 0; i < dst->nr_file_stats; i++)
+		dst->file_stats[i] = all[rank[i].idx];
+out:
+	free(rank);
+	free(all);
+}
+
+/*
+ * clat_depth_hist keeps one struct clat_depth_stat per data direction and
+ * power of two of the queue depth at submit.
+ */
+int init_clat_depth(struct thread_stat *ts)
+{
+	unsigned int nr = DDIR_RWDIR_CNT * FIO_CLAT_DEPTH_NR;
+
+	ts->clat_depth = scalloc(nr, sizeof(*ts->clat_depth));
+	if (!ts->clat_depth) {
+		log_err("fio: failed to allocate clat_depth_hist\n");
+		return 1;
 	}
+
+	ts->clat_depth_nr = nr;
+	return 0;
 }
 
-void sum_group_stats(struct group_run_stats *dst, struct group_run_stats *src)
+static void reset_clat_depth(struct thread_stat *ts)
 {
-	int i;
+	if (!ts->clat_depth)
+		return;
 
-	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
-		if (dst->max_run[i] < src->max_run[i])
-			dst->max_run[i] = src->max_run[i];
-		if (dst->min_run[i] && dst->min_run[i] > src->min_run[i])
-			dst->min_run[i] = src->min_run[i];
-		if (dst->max_bw[i] < src->max_bw[i])
-			dst->max_bw[i] = src->max_bw[i];
-		if (dst->min_bw[i] && dst->min_bw[i] > src->min_bw[i])
-			dst->min_bw[i] = src->min_bw[i];
+	memset(ts->clat_depth, 0, ts->clat_depth_nr * sizeof(*ts->clat_depth));
+}
 
-		dst->iobytes[i] += src->iobytes[i];
-		dst->agg[i] += src->agg[i];
+void free_clat_depth(struct thread_stat *ts)
+{
+	sfree(ts->clat_depth);
+	ts->clat_depth = NULL;
+	ts->clat_depth_nr = 0;
+}
+
+void add_clat_depth_sample(struct thread_stat *ts, enum fio_ddir ddir,
+			   unsigned int depth, unsigned long long nsec)
+{
+	struct clat_depth_stat *cd;
+	unsigned int idx = 0;
+
+	if (depth > 1) {
+		idx = (sizeof(depth) * 8) - __builtin_clz(depth) - 1;
+		if (idx >= FIO_CLAT_DEPTH_NR)
+			idx = FIO_CLAT_DEPTH_NR - 1;
 	}
 
-	if (!dst->kb_base)
-		dst->kb_base = src->kb_base;
-	if (!dst->unit_base)
-		dst->unit_base = src->unit_base;
-	if (!dst->sig_figs)
-		dst->sig_figs = src->sig_figs;
+	cd = &ts->clat_depth[ddir * FIO_CLAT_DEPTH_NR + idx];
+	cd->lat_sum += nsec;
+	cd->hist[lat_heatmap_idx(nsec / 1000)]++;
+}
+
+static void sum_clat_depth(struct thread_stat *dst, struct thread_stat *src)
+{
+	unsigned int i, j, k;
+
+	if (!src->clat_depth)
+		return;
+	if (!dst->clat_depth && init_clat_depth(dst))
+		return;
+
+	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
+		unsigned int dst_ddir = i;
+
+		if (dst->unified_rw_rep == UNIFIED_MIXED)
+			dst_ddir = 0;
+
+		for (j = 0; j < FIO_CLAT_DEPTH_NR; j++) {
+			struct clat_depth_stat *d, *s;
+
+			d = &dst->clat_depth[dst_ddir * FIO_CLAT_DEPTH_NR + j];
+			s = &src->clat_depth[i * FIO_CLAT_DEPTH_NR + j];
+			d->lat_sum += s->lat_sum;
+			for (k = 0; k < FIO_LAT_HEATMAP_NR; k++)
+				d->hist[k] += s->hist[k];
+		}
+	}
 }
 
 /*
@@ -2356,12 +3590,45 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src)
 	for (k = 0; k < FIO_IO_U_PLAT_NR; k++)
 		dst->io_u_sync_plat[k] += src->io_u_sync_plat[k];
 
+	for (k = 0; k < FIO_ZONE_MGMT_CNT; k++) {
+		sum_stat(&dst->zone_mgmt_stat[k], &src->zone_mgmt_stat[k],
+			 false);
+		for (m = 0; m < FIO_IO_U_PLAT_NR; m++)
+			dst->io_u_zone_mgmt_plat[k][m] +=
+				src->io_u_zone_mgmt_plat[k][m];
+	}
+
+	for (k = 0; k < FIO_MAX_DP_IDS; k++) {
+		dst->dp_io_bytes[k] += src->dp_io_bytes[k];
+		sum_stat(&dst->dp_clat_stat[k], &src->dp_clat_stat[k], false);
+		dst->dp_ru_reclaims[k] += src->dp_ru_reclaims[k];
+		dst->dp_gc_bytes[k] += src->dp_gc_bytes[k];
+	}
+	dst->dp_emu_host_bytes += src->dp_emu_host_bytes;
+	dst->dp_emu_gc_bytes += src->dp_emu_gc_bytes;
+
+	for (k = 0; k < FIO_VJ_CNT; k++)
+		dst->vj_blocks[k] += src->vj_blocks[k];
+	dst->vj_violations += src->vj_violations;
+
+	dst->dedupe_bufs += src->dedupe_bufs;
+	dst->dedupe_dup_bufs += src->dedupe_dup_bufs;
+
 	dst->total_run_time += src->total_run_time;
 	dst->total_submit += src->total_submit;
 	dst->total_complete += src->total_complete;
+	dst->zc_bytes += src->zc_bytes;
+	dst->zc_copied_bytes += src->zc_copied_bytes;
+	dst->http_requests += src->http_requests;
+	dst->http_connects += src->http_connects;
 	dst->nr_zone_resets += src->nr_zone_resets;
 	dst->cachehit += src->cachehit;
 	dst->cachemiss += src->cachemiss;
+
+	sum_lat_outliers(dst, src);
+	sum_lat_heatmap(dst, src);
+	sum_file_stats(dst, src);
+	sum_clat_depth(dst, src);
 }
 
 void init_group_run_stat(struct group_run_stats *gs)
@@ -2385,6 +3652,10 @@ void init_thread_stat_min_vals(struct thread_stat *ts)
 		ts->iops_stat[i].min_val = ULONG_MAX;
 	}
 	ts->sync_stat.min_val = ULONG_MAX;
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++)
+		ts->zone_mgmt_stat[i].min_val = ULONG_MAX;
+	for (i = 0; i < FIO_MAX_DP_IDS; i++)
+		ts->dp_clat_stat[i].min_val = ULONG_MAX;
 }
 
 void init_thread_stat(struct thread_stat *ts)
@@ -2577,6 +3848,7 @@ void __show_run_stats(void)
 		ts->latency_target = td->o.latency_target;
 		ts->latency_percentile = td->o.latency_percentile;
 		ts->latency_window = td->o.latency_window;
+		ts->dedupe_percentage = td->o.dedupe_percentage;
 
 		ts->nr_block_infos = td->ts.nr_block_infos;
 		for (k = 0; k < ts->nr_block_infos; k++)
@@ -2745,6 +4017,10 @@ void __show_run_stats(void)
 	for (i = 0; i < nr_ts; i++) {
 		ts = &threadstats[i];
 		free_clat_prio_stats(ts);
+		free_lat_outliers(ts);
+		free_lat_heatmap(ts);
+		free_file_stats(ts);
+		free_clat_depth(ts);
 	}
 	free(threadstats);
 	free(opt_lists);
@@ -3132,10 +4408,31 @@ void reset_io_stats(struct thread_data *td)
 			reset_io_u_plat(ts->io_u_plat[i][j]);
 
 	reset_clat_prio_stats(ts);
+	reset_lat_outliers(td);
+	reset_lat_heatmap(ts);
+	reset_file_stats(td);
+	reset_clat_depth(ts);
 
 	ts->total_io_u[DDIR_SYNC] = 0;
 	reset_io_u_plat(ts->io_u_sync_plat);
 
+	for (i = 0; i < FIO_ZONE_MGMT_CNT; i++) {
+		reset_io_stat(&ts->zone_mgmt_stat[i]);
+		reset_io_u_plat(ts->io_u_zone_mgmt_plat[i]);
+	}
+
+	for (i = 0; i < FIO_MAX_DP_IDS; i++) {
+		ts->dp_io_bytes[i] = 0;
+		reset_io_stat(&ts->dp_clat_stat[i]);
+		ts->dp_ru_reclaims[i] = 0;
+		ts->dp_gc_bytes[i] = 0;
+	}
+	ts->dp_emu_host_bytes = 0;
+	ts->dp_emu_gc_bytes = 0;
+
+	ts->dedupe_bufs = 0;
+	ts->dedupe_dup_bufs = 0;
+
 	for (i = 0; i < FIO_IO_U_MAP_NR; i++) {
 		ts->io_u_map[i] = 0;
 		ts->io_u_submit[i] = 0;
@@ -3151,6 +4448,8 @@ void reset_io_stats(struct thread_data *td)
 
 	ts->total_submit = 0;
 	ts->total_complete = 0;
+	ts->zc_bytes = ts->zc_copied_bytes = 0;
+	ts->http_requests = ts->http_connects = 0;
 	ts->nr_zone_resets = 0;
 	ts->cachehit = ts->cachemiss = 0;
 }
@@ -3271,6 +4570,35 @@ void add_agg_sample(union io_sample_data data, enum fio_ddir ddir,
 	__add_log_sample(iolog, mtime_since_genesis(), &sample);
 }
 
+void add_dp_sample(struct thread_data *td, uint16_t plid,
+		   unsigned long long nsec, unsigned long long bytes)
+{
+	const bool needs_lock = td_async_processing(td);
+	struct thread_stat *ts = &td->ts;
+
+	if (plid >= FIO_MAX_DP_IDS)
+		return;
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	ts->dp_io_bytes[plid] += bytes;
+	add_stat_sample(&ts->dp_clat_stat[plid], nsec);
+
+	if (needs_lock)
+		__td_io_u_unlock(td);
+}
+
+void add_zone_mgmt_sample(struct thread_stat *ts, enum fio_zone_mgmt op,
+			  unsigned long long nsec)
+{
+	unsigned int idx = plat_val_to_idx(nsec);
+	assert(idx < FIO_IO_U_PLAT_NR);
+
+	ts->io_u_zone_mgmt_plat[op][idx]++;
+	add_stat_sample(&ts->zone_mgmt_stat[op], nsec);
+}
+
 void add_sync_clat_sample(struct thread_stat *ts, unsigned long long nsec)
 {
 	unsigned int idx = plat_val_to_idx(nsec);
@@ -3685,6 +5013,170 @@ int calc_log_samples(void)
 	return next == ~0U ? 0 : next;
 }
 
+/*
+ * Per-interval latency percentile log. Every log_pct_msec the helper thread
+ * diffs the job's latency histogram against the snapshot taken at the end of
+ * the previous interval, and writes the percentiles of that delta. Each line
+ * thus describes a single interval rather than the run so far, which is what
+ * is needed to see tail latency drift over time.
+ */
+struct pct_log {
+	FILE *f;
+	fio_fp64_t plist[FIO_IO_U_LIST_MAX_LEN];
+	uint64_t last[DDIR_RWDIR_CNT][FIO_IO_U_PLAT_NR];
+	uint64_t delta[FIO_IO_U_PLAT_NR];
+	unsigned long long last_msec;
+};
+
+int pct_log_init(struct thread_data *td, const char *name)
+{
+	struct pct_log *pl;
+
+	pl = calloc(1, sizeof(*pl));
+	if (!pl)
+		return 1;
+
+	pl->f = fopen(name, td->o.per_job_logs ? "w" : "a");
+	if (!pl->f) {
+		log_err("fio: failed to open percentile log %s: %s\n", name,
+			strerror(errno));
+		free(pl);
+		return 1;
+	}
+
+	memcpy(pl->plist, td->o.log_pct_list, sizeof(pl->plist));
+	td->pct_log = pl;
+	return 0;
+}
+
+static void pct_log_close(struct thread_data *td)
+{
+	fclose(td->pct_log->f);
+	free(td->pct_log);
+	td->pct_log = NULL;
+}
+
+static void pct_log_write(struct thread_data *td, unsigned long long msec)
+{
+	struct pct_log *pl = td->pct_log;
+	enum fio_lat lat = td->o.lat_percentiles ? FIO_LAT : FIO_CLAT;
+	int ddir, i;
+
+	for (ddir = 0; ddir < DDIR_RWDIR_CNT; ddir++) {
+		uint64_t *cur = td->ts.io_u_plat[lat][ddir];
+		unsigned long long *ovals = NULL, nr = 0, maxv, minv;
+		unsigned int len;
+		bool reset = false;
+
+		/*
+		 * The job updates these counters while we read them, so read
+		 * each bucket once and use that same value for both the delta
+		 * and the new snapshot. A bucket going backwards means the
+		 * stats were reset underneath us; start over from zero then.
+		 */
+		for (i = 0; i < FIO_IO_U_PLAT_NR; i++) {
+			uint64_t val = cur[i];
+
+			if (val < pl->last[ddir][i])
+				reset = true;
+			pl->delta[i] = val - pl->last[ddir][i];
+			pl->last[ddir][i] = val;
+		}
+		if (reset)
+			memcpy(pl->delta, pl->last[ddir], sizeof(pl->delta));
+
+		for (i = 0; i < FIO_IO_U_PLAT_NR; i++)
+			nr += pl->delta[i];
+		if (!nr)
+			continue;
+
+		len = calc_clat_percentiles(pl->delta, nr, pl->plist, &ovals,
+						&maxv, &minv);
+		if (!len)
+			continue;
+
+		if (td->o.log_pct_json) {
+			fprintf(pl->f, "{\"time\": %llu, \"ddir\": \"%s\", "
+				"\"samples\": %llu, \"percentiles\": {", msec,
+				io_ddir_name(ddir), nr);
+			for (i = 0; i < len; i++)
+				fprintf(pl->f, "%s\"%f\": %llu", i ? ", " : "",
+					pl->plist[i].u.f, ovals[i]);
+			fprintf(pl->f, "}}\n");
+		} else {
+			fprintf(pl->f, "%llu, %d, %llu", msec, ddir, nr);
+			for (i = 0; i < len; i++)
+				fprintf(pl->f, ", %llu", ovals[i]);
+			fprintf(pl->f, "\n");
+		}
+
+		free(ovals);
+	}
+
+	fflush(pl->f);
+}
+
+/*
+ * Returns msecs to next percentile log interval, 0 if nothing is logging
+ */
+unsigned int calc_pct_log_samples(void)
+{
+	unsigned int next = ~0U;
+	struct timespec now;
+
+	for_each_td(td) {
+		struct pct_log *pl = td->pct_log;
+		unsigned long long elapsed, interval = td->o.log_pct_msec;
+
+		if (!pl)
+			continue;
+
+		if (td->runstate >= TD_EXITED) {
+			fio_gettime(&now, NULL);
+			pct_log_write(td, mtime_since(&td->epoch, &now));
+			pct_log_close(td);
+			continue;
+		}
+		if (!td_in_logging_state(td)) {
+			next = min(next, (unsigned int) interval);
+			continue;
+		}
+
+		fio_gettime(&now, NULL);
+		elapsed = mtime_since(&td->epoch, &now);
+
+		/* epoch was moved, e.g. by the end of ramp_time */
+		if (elapsed < pl->last_msec)
+			pl->last_msec = 0;
+
+		if (elapsed - pl->last_msec >= interval) {
+			pl->last_msec += (elapsed - pl->last_msec) / interval * interval;
+			pct_log_write(td, pl->last_msec);
+		}
+
+		next = min(next, (unsigned int) (pl->last_msec + interval - elapsed));
+	} end_for_each();
+
+	return next == ~0U ? 0 : next;
+}
+
+/*
+ * Write the final, partial interval for jobs the helper did not see exit
+ */
+void pct_log_exit(void)
+{
+	struct timespec now;
+
+	for_each_td(td) {
+		if (!td->pct_log)
+			continue;
+
+		fio_gettime(&now, NULL);
+		pct_log_write(td, mtime_since(&td->epoch, &now));
+		pct_log_close(td);
+	} end_for_each();
+}
+
 void stat_init(void)
 {
 	stat_sem = fio_sem_init(FIO_SEM_UNLOCKED);
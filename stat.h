@@ -157,12 +157,107 @@ enum fio_lat {
 	FIO_LAT_CNT = 3,
 };
 
+enum fio_zone_mgmt {
+	FIO_ZONE_RESET = 0,
+	FIO_ZONE_FINISH,
+
+	FIO_ZONE_MGMT_CNT = 2,
+};
+
+/*
+ * What a crash consistency check found in a block, see verify_journal
+ */
+enum fio_vj_state {
+	FIO_VJ_DURABLE = 0,
+	FIO_VJ_TORN,
+	FIO_VJ_LOST,
+
+	FIO_VJ_CNT = 3,
+};
+
 struct clat_prio_stat {
 	uint64_t io_u_plat[FIO_IO_U_PLAT_NR];
 	struct io_stat clat_stat;
 	uint32_t ioprio;
 };
 
+/*
+ * lat_outliers keeps at most this many I/Os per window, and at most
+ * FIO_LAT_OUTLIERS_SLOTS in total. Windows past the last one that fits
+ * are merged into it.
+ */
+#define FIO_LAT_OUTLIERS_MAX	1024
+#define FIO_LAT_OUTLIERS_SLOTS	4096
+
+/*
+ * One of the slowest I/Os of a job. Times are in nsec since the job
+ * started.
+ */
+struct lat_outlier {
+	uint64_t lat;
+	uint64_t offset;
+	uint64_t start;
+	uint64_t issue;
+	uint64_t complete;
+	uint32_t window;
+	uint32_t fileno;
+	uint32_t len;
+	uint32_t depth;
+	uint16_t ddir;
+	uint16_t ioprio;
+	uint32_t pad;
+};
+
+/*
+ * lat_heatmap buckets completion latencies in usec, with
+ * FIO_LAT_HEATMAP_VAL linear buckets for each power of two. Values of
+ * 2^(FIO_LAT_HEATMAP_GROUPS + 1) usec (about 67s) and up land in the last
+ * bucket. At most FIO_LAT_HEATMAP_MAX_REGIONS regions are kept per job.
+ */
+#define FIO_LAT_HEATMAP_BITS	2
+#define FIO_LAT_HEATMAP_VAL	(1 << FIO_LAT_HEATMAP_BITS)
+#define FIO_LAT_HEATMAP_GROUPS	25
+#define FIO_LAT_HEATMAP_NR	(FIO_LAT_HEATMAP_GROUPS * FIO_LAT_HEATMAP_VAL)
+#define FIO_LAT_HEATMAP_MAX_REGIONS	1024
+
+/*
+ * file_stats keeps a struct file_stat for every file of a job, and reports
+ * at most FIO_FILE_STATS_MAX of them. Completion latencies are counted in
+ * FIO_FILE_STAT_NR buckets, each four times as wide as the one before.
+ */
+#define FIO_FILE_STATS_MAX	1024
+#define FIO_FILE_STAT_NR	12
+#define FIO_FILE_STAT_NAME	256
+
+enum {
+	FIO_FILE_STATS_LAT	= 0,
+	FIO_FILE_STATS_BW,
+};
+
+struct file_stat {
+	uint64_t bytes;
+	uint64_t lat_sum;
+	uint64_t lat_max;
+	uint32_t lat_hist[FIO_FILE_STAT_NR];
+};
+
+struct file_stat_entry {
+	char name[FIO_FILE_STAT_NAME];
+	struct file_stat fs;
+};
+
+/*
+ * clat_depth_hist splits completion latency by the queue depth an I/O was
+ * submitted at, in powers of two up to FIO_CLAT_DEPTH_NR - 1. Latencies
+ * use the lat_heatmap buckets.
+ */
+#define FIO_CLAT_DEPTH_NR	11
+
+struct clat_depth_stat {
+	uint64_t lat_sum;
+	uint64_t hist[FIO_LAT_HEATMAP_NR];
+};
+
 struct thread_stat {
 	char name[FIO_JOBNAME_SIZE];
 	char verror[FIO_VERROR_SIZE];
@@ -223,6 +318,19 @@ struct thread_stat {
 	uint64_t runtime[DDIR_RWDIR_CNT];
 	uint64_t total_run_time;
 
+	/*
+	 * net engine zerocopy=1: bytes sent without a copy, and bytes the
+	 * kernel ended up copying anyway
+	 */
+	uint64_t zc_bytes;
+	uint64_t zc_copied_bytes;
+
+	/*
+	 * http engine: requests completed, and new connections they opened
+	 */
+	uint64_t http_requests;
+	uint64_t http_connects;
+
 	/*
 	 * IO Error related stats
 	 */
@@ -235,6 +343,27 @@ struct thread_stat {
 
 	/* ZBD stats */
 	uint64_t nr_zone_resets;
+	struct io_stat zone_mgmt_stat[FIO_ZONE_MGMT_CNT] __attribute__((aligned(8)));
+	uint64_t io_u_zone_mgmt_plat[FIO_ZONE_MGMT_CNT][FIO_IO_U_PLAT_NR];
+
+	/* Data placement stats, indexed by placement ID */
+	uint64_t dp_io_bytes[FIO_MAX_DP_IDS];
+	struct io_stat dp_clat_stat[FIO_MAX_DP_IDS] __attribute__((aligned(8)));
+	uint64_t dp_ru_reclaims[FIO_MAX_DP_IDS];
+	uint64_t dp_gc_bytes[FIO_MAX_DP_IDS];
+	/* Emulated data placement device, see dp_emulation */
+	uint64_t dp_emu_host_bytes;
+	uint64_t dp_emu_gc_bytes;
+
+	/* Crash consistency check results, see verify_journal */
+	uint64_t vj_blocks[FIO_VJ_CNT];
+	uint64_t vj_violations;
+
+	/* Write buffers made with dedupe_percentage set, and the duplicates */
+	uint64_t dedupe_bufs;
+	uint64_t dedupe_dup_bufs;
+	uint32_t dedupe_percentage;
+	uint32_t pad7;
 
 	uint64_t nr_block_infos;
 	uint32_t block_infos[MAX_NR_BLOCK_INFOS];
@@ -293,6 +422,74 @@ struct thread_stat {
 	};
 	uint32_t nr_clat_prio[DDIR_RWDIR_CNT];
 
+	union {
+		/*
+		 * One min-heap of lat_outliers_per_window entries for each
+		 * window, lat_outliers_slots entries in total.
+		 */
+		struct lat_outlier *lat_outliers;
+		/*
+		 * For FIO_NET_CMD_TS, the pointed to data will temporarily
+		 * be stored at this offset from the start of the payload.
+		 */
+		uint64_t lat_outliers_offset;
+		uint64_t pad8;
+	};
+	uint32_t lat_outliers_slots;
+	uint32_t lat_outliers_per_window;
+	uint64_t lat_outliers_window;
+
+	union {
+		/*
+		 * FIO_LAT_HEATMAP_NR buckets for each of lat_heatmap_regions
+		 * regions of lat_heatmap_region bytes.
+		 */
+		uint64_t *lat_heatmap;
+		/*
+		 * For FIO_NET_CMD_TS, the pointed to data will temporarily
+		 * be stored at this offset from the start of the payload.
+		 */
+		uint64_t lat_heatmap_offset;
+		uint64_t pad9;
+	};
+	uint32_t lat_heatmap_regions;
+	uint32_t pad10;
+	uint64_t lat_heatmap_region;
+
+	union {
+		/*
+		 * The top nr_file_stats files of the job, at most
+		 * file_stats_top of them, sorted by file_stats_sort.
+		 */
+		struct file_stat_entry *file_stats;
+		/*
+		 * For FIO_NET_CMD_TS, the pointed to data will temporarily
+		 * be stored at this offset from the start of the payload.
+		 */
+		uint64_t file_stats_offset;
+		uint64_t pad11;
+	};
+	uint32_t nr_file_stats;
+	uint32_t file_stats_top;
+	uint32_t file_stats_sort;
+	uint32_t pad12;
+
+	union {
+		/*
+		 * FIO_CLAT_DEPTH_NR entries for each data direction,
+		 * clat_depth_nr in total.
+		 */
+		struct clat_depth_stat *clat_depth;
+		/*
+		 * For FIO_NET_CMD_TS, the pointed to data will temporarily
+		 * be stored at this offset from the start of the payload.
+		 */
+		uint64_t clat_depth_offset;
+		uint64_t pad13;
+	};
+	uint32_t clat_depth_nr;
+	uint32_t pad14;
+
 	uint64_t cachehit;
 	uint64_t cachemiss;
 } __attribute__((packed));
@@ -378,10 +575,37 @@ extern void add_iops_sample(struct thread_data *, struct io_u *,
 				unsigned int);
 extern void add_bw_sample(struct thread_data *, struct io_u *,
 				unsigned int, unsigned long long);
+extern void add_dp_sample(struct thread_data *td, uint16_t plid,
+			  unsigned long long nsec, unsigned long long bytes);
+extern void add_zone_mgmt_sample(struct thread_stat *ts,
+				 enum fio_zone_mgmt op,
+				 unsigned long long nsec);
 extern void add_sync_clat_sample(struct thread_stat *ts,
 				unsigned long long nsec);
 extern int calc_log_samples(void);
+extern int pct_log_init(struct thread_data *, const char *);
+extern unsigned int calc_pct_log_samples(void);
+extern void pct_log_exit(void);
 extern void free_clat_prio_stats(struct thread_stat *);
+extern int init_lat_outliers(struct thread_data *);
+extern void add_lat_outlier(struct thread_data *, struct io_u *,
+			    enum fio_ddir, const struct timespec *,
+			    unsigned long long);
+extern void free_lat_outliers(struct thread_stat *);
+extern int init_lat_heatmap(struct thread_data *);
+extern void add_lat_heatmap_sample(struct thread_stat *, uint64_t,
+				   unsigned long long);
+extern int write_lat_heatmap(struct thread_data *);
+extern void free_lat_heatmap(struct thread_stat *);
+extern int init_file_stats(struct thread_data *);
+extern void add_file_stat(struct thread_data *, struct fio_file *,
+			  unsigned int, unsigned long long);
+extern void file_stats_exit(struct thread_data *);
+extern void free_file_stats(struct thread_stat *);
+extern int init_clat_depth(struct thread_stat *);
+extern void add_clat_depth_sample(struct thread_stat *, enum fio_ddir,
+				  unsigned int, unsigned long long);
+extern void free_clat_depth(struct thread_stat *);
 extern int alloc_clat_prio_stat_ddir(struct thread_stat *, enum fio_ddir, int);
 
 extern void print_disk_util(struct disk_util_stat *, struct disk_util_agg *, int terse, struct buf_output *);
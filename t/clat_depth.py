@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# clat_depth.py
+#
+# Test clat_depth_hist, which splits the completion latency of a job by the
+# queue depth each I/O was submitted at in the JSON+ output. Batched
+# submissions fill the depths in a known proportion, and on a simdev device
+# with a fixed latency every depth sees that latency.
+#
+# USAGE
+# python clat_depth.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/clat_depth.py
+# python t/clat_depth.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import sys
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+DDIRS = ['read', 'write', 'trim', 'mixed']
+
+
+class FioClatDepthTest(FioJobCmdTest):
+    """Completion latency by queue depth test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        fio_args = [
+                    "--name=cd",
+                    f"--ioengine={self.fio_opts.get('ioengine', 'null')}",
+                    "--size=1T",
+                    "--time_based",
+                    "--runtime=1",
+                    "--clat_depth_hist=1",
+                    f"--output-format={self.fio_opts.get('output-format', 'json+')}",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'iodepth', 'iodepth_batch', 'simdev_lat',
+                                    'unified_rw_reporting', 'disable_clat'])
+
+        super().setup(fio_args)
+
+    def check_ddir(self, ddir, clat):
+        """Check the depth bins of one data direction against its clat."""
+
+        bins = clat['depth_bins']
+        shares = self.fio_opts['shares']
+        depths = sorted(int(d) for d in bins)
+        if depths != sorted(shares):
+            self.fail(f"{ddir}: found depths {depths}, expected {sorted(shares)}")
+            return
+
+        total = sum(b['N'] for b in bins.values())
+        if total != clat['N']:
+            self.fail(f"{ddir}: {total} samples in the depth bins, clat has {clat['N']}")
+            return
+
+        mean = sum(b['N'] * b['mean'] for b in bins.values()) / total
+        if abs(mean - clat['mean']) > 0.01 * clat['mean'] + 1:
+            self.fail(f"{ddir}: depth bins mean {mean}, clat mean {clat['mean']}")
+
+        # A batch of n I/Os is submitted at depths 1 to n, each counted
+        # in the bin of the power of two at or below its depth
+        tolerance = self.fio_opts.get('share_tolerance', 0.005)
+        for depth, share in shares.items():
+            found = bins[str(depth)]['N'] / total
+            if abs(found - share) > tolerance:
+                self.fail(f"{ddir}: {found:.4f} of the I/Os at depth {depth}, "
+                          f"expected {share:.4f}")
+
+        for depth, depth_bin in bins.items():
+            if sum(depth_bin['bins'].values()) != depth_bin['N']:
+                self.fail(f"{ddir}: depth {depth} histogram does not add up to N")
+            if 'lat_us' in self.fio_opts:
+                lat_ns = self.fio_opts['lat_us'] * 1000
+                if not lat_ns <= depth_bin['mean'] <= lat_ns * 1.1 + 50000:
+                    self.fail(f"{ddir}: depth {depth} mean {depth_bin['mean']}, "
+                              f"device latency {lat_ns}")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        for ddir in DDIRS:
+            if ddir not in job or not job[ddir]['clat_ns']['N']:
+                continue
+            clat = job[ddir]['clat_ns']
+            if ddir in self.fio_opts.get('ddirs', []):
+                if 'depth_bins' not in clat:
+                    self.fail(f"{ddir}: no depth bins")
+                    continue
+                self.check_ddir(ddir, clat)
+            elif 'depth_bins' in clat:
+                self.fail(f"{ddir}: unexpected depth bins")
+
+
+TEST_LIST = [
+    {
+        # Batches of 16 fill every power of two up to 16
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "iodepth": 16,
+            "iodepth_batch": 16,
+            "ddirs": ['read', 'write'],
+            "shares": {1: 1/16, 2: 2/16, 4: 4/16, 8: 8/16, 16: 1/16},
+            },
+        "test_class": FioClatDepthTest,
+    },
+    {
+        # Synchronous I/O is always submitted at depth 1
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "read",
+            "ddirs": ['read'],
+            "shares": {1: 1.0},
+            },
+        "test_class": FioClatDepthTest,
+    },
+    {
+        # Mixed reporting merges the reads and writes
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randrw",
+            "iodepth": 8,
+            "iodepth_batch": 8,
+            "unified_rw_reporting": "mixed",
+            "ddirs": ['mixed'],
+            "shares": {1: 1/8, 2: 2/8, 4: 4/8, 8: 1/8},
+            },
+        "test_class": FioClatDepthTest,
+    },
+    {
+        # Plain JSON output leaves the depth bins out
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randrw",
+            "iodepth": 4,
+            "iodepth_batch": 4,
+            "output-format": "json",
+            },
+        "test_class": FioClatDepthTest,
+    },
+    {
+        # No completion latency to split
+        "test_id": 5,
+        "fio_opts": {
+            "disable_clat": 1,
+            "expect_err": "clat_depth_hist requires disable_clat=0",
+            },
+        "test_class": FioClatDepthTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # A device with a fixed latency stays at full depth, and every
+        # depth sees that latency
+        "test_id": 6,
+        "fio_opts": {
+            "rw": "randread",
+            "ioengine": "simdev",
+            "simdev_lat": "1ms",
+            "iodepth": 16,
+            "ddirs": ['read'],
+            "shares": {1: 0, 2: 0, 4: 0, 8: 0, 16: 1.0},
+            "share_tolerance": 0.01,
+            "lat_us": 1000,
+            },
+        "test_class": FioClatDepthTest,
+    },
+]
+
+
+def main():
+    """Run completion latency by queue depth tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'clat-depth', __file__))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# content_pool.py
+#
+# Test buffer_pool_size and buffer_pool_file, which take write content from a
+# pool built when the job starts. The written file is read back and checked
+# against the pool settings: its compress ratio, the blocks that repeat, and
+# for a sample file, where in the sample each block came from. Duplicates
+# found in the file must match the duplicates fio reports.
+#
+# USAGE
+# python content_pool.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/content_pool.py
+# python t/content_pool.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import zlib
+import random
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+BS = 4096
+SIZE = 16 * 1024 * 1024
+SAMPLE_SIZE = 1024 * 1024
+
+
+class FioContentPoolTest(FioJobCmdTest):
+    """Content pool test."""
+
+    def setup(self, parameters):
+        """Setup the test, writing the sample file first for buffer_pool_file."""
+
+        super().setup([])
+
+        self.datafile = os.path.abspath(os.path.join(self.paths['test_dir'], 'cp.dat'))
+        fio_args = [
+                    "--name=cp",
+                    f"--filename={self.datafile}",
+                    "--rw=write",
+                    f"--bs={BS}",
+                    f"--size={SIZE}",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['ioengine', 'buffer_pool_size', 'buffer_compress_percentage',
+                                    'dedupe_percentage', 'dedupe_mode',
+                                    'dedupe_working_set_percentage', 'iomem_align',
+                                    'verify'])
+
+        if 'sample' in self.fio_opts:
+            self.sample = os.path.abspath(os.path.join(self.paths['test_dir'], 'sample.dat'))
+            rng = random.Random(self.fio_opts['sample'])
+            with open(self.sample, 'wb') as file:
+                file.write(rng.randbytes(SAMPLE_SIZE))
+            fio_args.append(f"--buffer_pool_file={self.sample}")
+
+        super().setup(fio_args)
+
+    def check_sample(self, blocks, duplicates):
+        """
+        Every block is a chunk of the sample file. With a dedupe working set,
+        exactly the duplicates come from the start of the sample.
+        """
+
+        with open(self.sample, 'rb') as file:
+            sample = file.read()
+        chunks = {sample[i:i+BS]: i // BS for i in range(0, len(sample), BS)}
+
+        for i, block in enumerate(blocks):
+            if block not in chunks:
+                self.fail(f"Block {i} is not a block of the sample file")
+                return
+
+        if self.fio_opts.get('dedupe_mode') == 'working_set':
+            ws_chunks = SAMPLE_SIZE // BS * self.fio_opts['dedupe_working_set_percentage'] // 100
+            from_ws = sum(1 for block in blocks if chunks[block] < ws_chunks)
+            if from_ws != duplicates:
+                self.fail(f"{from_ws} blocks from the working set, {duplicates} duplicates")
+
+    def check_dedupe(self, job, blocks):
+        """Writes repeat the previous write as often as reported and requested."""
+
+        dedupe = job.get('dedupe')
+        if not dedupe:
+            self.fail("No dedupe statistics reported")
+            return 0
+
+        if dedupe['buffers'] != len(blocks):
+            self.fail(f"{dedupe['buffers']} buffers counted for {len(blocks)} writes")
+
+        requested = self.fio_opts['dedupe_percentage']
+        if abs(dedupe['achieved'] - requested) > 3:
+            self.fail(f"{dedupe['achieved']:.2f}% of writes repeated, requested {requested}%")
+
+        # A fresh range picked from a large pool rarely matches the last one
+        if self.fio_opts.get('dedupe_mode', 'repeat') == 'repeat':
+            repeats = sum(1 for i in range(1, len(blocks)) if blocks[i] == blocks[i - 1])
+            if not dedupe['duplicates'] <= repeats <= dedupe['duplicates'] + 2:
+                self.fail(f"{repeats} blocks repeat the previous block, "
+                          f"{dedupe['duplicates']} duplicates reported")
+
+        return dedupe['duplicates']
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        if job['write']['io_bytes'] != SIZE:
+            self.fail(f"Wrote {job['write']['io_bytes']} of {SIZE} bytes")
+
+        with open(self.datafile, 'rb') as file:
+            data = file.read()
+        blocks = [data[i:i+BS] for i in range(0, len(data), BS)]
+
+        duplicates = 0
+        if 'dedupe_percentage' in self.fio_opts:
+            duplicates = self.check_dedupe(job, blocks)
+        elif 'dedupe' in job:
+            self.fail("Dedupe statistics reported without dedupe_percentage")
+
+        # Writes pick random ranges of the pool, so some repeat by chance
+        if 'unique' in self.fio_opts:
+            low, high = self.fio_opts['unique']
+            unique = len(set(blocks)) / len(blocks)
+            if not low <= unique <= high:
+                self.fail(f"Unique block share {unique:.2f} outside [{low}, {high}]")
+
+        if 'ratio' in self.fio_opts:
+            low, high = self.fio_opts['ratio']
+            ratio = len(data) / len(zlib.compress(data, 1))
+            if not low <= ratio <= high:
+                self.fail(f"Compress ratio {ratio:.2f} outside [{low}, {high}]")
+
+        if 'sample' in self.fio_opts:
+            self.check_sample(blocks, duplicates)
+
+
+TEST_LIST = [
+    {
+        # Compressible content, written without a copy
+        "test_id": 1,
+        "fio_opts": {
+            "ioengine": "psync",
+            "buffer_pool_size": "128m",
+            "buffer_compress_percentage": 50,
+            "unique": (0.9, 1.0),
+            "ratio": (1.6, 2.6),
+            },
+        "test_class": FioContentPoolTest,
+    },
+    {
+        # Dedupable content, copied into the io_u buffer by mmap
+        "test_id": 2,
+        "fio_opts": {
+            "ioengine": "mmap",
+            "buffer_pool_size": "256m",
+            "dedupe_percentage": 30,
+            "unique": (0.64, 0.74),
+            },
+        "test_class": FioContentPoolTest,
+    },
+    {
+        # Content from a sample file
+        "test_id": 3,
+        "fio_opts": {
+            "ioengine": "posixaio",
+            "sample": 3,
+            },
+        "test_class": FioContentPoolTest,
+    },
+    {
+        # Duplicates come from the working set at the start of the pool
+        "test_id": 4,
+        "fio_opts": {
+            "ioengine": "psync",
+            "sample": 4,
+            "dedupe_percentage": 40,
+            "dedupe_mode": "working_set",
+            "dedupe_working_set_percentage": 10,
+            },
+        "test_class": FioContentPoolTest,
+    },
+    {
+        # Pool writes carry no verify headers
+        "test_id": 5,
+        "fio_opts": {
+            "buffer_pool_size": "8m",
+            "verify": "crc32c",
+            "expect_err": "do not support verify",
+            },
+        "test_class": FioContentPoolTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # A sample file read into memory that starts off the page
+        "test_id": 6,
+        "fio_opts": {
+            "ioengine": "psync",
+            "sample": 6,
+            "iomem_align": 512,
+            },
+        "test_class": FioContentPoolTest,
+    },
+]
+
+
+def main():
+    """Run content pool tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'content-pool', __file__))
+
+
+if __name__ == '__main__':
+    main()
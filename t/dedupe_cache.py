@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# dedupe_cache.py
+#
+# Test dedupe_working_set_cache, which takes duplicate write buffers from
+# precomputed working set pages. Each test writes the same job with and
+# without the cache and compares the data. The reported dedupe ratio is
+# checked against the request and against the duplicate blocks found in
+# the written files.
+#
+# USAGE
+# python dedupe_cache.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/dedupe_cache.py
+# python t/dedupe_cache.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import subprocess
+from fiotestlib import FioJobCmdTest, run_test_script
+
+
+SIZE = 8 * 1024 * 1024
+WORKING_SET_PERCENTAGE = 10
+
+
+class FioDedupeCacheTest(FioJobCmdTest):
+    """dedupe_working_set_cache test."""
+
+    def job_args(self, prefix, cache):
+        """fio arguments writing files named after prefix."""
+
+        fmt = os.path.abspath(os.path.join(self.paths['test_dir'], prefix))
+        fio_args = [
+                    "--name=dc",
+                    f"--filename_format={fmt}.$jobnum",
+                    "--rw=write",
+                    f"--size={SIZE}",
+                    "--dedupe_mode=working_set",
+                    f"--dedupe_working_set_percentage={WORKING_SET_PERCENTAGE}",
+                    f"--dedupe_working_set_cache={cache}",
+                   ]
+        fio_args += self.opts_args(['ioengine', 'bs', 'numjobs', 'dedupe_percentage',
+                                    'dedupe_global', 'buffer_compress_percentage'])
+        return fio_args
+
+    def setup(self, parameters):
+        """Setup the test, writing the reference files without the cache."""
+
+        super().setup([])
+
+        result = subprocess.run([self.paths['exe']] + self.job_args('ref', 0),
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                check=False)
+        if result.returncode:
+            print(f"Reference run failed: {result.stderr.decode()}")
+
+        fio_args = self.job_args('dc', 1)
+        fio_args += [
+                     "--output-format=json",
+                     f"--output={self.filenames['output']}",
+                    ]
+        super().setup(fio_args)
+
+    def read_blocks(self, nr_jobs):
+        """Compare the files written with and without the cache, return their blocks."""
+
+        bs = self.fio_opts['bs']
+        blocks = []
+        for i in range(nr_jobs):
+            with open(os.path.join(self.paths['test_dir'], f"ref.{i}"), 'rb') as file:
+                ref = file.read()
+            with open(os.path.join(self.paths['test_dir'], f"dc.{i}"), 'rb') as file:
+                data = file.read()
+            if ref != data:
+                self.fail(f"Job {i} wrote different data with the cache")
+            blocks += [data[j:j+bs] for j in range(0, len(data), bs)]
+
+        return blocks
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        nr_jobs = self.fio_opts.get('numjobs', 1)
+        jobs = self.get_jobs(nr_jobs)
+        if not jobs:
+            return
+
+        duplicates = 0
+        for job in jobs:
+            dedupe = job['dedupe']
+            if dedupe['requested'] != self.fio_opts['dedupe_percentage']:
+                self.fail(f"Requested {dedupe['requested']}%")
+            if dedupe['buffers'] != job['write']['total_ios']:
+                self.fail(f"{dedupe['buffers']} buffers counted for "
+                          f"{job['write']['total_ios']} writes")
+            if abs(dedupe['achieved'] - dedupe['requested']) > 3:
+                self.fail(f"Achieved {dedupe['achieved']}% of {dedupe['requested']}%")
+            if abs(dedupe['achieved'] - 100 * dedupe['duplicates'] / dedupe['buffers']) > 0.01:
+                self.fail(f"Achieved {dedupe['achieved']}% for {dedupe['duplicates']} "
+                          f"duplicates of {dedupe['buffers']} buffers")
+            duplicates += dedupe['duplicates']
+
+        # Unique buffers are all different, duplicates are copies of the
+        # pages of the working set
+        blocks = self.read_blocks(nr_jobs)
+        ws_pages = len(blocks) * WORKING_SET_PERCENTAGE // 100
+        distinct = len(set(blocks))
+        unique = len(blocks) - duplicates
+        if not unique <= distinct <= unique + ws_pages:
+            self.fail(f"{distinct} distinct blocks, {unique} unique buffers and "
+                      f"{ws_pages} working set pages")
+
+
+TEST_LIST = [
+    {
+        # Duplicates written straight from the cache
+        "test_id": 1,
+        "fio_opts": {
+            "ioengine": "psync",
+            "bs": 4096,
+            "dedupe_percentage": 50,
+            },
+        "test_class": FioDedupeCacheTest,
+    },
+    {
+        # Copied from the cache, with compression
+        "test_id": 2,
+        "fio_opts": {
+            "ioengine": "mmap",
+            "bs": 8192,
+            "dedupe_percentage": 30,
+            "buffer_compress_percentage": 40,
+            },
+        "test_class": FioDedupeCacheTest,
+    },
+    {
+        # One cache shared by global dedupe jobs
+        "test_id": 3,
+        "fio_opts": {
+            "ioengine": "psync",
+            "bs": 4096,
+            "numjobs": 3,
+            "dedupe_percentage": 60,
+            "dedupe_global": 1,
+            },
+        "test_class": FioDedupeCacheTest,
+    },
+]
+
+
+def main():
+    """Run dedupe_working_set_cache tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'dedupe-cache', __file__))
+
+
+if __name__ == '__main__':
+    main()
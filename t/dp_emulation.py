@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# dp_emulation.py
+#
+# Test data placement emulation (dp_emulation=1) and the per placement ID
+# statistics. The bytes and I/Os reported per placement ID must add up to
+# the job totals, the emulated device must see every byte written, and the
+# reported write amplification must follow from the garbage collection
+# traffic and move with the over-provisioning of the device.
+#
+# USAGE
+# python dp_emulation.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/dp_emulation.py
+# python t/dp_emulation.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+RU_SIZE = 1024 * 1024
+
+
+class FioDpEmuTest(FioJobCmdTest):
+    """dp_emulation test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        filename = os.path.abspath(os.path.join(self.paths['test_dir'], 'dp-emu.dat'))
+        fio_args = [
+                    "--name=dp-emu",
+                    f"--filename={filename}",
+                    "--size=16m",
+                    "--bs=4k",
+                    "--dp_emulation=1",
+                    f"--dp_emulation_ru_size={RU_SIZE}",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'io_size', 'norandommap', 'dataplacement',
+                                    'plids', 'plid_select', 'dp_emulation_nr_ruhs',
+                                    'dp_emulation_op'])
+
+        super().setup(fio_args)
+
+    def check_totals(self, job, plids):
+        """Per placement ID counts add up to the job and device totals."""
+
+        written = sum(p['io_bytes'] for p in plids)
+        if written != job['write']['io_bytes']:
+            self.fail(f"Placement IDs wrote {written} of {job['write']['io_bytes']} bytes")
+
+        ios = sum(p['clat_ns']['N'] for p in plids)
+        if ios != job['write']['total_ios']:
+            self.fail(f"Placement IDs completed {ios} of {job['write']['total_ios']} writes")
+
+        emulation = job['dataplacement']['emulation']
+        if emulation['host_bytes'] != job['write']['io_bytes']:
+            self.fail(f"Emulated device saw {emulation['host_bytes']} of "
+                      f"{job['write']['io_bytes']} bytes")
+
+        # Data relocated a second time, out of the reclaim units garbage
+        # collection wrote, only counts for the device
+        gc_bytes = sum(p['gc_bytes'] for p in plids)
+        if gc_bytes > emulation['gc_bytes']:
+            self.fail(f"Placement IDs relocated {gc_bytes} of {emulation['gc_bytes']} bytes")
+
+        # A reclaimed unit had some invalid data, less than a unit is moved
+        for plid in plids:
+            if plid['gc_bytes'] >= max(plid['ru_reclaims'], 1) * RU_SIZE:
+                self.fail(f"Placement ID {plid['plid']} relocated {plid['gc_bytes']} bytes "
+                          f"out of {plid['ru_reclaims']} reclaim units")
+
+        waf = (emulation['host_bytes'] + emulation['gc_bytes']) / emulation['host_bytes']
+        if abs(emulation['waf'] - waf) > 1e-5:
+            self.fail(f"WAF {emulation['waf']} does not match the relocated bytes, {waf}")
+
+    def check_shares(self, job, plids):
+        """Each placement ID gets its expected share of the writes."""
+
+        total = job['write']['io_bytes']
+        for plid in plids:
+            share = plid['io_bytes'] / total
+            expected = self.fio_opts['expect_shares'][plid['plid']]
+            if abs(share - expected) > self.fio_opts.get('share_tolerance', 0):
+                self.fail(f"Placement ID {plid['plid']} wrote {share:.3f} of the data, "
+                          f"expected {expected:.3f}")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        plids = job['dataplacement']['plids']
+        ids = [p['plid'] for p in plids]
+        if ids != sorted(self.fio_opts['expect_shares']):
+            self.fail(f"Expected placement IDs {sorted(self.fio_opts['expect_shares'])}, got {ids}")
+            return
+
+        self.check_totals(job, plids)
+        self.check_shares(job, plids)
+
+        waf = job['dataplacement']['emulation']['waf']
+        low, high = self.fio_opts['expect_waf']
+        if not low <= waf <= high:
+            self.fail(f"WAF {waf}, expected between {low} and {high}")
+
+
+TEST_LIST = [
+    {
+        # Sequential overwrites never relocate data, round robin placement
+        # splits them evenly
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "write",
+            "io_size": "64m",
+            "dataplacement": "fdp",
+            "dp_emulation_nr_ruhs": 4,
+            "expect_shares": {0: 0.25, 1: 0.25, 2: 0.25, 3: 0.25},
+            "expect_waf": (1.0, 1.0),
+            },
+        "test_class": FioDpEmuTest,
+    },
+    {
+        # Uniformly random overwrites do, only the selected IDs are used
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randwrite",
+            "io_size": "64m",
+            "norandommap": 1,
+            "dataplacement": "fdp",
+            "plids": "1,3",
+            "plid_select": "random",
+            "expect_shares": {1: 0.5, 3: 0.5},
+            "share_tolerance": 0.05,
+            "expect_waf": (1.1, 1.4),
+            },
+        "test_class": FioDpEmuTest,
+    },
+    {
+        # More over-provisioning leaves less data to relocate
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "io_size": "64m",
+            "norandommap": 1,
+            "dataplacement": "fdp",
+            "plids": "1,3",
+            "plid_select": "random",
+            "dp_emulation_op": 50,
+            "expect_shares": {1: 0.5, 3: 0.5},
+            "share_tolerance": 0.05,
+            "expect_waf": (1.0001, 1.15),
+            },
+        "test_class": FioDpEmuTest,
+    },
+    {
+        # Stream IDs map to the emulated handles
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randwrite",
+            "io_size": "64m",
+            "norandommap": 1,
+            "dataplacement": "streams",
+            "plids": "5,9",
+            "expect_shares": {5: 0.5, 9: 0.5},
+            "share_tolerance": 0.001,
+            "expect_waf": (1.1, 1.4),
+            },
+        "test_class": FioDpEmuTest,
+    },
+    {
+        # Emulation needs a data placement interface
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "write",
+            "expect_err": "dp_emulation requires dataplacement",
+            },
+        "test_class": FioDpEmuTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run data placement emulation tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'dp-emu', __file__))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# file_stats.py
+#
+# Test file_stats and file_stats_sort, which report the files of a job
+# with the highest latency or bandwidth. Single jobs log their I/O, so the
+# I/Os reported for each file and the choice of the busiest files can be
+# checked against the log. With every file reported, the files must add up
+# to the job.
+#
+# USAGE
+# python file_stats.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/file_stats.py
+# python t/file_stats.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import locale
+from collections import Counter
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+BS = 4096
+BUCKETS = 12
+DDIRS = ['read', 'write']
+
+
+class FioFileStatsTest(FioJobCmdTest):
+    """Per-file stats test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        self.iolog = os.path.abspath(os.path.join(self.paths['test_dir'], 'fs.iolog'))
+        fio_args = [
+                    "--name=fs",
+                    "--ioengine=psync",
+                    f"--directory={os.path.abspath(self.paths['test_dir'])}",
+                    "--filesize=256k",
+                    f"--bs={BS}",
+                    "--time_based",
+                    "--runtime=1",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'nrfiles', 'file_stats', 'file_stats_sort',
+                                    'file_service_type', 'numjobs', 'group_reporting',
+                                    'disable_clat'])
+
+        # Jobs would share the I/O log
+        if self.fio_opts.get('numjobs', 1) == 1:
+            fio_args.append(f"--write_iolog={self.iolog}")
+
+        super().setup(fio_args)
+
+    def read_iolog(self):
+        """Return the number of I/Os logged for each file."""
+
+        ios = Counter()
+        with open(self.iolog, 'r', encoding=locale.getpreferredencoding()) as file:
+            for line in file:
+                fields = line.split()
+                if len(fields) == 5 and fields[2] in DDIRS:
+                    ios[fields[1]] += 1
+
+        return ios
+
+    def check_files(self, stats):
+        """Check the entries of each file and their order."""
+
+        bounds = [0] + [4 ** i for i in range(BUCKETS - 1)]
+        if stats['bucket_us'] != bounds:
+            self.fail(f"Unexpected bucket bounds {stats['bucket_us']}")
+
+        sort = self.fio_opts.get('file_stats_sort', 'lat')
+        if stats['sort'] != sort:
+            self.fail(f"Sorted by {stats['sort']}, expected {sort}")
+
+        key = 'bytes' if sort == 'bw' else 'lat_mean_ns'
+        keys = [f[key] for f in stats['files']]
+        if keys != sorted(keys, reverse=True):
+            self.fail(f"Files not sorted by {key}: {keys}")
+
+        for file in stats['files']:
+            if file['ios'] != sum(file['lat_hist']) or \
+               file['bytes'] != file['ios'] * BS or \
+               file['lat_max_ns'] < file['lat_mean_ns']:
+                self.fail(f"Inconsistent file entry {file}")
+
+    def check_iolog(self, stats):
+        """The reported I/Os match the log, the busiest files are reported."""
+
+        logged = self.read_iolog()
+        for file in stats['files']:
+            if file['ios'] != logged[file['name']]:
+                self.fail(f"{file['name']}: {file['ios']} I/Os reported, "
+                          f"{logged[file['name']]} logged")
+
+        if stats['sort'] == 'bw':
+            busiest = sorted(logged.values(), reverse=True)[:len(stats['files'])]
+            reported = [f['ios'] for f in stats['files']]
+            if reported != busiest:
+                self.fail(f"Reported files with {reported} I/Os, the busiest had {busiest}")
+
+    def check_totals(self, job, stats):
+        """With every file reported, the files add up to the job."""
+
+        ios = sum(job[ddir]['clat_ns']['N'] for ddir in DDIRS)
+        if sum(f['ios'] for f in stats['files']) != ios:
+            self.fail(f"File I/Os do not add up to {ios}")
+
+        lat = sum(job[ddir]['clat_ns']['mean'] * job[ddir]['clat_ns']['N'] for ddir in DDIRS)
+        file_lat = sum(f['lat_mean_ns'] * f['ios'] for f in stats['files'])
+        if abs(file_lat - lat) > ios:
+            self.fail(f"File latencies add up to {file_lat}, expected {lat}")
+
+        lat_max = max(job[ddir]['clat_ns']['max'] for ddir in DDIRS)
+        if max(f['lat_max_ns'] for f in stats['files']) != lat_max:
+            self.fail(f"No file has the slowest I/O of the job, {lat_max} ns")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        stats = job['file_stats']
+        self.check_files(stats)
+
+        files = self.fio_opts['nrfiles'] * self.fio_opts.get('numjobs', 1)
+        expected = min(files, self.fio_opts['file_stats'])
+        if len(stats['files']) != expected:
+            self.fail(f"{len(stats['files'])} files reported, expected {expected}")
+        if len({f['name'] for f in stats['files']}) != len(stats['files']):
+            self.fail("Files reported more than once")
+
+        if self.fio_opts.get('numjobs', 1) == 1:
+            self.check_iolog(stats)
+        if expected == files:
+            self.check_totals(job, stats)
+
+
+TEST_LIST = [
+    {
+        # Every file, by latency
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "nrfiles": 20,
+            "file_stats": 50,
+            },
+        "test_class": FioFileStatsTest,
+    },
+    {
+        # Busiest files of a skewed workload
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randread",
+            "nrfiles": 50,
+            "file_stats": 5,
+            "file_stats_sort": "bw",
+            "file_service_type": "zipf:1.2",
+            },
+        "test_class": FioFileStatsTest,
+    },
+    {
+        # Top files of several jobs merged by group_reporting
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "nrfiles": 10,
+            "file_stats": 8,
+            "numjobs": 2,
+            "group_reporting": 1,
+            },
+        "test_class": FioFileStatsTest,
+    },
+    {
+        # No completion latency to rank files by
+        "test_id": 4,
+        "fio_opts": {
+            "nrfiles": 2,
+            "file_stats": 2,
+            "disable_clat": 1,
+            "expect_err": "file_stats requires disable_clat=0",
+            },
+        "test_class": FioFileStatsTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # Every file of several jobs merged by group_reporting
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "randread",
+            "nrfiles": 4,
+            "file_stats": 8,
+            "numjobs": 2,
+            "group_reporting": 1,
+            },
+        "test_class": FioFileStatsTest,
+    },
+]
+
+
+def main():
+    """Run per-file stats tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'file-stats', __file__))
+
+
+if __name__ == '__main__':
+    main()
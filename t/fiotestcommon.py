@@ -60,6 +60,7 @@ class Requirements():
     _unittests = False
     _cpucount4 = False
     _nvmecdev = False
+    _http = False
 
     def __init__(self, fio_root, args):
         Requirements._not_macos = platform.system() != "Darwin"
@@ -72,9 +73,11 @@ class Requirements():
             if not success:
                 print(f"Unable to open {config_file} to check requirements")
                 Requirements._zbd = True
+                Requirements._http = True
             else:
                 Requirements._zbd = "CONFIG_HAS_BLKZONED" in contents
                 Requirements._libaio = "CONFIG_LIBAIO" in contents
+                Requirements._http = "CONFIG_HTTP" in contents
 
             contents, success = get_file("/proc/kallsyms")
             if not success:
@@ -115,6 +118,7 @@ class Requirements():
                 Requirements.unittests,
                 Requirements.cpucount4,
                 Requirements.nvmecdev,
+                Requirements.http,
                     ]
         for req in req_list:
             value, desc = req()
@@ -174,3 +178,8 @@ class Requirements():
     def nvmecdev(cls):
         """Do we have an NVMe character device to test?"""
         return Requirements._nvmecdev, "NVMe character device test target required"
+
+    @classmethod
+    def http(cls):
+        """Was the http ioengine built?"""
+        return Requirements._http, "http ioengine required"
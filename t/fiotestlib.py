@@ -12,8 +12,10 @@ describing fio tests.
 import os
 import sys
 import json
+import time
 import locale
 import logging
+import argparse
 import platform
 import traceback
 import subprocess
@@ -336,6 +338,59 @@ class FioJobCmdTest(FioExeTest):
 
         return False
 
+    def opts_args(self, opts):
+        """Return fio arguments for the options in opts that the test sets."""
+
+        return [f"--{opt}={self.fio_opts[opt]}" for opt in opts if opt in self.fio_opts]
+
+    def fail(self, reason):
+        """Mark the test as failed and record why."""
+
+        print(reason)
+        self.failure_reason += f" {reason},"
+        self.passed = False
+
+    def check_expected_error(self):
+        """
+        For a test that sets fio_opts['expect_err'], check that fio printed
+        that error message. Returns True if the test expects an error, in
+        which case there is nothing else to check.
+        """
+
+        if 'expect_err' not in self.fio_opts:
+            return False
+
+        output = ''
+        for name in ['stderr', 'output']:
+            contents, _ = get_file(self.filenames[name])
+            if contents:
+                output += contents
+        if self.fio_opts['expect_err'] not in output:
+            self.fail(f"'{self.fio_opts['expect_err']}' not found in output")
+
+        return True
+
+    def get_jobs(self, nr_jobs=1, error=0):
+        """
+        Return the jobs in the JSON output, failing the test unless there
+        are nr_jobs of them and none reported an error other than error.
+        """
+
+        if not self.json_data and not self.get_json():
+            self.fail('Unable to decode JSON data')
+            return None
+
+        jobs = self.json_data['jobs']
+        if len(jobs) != nr_jobs:
+            self.fail(f"Expected {nr_jobs} job(s) in the output, found {len(jobs)}")
+            return None
+        for job in jobs:
+            if job['error'] != error:
+                self.fail(f"Job {job['jobname']} failed with error {job['error']}")
+                return None
+
+        return jobs
+
     @staticmethod
     def check_empty(job):
         """
@@ -486,3 +541,61 @@ def run_fio_tests(test_list, test_env, args):
     print(f"{passed} test(s) passed, {failed} failed, {skipped} skipped")
 
     return passed, failed, skipped
+
+
+def parse_test_args():
+    """Parse the command-line arguments shared by the test scripts."""
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-f', '--fio', help='path to fio executable (e.g., ./fio)')
+    parser.add_argument('-a', '--artifact-root', help='artifact root directory')
+    parser.add_argument('-d', '--debug', help='enable debug output', action='store_true')
+    parser.add_argument('-s', '--skip', nargs='+', type=int,
+                        help='list of test(s) to skip')
+    parser.add_argument('-o', '--run-only', nargs='+', type=int,
+                        help='list of test(s) to run, skipping all others')
+    args = parser.parse_args()
+
+    return args
+
+
+def run_test_script(test_list, basename, script, args=None):
+    """
+    Run the FioJobCmdTest list of a test script: set up fio and the
+    artifact directory from the command line and run the tests. Returns
+    the number of failed tests.
+
+    test_list   list of tests to run
+    basename    prefix for the artifacts of each test
+    script      path of the test script, used to locate the fio root
+    args        parsed command line, parsed here if not given
+    """
+
+    if not args:
+        args = parse_test_args()
+
+    if args.debug:
+        logging.basicConfig(level=logging.DEBUG)
+    else:
+        logging.basicConfig(level=logging.INFO)
+
+    if args.fio:
+        fio_path = str(Path(args.fio).absolute())
+    else:
+        fio_path = 'fio'
+    print(f"fio path is {fio_path}")
+
+    artifact_root = args.artifact_root if args.artifact_root else \
+        f"{basename}-test-{time.strftime('%Y%m%d-%H%M%S')}"
+    os.mkdir(artifact_root)
+    print(f"Artifact directory is {artifact_root}")
+
+    test_env = {
+              'fio_path': fio_path,
+              'fio_root': str(Path(script).absolute().parent.parent),
+              'artifact_root': artifact_root,
+              'basename': basename,
+              }
+
+    _, failed, _ = run_fio_tests(test_list, test_env, args)
+    return failed
@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# http_engine.py
+#
+# Test the http ioengine against a local stand-in object server. The server
+# keeps objects in memory and supports PUT/GET/DELETE, which is all fio
+# needs in webdav mode. It counts the requests it sees and how many were
+# in flight at once, so the tests can check that every I/O became exactly
+# one request and that iodepth > 1 really overlaps them. The requests and
+# connections fio reports must show connections being kept alive.
+#
+# USAGE
+# python http_engine.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/http_engine.py
+# python t/http_engine.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import sys
+import time
+import threading
+from collections import Counter
+from http.server import ThreadingHTTPServer, BaseHTTPRequestHandler
+from fiotestlib import FioJobCmdTest, parse_test_args, run_test_script
+
+
+class ObjectHandler(BaseHTTPRequestHandler):
+    """In-memory object store request handler."""
+
+    protocol_version = 'HTTP/1.1'
+    objects = {}
+    requests = Counter()
+    in_flight = 0
+    max_in_flight = 0
+    lock = threading.Lock()
+
+    @classmethod
+    def reset_stats(cls):
+        """Forget the requests of the previous test."""
+
+        with cls.lock:
+            cls.requests = Counter()
+            cls.max_in_flight = 0
+
+    def log_message(self, *args):
+        pass
+
+    def reply(self, code, body=b''):
+        """Send a response with an optional body."""
+
+        self.send_response(code)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        if body:
+            self.wfile.write(body)
+
+    def serve(self, method):
+        """
+        Count a request and hold it briefly, so that requests fio sends
+        together are seen in flight together.
+        """
+
+        cls = type(self)
+        with cls.lock:
+            cls.requests[method] += 1
+            cls.in_flight += 1
+            cls.max_in_flight = max(cls.max_in_flight, cls.in_flight)
+        time.sleep(0.002)
+        with cls.lock:
+            cls.in_flight -= 1
+
+    def do_PUT(self):
+        """Store an object."""
+
+        length = int(self.headers.get('Content-Length', 0))
+        data = self.rfile.read(length)
+        self.serve('PUT')
+        with self.lock:
+            self.objects[self.path] = data
+        self.reply(201)
+
+    def do_GET(self):
+        """Return an object, 404 if it was never written."""
+
+        self.serve('GET')
+        with self.lock:
+            data = self.objects.get(self.path)
+        if data is None:
+            self.reply(404)
+        else:
+            self.reply(200, data)
+
+    def do_DELETE(self):
+        """Remove an object."""
+
+        self.serve('DELETE')
+        with self.lock:
+            self.objects.pop(self.path, None)
+        self.reply(204)
+
+
+class ObjectServer(ThreadingHTTPServer):
+    """Stand-in object server, accepting many concurrent connections."""
+
+    request_queue_size = 256
+    daemon_threads = True
+
+
+class FioHttpTest(FioJobCmdTest):
+    """http ioengine test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        ObjectHandler.reset_stats()
+
+        fio_args = [
+                    "--name=http",
+                    "--ioengine=http",
+                    f"--http_host=127.0.0.1:{self.fio_opts['port']}",
+                    f"--filename=/{self.fio_opts['object']}",
+                    f"--output={self.filenames['output']}",
+                    "--output-format=json",
+                   ]
+        fio_args += self.opts_args(['rw', 'bs', 'size', 'iodepth', 'verify'])
+
+        super().setup(fio_args)
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        # Every I/O is one request of its own object
+        bs = self.fio_opts['bs_bytes']
+        nr_blocks = self.fio_opts['size_bytes'] // bs
+        expected = Counter()
+        if 'write' in self.fio_opts['rw']:
+            expected['PUT'] = nr_blocks
+        if 'read' in self.fio_opts['rw'] or 'verify' in self.fio_opts:
+            expected['GET'] = nr_blocks
+        if 'trim' in self.fio_opts['rw']:
+            expected['DELETE'] = nr_blocks
+        if ObjectHandler.requests != expected:
+            self.fail(f"Server saw {dict(ObjectHandler.requests)}, expected {dict(expected)}")
+
+        for ddir, method in [('write', 'PUT'), ('read', 'GET'), ('trim', 'DELETE')]:
+            if job[ddir]['total_ios'] != expected[method]:
+                self.fail(f"{job[ddir]['total_ios']} {ddir} I/Os for "
+                          f"{expected[method]} {method} requests")
+
+        if 'write' in self.fio_opts['rw']:
+            prefix = f"/{self.fio_opts['object']}_"
+            sizes = [len(v) for k, v in ObjectHandler.objects.items() if k.startswith(prefix)]
+            if len(sizes) != nr_blocks or set(sizes) != {bs}:
+                self.fail(f"Stored {len(sizes)} objects of sizes {set(sizes)}, "
+                          f"expected {nr_blocks} of {bs} bytes")
+
+        # Connections are kept alive, one is enough at iodepth=1
+        iodepth = self.fio_opts['iodepth']
+        http = job.get('http', {})
+        if http.get('requests') != sum(expected.values()):
+            self.fail(f"{http.get('requests')} requests reported, "
+                      f"expected {sum(expected.values())}")
+        elif iodepth == 1 and http['connections'] != 1:
+            self.fail(f"{http['connections']} connections opened at iodepth=1")
+        elif not 1 <= http['connections'] < http['requests']:
+            self.fail(f"{http['connections']} connections opened for {http['requests']} "
+                      "requests, none was reused")
+        elif http['reused'] != http['requests'] - http['connections']:
+            self.fail(f"{http['reused']} of {http['requests']} requests reused a connection, "
+                      f"{http['connections']} connections opened")
+
+        peak = ObjectHandler.max_in_flight
+        if iodepth == 1 and peak != 1:
+            self.fail(f"{peak} requests in flight at iodepth=1")
+        if iodepth > 1 and not 1 < peak <= iodepth:
+            self.fail(f"{peak} requests in flight at most, iodepth is {iodepth}")
+
+
+TEST_LIST = [
+    {
+        # One request in flight
+        "test_id": 1,
+        "fio_opts": {
+            "object": "qd1",
+            "rw": "write",
+            "bs": "4k",
+            "bs_bytes": 4096,
+            "size": "1m",
+            "size_bytes": 1048576,
+            "iodepth": 1,
+            "verify": "crc32c",
+            },
+        "test_class": FioHttpTest,
+    },
+    {
+        # Many concurrent requests, verified by reading back
+        "test_id": 2,
+        "fio_opts": {
+            "object": "qd16",
+            "rw": "write",
+            "bs": "16k",
+            "bs_bytes": 16384,
+            "size": "4m",
+            "size_bytes": 4194304,
+            "iodepth": 16,
+            "verify": "crc32c",
+            },
+        "test_class": FioHttpTest,
+    },
+    {
+        # Concurrent reads of objects that don't exist read back zeroes
+        "test_id": 3,
+        "fio_opts": {
+            "object": "missing",
+            "rw": "randread",
+            "bs": "4k",
+            "bs_bytes": 4096,
+            "size": "1m",
+            "size_bytes": 1048576,
+            "iodepth": 8,
+            },
+        "test_class": FioHttpTest,
+    },
+    {
+        # Concurrent DELETE requests
+        "test_id": 4,
+        "fio_opts": {
+            "object": "trim",
+            "rw": "randtrim",
+            "bs": "4k",
+            "bs_bytes": 4096,
+            "size": "1m",
+            "size_bytes": 1048576,
+            "iodepth": 8,
+            },
+        "test_class": FioHttpTest,
+    },
+]
+
+
+def main():
+    """Run http ioengine tests."""
+
+    args = parse_test_args()
+
+    server = ObjectServer(('127.0.0.1', 0), ObjectHandler)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+
+    for test in TEST_LIST:
+        test['fio_opts']['port'] = server.server_address[1]
+
+    failed = run_test_script(TEST_LIST, 'http', __file__, args)
+
+    server.shutdown()
+    sys.exit(failed)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# lat_heatmap.py
+#
+# Test lat_heatmap, lat_heatmap_region and write_lat_heatmap, which keep a
+# completion latency histogram per device region. The heatmap is checked
+# against a per-I/O completion latency log of the same run and the reported
+# completions, and the binary file against the JSON output. On a simdev
+# device with a fixed latency all samples land in the bucket of that latency.
+#
+# USAGE
+# python lat_heatmap.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/lat_heatmap.py
+# python t/lat_heatmap.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import glob
+import struct
+import locale
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+BUCKET_BITS = 2
+BUCKET_VAL = 1 << BUCKET_BITS
+BUCKETS = 25 * BUCKET_VAL
+MAX_REGIONS = 1024
+DDIRS = ['read', 'write', 'trim']
+
+
+def bucket_idx(usec):
+    """Return the heatmap bucket of a latency in usec."""
+
+    if usec < BUCKET_VAL:
+        return usec
+
+    msb = usec.bit_length() - 1
+    idx = (msb - BUCKET_BITS + 1) * BUCKET_VAL + \
+        ((usec >> (msb - BUCKET_BITS)) & (BUCKET_VAL - 1))
+    return min(idx, BUCKETS - 1)
+
+
+class FioLatHeatmapTest(FioJobCmdTest):
+    """Latency heatmap test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        self.prefix = os.path.abspath(os.path.join(self.paths['test_dir'], 'hm'))
+        fio_args = [
+                    "--name=hm",
+                    f"--filename={self.prefix}.data",
+                    "--bs=4k",
+                    "--time_based",
+                    "--runtime=1",
+                    f"--write_lat_heatmap={self.prefix}",
+                    f"--write_lat_log={self.prefix}",
+                    "--log_offset=1",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'ioengine', 'iodepth', 'simdev_lat', 'size',
+                                    'lat_heatmap_region', 'zonemode', 'zonesize', 'zonerange',
+                                    'numjobs', 'group_reporting', 'disable_clat', 'rate_iops'])
+
+        super().setup(fio_args)
+
+    def read_clat_logs(self):
+        """Return (lat_ns, offset) of every I/O in the clat logs."""
+
+        entries = []
+        for log in glob.glob(f"{self.prefix}_clat.*.log"):
+            with open(log, 'r', encoding=locale.getpreferredencoding()) as file:
+                for line in file:
+                    fields = [int(x) for x in line.split(',')]
+                    entries.append((fields[1], fields[4]))
+
+        return entries
+
+    def read_bin(self, filename):
+        """Return the header fields, bucket bounds and counts of a binary file."""
+
+        with open(filename, 'rb') as file:
+            data = file.read()
+
+        magic, version, buckets, regions, _, region = \
+            struct.unpack_from('<8sIIIIQ', data)
+        if magic != b'fiohmap\0' or version != 1 or buckets != BUCKETS:
+            self.fail(f"Unexpected header in {filename}: {magic} {version} {buckets}")
+            return None
+
+        values = struct.unpack_from(f"<{buckets * (regions + 1)}Q", data, 32)
+        if len(data) != 32 + 8 * buckets * (regions + 1):
+            self.fail(f"{filename} is {len(data)} bytes")
+
+        counts = [list(values[(i + 1) * buckets:(i + 2) * buckets])
+                  for i in range(regions)]
+        return region, regions, list(values[:buckets]), counts
+
+    def check_map(self, job, heatmap):
+        """Check the heatmap against the clat logs and the completions."""
+
+        region = heatmap['region_bytes']
+        clat_log = self.read_clat_logs()
+        completions = sum(job[ddir]['clat_ns']['N'] for ddir in DDIRS)
+        samples = sum(m['samples'] for m in heatmap['map'])
+        if not len(clat_log) == samples == completions:
+            self.fail(f"{samples} heatmap samples, {len(clat_log)} logged I/Os, "
+                      f"{completions} completions")
+
+        expected = {}
+        for lat, offset in clat_log:
+            idx = min(offset // region, heatmap['regions'] - 1)
+            expected.setdefault(idx, [0] * BUCKETS)
+            expected[idx][bucket_idx(lat // 1000)] += 1
+
+        found = {m['region']: m['counts'] for m in heatmap['map']}
+        if found != expected:
+            self.fail(f"Heatmap regions {sorted(found.keys())} do not match the "
+                      f"clat log regions {sorted(expected.keys())}")
+
+        for entry in heatmap['map']:
+            if entry['offset'] != entry['region'] * region or \
+               entry['samples'] != sum(entry['counts']):
+                self.fail(f"Inconsistent region {entry['region']}")
+
+    def check_bin(self, heatmap):
+        """Check the binary heatmap files against the JSON output."""
+
+        files = glob.glob(f"{self.prefix}_lat_heatmap.*.bin")
+        if len(files) != self.fio_opts.get('numjobs', 1):
+            self.fail(f"Found heatmap files {files}")
+            return
+
+        total = [[0] * BUCKETS for _ in range(heatmap['regions'])]
+        for filename in files:
+            result = self.read_bin(filename)
+            if not result:
+                return
+            region, regions, bounds, counts = result
+            if region != heatmap['region_bytes'] or regions != heatmap['regions'] or \
+               bounds != heatmap['bucket_us']:
+                self.fail(f"{filename} geometry differs from the JSON output")
+                return
+            for i in range(regions):
+                for j in range(BUCKETS):
+                    total[i][j] += counts[i][j]
+
+        found = {m['region']: m['counts'] for m in heatmap['map']}
+        expected = {i: c for i, c in enumerate(total) if sum(c)}
+        if found != expected:
+            self.fail("Binary heatmap counts differ from the JSON output")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        heatmap = job['lat_heatmap']
+        bounds = [bucket_idx(b) for b in heatmap['bucket_us']]
+        if bounds != list(range(BUCKETS)):
+            self.fail(f"Bucket bounds {heatmap['bucket_us']} do not match the layout")
+
+        if heatmap['region_bytes'] != self.fio_opts['region_bytes'] or \
+           heatmap['regions'] != self.fio_opts['regions']:
+            self.fail(f"Found {heatmap['regions']} regions of "
+                      f"{heatmap['region_bytes']} bytes")
+
+        self.check_map(job, heatmap)
+        self.check_bin(heatmap)
+
+        # Nothing completes before the device latency, and most I/Os
+        # complete within a bucket of it
+        if 'lat_us' in self.fio_opts:
+            low = bucket_idx(self.fio_opts['lat_us'])
+            for entry in heatmap['map']:
+                counts = entry['counts']
+                if sum(counts[:low]) or sum(counts[low:low + 2]) < 0.9 * entry['samples']:
+                    self.fail(f"Region {entry['region']} latencies not in buckets "
+                              f"{low}-{low + 1}: {counts}")
+                    break
+
+
+TEST_LIST = [
+    {
+        # Latencies spread over several buckets
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "ioengine": "psync",
+            "size": "64m",
+            "lat_heatmap_region": "16m",
+            "region_bytes": 16 * 1024 * 1024,
+            "regions": 4,
+            },
+        "test_class": FioLatHeatmapTest,
+    },
+    {
+        # Region size raised to bound the memory used
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randread",
+            "ioengine": "null",
+            "rate_iops": 50000,
+            "size": "100T",
+            "region_bytes": 128 * 1024 * 1024 * 1024,
+            "regions": 800,
+            },
+        "test_class": FioLatHeatmapTest,
+    },
+    {
+        # Regions of two zones
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "ioengine": "null",
+            "rate_iops": 50000,
+            "size": "8g",
+            "zonemode": "strided",
+            "zonesize": "256m",
+            "zonerange": "256m",
+            "lat_heatmap_region": "2z",
+            "region_bytes": 512 * 1024 * 1024,
+            "regions": 16,
+            },
+        "test_class": FioLatHeatmapTest,
+    },
+    {
+        # Jobs merged by group_reporting
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randread",
+            "ioengine": "null",
+            "rate_iops": 50000,
+            "size": "4g",
+            "lat_heatmap_region": "256m",
+            "numjobs": 3,
+            "group_reporting": 1,
+            "region_bytes": 256 * 1024 * 1024,
+            "regions": 16,
+            },
+        "test_class": FioLatHeatmapTest,
+    },
+    {
+        # No completion latency to record
+        "test_id": 5,
+        "fio_opts": {
+            "ioengine": "null",
+            "size": "1g",
+            "disable_clat": 1,
+            "expect_err": "lat_heatmap requires disable_clat=0",
+            },
+        "test_class": FioLatHeatmapTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # Zone sized regions without zones
+        "test_id": 6,
+        "fio_opts": {
+            "ioengine": "null",
+            "size": "1g",
+            "lat_heatmap_region": "1z",
+            "expect_err": "lat_heatmap_region in zones requires a zonemode",
+            },
+        "test_class": FioLatHeatmapTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # A fixed device latency fills one bucket in every region
+        "test_id": 7,
+        "fio_opts": {
+            "rw": "randread",
+            "ioengine": "simdev",
+            "iodepth": 16,
+            "simdev_lat": "2ms",
+            "size": "64g",
+            "lat_heatmap_region": "4g",
+            "region_bytes": 4 * 1024 * 1024 * 1024,
+            "regions": 16,
+            "lat_us": 2000,
+            },
+        "test_class": FioLatHeatmapTest,
+    },
+]
+
+
+def main():
+    """Run latency heatmap tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'lat-heatmap', __file__))
+
+
+if __name__ == '__main__':
+    main()
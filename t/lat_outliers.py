@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# lat_outliers.py
+#
+# Test lat_outliers and lat_outliers_window, which report the slowest I/Os
+# of a job in the JSON output. Jobs run against a simdev device with an
+# exponentially distributed latency, and the reported I/Os are checked
+# against a per-I/O latency log of the same run and the latency summary.
+#
+# USAGE
+# python lat_outliers.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/lat_outliers.py
+# python t/lat_outliers.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import glob
+import locale
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+BS = 4096
+RUNTIME_US = 2000000
+DDIRS = ['read', 'write', 'trim']
+
+
+class FioLatOutliersTest(FioJobCmdTest):
+    """Latency outlier test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        self.prefix = os.path.abspath(os.path.join(self.paths['test_dir'], 'lo'))
+        fio_args = [
+                    "--name=lo",
+                    "--ioengine=simdev",
+                    "--simdev_lat=1ms",
+                    "--simdev_lat_dist=exponential",
+                    "--iodepth=8",
+                    "--size=1T",
+                    f"--bs={BS}",
+                    "--time_based",
+                    f"--runtime={RUNTIME_US}us",
+                    f"--write_lat_log={self.prefix}",
+                    "--log_offset=1",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'lat_outliers', 'lat_outliers_window', 'numjobs',
+                                    'group_reporting', 'disable_lat'])
+
+        super().setup(fio_args)
+
+    def read_lat_logs(self):
+        """Return (msec, lat_ns, ddir, offset) of every I/O in the latency logs."""
+
+        entries = []
+        for log in glob.glob(f"{self.prefix}_lat.*.log"):
+            with open(log, 'r', encoding=locale.getpreferredencoding()) as file:
+                for line in file:
+                    fields = [int(x) for x in line.split(',')]
+                    entries.append((fields[0], fields[1], fields[2], fields[4]))
+
+        return entries
+
+    def check_ios(self, ios, lat_log, window_us):
+        """Check the reported I/Os of one window against the latency log."""
+
+        per_window = self.fio_opts['lat_outliers']
+        lats = [io['lat_ns'] for io in ios]
+        if lats != sorted(lats, reverse=True):
+            self.fail(f"Outliers not sorted by latency: {lats}")
+        if len(ios) > per_window:
+            self.fail(f"{len(ios)} outliers in a window, expected at most {per_window}")
+
+        logged = {(e[1], e[3]) for e in lat_log}
+        for io in ios:
+            if io['bytes'] != BS or io['ddir'] not in ('read', 'write'):
+                self.fail(f"Unexpected outlier {io}")
+            if (io['lat_ns'], io['offset']) not in logged:
+                self.fail(f"Outlier {io} not in the latency log")
+            if not io['start_ns'] <= io['issue_ns'] <= io['complete_ns'] or \
+               io['complete_ns'] - io['start_ns'] != io['lat_ns']:
+                self.fail(f"Outlier {io} timestamps do not add up")
+            if window_us and io['complete_ns'] // (window_us * 1000) != io['window']:
+                self.fail(f"Outlier {io} completed outside its window")
+
+        if not window_us:
+            expected = sorted((e[1] for e in lat_log), reverse=True)[:per_window]
+            if lats != expected:
+                self.fail(f"Outliers {lats}, expected {expected}")
+            return
+
+        # I/Os logged clearly inside the window must be reported, unless
+        # the window is full and they are faster than all reported
+        window = ios[0]['window']
+        low = window * window_us // 1000 + 1
+        high = (window + 1) * window_us // 1000 - 1
+        inside = [e[1] for e in lat_log if low < e[0] < high]
+        full = len(ios) == per_window
+        missed = [lat for lat in inside if lat not in lats and (not full or lat > lats[-1])]
+        if missed:
+            self.fail(f"Window {window} missed outliers {missed}")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        outliers = job['lat_outliers']
+        window_us = outliers['window_us']
+        if outliers['per_window'] != self.fio_opts['lat_outliers']:
+            self.fail(f"per_window is {outliers['per_window']}")
+
+        lat_log = self.read_lat_logs()
+        nr_ios = sum(job[ddir]['lat_ns']['N'] for ddir in DDIRS)
+        if len(lat_log) != nr_ios:
+            self.fail(f"{len(lat_log)} I/Os logged, {nr_ios} completed")
+            return
+
+        # The slowest I/O of the run is an outlier of some window
+        slowest = max(job[ddir]['lat_ns']['max'] for ddir in DDIRS)
+        if max(io['lat_ns'] for io in outliers['ios']) != slowest:
+            self.fail(f"Slowest I/O took {slowest} ns, it is not an outlier")
+
+        windows = sorted({io['window'] for io in outliers['ios']})
+        if window_us:
+            expected = RUNTIME_US // window_us
+            if not expected <= len(windows) <= expected + 1:
+                self.fail(f"Found windows {windows}, expected {expected}")
+        elif windows != [0]:
+            self.fail(f"Found windows {windows} without lat_outliers_window")
+
+        for window in windows:
+            ios = [io for io in outliers['ios'] if io['window'] == window]
+            self.check_ios(ios, lat_log, window_us)
+
+
+TEST_LIST = [
+    {
+        # Slowest I/Os of the whole run
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "lat_outliers": 8,
+            },
+        "test_class": FioLatOutliersTest,
+    },
+    {
+        # Slowest I/Os of each 500ms
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randread",
+            "lat_outliers": 3,
+            "lat_outliers_window": "500ms",
+            },
+        "test_class": FioLatOutliersTest,
+    },
+    {
+        # Outliers of several jobs merged by group_reporting
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "lat_outliers": 5,
+            "numjobs": 3,
+            "group_reporting": 1,
+            },
+        "test_class": FioLatOutliersTest,
+    },
+    {
+        # No latency to rank I/Os by
+        "test_id": 4,
+        "fio_opts": {
+            "lat_outliers": 4,
+            "disable_lat": 1,
+            "expect_err": "lat_outliers requires disable_lat=0",
+            },
+        "test_class": FioLatOutliersTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run latency outlier tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'lat-outliers', __file__))
+
+
+if __name__ == '__main__':
+    main()
@@ -2,7 +2,8 @@
 #
 # log_compression.py
 #
-# Test log_compression and log_store_compressed. Uses null ioengine.
+# Test log_compression and log_store_compressed, with each
+# log_compression_type that fio was built with. Uses null ioengine.
 # Previous bugs have caused output in per I/O log files to be missing
 # and/or out of order
 #
@@ -24,6 +25,7 @@
 #
 # With log_compression=10K
 # With log_store_compressed=1 and log_compression=10K
+# Both of the above for zlib, and for zstd and lz4 if available
 
 import os
 import sys
@@ -40,7 +42,14 @@ def parse_args():
     return parser.parse_args()
 
 
-def run_fio(fio,log_store_compressed):
+def compression_types(fio):
+    """Return the log_compression_type values fio accepts."""
+    output = subprocess.check_output([fio, '--cmdhelp=log_compression_type'],
+                                     universal_newlines=True)
+    return [t for t in ['zlib', 'zstd', 'lz4'] if ' {} '.format(t) in output]
+
+
+def run_fio(fio,log_store_compressed,compression_type):
     fio_args = [
         '--name=job',
         '--ioengine=null',
@@ -52,10 +61,16 @@ def run_fio(fio,log_store_compressed):
         '--per_job_logs=0',
         '--log_offset=1',
         '--log_compression=10K',
+        '--log_compression_type={}'.format(compression_type),
         ]
     if log_store_compressed:
         fio_args.append('--log_store_compressed=1')
 
+    # per_job_logs=0 appends to the log of the previous run
+    for name in ['test_bw.log', 'test_bw.log.fz']:
+        if os.path.exists(name):
+            os.remove(name)
+
     subprocess.check_output([fio] + fio_args)
 
     if log_store_compressed:
@@ -102,15 +117,17 @@ def main():
 
     passed_count = 0
     failed_count = 0
-    for log_store_compressed in [False, True]:
-        run_fio(fio_path, log_store_compressed)
-        passed = check_log_file(log_store_compressed)
-        print('Test with log_store_compressed={} {}'.format(log_store_compressed,
-            'PASSED' if passed else 'FAILED'))
-        if passed:
-            passed_count+=1
-        else:
-            failed_count+=1
+    for compression_type in compression_types(fio_path):
+        for log_store_compressed in [False, True]:
+            run_fio(fio_path, log_store_compressed, compression_type)
+            passed = check_log_file(log_store_compressed)
+            print('Test with log_compression_type={} log_store_compressed={} {}'.format(
+                compression_type, log_store_compressed,
+                'PASSED' if passed else 'FAILED'))
+            if passed:
+                passed_count+=1
+            else:
+                failed_count+=1
 
     print('{} tests passed, {} failed'.format(passed_count, failed_count))
 
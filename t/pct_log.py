@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# pct_log.py
+#
+# Test write_pct_log, which logs the latency percentiles of each
+# log_pct_msec interval. Jobs run against simdev devices with a fixed
+# latency per data direction, so the logged percentiles are known, and the
+# samples of all intervals must add up to the completions fio reports.
+#
+# USAGE
+# python pct_log.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/pct_log.py
+# python t/pct_log.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import json
+import locale
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+MSEC = 500
+DEFAULT_LIST = [50.0, 90.0, 99.0, 99.9, 99.99]
+DDIRS = ['read', 'write', 'trim']
+
+
+class FioPctLogTest(FioJobCmdTest):
+    """Latency percentile log test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        self.prefix = os.path.abspath(os.path.join(self.paths['test_dir'], 'pct'))
+        fio_args = [
+                    "--name=pct",
+                    "--ioengine=simdev",
+                    "--iodepth=16",
+                    "--size=1T",
+                    "--time_based",
+                    f"--runtime={self.fio_opts['runtime']}",
+                    "--rate_iops=2000",
+                    f"--write_pct_log={self.prefix}",
+                    f"--log_pct_msec={MSEC}",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'simdev_lat', 'ramp_time', 'log_pct_list',
+                                    'log_pct_json', 'lat_percentiles', 'clat_percentiles'])
+
+        super().setup(fio_args)
+
+    def parse_log(self):
+        """Return the log as a list of (time, ddir, samples, {pct: value})."""
+
+        lat = 'lat' if self.fio_opts.get('lat_percentiles') else 'clat'
+        plist = self.fio_opts.get('plist', DEFAULT_LIST)
+        entries = []
+
+        with open(f"{self.prefix}_{lat}_pct.1.log", 'r',
+                  encoding=locale.getpreferredencoding()) as file:
+            for line in file:
+                if self.fio_opts.get('log_pct_json'):
+                    entry = json.loads(line)
+                    ddir = DDIRS.index(entry['ddir'])
+                    pcts = {float(k): v for k, v in entry['percentiles'].items()}
+                    entries.append((entry['time'], ddir, entry['samples'], pcts))
+                else:
+                    fields = [int(x) for x in line.split(',')]
+                    if len(fields) != 3 + len(plist):
+                        self.fail(f"Unexpected number of fields: {line.strip()}")
+                        return []
+                    entries.append((fields[0], fields[1], fields[2],
+                                    dict(zip(plist, fields[3:]))))
+
+        return entries
+
+    def check_interval(self, ddir, msec, samples, pcts):
+        """Check the percentiles of one interval against the modeled latency."""
+
+        plist = self.fio_opts.get('plist', DEFAULT_LIST)
+        if samples <= 0 or samples > 3 * MSEC:
+            self.fail(f"ddir {ddir}: {samples} samples in one interval")
+        if sorted(pcts.keys()) != sorted(plist):
+            self.fail(f"ddir {ddir}: percentiles {list(pcts.keys())}")
+            return
+
+        values = [pcts[p] for p in sorted(pcts.keys())]
+        if values != sorted(values):
+            self.fail(f"ddir {ddir}: percentile values decrease {values}")
+
+        # Nothing completes before the device latency, and the median
+        # is late by no more than the reap granularity. Values are
+        # histogram buckets, which are within 1/64 of the latency.
+        lat_ns = self.fio_opts['lat_us'][ddir] * 1000
+        if values[0] < lat_ns * 0.98:
+            self.fail(f"ddir {ddir} at {msec}: percentile {values[0]} below the "
+                      f"latency {lat_ns}")
+        median = pcts[50.0] if 50.0 in pcts else values[0]
+        if median > lat_ns * 1.1 + 50000:
+            self.fail(f"ddir {ddir} at {msec}: median {median}, latency {lat_ns}")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        entries = self.parse_log()
+        if not self.passed:
+            return
+
+        lat = 'lat_ns' if self.fio_opts.get('lat_percentiles') else 'clat_ns'
+        intervals = self.fio_opts['runtime'] * 1000 // MSEC
+        for ddir in self.fio_opts['lat_us']:
+            lines = [e for e in entries if e[1] == ddir]
+            if not intervals - 1 <= len(lines) <= intervals + 1:
+                self.fail(f"ddir {ddir}: {len(lines)} lines, expected about {intervals}")
+                continue
+
+            # Every completion after ramp_time is in exactly one interval
+            samples = sum(e[2] for e in lines)
+            completions = job[DDIRS[ddir]][lat]['N']
+            if samples != completions:
+                self.fail(f"ddir {ddir}: {samples} samples logged, {completions} completions")
+
+            prev = 0
+            for msec, _, samples, pcts in lines:
+                if msec <= prev:
+                    self.fail(f"ddir {ddir}: time {msec} after {prev}")
+                self.check_interval(ddir, msec, samples, pcts)
+                prev = msec
+
+            # Every interval but the last partial one lands on the grid
+            for msec, _, _, _ in lines[:-1]:
+                if msec % MSEC:
+                    self.fail(f"ddir {ddir}: time {msec} not a multiple of {MSEC}")
+
+        if {e[1] for e in entries} != set(self.fio_opts['lat_us']):
+            self.fail(f"Unexpected ddirs {set(e[1] for e in entries)}")
+
+
+TEST_LIST = [
+    {
+        # CSV log with the default percentile list
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "runtime": 3,
+            "simdev_lat": "100us,5ms",
+            "lat_us": {0: 100, 1: 5000},
+            },
+        "test_class": FioPctLogTest,
+    },
+    {
+        # JSON log of total latency with a custom percentile list
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "read",
+            "runtime": 3,
+            "simdev_lat": "2ms",
+            "lat_us": {0: 2000},
+            "log_pct_json": 1,
+            "lat_percentiles": 1,
+            "log_pct_list": "99:50:99.9",
+            "plist": [50.0, 99.0, 99.9],
+            },
+        "test_class": FioPctLogTest,
+    },
+    {
+        # Intervals start after ramp_time
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "write",
+            "runtime": 2,
+            "ramp_time": 1,
+            "simdev_lat": "500us",
+            "lat_us": {1: 500},
+            },
+        "test_class": FioPctLogTest,
+    },
+    {
+        # No histogram to log from
+        "test_id": 4,
+        "fio_opts": {
+            "runtime": 1,
+            "clat_percentiles": 0,
+            "expect_err": "requires clat_percentiles or lat_percentiles",
+            },
+        "test_class": FioPctLogTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run latency percentile log tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'pct-log', __file__))
+
+
+if __name__ == '__main__':
+    main()
@@ -554,6 +554,36 @@ class FioJobFileTest_t0029(FioJobFileTest):
         if self.json_data['jobs'][1]['read']['io_kbytes'] != 8:
             self.passed = False
 
+class FioJobFileTest_t0038(FioJobFileTest):
+    """Test experimental verify checks every loop."""
+    def check_result(self):
+        super().check_result()
+
+        if not self.passed:
+            return
+
+        job = self.json_data['jobs'][0]
+        if job['write']['io_kbytes'] != 2048 or job['read']['io_kbytes'] != 2048:
+            self.failure_reason = f"{self.failure_reason} wrote {job['write']['io_kbytes']} KiB, verified {job['read']['io_kbytes']} KiB,"
+            self.passed = False
+
+class FioJobFileTest_t0036(FioJobFileTest):
+    """Test verify of fixed block size jobs without a random map."""
+    def check_result(self):
+        super().check_result()
+
+        if not self.passed:
+            return
+
+        overwrite, lfsr, sequential = self.json_data['jobs']
+        if not 0 < overwrite['read']['io_kbytes'] <= 1024:
+            self.failure_reason = f"{self.failure_reason} overwritten blocks verified more than once,"
+            self.passed = False
+        for job in [lfsr, sequential]:
+            if job['read']['io_kbytes'] != job['write']['io_kbytes']:
+                self.failure_reason = f"{self.failure_reason} {job['jobname']} not all writes verified,"
+                self.passed = False
+
 class FioJobFileTest_LogFileFormat(FioJobFileTest):
     """Test log file format"""
     def setup(self, *args, **kws):
@@ -954,6 +984,35 @@ TEST_LIST = [
         'pre_success':      SUCCESS_DEFAULT,
         'requirements':     [],
     },
+    {
+        'test_id':          36,
+        'test_class':       FioJobFileTest_t0036,
+        'job':              't0036.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
+    {
+        'test_id':          37,
+        'test_class':       FioJobFileTest,
+        'job':              't0037.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'requirements':     [],
+    },
+    {
+        'test_id':          38,
+        'test_class':       FioJobFileTest_t0038,
+        'job':              't0038.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
     {
         'test_id':          1000,
         'test_class':       FioExeTest,
@@ -1084,6 +1143,118 @@ TEST_LIST = [
         'success':          SUCCESS_DEFAULT,
         'requirements':     [Requirements.linux, Requirements.nvmecdev],
     },
+    {
+        'test_id':          1016,
+        'test_class':       FioExeTest,
+        'exe':              't/http_engine.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [Requirements.http],
+    },
+    {
+        'test_id':          1017,
+        'test_class':       FioExeTest,
+        'exe':              't/simdev.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1018,
+        'test_class':       FioExeTest,
+        'exe':              't/zbd_emulation.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1018,
+        'test_class':       FioExeTest,
+        'exe':              't/dp_emulation.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1019,
+        'test_class':       FioExeTest,
+        'exe':              't/verify_journal.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1020,
+        'test_class':       FioExeTest,
+        'exe':              't/verify_streaming.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1021,
+        'test_class':       FioExeTest,
+        'exe':              'fio',
+        'parameters':       ['--crctest=crc64,crc64-nvme,crc16,crc7,crc-t10dif,sha1,sha256,xxh3,xxh128'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1022,
+        'test_class':       FioExeTest,
+        'exe':              't/content_pool.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1023,
+        'test_class':       FioExeTest,
+        'exe':              't/dedupe_cache.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1024,
+        'test_class':       FioExeTest,
+        'exe':              't/pct_log.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1025,
+        'test_class':       FioExeTest,
+        'exe':              't/lat_outliers.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1026,
+        'test_class':       FioExeTest,
+        'exe':              't/lat_heatmap.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1027,
+        'test_class':       FioExeTest,
+        'exe':              't/file_stats.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
+    {
+        'test_id':          1028,
+        'test_class':       FioExeTest,
+        'exe':              't/clat_depth.py',
+        'parameters':       ['-f', '{fio_path}'],
+        'success':          SUCCESS_DEFAULT,
+        'requirements':     [],
+    },
 ]
 
 
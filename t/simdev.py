@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# simdev.py
+#
+# Test the simdev ioengine. Jobs run at iodepth > 1 against simulated
+# devices with known latencies, throughput caps and stalls, and the
+# reported latencies and IOPS are checked against the model. A per-I/O
+# completion latency log shows the order in which I/Os completed.
+#
+# USAGE
+# python simdev.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/simdev.py
+# python t/simdev.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import locale
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+RUNTIME = 2
+DDIRS = ['read', 'write', 'trim']
+
+
+class FioSimdevTest(FioJobCmdTest):
+    """simdev ioengine test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        self.prefix = os.path.abspath(os.path.join(self.paths['test_dir'], 'simdev'))
+        fio_args = [
+                    "--name=simdev",
+                    "--ioengine=simdev",
+                    "--size=1T",
+                    "--bs=4k",
+                    "--time_based",
+                    f"--runtime={RUNTIME}",
+                    f"--write_lat_log={self.prefix}",
+                    "--log_offset=1",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                   ]
+        fio_args += self.opts_args(['rw', 'iodepth', 'simdev_lat', 'simdev_lat_dev',
+                                    'simdev_lat_dist', 'simdev_iops',
+                                    'simdev_gc_interval', 'simdev_gc_duration'])
+
+        super().setup(fio_args)
+
+    def read_clat_log(self):
+        """Return (msec, clat_ns, ddir) of every I/O, in completion order."""
+
+        entries = []
+        with open(f"{self.prefix}_clat.1.log", 'r',
+                  encoding=locale.getpreferredencoding()) as file:
+            for line in file:
+                fields = [int(x) for x in line.split(',')]
+                entries.append((fields[0], fields[1], fields[2]))
+
+        return entries
+
+    def check_latency(self, job):
+        """Check the completion latency of each data direction against the model."""
+
+        for ddir, lat_us in self.fio_opts['expect_lat_us'].items():
+            clat = job[ddir]['clat_ns']
+            lat_ns = lat_us * 1000
+            if not clat['N']:
+                self.fail(f"No {ddir} completions")
+                continue
+
+            # Nothing completes early. The mean may be late by the
+            # sleep granularity of getevents, and by however long a loaded
+            # host takes to reap, so lat_late_tolerance can allow more.
+            if self.fio_opts.get('simdev_lat_dist', 'fixed') == 'fixed' and \
+               clat['min'] < lat_ns:
+                self.fail(f"{ddir} clat min {clat['min']} below the modeled {lat_ns}")
+            early = self.fio_opts.get('lat_tolerance', 0.1)
+            late = self.fio_opts.get('lat_late_tolerance', early)
+            if not lat_ns * (1 - early) <= clat['mean'] <= lat_ns * (1 + late) + 50000:
+                self.fail(f"{ddir} clat mean {clat['mean']}, modeled {lat_ns}")
+
+    def check_iops(self, job):
+        """Check the total IOPS against the depth over latency, or the IOPS cap."""
+
+        iops = sum(job[ddir]['iops'] for ddir in DDIRS)
+        expected = self.fio_opts['expect_iops']
+        if not 0.85 * expected <= iops <= 1.05 * expected:
+            self.fail(f"{iops} IOPS, expected about {expected}")
+
+    def check_order(self, entries):
+        """
+        Completions are logged in the order they happen. With fast reads and
+        slow writes in flight together, reads submitted well after a write
+        have to complete before it.
+        """
+
+        times = [e[0] for e in entries]
+        if times != sorted(times):
+            self.fail("Completion times in the latency log go backwards")
+            return
+
+        # Walk back from the last completion, tracking the earliest
+        # submitted write that completes later than the current I/O
+        overtaken = 0
+        later_write = None
+        for msec, clat_ns, ddir in reversed(entries):
+            submit = msec - clat_ns / 1000000
+            if ddir == 1:
+                if later_write is None or submit < later_write:
+                    later_write = submit
+            elif later_write is not None and submit > later_write + 1:
+                overtaken += 1
+
+        if not overtaken:
+            self.fail("No read overtook a slower write, completions are not ordered by expiry")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        if 'expect_lat_us' in self.fio_opts:
+            self.check_latency(job)
+        if 'expect_iops' in self.fio_opts:
+            self.check_iops(job)
+
+        entries = self.read_clat_log()
+        total = sum(job[ddir]['clat_ns']['N'] for ddir in DDIRS)
+        if len(entries) != total:
+            self.fail(f"{len(entries)} entries in the latency log, {total} completions")
+            return
+
+        if self.fio_opts.get('check_order'):
+            self.check_order(entries)
+
+        if 'simdev_gc_duration' in self.fio_opts:
+            # I/Os queued at the start of a stall wait it out, and
+            # none waits for longer
+            stall_ns = int(self.fio_opts['simdev_gc_duration'].rstrip('ms')) * 1000000
+            slowest = max(e[1] for e in entries)
+            if not 0.8 * stall_ns <= slowest <= 1.2 * stall_ns:
+                self.fail(f"Slowest I/O took {slowest} ns, stalls last {stall_ns} ns")
+
+TEST_LIST = [
+    {
+        # Fast reads and slow writes in flight together
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randrw",
+            "iodepth": 16,
+            "simdev_lat": "100us,5ms",
+            "expect_lat_us": {'read': 100, 'write': 5000},
+            "check_order": True,
+            },
+        "test_class": FioSimdevTest,
+    },
+    {
+        # Latencies beyond one rotation of the timer wheel
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randread",
+            "iodepth": 8,
+            "simdev_lat": "30ms",
+            "expect_lat_us": {'read': 30000},
+            "expect_iops": 8 / 0.030,
+            },
+        "test_class": FioSimdevTest,
+    },
+    {
+        # Exponentially distributed latency keeps its mean. Many short
+        # service times make it sensitive to reaping delays on a busy host.
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "iodepth": 32,
+            "simdev_lat_dist": "exponential",
+            "simdev_lat": "1ms",
+            "expect_lat_us": {'write': 1000},
+            "lat_tolerance": 0.15,
+            "lat_late_tolerance": 0.5,
+            },
+        "test_class": FioSimdevTest,
+    },
+    {
+        # The IOPS cap wins over a short latency
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randread",
+            "iodepth": 16,
+            "simdev_lat": "10us",
+            "simdev_iops": 2000,
+            "expect_iops": 2000,
+            },
+        "test_class": FioSimdevTest,
+    },
+    {
+        # Periodic stalls hold back completions
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "randwrite",
+            "iodepth": 4,
+            "simdev_lat": "200us",
+            "simdev_gc_interval": "250ms",
+            "simdev_gc_duration": "50ms",
+            },
+        "test_class": FioSimdevTest,
+    },
+    {
+        # A stall must be shorter than its interval
+        "test_id": 6,
+        "fio_opts": {
+            "rw": "randread",
+            "simdev_gc_interval": "10ms",
+            "simdev_gc_duration": "10ms",
+            "expect_err": "simdev_gc_duration must be smaller than simdev_gc_interval",
+            },
+        "test_class": FioSimdevTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run simdev ioengine tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'simdev', __file__))
+
+
+if __name__ == '__main__':
+    main()
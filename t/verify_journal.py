@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# verify_journal.py
+#
+# Test crash consistency checking with verify_journal. Each test writes a
+# file while journaling its writes and flushes, damages the file the way a
+# crash could, then checks it against the journal with verify_only=1. The
+# write phase logs its I/O, so that the blocks the check accounts for can be
+# compared with the blocks that were written, and the blocks found torn or
+# lost with the ranges that were damaged.
+#
+# USAGE
+# python verify_journal.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/verify_journal.py
+# python t/verify_journal.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import errno
+import locale
+import subprocess
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO, SUCCESS_STDERR
+
+
+BS = 4096
+JOURNAL_RECORD_SIZE = 24
+
+
+class FioVerifyJournalTest(FioJobCmdTest):
+    """verify_journal test."""
+
+    def setup(self, parameters):
+        """Write the file, damage it, and set up the check."""
+
+        super().setup([])
+
+        filename = os.path.abspath(os.path.join(self.paths['test_dir'], 'vj.dat'))
+        journal = os.path.abspath(os.path.join(self.paths['test_dir'], 'vj.journal'))
+        self.iolog = os.path.abspath(os.path.join(self.paths['test_dir'], 'vj.iolog'))
+        fio_args = [
+                    "--name=vj",
+                    f"--filename={filename}",
+                    f"--verify_journal={journal}",
+                    "--size=4m",
+                    "--ioengine=posixaio",
+                    "--iodepth=8",
+                    "--verify=crc32c",
+                    "--continue_on_error=verify",
+                   ]
+        fio_args += self.opts_args(['rw', 'bs', 'bsrange', 'io_size', 'norandommap',
+                                    'verify_interval', 'fsync'])
+
+        if 'expect_err' not in self.fio_opts:
+            result = subprocess.run([self.paths['exe']] + fio_args +
+                                    ["--do_verify=0", f"--write_iolog={self.iolog}"],
+                                    stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                    check=False)
+            if result.returncode:
+                print(f"Write phase failed: {result.stderr.decode()}")
+
+            self.damage(filename, journal + ".0")
+            fio_args.append("--output-format=json")
+
+        fio_args += [
+                     "--verify_only=1",
+                     f"--output={self.filenames['output']}",
+                    ]
+        super().setup(fio_args)
+
+    def damage(self, filename, journal):
+        """Zero ranges of the file and drop records from the end of the journal."""
+
+        with open(filename, 'r+b') as file:
+            for offset, length in self.fio_opts.get('zero', []):
+                file.seek(offset)
+                file.write(bytes(length))
+
+        if 'journal_drop' in self.fio_opts:
+            size = os.path.getsize(journal)
+            os.truncate(journal, size - self.fio_opts['journal_drop'] * JOURNAL_RECORD_SIZE)
+
+    def written_blocks(self):
+        """Return the blocks the write phase wrote, from its I/O log."""
+
+        blocks = set()
+        with open(self.iolog, 'r', encoding=locale.getpreferredencoding()) as file:
+            for line in file:
+                fields = line.split()
+                if len(fields) == 5 and fields[2] == 'write':
+                    offset, length = int(fields[3]), int(fields[4])
+                    blocks.update(range(offset // BS, (offset + length) // BS))
+
+        return blocks
+
+    def damaged_blocks(self):
+        """Return the blocks zeroed entirely and those zeroed in part."""
+
+        lost, torn = set(), set()
+        for offset, length in self.fio_opts.get('zero', []):
+            for block in range(offset // BS, (offset + length + BS - 1) // BS):
+                if offset <= block * BS and (block + 1) * BS <= offset + length:
+                    lost.add(block)
+                else:
+                    torn.add(block)
+
+        return lost, torn
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        # Violations fail the job with EILSEQ
+        violations = self.fio_opts.get('violations', 0)
+        jobs = self.get_jobs(error=errno.EILSEQ if violations else 0)
+        if not jobs:
+            return
+        job = jobs[0]
+
+        if 'verify_journal' not in job:
+            self.fail("No verify_journal results")
+            return
+        result = job['verify_journal']
+
+        # Blocks whose last write the journal missed are not checked, all
+        # others are found in one of the states
+        checked = result['durable'] + result['torn'] + result['lost']
+        written = len(self.written_blocks())
+        dropped = self.fio_opts.get('journal_drop', 0)
+        if not written - dropped <= checked <= written:
+            self.fail(f"{checked} blocks checked, {written} written, "
+                      f"{dropped} journal records dropped")
+
+        lost, torn = self.damaged_blocks()
+        if 'journal_drop' not in self.fio_opts:
+            for key, blocks in [('lost', lost), ('torn', torn)]:
+                if result[key] != len(blocks):
+                    self.fail(f"{result[key]} blocks {key}, damaged {len(blocks)}")
+            if result['durable'] != written - len(lost) - len(torn):
+                self.fail(f"{result['durable']} blocks durable, "
+                          f"{written - len(lost) - len(torn)} undamaged")
+
+        # Only blocks a flush covered have to survive
+        if result['violations'] != violations:
+            self.fail(f"{result['violations']} violations, expected {violations}")
+        if violations and not job['total_err']:
+            self.fail("Violations were not reported as errors")
+
+
+TEST_LIST = [
+    {
+        # Nothing lost
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": BS,
+            "fsync": 16,
+            },
+        "test_class": FioVerifyJournalTest,
+    },
+    {
+        # Blocks lost and torn after a flush covered them
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "write",
+            "bs": BS,
+            "verify_interval": 512,
+            "fsync": 16,
+            "zero": [(8192, 4096), (16384, 512)],
+            "violations": 2,
+            },
+        "test_class": FioVerifyJournalTest,
+        "success": SUCCESS_STDERR,
+    },
+    {
+        # Blocks lost without a flush are not a violation
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "write",
+            "bs": BS,
+            "zero": [(8192, 8192)],
+            },
+        "test_class": FioVerifyJournalTest,
+    },
+    {
+        # Overwrites the journal did not get to record are taken as durable
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": BS,
+            "io_size": "16m",
+            "norandommap": 1,
+            "fsync": 8,
+            "journal_drop": 2000,
+            },
+        "test_class": FioVerifyJournalTest,
+    },
+    {
+        # The journal names blocks of a fixed size
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bsrange": "4k-16k",
+            "expect_err": "verify_journal needs a fixed write block size",
+            },
+        "test_class": FioVerifyJournalTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run verify journal tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'verify-journal', __file__))
+
+
+if __name__ == '__main__':
+    main()
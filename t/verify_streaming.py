@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# verify_streaming.py
+#
+# Test verify_streaming=1, which regenerates the blocks a job wrote for the
+# verify phase instead of keeping a history of the writes. Jobs log their
+# I/O, so that the blocks read back can be compared with the blocks that
+# were written, in every loop. A file damaged after it was written must be
+# reported at the damaged offset.
+#
+# USAGE
+# python verify_streaming.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/verify_streaming.py
+# python t/verify_streaming.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import errno
+import locale
+import subprocess
+from collections import Counter
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO, get_file
+
+
+SIZE = 8 * 1024 * 1024
+
+
+class FioVerifyStreamingTest(FioJobCmdTest):
+    """verify_streaming test."""
+
+    def setup(self, parameters):
+        """Setup the test, writing and damaging the file first for verify_only."""
+
+        super().setup([])
+
+        filename = os.path.abspath(os.path.join(self.paths['test_dir'], 'vs.dat'))
+        self.iolog = os.path.abspath(os.path.join(self.paths['test_dir'], 'vs.iolog'))
+        fio_args = [
+                    "--name=vs",
+                    f"--filename={filename}",
+                    f"--size={SIZE}",
+                    "--ioengine=posixaio",
+                    "--iodepth=8",
+                    "--verify=crc32c",
+                    "--verify_streaming=1",
+                   ]
+        fio_args += self.opts_args(['rw', 'bs', 'bsrange', 'io_size', 'random_generator',
+                                    'loops'])
+
+        if 'zero' in self.fio_opts:
+            result = subprocess.run([self.paths['exe']] + fio_args + ["--do_verify=0"],
+                                    stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                    check=False)
+            if result.returncode:
+                print(f"Write phase failed: {result.stderr.decode()}")
+
+            with open(filename, 'r+b') as file:
+                offset, length = self.fio_opts['zero']
+                file.seek(offset)
+                file.write(bytes(length))
+            fio_args.append("--verify_only=1")
+        elif 'expect_err' not in self.fio_opts:
+            fio_args.append(f"--write_iolog={self.iolog}")
+
+        fio_args += [
+                     "--output-format=json",
+                     f"--output={self.filenames['output']}",
+                    ]
+        super().setup(fio_args)
+
+    def read_iolog(self):
+        """Return a count of the (offset, length) written and read."""
+
+        ios = {'write': Counter(), 'read': Counter()}
+        with open(self.iolog, 'r', encoding=locale.getpreferredencoding()) as file:
+            for line in file:
+                fields = line.split()
+                if len(fields) == 5 and fields[2] in ios:
+                    ios[fields[2]][(int(fields[3]), int(fields[4]))] += 1
+
+        return ios['write'], ios['read']
+
+    def check_damage(self):
+        """The verify phase fails at the block that was damaged."""
+
+        jobs = self.get_jobs(error=errno.EILSEQ)
+        if not jobs:
+            return
+
+        offset, length = self.fio_opts['zero']
+        message = f"offset {offset}, length {length}"
+        contents, _ = get_file(self.filenames['stderr'])
+        if not contents or "bad magic header" not in contents or message not in contents:
+            self.fail(f"No verify failure reported at {message}")
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        if 'zero' in self.fio_opts:
+            self.check_damage()
+            return
+
+        jobs = self.get_jobs()
+        if not jobs:
+            return
+        job = jobs[0]
+
+        loops = self.fio_opts.get('loops', 1)
+        if job['write']['io_bytes'] != SIZE * loops:
+            self.fail(f"Wrote {job['write']['io_bytes']} bytes in {loops} loop(s) "
+                      f"of {SIZE} bytes")
+        if 'bs' in self.fio_opts:
+            nr_blocks = SIZE // self.fio_opts['bs'] * loops
+            if job['write']['total_ios'] != nr_blocks:
+                self.fail(f"{job['write']['total_ios']} writes, expected {nr_blocks}")
+
+        # The verify phase reads back every block it wrote, once per loop
+        for key in ['io_bytes', 'total_ios']:
+            if job['read'][key] != job['write'][key]:
+                self.fail(f"Verify read {key} {job['read'][key]}, wrote {job['write'][key]}")
+
+        writes, reads = self.read_iolog()
+        if sum(writes.values()) != job['write']['total_ios']:
+            self.fail(f"{sum(writes.values())} writes logged, "
+                      f"{job['write']['total_ios']} completed")
+        if reads != writes:
+            self.fail(f"Verify read {len(reads)} distinct blocks, {len(writes - reads)} "
+                      "written blocks were not read back as written")
+        if 'bs' in self.fio_opts and set(writes.values()) != {loops}:
+            self.fail(f"Blocks written {set(writes.values())} times, expected {loops}")
+
+
+TEST_LIST = [
+    {
+        # Sequential writes
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "write",
+            "bs": 4096,
+            },
+        "test_class": FioVerifyStreamingTest,
+    },
+    {
+        # Sequential writes of mixed sizes, verified after each loop
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "write",
+            "bsrange": "4k-64k",
+            "loops": 2,
+            },
+        "test_class": FioVerifyStreamingTest,
+    },
+    {
+        # LFSR random writes, the same sequence in each loop
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": 4096,
+            "random_generator": "lfsr",
+            "loops": 3,
+            },
+        "test_class": FioVerifyStreamingTest,
+    },
+    {
+        # Verifying an earlier run finds the damaged block
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": 4096,
+            "random_generator": "lfsr",
+            "zero": (65536, 4096),
+            },
+        "test_class": FioVerifyStreamingTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # Random offsets that may repeat cannot be replayed
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": 4096,
+            "expect_err": "verify_streaming needs sequential writes or uniform LFSR offsets",
+            },
+        "test_class": FioVerifyStreamingTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # Nor can overwrites
+        "test_id": 6,
+        "fio_opts": {
+            "rw": "write",
+            "bs": 4096,
+            "io_size": "16m",
+            "expect_err": "verify_streaming cannot verify blocks that are overwritten",
+            },
+        "test_class": FioVerifyStreamingTest,
+        "success": SUCCESS_NONZERO,
+    },
+]
+
+
+def main():
+    """Run verify_streaming tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'verify-streaming', __file__))
+
+
+if __name__ == '__main__':
+    main()
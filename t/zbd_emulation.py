@@ -0,0 +1,316 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+"""
+# zbd_emulation.py
+#
+# Test host-managed zoned block device emulation on regular files
+# (zonemode=zbd with zone_emulation=1), and zone append writes to it. The
+# offsets of all writes are logged and checked against the zone layout,
+# the amount of data written and verified is checked against the job, and
+# the zone reset and finish commands reported against the workload.
+#
+# USAGE
+# python zbd_emulation.py [-f fio-executable]
+#
+# EXAMPLES
+# python t/zbd_emulation.py
+# python t/zbd_emulation.py -f ./fio
+#
+# REQUIREMENTS
+# Python 3.7+
+#
+"""
+
+import os
+import sys
+import glob
+import locale
+from fiotestlib import FioJobCmdTest, run_test_script
+from fiotestcommon import SUCCESS_NONZERO
+
+
+SIZE = 32 * 1024 * 1024
+ZONE_SIZE = 1024 * 1024
+
+
+class FioZbdEmuTest(FioJobCmdTest):
+    """zone_emulation test."""
+
+    def setup(self, parameters):
+        """Setup the test."""
+
+        filename = os.path.abspath(os.path.join(self.paths['test_dir'], 'zbd-emu.dat'))
+        self.prefix = os.path.abspath(os.path.join(self.paths['test_dir'], 'zbd-emu'))
+        fio_args = [
+                    f"--filename={filename}",
+                    "--zonemode=zbd",
+                    "--zone_emulation=1",
+                    f"--zonesize={self.fio_opts.get('zonesize', ZONE_SIZE)}",
+                    f"--size={SIZE}",
+                    f"--write_lat_log={self.prefix}",
+                    "--log_offset=1",
+                    "--output-format=json",
+                    f"--output={self.filenames['output']}",
+                    "--name=zbd-emu",
+                   ]
+        fio_args += self.opts_args(['rw', 'bs', 'ioengine', 'iodepth', 'numjobs', 'verify',
+                                    'zonecapacity', 'max_open_zones', 'ignore_zone_limits',
+                                    'zone_emulation_max_open', 'zone_emulation_max_active',
+                                    'zone_reset_frequency', 'zone_append', 'io_size'])
+        if 'second_job' in self.fio_opts:
+            fio_args.append("--name=zbd-emu-2")
+            fio_args += [f"--{k}={v}" for k, v in self.fio_opts['second_job'].items()]
+
+        super().setup(fio_args)
+
+        # zonemode=zbd needs the file to exist to know the number of zones
+        with open(filename, 'wb') as file:
+            file.truncate(SIZE)
+
+    def read_writes(self):
+        """Return (offset, length) of every write the jobs logged."""
+
+        writes = []
+        for log in glob.glob(f"{self.prefix}_clat.*.log"):
+            with open(log, 'r', encoding=locale.getpreferredencoding()) as file:
+                for line in file:
+                    fields = [int(x) for x in line.split(',')]
+                    if fields[2] == 1:
+                        writes.append((fields[4], fields[3]))
+
+        return writes
+
+    def check_writes(self, jobs):
+        """Every write falls within the writable part of a single zone."""
+
+        zone_size = self.fio_opts.get('zonesize', ZONE_SIZE)
+        capacity = self.fio_opts.get('zonecapacity', zone_size)
+        writes = self.read_writes()
+
+        nr_writes = sum(job['write']['total_ios'] for job in jobs)
+        if len(writes) != nr_writes:
+            self.fail(f"{len(writes)} writes logged, {nr_writes} completed")
+
+        for offset, length in writes:
+            if offset + length > SIZE or offset % zone_size + length > capacity:
+                self.fail(f"Write of {length} bytes at {offset} crosses the zone capacity "
+                          f"{capacity}")
+                return
+
+    def check_result(self):
+        super().check_result()
+        if not self.passed:
+            return
+
+        if self.check_expected_error():
+            return
+
+        if 'expect_job_err' in self.fio_opts:
+            if not self.get_json():
+                self.fail('Unable to decode JSON data')
+                return
+            error = self.json_data['jobs'][0]['error']
+            if error != self.fio_opts['expect_job_err']:
+                self.fail(f"Job failed with error {error}, expected "
+                          f"{self.fio_opts['expect_job_err']}")
+            return
+
+        jobs = self.get_jobs(self.fio_opts.get('numjobs', 1))
+        if not jobs:
+            return
+
+        self.check_writes(jobs)
+
+        written = sum(job['write']['io_bytes'] for job in jobs)
+        expected = self.fio_opts.get('io_size', SIZE) * len(jobs)
+        if written != expected:
+            self.fail(f"Wrote {written} bytes, expected {expected}")
+
+        if 'verify' in self.fio_opts:
+            verified = sum(job['read']['io_bytes'] for job in jobs)
+            if verified != written:
+                self.fail(f"Verified {verified} of {written} bytes")
+
+        # Writing more than the device holds requires zone resets, with
+        # zones finished early when they have no room for another block
+        for cmd in ['reset', 'finish']:
+            expect = cmd in self.fio_opts.get('expect_zone_mgmt', [])
+            nr_cmds = sum(job.get('zone_mgmt', {}).get(cmd, {}).get('total_cmds', 0)
+                          for job in jobs)
+            if expect and not nr_cmds:
+                self.fail(f"No zone {cmd} commands reported")
+            if not expect and nr_cmds:
+                self.fail(f"{nr_cmds} unexpected zone {cmd} commands reported")
+
+
+TEST_LIST = [
+    {
+        # Fill all zones sequentially and verify
+        "test_id": 1,
+        "fio_opts": {
+            "rw": "write",
+            "bs": "64k",
+            "verify": "crc32c",
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # Random writes with zone resets, zone capacity and device limits
+        "test_id": 2,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "16k",
+            "zonecapacity": 786432,
+            "io_size": 3 * SIZE,
+            "max_open_zones": 4,
+            "zone_emulation_max_open": 4,
+            "zone_emulation_max_active": 4,
+            "expect_zone_mgmt": ['reset'],
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # Several jobs writing to the same emulated device
+        "test_id": 3,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "4k",
+            "ioengine": "posixaio",
+            "iodepth": 8,
+            "numjobs": 4,
+            "io_size": SIZE // 2,
+            "max_open_zones": 8,
+            "zone_reset_frequency": 0.01,
+            "zone_emulation_max_open": 8,
+            "expect_zone_mgmt": ['reset'],
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # max_open_zones cannot exceed the emulated open zone limit
+        "test_id": 4,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "4k",
+            "max_open_zones": 8,
+            "zone_emulation_max_open": 4,
+            "expect_err": "larger than max (4)",
+            },
+        "test_class": FioZbdEmuTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # The emulated device rejects writes exceeding its active zone limit
+        "test_id": 5,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "4k",
+            "max_open_zones": 8,
+            "ignore_zone_limits": 1,
+            "zone_emulation_max_active": 2,
+            "expect_job_err": 75,
+            },
+        "test_class": FioZbdEmuTest,
+        "success": {'zero_return': False, 'timeout': 600},
+    },
+    {
+        # Zone appends with many writes in flight, verify where they landed
+        "test_id": 6,
+        "fio_opts": {
+            "rw": "write",
+            "bs": "16k",
+            "ioengine": "posixaio",
+            "iodepth": 16,
+            "zone_append": 1,
+            "verify": "crc32c",
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # Several jobs appending to the same zones, with zone resets
+        "test_id": 7,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "16k",
+            "ioengine": "posixaio",
+            "iodepth": 16,
+            "numjobs": 4,
+            "io_size": SIZE,
+            "max_open_zones": 2,
+            "zone_emulation_max_open": 2,
+            "zone_append": 1,
+            "expect_zone_mgmt": ['reset'],
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # Many jobs appending to many open zones, zones change often
+        "test_id": 8,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "4k",
+            "ioengine": "posixaio",
+            "iodepth": 8,
+            "numjobs": 16,
+            "io_size": SIZE // 2,
+            "max_open_zones": 16,
+            "zone_emulation_max_open": 16,
+            "zone_append": 1,
+            "expect_zone_mgmt": ['reset'],
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # More zones than one zone report returns, reported in ranges
+        "test_id": 9,
+        "fio_opts": {
+            "rw": "write",
+            "bs": "2k",
+            "zonesize": 2048,
+            "io_size": SIZE // 8,
+            "verify": "crc32c",
+            },
+        "test_class": FioZbdEmuTest,
+    },
+    {
+        # Zone appends and regular writes cannot share zones
+        "test_id": 10,
+        "fio_opts": {
+            "rw": "randwrite",
+            "bs": "16k",
+            "ioengine": "posixaio",
+            "zone_append": 1,
+            "second_job": {"rw": "randwrite", "bs": "16k"},
+            "expect_err": "jobs with and without zone_append cannot write to the same zoned device",
+            },
+        "test_class": FioZbdEmuTest,
+        "success": SUCCESS_NONZERO,
+    },
+    {
+        # Zones without room for another block are finished, resets are
+        # queued alongside the writes
+        "test_id": 11,
+        "fio_opts": {
+            "rw": "write",
+            "bs": "12k",
+            "ioengine": "io_uring",
+            "iodepth": 16,
+            "io_size": 12288 * 5000,
+            "max_open_zones": 4,
+            "zone_emulation_max_active": 4,
+            "expect_zone_mgmt": ['reset', 'finish'],
+            },
+        "test_class": FioZbdEmuTest,
+    },
+]
+
+
+def main():
+    """Run zone emulation tests."""
+
+    sys.exit(run_test_script(TEST_LIST, 'zbd-emu', __file__))
+
+
+if __name__ == '__main__':
+    main()
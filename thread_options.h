@@ -154,9 +154,11 @@ struct thread_options {
 	unsigned long long verify_backlog;
 	unsigned int verify_batch;
 	unsigned int experimental_verify;
+	unsigned int verify_streaming;
 	unsigned int verify_state;
 	unsigned int verify_state_save;
 	unsigned int verify_write_sequence;
+	char *verify_journal;
 	unsigned int use_thread;
 	unsigned int unlink;
 	unsigned int unlink_each_loop;
@@ -171,6 +173,7 @@ struct thread_options {
 	unsigned int log_offset;
 	unsigned int log_gz;
 	unsigned int log_gz_store;
+	unsigned int log_gz_type;
 	unsigned int log_alternate_epoch;
 	unsigned int log_alternate_epoch_clock_id;
 	unsigned int norandommap;
@@ -265,6 +268,9 @@ struct thread_options {
 	unsigned int dedupe_mode;
 	unsigned int dedupe_working_set_percentage;
 	unsigned int dedupe_global;
+	unsigned int dedupe_working_set_cache;
+	unsigned long long buffer_pool_size;
+	char *buffer_pool_file;
 	unsigned int time_based;
 	unsigned int disable_lat;
 	unsigned int disable_clat;
@@ -297,11 +303,18 @@ struct thread_options {
 	unsigned int write_lat_log;
 	unsigned int write_iops_log;
 	unsigned int write_hist_log;
+	unsigned int write_pct_log;
+
+	unsigned int log_pct_msec;
+	unsigned int log_pct_json;
+	fio_fp64_t log_pct_list[FIO_IO_U_LIST_MAX_LEN];
 
 	char *bw_log_file;
 	char *lat_log_file;
 	char *iops_log_file;
 	char *hist_log_file;
+	char *pct_log_file;
+	char *lat_heatmap_file;
 	char *replay_redirect;
 
 	/*
@@ -363,6 +376,18 @@ struct thread_options {
 	uint32_t latency_run;
 	fio_fp64_t latency_percentile;
 
+	unsigned int lat_outliers;
+	unsigned long long lat_outliers_window;
+
+	unsigned int lat_heatmap;
+	unsigned int write_lat_heatmap;
+	unsigned int lat_heatmap_region_nz;
+	unsigned long long lat_heatmap_region;
+
+	unsigned int file_stats;
+	unsigned int file_stats_sort;
+	unsigned int clat_depth_hist;
+
 	/*
 	 * flow support
 	 */
@@ -389,6 +414,10 @@ struct thread_options {
 	int max_open_zones;
 	unsigned int job_max_open_zones;
 	unsigned int ignore_zone_limits;
+	unsigned int zone_emu;
+	unsigned int zone_emu_max_open;
+	unsigned int zone_emu_max_active;
+	unsigned int zone_append;
 	fio_fp64_t zrt;
 	fio_fp64_t zrf;
 
@@ -398,6 +427,10 @@ struct thread_options {
 	uint16_t dp_ids[FIO_MAX_DP_IDS];
 	unsigned int dp_nr_ids;
 	char *dp_scheme_file;
+	unsigned int dp_emu;
+	unsigned long long dp_emu_ru_size;
+	unsigned int dp_emu_nr_ruhs;
+	unsigned int dp_emu_op;
 
 	unsigned int log_entries;
 	unsigned int log_prio;
@@ -588,6 +621,7 @@ struct thread_options_pack {
 	uint32_t dedupe_mode;
 	uint32_t dedupe_working_set_percentage;
 	uint32_t dedupe_global;
+	uint32_t dedupe_working_set_cache;
 	uint32_t time_based;
 	uint32_t disable_lat;
 	uint32_t disable_clat;
@@ -607,7 +641,8 @@ struct thread_options_pack {
 	uint32_t lat_percentiles;
 	uint32_t slat_percentiles;
 	uint32_t percentile_precision;
-	uint32_t pad;
+	uint32_t verify_streaming;
+	uint32_t log_gz_type;
 	fio_fp64_t percentile_list[FIO_IO_U_LIST_MAX_LEN];
 
 	uint8_t read_iolog_file[FIO_TOP_STR_MAX];
@@ -615,16 +650,23 @@ struct thread_options_pack {
 	uint8_t merge_blktrace_file[FIO_TOP_STR_MAX];
 	fio_fp64_t merge_blktrace_scalars[FIO_IO_U_LIST_MAX_LEN];
 	fio_fp64_t merge_blktrace_iters[FIO_IO_U_LIST_MAX_LEN];
+	fio_fp64_t log_pct_list[FIO_IO_U_LIST_MAX_LEN];
 
 	uint32_t write_bw_log;
 	uint32_t write_lat_log;
 	uint32_t write_iops_log;
 	uint32_t write_hist_log;
+	uint32_t write_pct_log;
+	uint32_t log_pct_msec;
+	uint32_t log_pct_json;
+	uint32_t pad2;
 
 	uint8_t bw_log_file[FIO_TOP_STR_MAX];
 	uint8_t lat_log_file[FIO_TOP_STR_MAX];
 	uint8_t iops_log_file[FIO_TOP_STR_MAX];
 	uint8_t hist_log_file[FIO_TOP_STR_MAX];
+	uint8_t pct_log_file[FIO_TOP_STR_MAX];
+	uint8_t lat_heatmap_file[FIO_TOP_STR_MAX];
 	uint8_t replay_redirect[FIO_TOP_STR_MAX];
 
 	/*
@@ -683,6 +725,21 @@ struct thread_options_pack {
 	uint32_t latency_run;
 	fio_fp64_t latency_percentile;
 
+	uint32_t lat_outliers;
+	uint32_t pad3;
+	uint64_t lat_outliers_window;
+
+	uint32_t lat_heatmap;
+	uint32_t write_lat_heatmap;
+	uint32_t lat_heatmap_region_nz;
+	uint32_t pad4;
+	uint64_t lat_heatmap_region;
+
+	uint32_t file_stats;
+	uint32_t file_stats_sort;
+	uint32_t clat_depth_hist;
+	uint32_t pad5;
+
 	/*
 	 * flow support
 	 */
@@ -707,6 +764,10 @@ struct thread_options_pack {
 	uint32_t zone_mode;
 	int32_t max_open_zones;
 	uint32_t ignore_zone_limits;
+	uint32_t zone_emu;
+	uint32_t zone_emu_max_open;
+	uint32_t zone_emu_max_active;
+	uint32_t zone_append;
 
 	uint32_t log_entries;
 	uint32_t log_prio;
@@ -718,6 +779,13 @@ struct thread_options_pack {
 	uint16_t dp_ids[FIO_MAX_DP_IDS];
 	uint32_t dp_nr_ids;
 	uint8_t dp_scheme_file[FIO_TOP_STR_MAX];
+	uint8_t verify_journal[FIO_TOP_STR_MAX];
+	uint8_t buffer_pool_file[FIO_TOP_STR_MAX];
+	uint64_t dp_emu_ru_size;
+	uint64_t buffer_pool_size;
+	uint32_t dp_emu;
+	uint32_t dp_emu_nr_ruhs;
+	uint32_t dp_emu_op;
 
 	uint32_t num_range;
 	/*
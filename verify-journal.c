@@ -0,0 +1,671 @@
+/*
+ * Crash consistency checking with a journal of acknowledged writes and
+ * flushes.
+ *
+ * While a job writes, every write and flush the device acknowledged is
+ * appended to a journal kept on another device. A separate thread writes
+ * the journal out and syncs it, so the job never waits for it. If the
+ * system crashes, running the same job with verify_only=1 reads the
+ * journal back and checks every block it names: the data written last is
+ * either there (durable), partly there (torn) or not there at all (lost).
+ * Blocks that lost data a completed flush covered are flagged.
+ *
+ * The journal may lag the writes it describes by up to VJ_FLUSH_MSEC when
+ * the crash hits. A block holding a later write of the same job than the
+ * journal knows about is taken to be durable.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fio.h"
+#include "pshared.h"
+#include "verify.h"
+#include "verify-journal.h"
+
+#define VJ_BUF_RECS	4096
+#define VJ_MAX_BUFS	16
+#define VJ_FLUSH_MSEC	100
+
+struct vj_buf {
+	struct flist_head list;
+	unsigned int nr;
+	struct vj_record recs[VJ_BUF_RECS];
+};
+
+/*
+ * @lock protects everything but @fd, which only the journal thread uses
+ * while writing. Records are added to @cur, which is handed to the journal
+ * thread once full, on a flush, or after VJ_FLUSH_MSEC.
+ */
+struct verify_journal {
+	int fd;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_cond_t free_cond;
+	struct flist_head full;
+	struct flist_head free;
+	struct vj_buf *cur;
+	unsigned int nr_bufs;
+	bool exit;
+	int error;
+
+	/* When the job started writing, see verify_journal_newer() */
+	uint32_t time_sec;
+	uint32_t time_nsec;
+};
+
+static char *vj_file_name(struct thread_data *td)
+{
+	char *name;
+
+	if (asprintf(&name, "%s.%d", td->o.verify_journal,
+		     td->thread_number - 1) < 0)
+		return NULL;
+
+	return name;
+}
+
+/*
+ * Check the journal instead of writing it
+ */
+bool verify_journal_check(struct thread_data *td)
+{
+	return td->o.verify_journal && td->o.verify_only && td_write(td);
+}
+
+static int vj_write_out(struct verify_journal *vj, struct flist_head *list)
+{
+	struct flist_head *n;
+
+	flist_for_each(n, list) {
+		struct vj_buf *buf = flist_entry(n, struct vj_buf, list);
+		size_t left = buf->nr * sizeof(buf->recs[0]);
+		char *p = (char *) buf->recs;
+
+		while (left) {
+			ssize_t ret = write(vj->fd, p, left);
+
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+				return errno;
+			}
+			p += ret;
+			left -= ret;
+		}
+		buf->nr = 0;
+	}
+
+#ifdef CONFIG_FDATASYNC
+	if (fdatasync(vj->fd) < 0)
+		return errno;
+#else
+	if (fsync(vj->fd) < 0)
+		return errno;
+#endif
+	return 0;
+}
+
+/*
+ * Called with vj->lock held. Queue the current buffer for the journal
+ * thread and start a new one, waiting for the journal thread to free one
+ * if it has fallen too far behind.
+ */
+static void vj_hand_off(struct verify_journal *vj)
+{
+	struct vj_buf *buf;
+
+	flist_add_tail(&vj->cur->list, &vj->full);
+	vj->cur = NULL;
+	pthread_cond_signal(&vj->cond);
+
+	while (flist_empty(&vj->free)) {
+		if (vj->nr_bufs < VJ_MAX_BUFS) {
+			buf = malloc(sizeof(*buf));
+			if (buf) {
+				buf->nr = 0;
+				vj->nr_bufs++;
+				vj->cur = buf;
+				return;
+			}
+		}
+		pthread_cond_wait(&vj->free_cond, &vj->lock);
+	}
+
+	vj->cur = flist_first_entry(&vj->free, struct vj_buf, list);
+	flist_del(&vj->cur->list);
+}
+
+static void vj_timeout(struct timespec *ts)
+{
+#ifdef CONFIG_PTHREAD_CONDATTR_SETCLOCK
+	clock_gettime(CLOCK_MONOTONIC, ts);
+#else
+	clock_gettime(CLOCK_REALTIME, ts);
+#endif
+	ts->tv_nsec += VJ_FLUSH_MSEC * 1000000ULL;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_nsec -= 1000000000;
+		ts->tv_sec++;
+	}
+}
+
+static void *vj_thread_main(void *data)
+{
+	struct verify_journal *vj = data;
+	struct timespec ts;
+	FLIST_HEAD(list);
+	bool exit;
+	int ret;
+
+	pthread_mutex_lock(&vj->lock);
+	do {
+		if (flist_empty(&vj->full) && !vj->exit) {
+			vj_timeout(&ts);
+			pthread_cond_timedwait(&vj->cond, &vj->lock, &ts);
+			if (flist_empty(&vj->full) && vj->cur && vj->cur->nr)
+				vj_hand_off(vj);
+		}
+		flist_splice_init(&vj->full, &list);
+		exit = vj->exit;
+		pthread_mutex_unlock(&vj->lock);
+
+		if (!flist_empty(&list) && !vj->error) {
+			ret = vj_write_out(vj, &list);
+			if (ret) {
+				log_err("fio: verify journal write failed: %s\n",
+					strerror(ret));
+				vj->error = ret;
+			}
+		}
+
+		pthread_mutex_lock(&vj->lock);
+		flist_splice_tail_init(&list, &vj->free);
+		pthread_cond_broadcast(&vj->free_cond);
+	} while (!exit);
+	pthread_mutex_unlock(&vj->lock);
+
+	return NULL;
+}
+
+static void vj_add(struct verify_journal *vj, struct vj_record *rec,
+		   bool now)
+{
+	pthread_mutex_lock(&vj->lock);
+	vj->cur->recs[vj->cur->nr++] = *rec;
+	if (now || vj->cur->nr == VJ_BUF_RECS)
+		vj_hand_off(vj);
+	pthread_mutex_unlock(&vj->lock);
+}
+
+/*
+ * Log a write fio saw complete successfully
+ */
+void verify_journal_write(struct thread_data *td, struct io_u *io_u)
+{
+	struct vj_record rec = {
+		.offset		= cpu_to_le64((uint64_t) io_u->verify_offset),
+		.rand_seed	= cpu_to_le64(io_u->rand_seed),
+		.fileno		= cpu_to_le32((uint32_t) io_u->file->fileno),
+		.numberio	= cpu_to_le16(io_u->numberio),
+		.type		= td->o.sync_io ? VJ_REC_WRITE_DURABLE :
+						  VJ_REC_WRITE,
+	};
+
+	vj_add(td->vjournal, &rec, false);
+}
+
+/*
+ * Log a flush being issued or completing. A flush only covers the writes
+ * that completed before it was issued, which the journal tells apart by
+ * logging both. The io_u address ties the two records together.
+ */
+void verify_journal_flush(struct thread_data *td, struct io_u *io_u,
+			  bool done)
+{
+	struct vj_record rec = {
+		.offset		= cpu_to_le64((uint64_t) (uintptr_t) io_u),
+		.fileno		= cpu_to_le32((uint32_t) io_u->file->fileno),
+		.type		= done ? VJ_REC_FLUSH : VJ_REC_FLUSH_ISSUE,
+	};
+
+	if (io_u->ddir != DDIR_SYNC && io_u->ddir != DDIR_DATASYNC)
+		return;
+
+	vj_add(td->vjournal, &rec, done);
+}
+
+static int vj_open(struct thread_data *td, struct verify_journal *vj)
+{
+	struct timespec now;
+	struct vj_file_header hdr;
+	char *name;
+
+	name = vj_file_name(td);
+	if (!name) {
+		td_verror(td, ENOMEM, "verify journal");
+		return 1;
+	}
+
+	vj->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (vj->fd < 0) {
+		td_verror(td, errno, "open verify journal");
+		free(name);
+		return 1;
+	}
+	free(name);
+
+	fio_gettime(&now, NULL);
+	vj->time_sec = now.tv_sec;
+	vj->time_nsec = now.tv_nsec;
+
+	hdr.magic = cpu_to_le64((uint64_t) VJ_MAGIC);
+	hdr.version = cpu_to_le32((uint32_t) VJ_VERSION);
+	hdr.nr_files = cpu_to_le32((uint32_t) td->files_index);
+	hdr.bs = cpu_to_le64((uint64_t) td->o.min_bs[DDIR_WRITE]);
+	hdr.time_sec = cpu_to_le32(vj->time_sec);
+	hdr.time_nsec = cpu_to_le32(vj->time_nsec);
+	if (write(vj->fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    fsync(vj->fd) < 0) {
+		td_verror(td, errno, "write verify journal");
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * verify_journal_init - set up the verify journal of a job
+ * @td: fio thread data.
+ *
+ * A job writing data starts the thread that writes out its journal. A job
+ * checking the journal after a crash reads it later, in
+ * verify_journal_load().
+ */
+int verify_journal_init(struct thread_data *td)
+{
+	struct verify_journal *vj;
+	pthread_attr_t attr;
+	int ret;
+
+	if (!td->o.verify_journal || !td_write(td))
+		return 0;
+
+	vj = calloc(1, sizeof(*vj));
+	if (!vj) {
+		td_verror(td, ENOMEM, "verify journal");
+		return 1;
+	}
+	vj->fd = -1;
+	INIT_FLIST_HEAD(&vj->full);
+	INIT_FLIST_HEAD(&vj->free);
+	td->vjournal = vj;
+	if (verify_journal_check(td))
+		return 0;
+
+	if (vj_open(td, vj))
+		goto err_close;
+
+	vj->cur = malloc(sizeof(*vj->cur));
+	if (!vj->cur) {
+		td_verror(td, ENOMEM, "verify journal");
+		goto err_close;
+	}
+	vj->cur->nr = 0;
+	vj->nr_bufs = 1;
+
+	ret = mutex_cond_init_pshared(&vj->lock, &vj->cond);
+	if (ret) {
+		td_verror(td, ret, "verify journal lock");
+		goto err_cur;
+	}
+	ret = cond_init_pshared(&vj->free_cond);
+	if (ret) {
+		td_verror(td, ret, "verify journal lock");
+		goto err_lock;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 2 * PTHREAD_STACK_MIN);
+	ret = pthread_create(&vj->thread, &attr, vj_thread_main, vj);
+	pthread_attr_destroy(&attr);
+	if (ret) {
+		log_err("fio: verify journal thread creation failed: %s\n",
+			strerror(ret));
+		goto err_cond;
+	}
+
+	return 0;
+
+err_cond:
+	pthread_cond_destroy(&vj->free_cond);
+err_lock:
+	pthread_cond_destroy(&vj->cond);
+	pthread_mutex_destroy(&vj->lock);
+err_cur:
+	free(vj->cur);
+err_close:
+	if (vj->fd != -1)
+		close(vj->fd);
+	free(vj);
+	td->vjournal = NULL;
+	return 1;
+}
+
+/*
+ * Write out what is left of the journal, and report if any of it could
+ * not be written.
+ */
+void verify_journal_exit(struct thread_data *td)
+{
+	struct verify_journal *vj = td->vjournal;
+	struct flist_head *n, *tmp;
+
+	if (!vj)
+		return;
+
+	if (vj->cur) {
+		pthread_mutex_lock(&vj->lock);
+		vj->exit = true;
+		if (vj->cur->nr)
+			vj_hand_off(vj);
+		pthread_cond_signal(&vj->cond);
+		pthread_mutex_unlock(&vj->lock);
+		pthread_join(vj->thread, NULL);
+
+		if (vj->error)
+			td_verror(td, vj->error, "write verify journal");
+
+		flist_for_each_safe(n, tmp, &vj->free) {
+			flist_del(n);
+			free(flist_entry(n, struct vj_buf, list));
+		}
+		free(vj->cur);
+		pthread_cond_destroy(&vj->cond);
+		pthread_cond_destroy(&vj->free_cond);
+		pthread_mutex_destroy(&vj->lock);
+	}
+
+	if (vj->fd != -1)
+		close(vj->fd);
+	free(vj);
+	td->vjournal = NULL;
+}
+
+static int vj_read(struct thread_data *td, int fd, struct vj_record *recs,
+		   unsigned int *nr)
+{
+	ssize_t ret;
+
+	*nr = 0;
+	ret = read(fd, recs, VJ_BUF_RECS * sizeof(*recs));
+	if (ret < 0) {
+		td_verror(td, errno, "read verify journal");
+		return 1;
+	}
+
+	/* A record cut short by the crash is ignored */
+	*nr = ret / sizeof(*recs);
+	return 0;
+}
+
+/*
+ * The journal index up to which a completed flush covers the writes to
+ * each file: the index of the matching flush issue record.
+ */
+static int vj_load_flushes(struct thread_data *td, int fd,
+			   struct vj_record *recs, uint64_t *flushed)
+{
+	uint64_t *tokens = NULL, *token_idx = NULL;
+	unsigned int nr_tokens = 0, nr, i, j;
+	uint64_t idx = 0;
+
+	do {
+		if (vj_read(td, fd, recs, &nr))
+			break;
+
+		for (i = 0; i < nr; i++, idx++) {
+			uint64_t token = le64_to_cpu(recs[i].offset);
+			uint32_t fileno = le32_to_cpu(recs[i].fileno);
+
+			if (recs[i].type != VJ_REC_FLUSH_ISSUE &&
+			    recs[i].type != VJ_REC_FLUSH)
+				continue;
+
+			for (j = 0; j < nr_tokens; j++)
+				if (tokens[j] == token)
+					break;
+
+			if (recs[i].type == VJ_REC_FLUSH_ISSUE) {
+				if (j == nr_tokens) {
+					uint64_t *t, *ti;
+
+					t = realloc(tokens, (j + 1) * sizeof(*tokens));
+					if (t)
+						tokens = t;
+					ti = realloc(token_idx, (j + 1) * sizeof(*token_idx));
+					if (ti)
+						token_idx = ti;
+					if (!t || !ti) {
+						free(tokens);
+						free(token_idx);
+						td_verror(td, ENOMEM, "verify journal");
+						return -ENOMEM;
+					}
+					tokens[nr_tokens++] = token;
+				}
+				token_idx[j] = idx;
+			} else if (j < nr_tokens && fileno < td->files_index)
+				flushed[fileno] = token_idx[j];
+		}
+	} while (nr);
+
+	free(tokens);
+	free(token_idx);
+	return td->error;
+}
+
+static void vj_load_write(struct thread_data *td, struct vj_record *rec,
+			  bool durable)
+{
+	uint32_t fileno = le32_to_cpu(rec->fileno);
+	uint64_t offset = le64_to_cpu(rec->offset);
+	struct verify_map *map;
+	struct vj_block *vb;
+	struct verify_map_block *b;
+	uint64_t idx;
+
+	if (fileno >= td->files_index || !td->files[fileno]->verify_map)
+		return;
+
+	map = td->files[fileno]->verify_map;
+	if (offset < map->start || (offset - map->start) % map->bs)
+		return;
+	idx = (offset - map->start) / map->bs;
+	if (idx >= map->nr_blocks)
+		return;
+
+	b = &map->blocks[idx];
+	vb = &map->journal[idx];
+	if (!(b->state & VMAP_F_LOGGED)) {
+		b->state = VMAP_F_LOGGED;
+		map->nr_logged++;
+		td->io_hist_len++;
+	}
+	b->numberio = le16_to_cpu(rec->numberio);
+	vb->rand_seed = le64_to_cpu(rec->rand_seed);
+	if (durable) {
+		vb->durable = 1;
+		vb->durable_numberio = b->numberio;
+	}
+}
+
+/**
+ * verify_journal_load - read the journal back after a crash
+ * @td: fio thread data.
+ *
+ * Instead of replaying the writes of the job, log the last write the
+ * journal recorded to each block in the verify map of its file, and
+ * remember whether a completed flush covered it. Returns the number of
+ * bytes to verify.
+ */
+uint64_t verify_journal_load(struct thread_data *td)
+{
+	struct verify_journal *vj = td->vjournal;
+	struct vj_file_header hdr;
+	struct vj_record *recs = NULL;
+	uint64_t *flushed = NULL, idx = 0, bytes = 0;
+	struct fio_file *f;
+	unsigned int i, nr;
+	char *name;
+	int fd;
+
+	name = vj_file_name(td);
+	if (!name) {
+		td_verror(td, ENOMEM, "verify journal");
+		return 0;
+	}
+	fd = open(name, O_RDONLY);
+	if (fd < 0) {
+		td_verror(td, errno, "open verify journal");
+		free(name);
+		return 0;
+	}
+
+	if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    le64_to_cpu(hdr.magic) != VJ_MAGIC ||
+	    le32_to_cpu(hdr.version) != VJ_VERSION) {
+		log_err("fio: %s is not a verify journal\n", name);
+		td_verror(td, EINVAL, "verify journal");
+		goto out;
+	}
+	if (le64_to_cpu(hdr.bs) != td->o.min_bs[DDIR_WRITE] ||
+	    le32_to_cpu(hdr.nr_files) != td->files_index) {
+		log_err("fio: verify journal %s was written by a different job\n",
+			name);
+		td_verror(td, EINVAL, "verify journal");
+		goto out;
+	}
+	vj->time_sec = le32_to_cpu(hdr.time_sec);
+	vj->time_nsec = le32_to_cpu(hdr.time_nsec);
+
+	for_each_file(td, f, i) {
+		struct verify_map *map = f->verify_map;
+
+		if (!map) {
+			log_err("fio: no verify map for %s\n", f->file_name);
+			td_verror(td, ENOMEM, "verify journal");
+			goto out;
+		}
+		if (!map->journal)
+			map->journal = malloc(map->nr_blocks * sizeof(map->journal[0]));
+		if (!map->journal) {
+			td_verror(td, ENOMEM, "verify journal");
+			goto out;
+		}
+		memset(map->journal, 0, map->nr_blocks * sizeof(map->journal[0]));
+	}
+
+	recs = malloc(VJ_BUF_RECS * sizeof(*recs));
+	flushed = calloc(td->files_index, sizeof(*flushed));
+	if (vj_load_flushes(td, fd, recs, flushed))
+		goto out;
+
+	if (lseek(fd, sizeof(hdr), SEEK_SET) < 0) {
+		td_verror(td, errno, "lseek verify journal");
+		goto out;
+	}
+
+	do {
+		if (vj_read(td, fd, recs, &nr))
+			goto out;
+
+		for (i = 0; i < nr; i++, idx++) {
+			uint32_t fileno = le32_to_cpu(recs[i].fileno);
+
+			if (recs[i].type == VJ_REC_WRITE_DURABLE)
+				vj_load_write(td, &recs[i], true);
+			else if (recs[i].type == VJ_REC_WRITE)
+				vj_load_write(td, &recs[i],
+					      fileno < td->files_index &&
+					      idx < flushed[fileno]);
+		}
+	} while (nr);
+
+	for_each_file(td, f, i)
+		bytes += f->verify_map->nr_logged * f->verify_map->bs;
+
+	dprint(FD_VERIFY, "verify journal %s: %"PRIu64" records, %"PRIu64" bytes to check\n",
+	       name, idx, bytes);
+out:
+	free(flushed);
+	free(recs);
+	free(name);
+	close(fd);
+	return bytes;
+}
+
+/*
+ * Whether a chunk that is not what the journal recorded was written later
+ * by the same job, after the journal was last written out. Such a chunk
+ * has a valid header from this job numbered after the journaled write.
+ * Writes from before the job started carry an older time stamp, unless the
+ * buffer they were written from had not been used yet.
+ */
+bool verify_journal_newer(struct thread_data *td, struct io_u *io_u,
+			  struct verify_header *hdr)
+{
+	struct verify_journal *vj = td->vjournal;
+	uint16_t ahead = hdr->numberio - io_u->numberio;
+
+	if (hdr->thread != td->thread_number || !ahead || ahead >= 32768)
+		return false;
+	if (!hdr->time_sec && !hdr->time_nsec)
+		return true;
+
+	return hdr->time_sec > vj->time_sec ||
+		(hdr->time_sec == vj->time_sec &&
+		 hdr->time_nsec >= vj->time_nsec);
+}
+
+/*
+ * Whether a chunk holds at least the last write a flush made durable, if
+ * there was one.
+ */
+bool verify_journal_durable(struct io_u *io_u, struct verify_header *hdr)
+{
+	struct verify_map *map = io_u->file->verify_map;
+	struct vj_block *vb;
+	uint16_t ahead;
+
+	vb = &map->journal[(io_u->verify_offset - map->start) / map->bs];
+	if (!vb->durable)
+		return true;
+	if (!hdr)
+		return false;
+
+	ahead = hdr->numberio - vb->durable_numberio;
+	return ahead < 32768;
+}
+
+/*
+ * Account a checked block. Returns EILSEQ if the block lost data that a
+ * completed flush covered.
+ */
+int verify_journal_account(struct thread_data *td, struct io_u *io_u,
+			   enum fio_vj_state state, bool violation)
+{
+	atomic_add(&td->ts.vj_blocks[state], 1);
+	if (!violation)
+		return 0;
+
+	atomic_add(&td->ts.vj_violations, 1);
+	log_err("verify: %s block at file %s offset %llu, length %llu was flushed before the crash\n",
+		state == FIO_VJ_LOST ? "lost" : "torn",
+		io_u->file->file_name, io_u->verify_offset, io_u->buflen);
+	return EILSEQ;
+}
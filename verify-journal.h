@@ -0,0 +1,66 @@
+#ifndef FIO_VERIFY_JOURNAL_H
+#define FIO_VERIFY_JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stat.h"
+
+struct thread_data;
+struct io_u;
+struct verify_header;
+
+/*
+ * On disk format of the verify journal, all fields little endian. A header
+ * is followed by records, in the order fio saw the I/O complete.
+ */
+#define VJ_MAGIC	0x6c6e726a766f6966ULL	/* "fiovjrnl" */
+#define VJ_VERSION	1
+
+struct vj_file_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t nr_files;
+	uint64_t bs;
+	uint32_t time_sec;	/* when the job started writing */
+	uint32_t time_nsec;
+};
+
+enum {
+	VJ_REC_WRITE		= 1,	/* write acknowledged */
+	VJ_REC_WRITE_DURABLE	= 2,	/* write acknowledged with O_SYNC */
+	VJ_REC_FLUSH_ISSUE	= 3,	/* flush issued, offset is a token */
+	VJ_REC_FLUSH		= 4,	/* flush with the same token acknowledged */
+};
+
+struct vj_record {
+	uint64_t offset;
+	uint64_t rand_seed;
+	uint32_t fileno;
+	uint16_t numberio;
+	uint8_t type;
+	uint8_t pad;
+};
+
+/*
+ * What the journal says about a block when checking it, see verify_map
+ */
+struct vj_block {
+	uint64_t rand_seed;
+	uint16_t durable_numberio;	/* last write known to be durable */
+	uint16_t durable;
+};
+
+extern int verify_journal_init(struct thread_data *);
+extern void verify_journal_exit(struct thread_data *);
+extern void verify_journal_write(struct thread_data *, struct io_u *);
+extern void verify_journal_flush(struct thread_data *, struct io_u *, bool);
+extern uint64_t verify_journal_load(struct thread_data *);
+extern bool verify_journal_check(struct thread_data *);
+extern bool verify_journal_newer(struct thread_data *, struct io_u *,
+				 struct verify_header *);
+extern bool verify_journal_durable(struct io_u *, struct verify_header *);
+extern int verify_journal_account(struct thread_data *, struct io_u *,
+				  enum fio_vj_state, bool);
+
+#endif
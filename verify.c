@@ -11,6 +11,7 @@
 #include "arch/arch.h"
 #include "fio.h"
 #include "verify.h"
+#include "verify-journal.h"
 #include "trim.h"
 #include "lib/rand.h"
 #include "lib/hweight.h"
@@ -27,6 +28,7 @@
 #include "crc/sha512.h"
 #include "crc/sha1.h"
 #include "crc/xxhash.h"
+#include "crc/xxh3.h"
 #include "crc/sha3.h"
 
 static void populate_hdr(struct thread_data *td, struct io_u *io_u,
@@ -189,6 +191,12 @@ static inline unsigned int __hdr_size(int verify_type)
 	case VERIFY_SHA1:
 		len = sizeof(struct vhdr_sha1);
 		break;
+	case VERIFY_XXH3:
+		len = sizeof(struct vhdr_xxh3);
+		break;
+	case VERIFY_XXH128:
+		len = sizeof(struct vhdr_xxh128);
+		break;
 	case VERIFY_PATTERN_NO_HDR:
 		return 0;
 	default:
@@ -226,6 +234,7 @@ struct vcont {
 	struct io_u *io_u;
 	unsigned int hdr_num;
 	struct thread_data *td;
+	bool quiet;	/* don't log failures */
 
 	/*
 	 * Output, only valid in case of error
@@ -341,6 +350,9 @@ static void log_verify_failure(struct verify_header *hdr, struct vcont *vc)
 	uint32_t len;
 	struct thread_data *td = vc->td;
 
+	if (vc->quiet)
+		return;
+
 	offset = vc->io_u->verify_offset;
 	if (td->o.verify != VERIFY_PATTERN_NO_HDR) {
 		len = hdr->len;
@@ -395,6 +407,8 @@ static int verify_io_u_pattern(struct verify_header *hdr, struct vcont *vc)
 	rc = cmp_pattern(pattern, pattern_size, mod, buf, len);
 	if (!rc)
 		return 0;
+	if (vc->quiet)
+		return EILSEQ;
 
 	/* Slow path, compare each byte */
 	for (i = 0; i < len; i++) {
@@ -446,6 +460,48 @@ static int verify_io_u_xxhash(struct verify_header *hdr, struct vcont *vc)
 	return EILSEQ;
 }
 
+static int verify_io_u_xxh3(struct verify_header *hdr, struct vcont *vc)
+{
+	void *p = io_u_verify_off(hdr, vc);
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+	uint64_t hash;
+
+	dprint(FD_VERIFY, "xxh3 verify io_u %p, len %u\n", vc->io_u, hdr->len);
+
+	hash = fio_xxh3_64(p, hdr->len - hdr_size(vc->td, hdr));
+
+	if (vh->hash == hash)
+		return 0;
+
+	vc->name = "xxh3";
+	vc->good_crc = &vh->hash;
+	vc->bad_crc = &hash;
+	vc->crc_len = sizeof(hash);
+	log_verify_failure(hdr, vc);
+	return EILSEQ;
+}
+
+static int verify_io_u_xxh128(struct verify_header *hdr, struct vcont *vc)
+{
+	void *p = io_u_verify_off(hdr, vc);
+	struct vhdr_xxh128 *vh = hdr_priv(hdr);
+	uint64_t hash[2];
+
+	dprint(FD_VERIFY, "xxh128 verify io_u %p, len %u\n", vc->io_u, hdr->len);
+
+	fio_xxh3_128(p, hdr->len - hdr_size(vc->td, hdr), hash);
+
+	if (!memcmp(vh->hash, hash, sizeof(hash)))
+		return 0;
+
+	vc->name = "xxh128";
+	vc->good_crc = vh->hash;
+	vc->bad_crc = hash;
+	vc->crc_len = sizeof(hash);
+	log_verify_failure(hdr, vc);
+	return EILSEQ;
+}
+
 static int verify_io_u_sha3(struct verify_header *hdr, struct vcont *vc,
 			    struct fio_sha3_ctx *sha3_ctx, uint8_t *sha,
 			    unsigned int sha_size, const char *name)
@@ -884,6 +940,129 @@ err:
 	return EILSEQ;
 }
 
+static int verify_chunk(struct verify_header *hdr, struct vcont *vc,
+			unsigned int verify_type)
+{
+	switch (verify_type) {
+	case VERIFY_HDR_ONLY:
+		/* Header is always verified, check if pattern is left
+		 * for verification. */
+		if (vc->td->o.verify_pattern_bytes)
+			return verify_io_u_pattern(hdr, vc);
+		return 0;
+	case VERIFY_MD5:
+		return verify_io_u_md5(hdr, vc);
+	case VERIFY_CRC64:
+		return verify_io_u_crc64(hdr, vc);
+	case VERIFY_CRC32C:
+	case VERIFY_CRC32C_INTEL:
+		return verify_io_u_crc32c(hdr, vc);
+	case VERIFY_CRC32:
+		return verify_io_u_crc32(hdr, vc);
+	case VERIFY_CRC16:
+		return verify_io_u_crc16(hdr, vc);
+	case VERIFY_CRC7:
+		return verify_io_u_crc7(hdr, vc);
+	case VERIFY_SHA256:
+		return verify_io_u_sha256(hdr, vc);
+	case VERIFY_SHA512:
+		return verify_io_u_sha512(hdr, vc);
+	case VERIFY_SHA3_224:
+		return verify_io_u_sha3_224(hdr, vc);
+	case VERIFY_SHA3_256:
+		return verify_io_u_sha3_256(hdr, vc);
+	case VERIFY_SHA3_384:
+		return verify_io_u_sha3_384(hdr, vc);
+	case VERIFY_SHA3_512:
+		return verify_io_u_sha3_512(hdr, vc);
+	case VERIFY_XXHASH:
+		return verify_io_u_xxhash(hdr, vc);
+	case VERIFY_SHA1:
+		return verify_io_u_sha1(hdr, vc);
+	case VERIFY_XXH3:
+		return verify_io_u_xxh3(hdr, vc);
+	case VERIFY_XXH128:
+		return verify_io_u_xxh128(hdr, vc);
+	case VERIFY_PATTERN:
+	case VERIFY_PATTERN_NO_HDR:
+		return verify_io_u_pattern(hdr, vc);
+	default:
+		log_err("Bad verify type %u\n", hdr->verify_type);
+		return EINVAL;
+	}
+}
+
+/*
+ * Whether a chunk holds intact data written by fio at this offset, no
+ * matter by which write
+ */
+static bool verify_chunk_intact(struct thread_data *td, struct io_u *io_u,
+				struct verify_header *hdr, unsigned int hdr_num,
+				unsigned int hdr_len)
+{
+	struct vcont vc = {
+		.io_u		= io_u,
+		.hdr_num	= hdr_num,
+		.td		= td,
+		.quiet		= true,
+	};
+
+	if (hdr->magic != FIO_HDR_MAGIC || hdr->len != hdr_len ||
+	    hdr->offset != io_u->verify_offset + hdr_num * td->o.verify_interval ||
+	    hdr->crc32 != fio_crc32c((void *) hdr,
+				     offsetof(struct verify_header, crc32)))
+		return false;
+
+	return !verify_chunk(hdr, &vc, td->o.verify);
+}
+
+/*
+ * Check a block named by the verify journal after a crash. Each chunk holds
+ * the write the journal recorded last, a later write the journal did not
+ * get to record, or older data.
+ */
+static int verify_journal_io_u(struct thread_data *td, struct io_u *io_u)
+{
+	unsigned int header_size = __hdr_size(td->o.verify);
+	unsigned int hdr_inc = get_hdr_inc(td, io_u);
+	unsigned int hdr_num = 0, nr_last = 0, nr_newer = 0, nr_old = 0;
+	bool violation = false;
+	enum fio_vj_state state;
+	void *p;
+
+	for (p = io_u->buf; p < io_u->buf + io_u->buflen;
+	     p += hdr_inc, hdr_num++) {
+		struct verify_header *hdr = p;
+
+		if (td->o.verify_offset)
+			memswp(p, p + td->o.verify_offset, header_size);
+
+		if (!verify_chunk_intact(td, io_u, hdr, hdr_num, hdr_inc)) {
+			nr_old++;
+			violation |= !verify_journal_durable(io_u, NULL);
+		} else if (hdr->numberio == io_u->numberio &&
+			   hdr->rand_seed == io_u->rand_seed)
+			nr_last++;
+		else if (verify_journal_newer(td, io_u, hdr))
+			nr_newer++;
+		else {
+			nr_old++;
+			violation |= !verify_journal_durable(io_u, hdr);
+		}
+	}
+
+	if (!nr_old && (!nr_last || !nr_newer))
+		state = FIO_VJ_DURABLE;
+	else if (!nr_last && !nr_newer)
+		state = FIO_VJ_LOST;
+	else
+		state = FIO_VJ_TORN;
+
+	dprint(FD_VERIFY, "verify journal: offset %llu, %u last, %u newer, %u old\n",
+	       io_u->verify_offset, nr_last, nr_newer, nr_old);
+	return verify_journal_account(td, io_u, state, violation);
+}
+
 int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 {
 	struct verify_header *hdr;
@@ -913,6 +1092,11 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		goto done;
 	}
 
+	if (io_u->flags & IO_U_F_VER_JOURNAL) {
+		ret = verify_journal_io_u(td, io_u);
+		goto done;
+	}
+
 	hdr_inc = get_hdr_inc(td, io_u);
 
 	ret = 0;
@@ -952,64 +1136,7 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		else
 			verify_type = hdr->verify_type;
 
-		switch (verify_type) {
-		case VERIFY_HDR_ONLY:
-			/* Header is always verified, check if pattern is left
-			 * for verification. */
-			if (td->o.verify_pattern_bytes)
-				ret = verify_io_u_pattern(hdr, &vc);
-			break;
-		case VERIFY_MD5:
-			ret = verify_io_u_md5(hdr, &vc);
-			break;
-		case VERIFY_CRC64:
-			ret = verify_io_u_crc64(hdr, &vc);
-			break;
-		case VERIFY_CRC32C:
-		case VERIFY_CRC32C_INTEL:
-			ret = verify_io_u_crc32c(hdr, &vc);
-			break;
-		case VERIFY_CRC32:
-			ret = verify_io_u_crc32(hdr, &vc);
-			break;
-		case VERIFY_CRC16:
-			ret = verify_io_u_crc16(hdr, &vc);
-			break;
-		case VERIFY_CRC7:
-			ret = verify_io_u_crc7(hdr, &vc);
-			break;
-		case VERIFY_SHA256:
-			ret = verify_io_u_sha256(hdr, &vc);
-			break;
-		case VERIFY_SHA512:
-			ret = verify_io_u_sha512(hdr, &vc);
-			break;
-		case VERIFY_SHA3_224:
-			ret = verify_io_u_sha3_224(hdr, &vc);
-			break;
-		case VERIFY_SHA3_256:
-			ret = verify_io_u_sha3_256(hdr, &vc);
-			break;
-		case VERIFY_SHA3_384:
-			ret = verify_io_u_sha3_384(hdr, &vc);
-			break;
-		case VERIFY_SHA3_512:
-			ret = verify_io_u_sha3_512(hdr, &vc);
-			break;
-		case VERIFY_XXHASH:
-			ret = verify_io_u_xxhash(hdr, &vc);
-			break;
-		case VERIFY_SHA1:
-			ret = verify_io_u_sha1(hdr, &vc);
-			break;
-		case VERIFY_PATTERN:
-		case VERIFY_PATTERN_NO_HDR:
-			ret = verify_io_u_pattern(hdr, &vc);
-			break;
-		default:
-			log_err("Bad verify type %u\n", hdr->verify_type);
-			ret = EINVAL;
-		}
+		ret = verify_chunk(hdr, &vc, verify_type);
 
 		if (ret && verify_type != hdr->verify_type)
 			log_err("fio: verify type mismatch (%u media, %u given)\n",
@@ -1033,6 +1160,20 @@ static void fill_xxhash(struct verify_header *hdr, void *p, unsigned int len)
 	vh->hash = XXH32_digest(state);
 }
 
+static void fill_xxh3(struct verify_header *hdr, void *p, unsigned int len)
+{
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+
+	vh->hash = fio_xxh3_64(p, len);
+}
+
+static void fill_xxh128(struct verify_header *hdr, void *p, unsigned int len)
+{
+	struct vhdr_xxh128 *vh = hdr_priv(hdr);
+
+	fio_xxh3_128(p, len, vh->hash);
+}
+
 static void fill_sha3(struct fio_sha3_ctx *sha3_ctx, void *p, unsigned int len)
 {
 	fio_sha3_update(sha3_ctx, p, len);
@@ -1283,6 +1424,16 @@ static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 						io_u, hdr->len);
 		fill_sha1(hdr, data, data_len);
 		break;
+	case VERIFY_XXH3:
+		dprint(FD_VERIFY, "fill xxh3 io_u %p, len %u\n",
+						io_u, hdr->len);
+		fill_xxh3(hdr, data, data_len);
+		break;
+	case VERIFY_XXH128:
+		dprint(FD_VERIFY, "fill xxh128 io_u %p, len %u\n",
+						io_u, hdr->len);
+		fill_xxh128(hdr, data, data_len);
+		break;
 	case VERIFY_HDR_ONLY:
 	case VERIFY_PATTERN:
 	case VERIFY_PATTERN_NO_HDR:
@@ -1351,42 +1502,47 @@ int get_next_verify(struct thread_data *td, struct io_u *io_u)
 		td->io_hist_len--;
 
 		io_u->offset = ipo->offset;
-		io_u->verify_offset = ipo->offset;
+		io_u->verify_offset = ipo->verify_offset;
 		io_u->buflen = ipo->len;
 		io_u->numberio = ipo->numberio;
 		io_u->file = ipo->file;
-		io_u_set(td, io_u, IO_U_F_VER_LIST);
 
 		if (ipo->flags & IP_F_TRIMMED)
 			io_u_set(td, io_u, IO_U_F_TRIMMED);
+	} else if (!td->io_hist_len || !verify_map_next(td, io_u))
+		goto nothing;
 
-		if (!fio_file_open(io_u->file)) {
-			int r = td_io_open_file(td, io_u->file);
+	io_u_set(td, io_u, IO_U_F_VER_LIST);
 
-			if (r) {
-				dprint(FD_VERIFY, "failed file %s open\n",
-						io_u->file->file_name);
-				return 1;
-			}
+	if (!fio_file_open(io_u->file)) {
+		int r = td_io_open_file(td, io_u->file);
+
+		if (r) {
+			dprint(FD_VERIFY, "failed file %s open\n",
+					io_u->file->file_name);
+			return 1;
 		}
+	}
 
-		get_file(ipo->file);
-		assert(fio_file_open(io_u->file));
-		io_u->ddir = DDIR_READ;
-		io_u->xfer_buf = io_u->buf;
-		io_u->xfer_buflen = io_u->buflen;
+	get_file(io_u->file);
+	assert(fio_file_open(io_u->file));
+	io_u->ddir = DDIR_READ;
+	io_u->xfer_buf = io_u->buf;
+	io_u->xfer_buflen = io_u->buflen;
 
+	if (ipo) {
 		remove_trim_entry(td, ipo);
 		free(ipo);
-		dprint(FD_VERIFY, "get_next_verify: ret io_u %p\n", io_u);
+	}
+	dprint(FD_VERIFY, "get_next_verify: ret io_u %p\n", io_u);
 
-		if (!td->o.verify_pattern_bytes) {
-			io_u->rand_seed = __rand(&td->verify_state);
-			if (sizeof(int) != sizeof(long *))
-				io_u->rand_seed *= __rand(&td->verify_state);
-		}
-		return 0;
+	if (!td->o.verify_pattern_bytes &&
+	    !(io_u->flags & IO_U_F_VER_JOURNAL)) {
+		io_u->rand_seed = __rand(&td->verify_state);
+		if (sizeof(int) != sizeof(long *))
+			io_u->rand_seed *= __rand(&td->verify_state);
 	}
+	return 0;
 
 nothing:
 	dprint(FD_VERIFY, "get_next_verify: empty\n");
@@ -27,6 +27,8 @@ enum {
 	VERIFY_SHA3_512,		/* sha3-512 sum data blocks */
 	VERIFY_XXHASH,			/* xxhash sum data blocks */
 	VERIFY_SHA1,			/* sha1 sum data blocks */
+	VERIFY_XXH3,			/* xxh3 64-bit sum data blocks */
+	VERIFY_XXH128,			/* xxh3 128-bit sum data blocks */
 	VERIFY_PATTERN,			/* verify specific patterns */
 	VERIFY_PATTERN_NO_HDR,		/* verify specific patterns, no hdr */
 	VERIFY_NULL,			/* pretend to verify */
@@ -89,6 +91,12 @@ struct vhdr_crc7 {
 struct vhdr_xxhash {
 	uint32_t hash;
 };
+struct vhdr_xxh3 {
+	uint64_t hash;
+};
+struct vhdr_xxh128 {
+	uint64_t hash[2];
+};
 
 /*
  * Verify helpers
@@ -292,13 +292,15 @@ static int start_worker(struct workqueue *wq, unsigned int index,
 			return ret;
 	}
 
+	/*
+	 * Mark idle before the thread starts, so this can't clear the
+	 * running flag set by a worker that gets going first.
+	 */
+	sw->flags = SW_F_IDLE;
+
 	ret = pthread_create(&sw->thread, NULL, worker_thread, sw);
-	if (!ret) {
-		pthread_mutex_lock(&sw->lock);
-		sw->flags = SW_F_IDLE;
-		pthread_mutex_unlock(&sw->lock);
+	if (!ret)
 		return 0;
-	}
 
 	free_worker(sw, NULL);
 	return 1;
@@ -22,6 +22,7 @@
 #include "verify.h"
 #include "pshared.h"
 #include "zbd.h"
+#include "zbd_emu.h"
 
 static bool is_valid_offset(const struct fio_file *f, uint64_t offset)
 {
@@ -124,6 +125,26 @@ static void zone_lock(struct thread_data *td, const struct fio_file *f,
 			io_u_quiesce(td);
 		pthread_mutex_lock(&z->mutex);
 	}
+
+	/*
+	 * A reset or finish of the zone waits for the zone appends in flight
+	 * without the zone lock, see zbd_block_appends(). Stay out of the zone
+	 * until it is done, completing the appends of this job meanwhile.
+	 */
+	while (atomic_load_acquire(&z->nr_appends) & ZBD_APPENDS_BLOCKED) {
+		struct zoned_block_device_info *zbdi = f->zbd_info;
+
+		pthread_mutex_unlock(&z->mutex);
+		if (!td_ioengine_flagged(td, FIO_SYNCIO))
+			io_u_quiesce(td);
+
+		pthread_mutex_lock(&zbdi->appends_lock);
+		while (atomic_load_acquire(&z->nr_appends) & ZBD_APPENDS_BLOCKED)
+			pthread_cond_wait(&zbdi->appends_done, &zbdi->appends_lock);
+		pthread_mutex_unlock(&zbdi->appends_lock);
+
+		pthread_mutex_lock(&z->mutex);
+	}
 }
 
 static inline void zone_unlock(struct fio_zone_info *z)
@@ -164,6 +185,12 @@ static int zbd_get_zoned_model(struct thread_data *td, struct fio_file *f,
 		return -EINVAL;
 	}
 
+	/* Regular files with zone_emulation present a host-managed device. */
+	if (f->zbd_emu) {
+		*model = ZBD_HOST_MANAGED;
+		return 0;
+	}
+
 	/* If regular file, always emulate zones inside the file. */
 	if (f->filetype == FIO_TYPE_FILE) {
 		*model = ZBD_NONE;
@@ -204,7 +231,9 @@ static int zbd_report_zones(struct thread_data *td, struct fio_file *f,
 {
 	int ret;
 
-	if (td->io_ops && td->io_ops->report_zones)
+	if (f->zbd_emu)
+		ret = zbd_emu_report_zones(f, offset, zones, nr_zones);
+	else if (td->io_ops && td->io_ops->report_zones)
 		ret = td->io_ops->report_zones(td, f, offset, zones, nr_zones);
 	else
 		ret = blkzoned_report_zones(td, f, offset, zones, nr_zones);
@@ -237,7 +266,9 @@ static int zbd_reset_wp(struct thread_data *td, struct fio_file *f,
 {
 	int ret;
 
-	if (td->io_ops && td->io_ops->reset_wp)
+	if (f->zbd_emu)
+		ret = zbd_emu_reset_wp(f, offset, length);
+	else if (td->io_ops && td->io_ops->reset_wp)
 		ret = td->io_ops->reset_wp(td, f, offset, length);
 	else
 		ret = blkzoned_reset_wp(td, f, offset, length);
@@ -250,13 +281,141 @@ static int zbd_reset_wp(struct thread_data *td, struct fio_file *f,
 	return ret;
 }
 
+/**
+ * zbd_finish_wp - finish a range of zones
+ * @td: FIO thread data.
+ * @f: FIO file for which to finish zones
+ * @offset: Starting offset of the first zone to finish
+ * @length: Length of the range of zones to finish
+ *
+ * Returns 0 upon success and a negative error code upon failure.
+ */
+static int zbd_finish_wp(struct thread_data *td, struct fio_file *f,
+			 uint64_t offset, uint64_t length)
+{
+	int ret;
+
+	if (f->zbd_emu)
+		ret = zbd_emu_finish_zone(f, offset, length);
+	else if (td->io_ops && td->io_ops->finish_zone)
+		ret = td->io_ops->finish_zone(td, f, offset, length);
+	else
+		ret = blkzoned_finish_zone(td, f, offset, length);
+	if (ret < 0) {
+		td_verror(td, errno, "finish zone failed");
+		log_err("%s: finish zone at sector %"PRIu64" failed (%d).\n",
+			f->file_name, offset >> 9, errno);
+	}
+
+	return ret;
+}
+
+/*
+ * Whether zones are reset and finished with commands to the device, as
+ * opposed to zones that only exist in fio.
+ */
+static bool zbd_has_zone_mgmt(const struct fio_file *f)
+{
+	return f->zbd_info->model == ZBD_HOST_AWARE ||
+		f->zbd_info->model == ZBD_HOST_MANAGED;
+}
+
+/**
+ * zbd_block_appends - stop zone append writes to a zone and wait for those
+ *		       in flight
+ * @td: FIO thread data.
+ * @f: FIO file the zone belongs to.
+ * @z: Zone about to be reset or finished.
+ *
+ * Zone appends neither hold the zone lock while in flight nor take it to
+ * reserve room in a zone that is already a write target. Block new ones, then
+ * reap the I/Os of this job and wait for those of other jobs. z->mutex is
+ * dropped while waiting, zone_lock() keeps other writers out of the zone
+ * until zbd_unblock_appends().
+ *
+ * The caller must hold z->mutex and call zbd_unblock_appends() once the write
+ * pointer has been updated.
+ */
+static void zbd_block_appends(struct thread_data *td, struct fio_file *f,
+			      struct fio_zone_info *z)
+{
+	struct zoned_block_device_info *zbdi = f->zbd_info;
+
+	if (!atomic_add(&z->nr_appends, ZBD_APPENDS_BLOCKED))
+		return;
+
+	pthread_mutex_unlock(&z->mutex);
+	io_u_quiesce(td);
+
+	pthread_mutex_lock(&zbdi->appends_lock);
+	while (atomic_load_acquire(&z->nr_appends) != ZBD_APPENDS_BLOCKED)
+		pthread_cond_wait(&zbdi->appends_done, &zbdi->appends_lock);
+	pthread_mutex_unlock(&zbdi->appends_lock);
+
+	pthread_mutex_lock(&z->mutex);
+}
+
+/*
+ * Drop a zone append write from the count of those in flight to @z, and wake
+ * up a reset or finish of the zone waiting for it to be the last one.
+ */
+static void zbd_append_done(const struct fio_file *f, struct fio_zone_info *z)
+{
+	struct zoned_block_device_info *zbdi = f->zbd_info;
+
+	if (atomic_sub(&z->nr_appends, 1) != ZBD_APPENDS_BLOCKED + 1)
+		return;
+
+	pthread_mutex_lock(&zbdi->appends_lock);
+	pthread_cond_broadcast(&zbdi->appends_done);
+	pthread_mutex_unlock(&zbdi->appends_lock);
+}
+
+/*
+ * Let zone appends and the writers waiting in zone_lock() into @z again.
+ */
+static void zbd_unblock_appends(const struct fio_file *f,
+				struct fio_zone_info *z)
+{
+	struct zoned_block_device_info *zbdi = f->zbd_info;
+
+	atomic_sub(&z->nr_appends, ZBD_APPENDS_BLOCKED);
+
+	pthread_mutex_lock(&zbdi->appends_lock);
+	pthread_cond_broadcast(&zbdi->appends_done);
+	pthread_mutex_unlock(&zbdi->appends_lock);
+}
+
+/**
+ * zbd_zone_reset_done - update a zone after its write pointer was reset
+ * @td: FIO thread data.
+ * @f: FIO file the zone belongs to.
+ * @z: Zone that was reset.
+ *
+ * The caller must hold z->mutex.
+ */
+static void zbd_zone_reset_done(struct thread_data *td, struct fio_file *f,
+				struct fio_zone_info *z)
+{
+	if (accounting_vdb(td, f)) {
+		pthread_mutex_lock(&f->zbd_info->mutex);
+		f->zbd_info->wp_valid_data_bytes -= z->wp - z->start;
+		pthread_mutex_unlock(&f->zbd_info->mutex);
+	}
+
+	z->wp = z->start;
+
+	td->ts.nr_zone_resets++;
+}
+
 /**
  * __zbd_reset_zone - reset the write pointer of a single zone
  * @td: FIO thread data.
  * @f: FIO file associated with the disk for which to reset a write pointer.
  * @z: Zone to reset.
  *
- * Returns 0 upon success and a negative error code upon failure.
+ * The reset is issued synchronously, see zbd_zone_mgmt_io_u() for queueing
+ * it instead. Returns 0 upon success and a negative error code upon failure.
  *
  * The caller must hold z->mutex.
  */
@@ -265,10 +424,10 @@ static int __zbd_reset_zone(struct thread_data *td, struct fio_file *f,
 {
 	uint64_t offset = z->start;
 	uint64_t length = (z+1)->start - offset;
-	uint64_t data_in_zone = z->wp - z->start;
-	int ret = 0;
+	struct timespec start;
+	int ret;
 
-	if (!data_in_zone)
+	if (z->wp == z->start)
 		return 0;
 
 	assert(is_valid_offset(f, offset + length - 1));
@@ -276,28 +435,23 @@ static int __zbd_reset_zone(struct thread_data *td, struct fio_file *f,
 	dprint(FD_ZBD, "%s: resetting wp of zone %u.\n",
 	       f->file_name, zbd_zone_idx(f, z));
 
-	switch (f->zbd_info->model) {
-	case ZBD_HOST_AWARE:
-	case ZBD_HOST_MANAGED:
+	zbd_block_appends(td, f, z);
+
+	if (zbd_has_zone_mgmt(f)) {
+		fio_gettime(&start, NULL);
 		ret = zbd_reset_wp(td, f, offset, length);
-		if (ret < 0)
+		add_zone_mgmt_sample(&td->ts, FIO_ZONE_RESET,
+				     ntime_since_now(&start));
+		if (ret < 0) {
+			zbd_unblock_appends(f, z);
 			return ret;
-		break;
-	default:
-		break;
-	}
-
-	if (accounting_vdb(td, f)) {
-		pthread_mutex_lock(&f->zbd_info->mutex);
-		f->zbd_info->wp_valid_data_bytes -= data_in_zone;
-		pthread_mutex_unlock(&f->zbd_info->mutex);
+		}
 	}
 
-	z->wp = z->start;
+	zbd_zone_reset_done(td, f, z);
+	zbd_unblock_appends(f, z);
 
-	td->ts.nr_zone_resets++;
-
-	return ret;
+	return 0;
 }
 
 /**
@@ -311,27 +465,22 @@ static int __zbd_reset_zone(struct thread_data *td, struct fio_file *f,
 static void zbd_write_zone_put(struct thread_data *td, const struct fio_file *f,
 			       struct fio_zone_info *z)
 {
-	uint32_t zi;
+	struct zoned_block_device_info *zbdi = f->zbd_info;
+	uint32_t last;
 
 	if (!z->write)
 		return;
 
-	for (zi = 0; zi < f->zbd_info->num_write_zones; zi++) {
-		if (zbd_get_zone(f, f->zbd_info->write_zones[zi]) == z)
-			break;
-	}
-	if (zi == f->zbd_info->num_write_zones)
-		return;
+	assert(zbd_get_zone(f, zbdi->write_zones[z->write_idx]) == z);
 
 	dprint(FD_ZBD, "%s: removing zone %u from write zone array\n",
 	       f->file_name, zbd_zone_idx(f, z));
 
-	memmove(f->zbd_info->write_zones + zi,
-		f->zbd_info->write_zones + zi + 1,
-		(ZBD_MAX_WRITE_ZONES - (zi + 1)) *
-		sizeof(f->zbd_info->write_zones[0]));
+	/* The array is unordered, fill the hole with the last entry */
+	last = zbdi->write_zones[--zbdi->num_write_zones];
+	zbdi->write_zones[z->write_idx] = last;
+	zbd_get_zone(f, last)->write_idx = z->write_idx;
 
-	f->zbd_info->num_write_zones--;
 	td->num_write_zones--;
 	z->write = 0;
 }
@@ -368,38 +517,130 @@ static int zbd_reset_zone(struct thread_data *td, struct fio_file *f,
  * @f: FIO file for which to finish a zone
  * @z: Zone to finish.
  *
- * Finish the zone at @offset with open or close status.
+ * Finish the zone at @offset with open or close status. The command is issued
+ * synchronously, see zbd_zone_mgmt_io_u() for queueing it instead.
+ *
+ * The caller must hold z->mutex.
  */
 static int zbd_finish_zone(struct thread_data *td, struct fio_file *f,
 			   struct fio_zone_info *z)
 {
-	uint64_t offset = z->start;
-	uint64_t length = f->zbd_info->zone_size;
+	struct timespec start;
 	int ret = 0;
 
-	switch (f->zbd_info->model) {
-	case ZBD_HOST_AWARE:
-	case ZBD_HOST_MANAGED:
-		if (td->io_ops && td->io_ops->finish_zone)
-			ret = td->io_ops->finish_zone(td, f, offset, length);
-		else
-			ret = blkzoned_finish_zone(td, f, offset, length);
-		break;
-	default:
-		break;
-	}
+	zbd_block_appends(td, f, z);
 
-	if (ret < 0) {
-		td_verror(td, errno, "finish zone failed");
-		log_err("%s: finish zone at sector %"PRIu64" failed (%d).\n",
-			f->file_name, offset >> 9, errno);
-	} else {
-		z->wp = (z+1)->start;
+	if (zbd_has_zone_mgmt(f)) {
+		fio_gettime(&start, NULL);
+		ret = zbd_finish_wp(td, f, z->start, f->zbd_info->zone_size);
+		add_zone_mgmt_sample(&td->ts, FIO_ZONE_FINISH,
+				     ntime_since_now(&start));
 	}
+	if (!ret)
+		z->wp = zbd_zone_end(z);
+	zbd_unblock_appends(f, z);
 
 	return ret;
 }
 
+/**
+ * zbd_put_zone_mgmt - Unlock the zone of a zone management command
+ * @td: FIO thread data.
+ * @io_u: I/O unit of a zone reset or finish command.
+ *
+ * Releases a command that did not complete, the zone is left as it was.
+ */
+static void zbd_put_zone_mgmt(struct thread_data *td, const struct io_u *io_u)
+{
+	struct fio_zone_info *z = zbd_offset_to_zone(io_u->file, io_u->offset);
+
+	zbd_unblock_appends(io_u->file, z);
+	zone_unlock(z);
+}
+
+/**
+ * zbd_zone_mgmt_io_u - turn an I/O unit into a zone reset or finish command
+ * @td: FIO thread data.
+ * @io_u: I/O unit for the zoned file.
+ * @z: Zone to reset or finish.
+ * @ddir: DDIR_ZONE_RESET or DDIR_ZONE_FINISH.
+ *
+ * @io_u is the I/O unit get_io_u() handed to zbd_adjust_block(), and the
+ * command takes its place. It is queued like any other I/O, asynchronously if
+ * the ioengine has FIO_ZONE_MGMT. Until it completes, writes to the zone wait
+ * for it and zone appends are blocked, other zones are written meanwhile.
+ * Several commands are in flight at once if the job has the queue depth for
+ * it.
+ *
+ * The caller must hold z->mutex. It is handed over to @io_u and released by
+ * zbd_end_zone_mgmt() once the command completes.
+ */
+static void zbd_zone_mgmt_io_u(struct thread_data *td, struct io_u *io_u,
+			       struct fio_zone_info *z, enum fio_ddir ddir)
+{
+	assert(zbd_has_zone_mgmt(io_u->file));
+
+	dprint(FD_ZBD, "%s: queueing %s of zone %u\n", io_u->file->file_name,
+	       io_ddir_name(ddir), zbd_zone_idx(io_u->file, z));
+
+	zbd_block_appends(td, io_u->file, z);
+
+	io_u->ddir = ddir;
+	io_u->offset = z->start;
+	io_u->buflen = 0;
+	io_u->zbd_queue_io = NULL;
+	io_u->zbd_put_io = zbd_put_zone_mgmt;
+}
+
+/**
+ * zbd_end_zone_mgmt - complete a zone reset or finish command
+ * @td: FIO thread data.
+ * @io_u: I/O unit of the command.
+ *
+ * Update the zone if the command succeeded and unlock it.
+ */
+void zbd_end_zone_mgmt(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct fio_zone_info *z = zbd_offset_to_zone(f, io_u->offset);
+
+	dprint(FD_ZBD, "%s: %s of zone %u done (%d)\n", f->file_name,
+	       io_ddir_name(io_u->ddir), zbd_zone_idx(f, z), io_u->error);
+
+	if (!io_u->error) {
+		if (io_u->ddir == DDIR_ZONE_RESET)
+			zbd_zone_reset_done(td, f, z);
+		else
+			z->wp = zbd_zone_end(z);
+	}
+
+	zbd_put_zone_mgmt(td, io_u);
+	io_u->zbd_put_io = NULL;
+}
+
+/**
+ * zbd_do_io_u_zone_mgmt - issue a zone management command synchronously
+ * @td: FIO thread data.
+ * @io_u: I/O unit of a zone reset or finish command.
+ *
+ * Used for ioengines that cannot queue these commands. On error, sets
+ * io_u->error.
+ */
+void zbd_do_io_u_zone_mgmt(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct fio_zone_info *z = zbd_offset_to_zone(f, io_u->offset);
+	uint64_t length = zbd_zone_end(z) - z->start;
+	int ret;
+
+	if (io_u->ddir == DDIR_ZONE_RESET)
+		ret = zbd_reset_wp(td, f, z->start, length);
+	else
+		ret = zbd_finish_wp(td, f, z->start, length);
+	if (ret < 0)
+		io_u->error = errno ? errno : EIO;
+}
+
 /**
  * zbd_reset_zones - Reset a range of zones.
  * @td: fio thread data.
@@ -407,6 +648,9 @@ static int zbd_finish_zone(struct thread_data *td, struct fio_file *f,
  * @zb: first zone to reset.
  * @ze: first zone not to reset.
  *
+ * Zones reset with a command to the device are only marked here. The I/O
+ * units the job gets next carry the resets instead, see zbd_queue_reset().
+ *
  * Returns 0 upon success and 1 upon failure.
  */
 static int zbd_reset_zones(struct thread_data *td, struct fio_file *f,
@@ -432,16 +676,58 @@ static int zbd_reset_zones(struct thread_data *td, struct fio_file *f,
 		if (z->wp != z->start) {
 			dprint(FD_ZBD, "%s: resetting zone %u\n",
 			       f->file_name, zbd_zone_idx(f, z));
-			if (zbd_reset_zone(td, f, z) < 0)
+			if (zbd_has_zone_mgmt(f)) {
+				pthread_mutex_lock(&f->zbd_info->mutex);
+				zbd_write_zone_put(td, f, z);
+				pthread_mutex_unlock(&f->zbd_info->mutex);
+				z->reset_zone = 1;
+			} else if (zbd_reset_zone(td, f, z) < 0)
 				res = 1;
 		}
 
 		zone_unlock(z);
 	}
 
+	if (zbd_has_zone_mgmt(f)) {
+		f->zbd_reset_next = zbd_zone_idx(f, zb);
+		f->zbd_reset_end = zbd_zone_idx(f, ze);
+	}
+
 	return res;
 }
 
+/**
+ * zbd_queue_reset - issue a zone reset marked by zbd_reset_zones()
+ * @td: FIO thread data.
+ * @io_u: I/O unit handed to zbd_adjust_block().
+ *
+ * Returns true if @io_u was turned into the reset of a zone, false once no
+ * marked zone is left.
+ */
+static bool zbd_queue_reset(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct fio_zone_info *z;
+
+	while (f->zbd_reset_next < f->zbd_reset_end) {
+		z = zbd_get_zone(f, f->zbd_reset_next++);
+		if (!z->reset_zone)
+			continue;
+
+		zone_lock(td, f, z);
+		if (z->reset_zone) {
+			z->reset_zone = 0;
+			if (z->wp != z->start) {
+				zbd_zone_mgmt_io_u(td, io_u, z, DDIR_ZONE_RESET);
+				return true;
+			}
+		}
+		zone_unlock(z);
+	}
+
+	return false;
+}
+
 /**
  * zbd_get_max_open_zones - Get the maximum number of open zones
  * @td: FIO thread data
@@ -457,7 +743,10 @@ static int zbd_get_max_open_zones(struct thread_data *td, struct fio_file *f,
 {
 	int ret;
 
-	if (td->io_ops && td->io_ops->get_max_open_zones)
+	if (f->zbd_emu) {
+		*max_open_zones = f->zbd_emu->max_open_zones;
+		ret = 0;
+	} else if (td->io_ops && td->io_ops->get_max_open_zones)
 		ret = td->io_ops->get_max_open_zones(td, f, max_open_zones);
 	else
 		ret = blkzoned_get_max_open_zones(td, f, max_open_zones);
@@ -484,6 +773,9 @@ static unsigned int zbd_get_max_active_zones(struct thread_data *td,
 	unsigned int max_active_zones;
 	int ret;
 
+	if (f->zbd_emu)
+		return f->zbd_emu->max_active_zones;
+
 	if (td->io_ops && td->io_ops->get_max_active_zones)
 		ret = td->io_ops->get_max_active_zones(td, f,
 						       &max_active_zones);
@@ -558,6 +850,7 @@ static bool __zbd_write_zone_get(struct thread_data *td,
 	dprint(FD_ZBD, "%s: adding zone %u to write zone array\n",
 	       f->file_name, zone_idx);
 
+	z->write_idx = zbdi->num_write_zones;
 	zbdi->write_zones[zbdi->num_write_zones++] = zone_idx;
 	td->num_write_zones++;
 	z->write = 1;
@@ -614,6 +907,30 @@ static bool zbd_using_direct_io(void)
 	return true;
 }
 
+/*
+ * Whether another job writes to the zones of @f with zone_append set
+ * differently. Zone appends reserve room in a zone without taking the zone
+ * lock, which regular writes to the zone rely on.
+ */
+static bool zbd_mixed_appends(const struct thread_data *td,
+			      const struct fio_file *f)
+{
+	struct fio_file *f2;
+	int j;
+
+	for_each_td(td2) {
+		if (td2 == td || !td_write(td2) ||
+		    td2->o.zone_append == td->o.zone_append)
+			continue;
+		for_each_file(td2, f2, j) {
+			if (f2->zbd_info == f->zbd_info)
+				return true;
+		}
+	} end_for_each();
+
+	return false;
+}
+
 /* Whether or not the I/O range for f includes one or more sequential zones */
 static bool zbd_is_seq_job(const struct fio_file *f)
 {
@@ -823,6 +1140,8 @@ static int init_zone_info(struct thread_data *td, struct fio_file *f)
 		return -ENOMEM;
 
 	mutex_init_pshared(&zbd_info->mutex);
+	mutex_cond_init_pshared(&zbd_info->appends_lock,
+				&zbd_info->appends_done);
 	zbd_info->refcount = 1;
 	p = &zbd_info->zone_info[0];
 	for (i = 0; i < nr_zones; i++, p++) {
@@ -851,6 +1170,183 @@ static int init_zone_info(struct thread_data *td, struct fio_file *f)
  */
 #define ZBD_REPORT_MAX_ZONES	8192U
 
+/*
+ * Maximum number of threads reporting zones in parallel.
+ */
+#define ZBD_REPORT_MAX_THREADS	16U
+
+/*
+ * Copy @nrz reported zones into the zone array entries starting at @p.
+ */
+static void zbd_copy_zones(struct fio_zone_info *p, const struct zbd_zone *z,
+			   int nrz, uint64_t zone_size)
+{
+	int i;
+
+	for (i = 0; i < nrz; i++, z++, p++) {
+		mutex_init_pshared_with_type(&p->mutex,
+					     PTHREAD_MUTEX_RECURSIVE);
+		p->start = z->start;
+		p->capacity = z->capacity;
+
+		switch (z->cond) {
+		case ZBD_ZONE_COND_NOT_WP:
+		case ZBD_ZONE_COND_FULL:
+			p->wp = p->start + p->capacity;
+			break;
+		default:
+			assert(z->start <= z->wp);
+			assert(z->wp <= z->start + zone_size);
+			p->wp = z->wp;
+			break;
+		}
+
+		switch (z->type) {
+		case ZBD_ZONE_TYPE_SWR:
+			p->has_wp = 1;
+			break;
+		default:
+			p->has_wp = 0;
+		}
+		p->type = z->type;
+		p->cond = z->cond;
+	}
+}
+
+/**
+ * struct zbd_report_range - a range of zones reported by one thread
+ * @td: FIO thread data.
+ * @f: FIO file for which to report zones.
+ * @zbd_info: zone array to fill in.
+ * @zone_size: size of a single zone in bytes.
+ * @zb: first zone to report.
+ * @ze: first zone not to report.
+ * @end: end of the last zone reported.
+ * @thread: thread reporting the range.
+ * @threaded: whether @thread was started.
+ * @ret: 0 upon success and a negative error code upon failure.
+ */
+struct zbd_report_range {
+	struct thread_data		*td;
+	struct fio_file			*f;
+	struct zoned_block_device_info	*zbd_info;
+	uint64_t			zone_size;
+	uint32_t			zb;
+	uint32_t			ze;
+	uint64_t			end;
+	pthread_t			thread;
+	bool				threaded;
+	int				ret;
+};
+
+static int zbd_report_range(struct zbd_report_range *r)
+{
+	struct zbd_zone *zones;
+	uint64_t offset = r->zb * r->zone_size;
+	uint32_t j;
+	int nrz = 0;
+
+	zones = calloc(ZBD_REPORT_MAX_ZONES, sizeof(struct zbd_zone));
+	if (!zones)
+		return -ENOMEM;
+
+	for (j = r->zb; j < r->ze; j += nrz) {
+		nrz = zbd_report_zones(r->td, r->f, offset, zones,
+				       min(r->ze - j, ZBD_REPORT_MAX_ZONES));
+		if (nrz < 0) {
+			log_info("fio: report zones (offset %"PRIu64") failed for %s (%d).\n",
+				 offset, r->f->file_name, -nrz);
+			break;
+		}
+		/* The range is not done, no zones reported means a bad device */
+		if (nrz == 0) {
+			log_info("fio: report zones (offset %"PRIu64") returned no zones for %s.\n",
+				 offset, r->f->file_name);
+			nrz = -EIO;
+			break;
+		}
+		nrz = min((uint32_t)nrz, r->ze - j);
+		zbd_copy_zones(&r->zbd_info->zone_info[j], zones, nrz,
+			       r->zone_size);
+		offset = zones[nrz - 1].start + zones[nrz - 1].len;
+	}
+	r->end = offset;
+
+	free(zones);
+	return nrz < 0 ? nrz : 0;
+}
+
+static void *zbd_report_thread(void *data)
+{
+	struct zbd_report_range *r = data;
+
+	r->ret = zbd_report_range(r);
+	return NULL;
+}
+
+/*
+ * Report the zones @zb..@ze-1 into f->zbd_info. Large devices are split into
+ * ranges reported in parallel, unless the zone report goes through the I/O
+ * engine which may not expect concurrent calls.
+ *
+ * Returns 0 and the end of the last zone in @end upon success and a negative
+ * error code upon failure.
+ */
+static int zbd_report_all_zones(struct thread_data *td, struct fio_file *f,
+				struct zoned_block_device_info *zbd_info,
+				uint64_t zone_size, uint32_t zb, uint32_t ze,
+				uint64_t *end)
+{
+	struct zbd_report_range *ranges;
+	uint32_t nr_threads, per_thread, i;
+	int ret = 0;
+
+	nr_threads = (ze - zb + ZBD_REPORT_MAX_ZONES - 1) / ZBD_REPORT_MAX_ZONES;
+	nr_threads = min(nr_threads, ZBD_REPORT_MAX_THREADS);
+	nr_threads = min(nr_threads, cpus_configured());
+	if ((td->io_ops && td->io_ops->report_zones && !f->zbd_emu) ||
+	    !nr_threads)
+		nr_threads = 1;
+	per_thread = (ze - zb + nr_threads - 1) / nr_threads;
+
+	ranges = calloc(nr_threads, sizeof(*ranges));
+	if (!ranges)
+		return -ENOMEM;
+
+	dprint(FD_ZBD, "%s: reporting zones %u .. %u with %u threads\n",
+	       f->file_name, zb, ze, nr_threads);
+
+	for (i = 0; i < nr_threads; i++) {
+		struct zbd_report_range *r = &ranges[i];
+
+		r->td = td;
+		r->f = f;
+		r->zbd_info = zbd_info;
+		r->zone_size = zone_size;
+		r->zb = min(zb + i * per_thread, ze);
+		r->ze = min(r->zb + per_thread, ze);
+		/* The first range is reported by the calling thread */
+		if (!i)
+			continue;
+		if (!pthread_create(&r->thread, NULL, zbd_report_thread, r))
+			r->threaded = true;
+		else
+			r->ret = zbd_report_range(r);
+	}
+	ranges[0].ret = zbd_report_range(&ranges[0]);
+
+	for (i = 0; i < nr_threads; i++) {
+		if (ranges[i].threaded)
+			pthread_join(ranges[i].thread, NULL);
+		if (ranges[i].ret && !ret)
+			ret = ranges[i].ret;
+	}
+	*end = ranges[nr_threads - 1].end;
+
+	free(ranges);
+	return ret;
+}
+
 /*
  * Parse the device zone report and store it in f->zbd_info. Must be called
  * only for devices that are zoned, namely those with a model != ZBD_NONE.
@@ -858,12 +1354,12 @@ static int init_zone_info(struct thread_data *td, struct fio_file *f)
 static int parse_zone_info(struct thread_data *td, struct fio_file *f)
 {
 	int nr_zones, nrz;
-	struct zbd_zone *zones, *z;
+	struct zbd_zone *zones;
 	struct fio_zone_info *p;
 	uint64_t zone_size, offset, capacity;
 	bool same_zone_cap = true;
 	struct zoned_block_device_info *zbd_info = NULL;
-	int i, j, ret = -ENOMEM;
+	int j, ret = -ENOMEM;
 
 	zones = calloc(ZBD_REPORT_MAX_ZONES, sizeof(struct zbd_zone));
 	if (!zones)
@@ -876,6 +1372,12 @@ static int parse_zone_info(struct thread_data *td, struct fio_file *f)
 			 f->file_name, -ret);
 		goto out;
 	}
+	if (nrz == 0) {
+		ret = -EIO;
+		log_info("fio: report zones (offset 0) returned no zones for %s.\n",
+			 f->file_name);
+		goto out;
+	}
 
 	zone_size = zones[0].len;
 	capacity = zones[0].capacity;
@@ -898,60 +1400,30 @@ static int parse_zone_info(struct thread_data *td, struct fio_file *f)
 	if (!zbd_info)
 		goto out;
 	mutex_init_pshared(&zbd_info->mutex);
+	mutex_cond_init_pshared(&zbd_info->appends_lock,
+				&zbd_info->appends_done);
 	zbd_info->refcount = 1;
-	p = &zbd_info->zone_info[0];
-	for (offset = 0, j = 0; j < nr_zones;) {
-		z = &zones[0];
-		for (i = 0; i < nrz; i++, j++, z++, p++) {
-			mutex_init_pshared_with_type(&p->mutex,
-						     PTHREAD_MUTEX_RECURSIVE);
-			p->start = z->start;
-			p->capacity = z->capacity;
-			if (capacity != z->capacity)
-				same_zone_cap = false;
-
-			switch (z->cond) {
-			case ZBD_ZONE_COND_NOT_WP:
-			case ZBD_ZONE_COND_FULL:
-				p->wp = p->start + p->capacity;
-				break;
-			default:
-				assert(z->start <= z->wp);
-				assert(z->wp <= z->start + zone_size);
-				p->wp = z->wp;
-				break;
-			}
 
-			switch (z->type) {
-			case ZBD_ZONE_TYPE_SWR:
-				p->has_wp = 1;
-				break;
-			default:
-				p->has_wp = 0;
-			}
-			p->type = z->type;
-			p->cond = z->cond;
-
-			if (j > 0 && p->start != p[-1].start + zone_size) {
-				log_info("%s: invalid zone data [%d:%d]: %"PRIu64" + %"PRIu64" != %"PRIu64"\n",
-					 f->file_name, j, i,
-					 p[-1].start, zone_size, p->start);
-				ret = -EINVAL;
-				goto out;
-			}
-		}
-		z--;
-		offset = z->start + z->len;
-		if (j >= nr_zones)
-			break;
+	nrz = min(nrz, nr_zones);
+	zbd_copy_zones(&zbd_info->zone_info[0], zones, nrz, zone_size);
+	offset = zones[nrz - 1].start + zones[nrz - 1].len;
+	if (nrz < nr_zones) {
+		ret = zbd_report_all_zones(td, f, zbd_info, zone_size, nrz,
+					   nr_zones, &offset);
+		if (ret)
+			goto out;
+	}
 
-		nrz = zbd_report_zones(td, f, offset, zones,
-				       min((uint32_t)(nr_zones - j),
-					   ZBD_REPORT_MAX_ZONES));
-		if (nrz < 0) {
-			ret = nrz;
-			log_info("fio: report zones (offset %"PRIu64") failed for %s (%d).\n",
-				 offset, f->file_name, -ret);
+	p = &zbd_info->zone_info[0];
+	for (j = 0; j < nr_zones; j++, p++) {
+		if (capacity != p->capacity)
+			same_zone_cap = false;
+
+		if (j > 0 && p->start != p[-1].start + zone_size) {
+			log_info("%s: invalid zone data [%d]: %"PRIu64" + %"PRIu64" != %"PRIu64"\n",
+				 f->file_name, j,
+				 p[-1].start, zone_size, p->start);
+			ret = -EINVAL;
 			goto out;
 		}
 	}
@@ -1041,16 +1513,22 @@ static int zbd_create_zone_info(struct thread_data *td, struct fio_file *f)
 
 	assert(td->o.zone_mode == ZONE_MODE_ZBD);
 
+	if (td->o.zone_emu && f->filetype == FIO_TYPE_FILE) {
+		ret = zbd_emu_init(td, f);
+		if (ret)
+			return ret;
+	}
+
 	ret = zbd_get_zoned_model(td, f, &zbd_model);
 	if (ret)
-		return ret;
+		goto free_emu;
 
 	switch (zbd_model) {
 	case ZBD_HOST_AWARE:
 	case ZBD_HOST_MANAGED:
 		ret = parse_zone_info(td, f);
 		if (ret)
-			return ret;
+			goto free_emu;
 		break;
 	case ZBD_NONE:
 		ret = init_zone_info(td, f);
@@ -1073,6 +1551,13 @@ static int zbd_create_zone_info(struct thread_data *td, struct fio_file *f)
 	}
 
 	return 0;
+
+free_emu:
+	if (f->zbd_emu) {
+		zbd_emu_free(f->zbd_emu);
+		f->zbd_emu = NULL;
+	}
+	return ret;
 }
 
 void zbd_free_zone_info(struct fio_file *f)
@@ -1086,9 +1571,13 @@ void zbd_free_zone_info(struct fio_file *f)
 	pthread_mutex_unlock(&f->zbd_info->mutex);
 
 	assert((int32_t)refcount >= 0);
-	if (refcount == 0)
+	if (refcount == 0) {
+		if (f->zbd_emu)
+			zbd_emu_free(f->zbd_emu);
 		sfree(f->zbd_info);
+	}
 	f->zbd_info = NULL;
+	f->zbd_emu = NULL;
 }
 
 /*
@@ -1113,6 +1602,7 @@ static int zbd_init_zone_info(struct thread_data *td, struct fio_file *file)
 				continue;
 			file->zbd_info = f2->zbd_info;
 			file->zbd_info->refcount++;
+			file->zbd_emu = f2->zbd_emu;
 			return 0;
 		}
 	} end_for_each();
@@ -1244,6 +1734,21 @@ int zbd_setup_files(struct thread_data *td)
 		f->max_zone =
 			zbd_offset_to_zone_idx(f, f->file_offset + f->io_size);
 
+		if (td->o.zone_append && td_write(td) && !f->zbd_emu &&
+		    ((zbd->model != ZBD_HOST_MANAGED &&
+		      zbd->model != ZBD_HOST_AWARE) ||
+		     !td_ioengine_flagged(td, FIO_ZONE_APPEND))) {
+			log_err("%s: zone_append is not supported by ioengine %s on this device\n",
+				f->file_name, td->io_ops->name);
+			return 1;
+		}
+
+		if (td_write(td) && zbd_mixed_appends(td, f)) {
+			log_err("%s: jobs with and without zone_append cannot write to the same zoned device\n",
+				f->file_name);
+			return 1;
+		}
+
 		vdb = zbd_verify_and_set_vdb(td, f);
 
 		dprint(FD_ZBD, "%s(%s): valid data bytes = %" PRIu64 "\n",
@@ -1685,6 +2190,35 @@ static void zbd_end_zone_io(struct thread_data *td, const struct io_u *io_u,
 	}
 }
 
+/**
+ * zbd_advance_wp - move the write pointer of a zone past a write
+ * @io_u: I/O unit
+ * @z: zone info pointer
+ *
+ * The caller must hold z->mutex.
+ */
+static void zbd_advance_wp(struct thread_data *td, const struct io_u *io_u,
+			   struct fio_zone_info *z)
+{
+	const struct fio_file *f = io_u->file;
+	struct zoned_block_device_info *zbd_info = f->zbd_info;
+	uint64_t zone_end;
+
+	zone_end = min((uint64_t)(io_u->offset + io_u->buflen),
+		       zbd_zone_capacity_end(z));
+
+	/*
+	 * z->wp > zone_end means that one or more I/O errors
+	 * have occurred.
+	 */
+	if (accounting_vdb(td, f) && z->wp <= zone_end) {
+		pthread_mutex_lock(&zbd_info->mutex);
+		zbd_info->wp_valid_data_bytes += zone_end - z->wp;
+		pthread_mutex_unlock(&zbd_info->mutex);
+	}
+	z->wp = zone_end;
+}
+
 /**
  * zbd_queue_io - update the write pointer of a sequential zone
  * @io_u: I/O unit
@@ -1700,7 +2234,6 @@ static void zbd_queue_io(struct thread_data *td, struct io_u *io_u, int q,
 	const struct fio_file *f = io_u->file;
 	struct zoned_block_device_info *zbd_info = f->zbd_info;
 	struct fio_zone_info *z;
-	uint64_t zone_end;
 
 	assert(zbd_info);
 
@@ -1716,19 +2249,7 @@ static void zbd_queue_io(struct thread_data *td, struct io_u *io_u, int q,
 
 	switch (io_u->ddir) {
 	case DDIR_WRITE:
-		zone_end = min((uint64_t)(io_u->offset + io_u->buflen),
-			       zbd_zone_capacity_end(z));
-
-		/*
-		 * z->wp > zone_end means that one or more I/O errors
-		 * have occurred.
-		 */
-		if (accounting_vdb(td, f) && z->wp <= zone_end) {
-			pthread_mutex_lock(&zbd_info->mutex);
-			zbd_info->wp_valid_data_bytes += zone_end - z->wp;
-			pthread_mutex_unlock(&zbd_info->mutex);
-		}
-		z->wp = zone_end;
+		zbd_advance_wp(td, io_u, z);
 		break;
 	default:
 		break;
@@ -1768,6 +2289,153 @@ static void zbd_put_io(struct thread_data *td, const struct io_u *io_u)
 	zone_unlock(z);
 }
 
+/**
+ * zbd_put_append - Account for the completion of a zone append write
+ * @io_u: I/O unit
+ */
+static void zbd_put_append(struct thread_data *td, const struct io_u *io_u)
+{
+	struct fio_zone_info *z = zbd_offset_to_zone(io_u->file, io_u->offset);
+
+	dprint(FD_ZBD,
+	       "%s: terminate append (%lld, %llu) for zone %u\n",
+	       io_u->file->file_name, io_u->offset, io_u->buflen,
+	       zbd_zone_idx(io_u->file, z));
+
+	zbd_append_done(io_u->file, z);
+}
+
+/**
+ * zbd_reserve_append - reserve room for a zone append write
+ * @z: zone info pointer
+ * @io_u: I/O unit
+ *
+ * The device picks the location of zone appends within the target zone, so
+ * writes to the same zone need not be serialized. Advance the write pointer
+ * right away to reserve room for the write and point @io_u at the reserved
+ * room. Zone appends update the write pointer with compare-and-swap only, a
+ * reservation does not need z->mutex.
+ *
+ * Returns false if the zone does not have room for @io_u.
+ */
+static bool zbd_reserve_append(struct fio_zone_info *z, struct io_u *io_u)
+{
+	const uint64_t end = zbd_zone_capacity_end(z);
+	uint64_t wp;
+
+	do {
+		wp = atomic_load_relaxed(&z->wp);
+		if (wp + io_u->buflen > end)
+			return false;
+	} while (!__sync_bool_compare_and_swap(&z->wp, wp, wp + io_u->buflen));
+
+	io_u->offset = wp;
+	return true;
+}
+
+static void zbd_start_append(struct thread_data *td, struct io_u *io_u,
+			     struct fio_zone_info *z)
+{
+	dprint(FD_ZBD, "%s: append (%lld, %llu) to zone %u\n",
+	       io_u->file->file_name, io_u->offset, io_u->buflen,
+	       zbd_zone_idx(io_u->file, z));
+
+	io_u_set(td, io_u, IO_U_F_ZONE_APPEND);
+	zbd_end_zone_io(td, io_u, z);
+	io_u->zbd_put_io = zbd_put_append;
+}
+
+/**
+ * zbd_queue_append - reserve room in a zone for a zone append write
+ * @io_u: I/O unit
+ * @z: zone info pointer
+ *
+ * Returns false with z->mutex still held if zone appends that did not take
+ * the lock have used up the room zbd_adjust_block() found. Otherwise drop the
+ * zone lock before the write is issued.
+ *
+ * The caller must hold z->mutex.
+ */
+static bool zbd_queue_append(struct thread_data *td, struct io_u *io_u,
+			     struct fio_zone_info *z)
+{
+	struct zoned_block_device_info *zbdi = io_u->file->zbd_info;
+
+	if (!zbd_reserve_append(z, io_u))
+		return false;
+
+	if (accounting_vdb(td, io_u->file)) {
+		pthread_mutex_lock(&zbdi->mutex);
+		zbdi->wp_valid_data_bytes += io_u->buflen;
+		pthread_mutex_unlock(&zbdi->mutex);
+	}
+
+	atomic_add(&z->nr_appends, 1);
+	zbd_start_append(td, io_u, z);
+	zone_unlock(z);
+	return true;
+}
+
+/**
+ * zbd_fast_append - reserve room for a zone append write without locking
+ * @io_u: I/O unit
+ * @z: zone info pointer
+ *
+ * Handle the common case of a zone append write to a zone that is a write
+ * target already and has room left, without taking any lock. A write to a
+ * zone that is not a write target is redirected to one of the write target
+ * zones, as zbd_convert_to_write_zone() would do.
+ *
+ * Returns false if the write has to go through the locked path instead.
+ */
+static bool zbd_fast_append(struct thread_data *td, struct io_u *io_u,
+			    struct fio_zone_info *z)
+{
+	const struct fio_file *f = io_u->file;
+	struct zoned_block_device_info *zbdi = f->zbd_info;
+	uint32_t zone_idx;
+
+	/* Zone reset triggers and valid data accounting need z->mutex */
+	if (td->o.zrf.u.f || accounting_vdb(td, f))
+		return false;
+
+	if (zbdi->max_write_zones && !z->write) {
+		/*
+		 * This statement accesses zbdi->write_zones[] on purpose
+		 * without locking.
+		 */
+		zone_idx = zbdi->write_zones[pick_random_zone_idx(f, io_u)];
+		if (zone_idx < f->min_zone || zone_idx >= f->max_zone)
+			return false;
+		z = zbd_get_zone(f, zone_idx);
+		if (!z->write)
+			return false;
+	}
+
+	if (!z->has_wp || z->cond == ZBD_ZONE_COND_OFFLINE || z->reset_zone)
+		return false;
+
+	/*
+	 * Resets and finishes block appends before moving the write pointer.
+	 * The zone may also have stopped being a write target or have been
+	 * marked for a reset since it was checked above.
+	 */
+	if (atomic_add(&z->nr_appends, 1) & ZBD_APPENDS_BLOCKED)
+		goto fail;
+	read_barrier();
+	if ((zbdi->max_write_zones && !z->write) || z->reset_zone)
+		goto fail;
+	if (!zbd_reserve_append(z, io_u))
+		goto fail;
+
+	zbd_start_append(td, io_u, z);
+	return true;
+
+fail:
+	zbd_append_done(f, z);
+	return false;
+}
+
 /*
  * Windows and MacOS do not define this.
  */
@@ -1913,6 +2581,10 @@ enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 	assert(is_valid_offset(f, io_u->offset));
 	assert(io_u->buflen);
 
+	/* Resets marked at job start go out first, in place of this I/O */
+	if (f->zbd_reset_next < f->zbd_reset_end && zbd_queue_reset(td, io_u))
+		return io_u_accept;
+
 	zb = zbd_offset_to_zone(f, io_u->offset);
 	orig_zb = zb;
 
@@ -1955,6 +2627,10 @@ enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 	    io_u->ddir == DDIR_READ && td->o.read_beyond_wp)
 		return io_u_accept;
 
+	if (io_u->ddir == DDIR_WRITE && td->o.zone_append &&
+	    zbd_fast_append(td, io_u, zb))
+		return io_u_accept;
+
 	zone_lock(td, f, zb);
 
 	switch (io_u->ddir) {
@@ -2045,7 +2721,16 @@ retry:
 			dprint(FD_ZBD,
 			       "%s: finish zone %d\n",
 			       f->file_name, zbd_zone_idx(f, zb));
-			io_u_quiesce(td);
+			if (zbd_has_zone_mgmt(f)) {
+				/*
+				 * Finish the zone in place of this write, a
+				 * sequential job goes on in the next zone.
+				 */
+				zbd_zone_mgmt_io_u(td, io_u, zb, DDIR_ZONE_FINISH);
+				if (!td_random(td))
+					f->last_pos[DDIR_WRITE] = zbd_zone_end(zb);
+				return io_u_accept;
+			}
 			zbd_finish_zone(td, f, zb);
 			if (zbd_zone_idx(f, zb) + 1 >= f->max_zone) {
 				if (!td_random(td))
@@ -2101,14 +2786,15 @@ retry:
 			}
 
 			/*
-			 * Since previous write requests may have been submitted
-			 * asynchronously and since we will submit the zone
-			 * reset synchronously, wait until previously submitted
-			 * write requests have completed before issuing a
-			 * zone reset.
+			 * Writes to the zone are done, they held the zone
+			 * lock while in flight. Issue the reset in place of
+			 * this write, the next write to the zone waits for it.
 			 */
-			io_u_quiesce(td);
 			zb->reset_zone = 0;
+			if (zb->wp != zb->start && zbd_has_zone_mgmt(f)) {
+				zbd_zone_mgmt_io_u(td, io_u, zb, DDIR_ZONE_RESET);
+				return io_u_accept;
+			}
 			if (__zbd_reset_zone(td, f, zb) < 0)
 				goto eof;
 
@@ -2176,6 +2862,8 @@ retry:
 	case DDIR_DATASYNC:
 	case DDIR_SYNC_FILE_RANGE:
 	case DDIR_WAIT:
+	case DDIR_ZONE_RESET:
+	case DDIR_ZONE_FINISH:
 	case DDIR_LAST:
 	case DDIR_INVAL:
 	case DDIR_TIMEOUT:
@@ -2190,6 +2878,12 @@ accept:
 	assert(!io_u->zbd_queue_io);
 	assert(!io_u->zbd_put_io);
 
+	if (io_u->ddir == DDIR_WRITE && td->o.zone_append) {
+		if (!zbd_queue_append(td, io_u, zb))
+			goto retry;
+		return io_u_accept;
+	}
+
 	io_u->zbd_queue_io = zbd_queue_io;
 	io_u->zbd_put_io = zbd_put_io;
 
@@ -2209,6 +2903,18 @@ eof:
 	return io_u_eof;
 }
 
+/**
+ * zbd_zone_start - Return the start of the zone containing an offset
+ * @f: FIO file.
+ * @offset: offset in bytes.
+ *
+ * Used by I/O engines to address zone append commands.
+ */
+uint64_t zbd_zone_start(const struct fio_file *f, uint64_t offset)
+{
+	return zbd_offset_to_zone(f, offset)->start;
+}
+
 /* Return a string with ZBD statistics */
 char *zbd_write_status(const struct thread_stat *ts)
 {
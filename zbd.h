@@ -32,6 +32,11 @@ enum io_u_action {
  * @write: whether or not this zone is the write target at this moment. Only
  *              relevant if zbd->max_open_zones > 0.
  * @reset_zone: whether or not this zone should be reset before writing to it
+ * @write_idx: index of this zone in the write_zones array if @write is set
+ * @nr_appends: number of zone append writes in flight to this zone. These do
+ *		not hold @mutex while in flight. ZBD_APPENDS_BLOCKED is set
+ *		while the zone is reset or finished, and keeps other writers
+ *		out while that waits for appends without @mutex.
  */
 struct fio_zone_info {
 	pthread_mutex_t		mutex;
@@ -43,8 +48,12 @@ struct fio_zone_info {
 	unsigned int		has_wp:1;
 	unsigned int		write:1;
 	unsigned int		reset_zone:1;
+	uint32_t		write_idx;
+	uint32_t		nr_appends;
 };
 
+#define ZBD_APPENDS_BLOCKED	(1U << 31)
+
 /**
  * zoned_block_device_info - zoned block device characteristics
  * @model: Device model.
@@ -57,6 +66,10 @@ struct fio_zone_info {
  *	zones in the conditions.
  * @mutex: Protects the modifiable members in this structure (refcount and
  *		num_open_zones).
+ * @appends_lock: protects waiting on @appends_done.
+ * @appends_done: signaled when the last zone append write in flight to a zone
+ *		whose appends are blocked completes, and when they are
+ *		unblocked again.
  * @zone_size: size of a single zone in bytes.
  * @wp_valid_data_bytes: total size of data in zones with write pointers
  * @write_min_zone: Minimum zone index of all job's write ranges. Inclusive.
@@ -80,6 +93,8 @@ struct zoned_block_device_info {
 	uint32_t		max_write_zones;
 	uint32_t		max_active_zones;
 	pthread_mutex_t		mutex;
+	pthread_mutex_t		appends_lock;
+	pthread_cond_t		appends_done;
 	uint64_t		zone_size;
 	uint64_t		wp_valid_data_bytes;
 	uint32_t		write_min_zone;
@@ -105,7 +120,10 @@ enum fio_ddir zbd_adjust_ddir(struct thread_data *td, struct io_u *io_u,
 enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u);
 char *zbd_write_status(const struct thread_stat *ts);
 int zbd_do_io_u_trim(struct thread_data *td, struct io_u *io_u);
+void zbd_do_io_u_zone_mgmt(struct thread_data *td, struct io_u *io_u);
+void zbd_end_zone_mgmt(struct thread_data *td, struct io_u *io_u);
 void zbd_log_err(const struct thread_data *td, const struct io_u *io_u);
+uint64_t zbd_zone_start(const struct fio_file *f, uint64_t offset);
 
 static inline void zbd_close_file(struct fio_file *f)
 {
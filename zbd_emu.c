@@ -0,0 +1,402 @@
+/*
+ * Host-managed zoned block device emulation on top of regular files.
+ *
+ * The emulated device keeps the zone state that a real host-managed device
+ * keeps in its firmware: a write pointer and a condition per zone, plus the
+ * number of open and closed zones. Writes that do not start at the write
+ * pointer of their zone, that cross the zone capacity or that would exceed
+ * the active zone limit are failed the same way a real device fails them.
+ *
+ * This file is released under the GPL.
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "fio.h"
+#include "file.h"
+#include "lib/pow2.h"
+#include "log.h"
+#include "pshared.h"
+#include "smalloc.h"
+#include "zbd_emu.h"
+
+/*
+ * Error codes the Linux block layer uses for zone resource errors. Fall back
+ * to EIO where these are not defined.
+ */
+#ifndef ETOOMANYREFS
+#define ETOOMANYREFS	EIO
+#endif
+#ifndef EOVERFLOW
+#define EOVERFLOW	EIO
+#endif
+
+static inline uint32_t zbd_emu_zone_idx(const struct zbd_emu *emu,
+					uint64_t offset)
+{
+	if (emu->zone_size_log2)
+		return offset >> emu->zone_size_log2;
+
+	return offset / emu->zone_size;
+}
+
+static inline bool zbd_emu_zone_is_open(const struct zbd_emu_zone *z)
+{
+	return z->cond == ZBD_ZONE_COND_IMP_OPEN ||
+		z->cond == ZBD_ZONE_COND_EXP_OPEN;
+}
+
+/*
+ * Drop the open or closed accounting of a zone that is about to change to
+ * the empty or full condition. The caller must hold emu->mutex.
+ */
+static void zbd_emu_zone_deactivate(struct zbd_emu *emu,
+				    struct zbd_emu_zone *z)
+{
+	if (zbd_emu_zone_is_open(z))
+		emu->nr_open--;
+	else if (z->cond == ZBD_ZONE_COND_CLOSED)
+		emu->nr_closed--;
+}
+
+/*
+ * Implicitly close an implicitly open zone to make room for opening another
+ * one, as ZNS and ZBC devices do. The caller must hold emu->mutex.
+ */
+static bool zbd_emu_close_one(struct zbd_emu *emu)
+{
+	uint32_t i, zi = emu->close_cursor;
+
+	for (i = 0; i < emu->nr_zones; i++, zi++) {
+		struct zbd_emu_zone *z;
+
+		if (zi >= emu->nr_zones)
+			zi = 0;
+		z = &emu->zones[zi];
+		if (z->cond != ZBD_ZONE_COND_IMP_OPEN)
+			continue;
+
+		z->cond = z->wp == z->start ? ZBD_ZONE_COND_EMPTY :
+			ZBD_ZONE_COND_CLOSED;
+		emu->nr_open--;
+		if (z->cond == ZBD_ZONE_COND_CLOSED)
+			emu->nr_closed++;
+		emu->close_cursor = zi + 1;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Implicitly open a zone for writing. Only taken when the first write to an
+ * empty or closed zone is issued, the write pointer check itself is lockless.
+ */
+static int zbd_emu_open_zone(struct zbd_emu *emu, struct zbd_emu_zone *z)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&emu->mutex);
+
+	switch (z->cond) {
+	case ZBD_ZONE_COND_IMP_OPEN:
+	case ZBD_ZONE_COND_EXP_OPEN:
+		goto out;
+	case ZBD_ZONE_COND_EMPTY:
+		if (emu->max_active_zones &&
+		    emu->nr_open + emu->nr_closed >= emu->max_active_zones) {
+			ret = -EOVERFLOW;
+			goto out;
+		}
+		break;
+	case ZBD_ZONE_COND_CLOSED:
+		break;
+	default:
+		ret = -EIO;
+		goto out;
+	}
+
+	if (emu->max_open_zones && emu->nr_open >= emu->max_open_zones &&
+	    !zbd_emu_close_one(emu)) {
+		ret = -ETOOMANYREFS;
+		goto out;
+	}
+
+	if (z->cond == ZBD_ZONE_COND_CLOSED)
+		emu->nr_closed--;
+	z->cond = ZBD_ZONE_COND_IMP_OPEN;
+	emu->nr_open++;
+
+out:
+	pthread_mutex_unlock(&emu->mutex);
+	return ret;
+}
+
+static void zbd_emu_zone_full(struct zbd_emu *emu, struct zbd_emu_zone *z)
+{
+	pthread_mutex_lock(&emu->mutex);
+	zbd_emu_zone_deactivate(emu, z);
+	z->cond = ZBD_ZONE_COND_FULL;
+	pthread_mutex_unlock(&emu->mutex);
+}
+
+/**
+ * zbd_emu_write - check a write against the emulated zone state
+ * @emu: emulated device.
+ * @offset: write start offset in bytes.
+ * @length: write length in bytes.
+ *
+ * Advance the write pointer of the target zone if the write starts at the
+ * write pointer and fits within the zone capacity. Returns 0 upon success and
+ * a negative error code if a real device would fail the write.
+ */
+int zbd_emu_write(struct zbd_emu *emu, uint64_t offset, uint64_t length)
+{
+	uint32_t zone_idx = zbd_emu_zone_idx(emu, offset);
+	struct zbd_emu_zone *z;
+	uint64_t end = offset + length;
+	int ret;
+
+	if (fio_unlikely(zone_idx >= emu->nr_zones))
+		return -EIO;
+
+	z = &emu->zones[zone_idx];
+	if (fio_unlikely(!zbd_emu_zone_is_open(z))) {
+		ret = zbd_emu_open_zone(emu, z);
+		if (ret)
+			return ret;
+	}
+
+	if (fio_unlikely(end > z->start + z->capacity))
+		return -EIO;
+	if (fio_unlikely(!__sync_bool_compare_and_swap(&z->wp, offset, end)))
+		return -EIO;
+
+	if (end == z->start + z->capacity)
+		zbd_emu_zone_full(emu, z);
+
+	return 0;
+}
+
+/**
+ * zbd_emu_append - place a zone append write
+ * @emu: emulated device.
+ * @offset: any offset within the target zone. Set to where the data is to be
+ *	written upon success.
+ * @length: write length in bytes.
+ *
+ * Returns 0 upon success and a negative error code if a real device would
+ * fail the write.
+ */
+int zbd_emu_append(struct zbd_emu *emu, unsigned long long *offset,
+		   uint64_t length)
+{
+	uint32_t zone_idx = zbd_emu_zone_idx(emu, *offset);
+	struct zbd_emu_zone *z;
+	uint64_t wp, end;
+	int ret;
+
+	if (fio_unlikely(zone_idx >= emu->nr_zones))
+		return -EIO;
+
+	z = &emu->zones[zone_idx];
+	if (fio_unlikely(!zbd_emu_zone_is_open(z))) {
+		ret = zbd_emu_open_zone(emu, z);
+		if (ret)
+			return ret;
+	}
+
+	do {
+		wp = z->wp;
+		end = wp + length;
+		if (fio_unlikely(end > z->start + z->capacity))
+			return -EIO;
+	} while (!__sync_bool_compare_and_swap(&z->wp, wp, end));
+
+	if (end == z->start + z->capacity)
+		zbd_emu_zone_full(emu, z);
+
+	*offset = wp;
+	return 0;
+}
+
+/*
+ * Look up the zones covering @offset...@offset+@length. Both ends must be
+ * zone aligned.
+ */
+static int zbd_emu_zone_range(struct zbd_emu *emu, uint64_t offset,
+			      uint64_t length, uint32_t *zb, uint32_t *ze)
+{
+	*zb = zbd_emu_zone_idx(emu, offset);
+	*ze = zbd_emu_zone_idx(emu, offset + length + emu->zone_size - 1);
+	if (*ze > emu->nr_zones)
+		*ze = emu->nr_zones;
+
+	if (*zb >= emu->nr_zones || emu->zones[*zb].start != offset) {
+		errno = EINVAL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Resetting a zone only rewinds its write pointer, the old data is left in
+ * the file. Deallocating it would make resets far more expensive than they
+ * are on real devices.
+ */
+int zbd_emu_reset_wp(struct fio_file *f, uint64_t offset, uint64_t length)
+{
+	struct zbd_emu *emu = f->zbd_emu;
+	uint32_t zi, zb, ze;
+	int ret;
+
+	ret = zbd_emu_zone_range(emu, offset, length, &zb, &ze);
+	if (ret)
+		return ret;
+
+	pthread_mutex_lock(&emu->mutex);
+	for (zi = zb; zi < ze; zi++) {
+		struct zbd_emu_zone *z = &emu->zones[zi];
+
+		zbd_emu_zone_deactivate(emu, z);
+		z->cond = ZBD_ZONE_COND_EMPTY;
+		z->wp = z->start;
+	}
+	pthread_mutex_unlock(&emu->mutex);
+
+	return 0;
+}
+
+int zbd_emu_finish_zone(struct fio_file *f, uint64_t offset, uint64_t length)
+{
+	struct zbd_emu *emu = f->zbd_emu;
+	uint32_t zi, zb, ze;
+	int ret;
+
+	ret = zbd_emu_zone_range(emu, offset, length, &zb, &ze);
+	if (ret)
+		return ret;
+
+	pthread_mutex_lock(&emu->mutex);
+	for (zi = zb; zi < ze; zi++) {
+		struct zbd_emu_zone *z = &emu->zones[zi];
+
+		zbd_emu_zone_deactivate(emu, z);
+		z->cond = ZBD_ZONE_COND_FULL;
+		z->wp = z->start + z->len;
+	}
+	pthread_mutex_unlock(&emu->mutex);
+
+	return 0;
+}
+
+int zbd_emu_report_zones(struct fio_file *f, uint64_t offset,
+			 struct zbd_zone *zones, unsigned int nr_zones)
+{
+	struct zbd_emu *emu = f->zbd_emu;
+	uint32_t zi = zbd_emu_zone_idx(emu, offset);
+	unsigned int i;
+
+	pthread_mutex_lock(&emu->mutex);
+	for (i = 0; i < nr_zones && zi < emu->nr_zones; i++, zi++) {
+		const struct zbd_emu_zone *z = &emu->zones[zi];
+
+		zones[i] = (struct zbd_zone) {
+			.start		= z->start,
+			.wp		= z->wp,
+			.len		= z->len,
+			.capacity	= z->capacity,
+			.type		= ZBD_ZONE_TYPE_SWR,
+			.cond		= z->cond,
+		};
+	}
+	pthread_mutex_unlock(&emu->mutex);
+
+	return i;
+}
+
+/**
+ * zbd_emu_init - set up host-managed zone emulation for a regular file
+ * @td: fio thread data.
+ * @f: regular file to emulate a zoned block device on.
+ *
+ * The zone geometry comes from the zonesize and zonecapacity job options, the
+ * zone resource limits from zone_emulation_max_open and
+ * zone_emulation_max_active. If the file size is not a multiple of the zone
+ * size, the capacity of the last zone is truncated at the end of the file.
+ *
+ * Returns 0 upon success and a negative error code upon failure.
+ */
+int zbd_emu_init(struct thread_data *td, struct fio_file *f)
+{
+	uint64_t zone_size = td->o.zone_size;
+	uint64_t zone_capacity = td->o.zone_capacity;
+	struct zbd_emu *emu;
+	uint32_t nr_zones, i;
+
+	if (zone_size == 0) {
+		log_err("%s: Specifying the zone size is mandatory with zone_emulation\n",
+			f->file_name);
+		return -EINVAL;
+	}
+	if (zone_size < 512 || (zone_size & 511)) {
+		log_err("%s: zone size must be a multiple of 512 bytes with zone_emulation\n",
+			f->file_name);
+		return -EINVAL;
+	}
+	if (zone_capacity == 0)
+		zone_capacity = zone_size;
+	if (zone_capacity > zone_size) {
+		log_err("%s: job parameter zonecapacity %llu is larger than zone size %llu\n",
+			f->file_name, td->o.zone_capacity, td->o.zone_size);
+		return -EINVAL;
+	}
+	if (f->real_file_size < zone_size) {
+		log_err("%s: file size %"PRIu64" is smaller than zone size %"PRIu64"\n",
+			f->file_name, f->real_file_size, zone_size);
+		return -EINVAL;
+	}
+	if (td->o.zone_emu_max_active &&
+	    td->o.zone_emu_max_open > td->o.zone_emu_max_active) {
+		log_err("%s: zone_emulation_max_open is larger than zone_emulation_max_active\n",
+			f->file_name);
+		return -EINVAL;
+	}
+
+	nr_zones = (f->real_file_size + zone_size - 1) / zone_size;
+	emu = scalloc(1, sizeof(*emu) + nr_zones * sizeof(emu->zones[0]));
+	if (!emu)
+		return -ENOMEM;
+
+	mutex_init_pshared(&emu->mutex);
+	emu->zone_size = zone_size;
+	if (is_power_of_2(zone_size))
+		emu->zone_size_log2 = __builtin_ctzll(zone_size);
+	emu->nr_zones = nr_zones;
+	emu->max_open_zones = td->o.zone_emu_max_open;
+	emu->max_active_zones = td->o.zone_emu_max_active;
+
+	for (i = 0; i < nr_zones; i++) {
+		struct zbd_emu_zone *z = &emu->zones[i];
+
+		z->start = i * zone_size;
+		z->wp = z->start;
+		z->len = zone_size;
+		z->capacity = min(zone_capacity, f->real_file_size - z->start);
+		z->cond = ZBD_ZONE_COND_EMPTY;
+	}
+
+	dprint(FD_ZBD, "%s: emulating %u zones of %"PRIu64" KB (max open %u, max active %u)\n",
+	       f->file_name, nr_zones, zone_size / 1024,
+	       emu->max_open_zones, emu->max_active_zones);
+
+	f->zbd_emu = emu;
+	return 0;
+}
+
+void zbd_emu_free(struct zbd_emu *emu)
+{
+	pthread_mutex_destroy(&emu->mutex);
+	sfree(emu);
+}
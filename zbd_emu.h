@@ -0,0 +1,106 @@
+/*
+ * Host-managed zoned block device emulation on top of regular files.
+ *
+ * This file is released under the GPL.
+ */
+#ifndef FIO_ZBD_EMU_H
+#define FIO_ZBD_EMU_H
+
+#include <pthread.h>
+
+#include "compiler/compiler.h"
+#include "file.h"
+#include "io_u.h"
+#include "zbd_types.h"
+
+struct thread_data;
+
+/**
+ * struct zbd_emu_zone - emulated zone state
+ * @start: zone start location (bytes)
+ * @wp: zone write pointer location (bytes). Advanced with compare-and-swap
+ *	so that sequential write enforcement does not need a lock.
+ * @len: zone length (bytes)
+ * @capacity: maximum size usable from the start of the zone (bytes)
+ * @cond: zone condition, modified with zbd_emu.mutex held
+ */
+struct zbd_emu_zone {
+	uint64_t		start;
+	uint64_t		wp;
+	uint64_t		len;
+	uint64_t		capacity;
+	enum zbd_zone_cond	cond;
+};
+
+/**
+ * struct zbd_emu - emulated host-managed zoned block device
+ * @mutex: protects zone conditions and the open/closed zone counters
+ * @zone_size: size of a single zone in bytes
+ * @zone_size_log2: log2 of the zone size if it is a power of 2, else 0
+ * @nr_zones: number of zones
+ * @max_open_zones: open zone limit, zero means no limit
+ * @max_active_zones: active (open or closed) zone limit, zero means no limit
+ * @nr_open: number of implicitly or explicitly open zones
+ * @nr_closed: number of closed zones
+ * @close_cursor: where to start looking for a zone to implicitly close
+ * @zones: emulated zone state
+ *
+ * The emulated device lives in shared memory and is shared by all jobs that
+ * access the same file, like struct zoned_block_device_info. Its zone state
+ * starts out empty every time fio runs.
+ */
+struct zbd_emu {
+	pthread_mutex_t		mutex;
+	uint64_t		zone_size;
+	uint32_t		zone_size_log2;
+	uint32_t		nr_zones;
+	uint32_t		max_open_zones;
+	uint32_t		max_active_zones;
+	uint32_t		nr_open;
+	uint32_t		nr_closed;
+	uint32_t		close_cursor;
+	struct zbd_emu_zone	zones[0];
+};
+
+int zbd_emu_init(struct thread_data *td, struct fio_file *f);
+void zbd_emu_free(struct zbd_emu *emu);
+int zbd_emu_report_zones(struct fio_file *f, uint64_t offset,
+			 struct zbd_zone *zones, unsigned int nr_zones);
+int zbd_emu_reset_wp(struct fio_file *f, uint64_t offset, uint64_t length);
+int zbd_emu_finish_zone(struct fio_file *f, uint64_t offset, uint64_t length);
+int zbd_emu_write(struct zbd_emu *emu, uint64_t offset, uint64_t length);
+int zbd_emu_append(struct zbd_emu *emu, unsigned long long *offset,
+		   uint64_t length);
+
+/*
+ * Check a write against the emulated device before it is issued, and place
+ * zone appends. Returns false with io_u->error set if the device rejects the
+ * write. A requeued write keeps the place it was given the first time.
+ */
+static inline bool zbd_emu_accept_io_u(struct thread_data *td,
+				       struct io_u *io_u)
+{
+	struct zbd_emu *emu = io_u->file->zbd_emu;
+	unsigned long long offset = io_u->offset;
+	int ret;
+
+	if (io_u->ddir != DDIR_WRITE || (io_u->flags & IO_U_F_ZONE_PLACED))
+		return true;
+
+	if (io_u->flags & IO_U_F_ZONE_APPEND) {
+		ret = zbd_emu_append(emu, &io_u->offset, io_u->xfer_buflen);
+		/* The engine prepared the write for the offset fio reserved */
+		if (!ret && io_u->offset != offset && td->io_ops->prep)
+			ret = td->io_ops->prep(td, io_u);
+	} else
+		ret = zbd_emu_write(emu, io_u->offset, io_u->xfer_buflen);
+	if (fio_unlikely(ret)) {
+		io_u->error = -ret;
+		return false;
+	}
+
+	io_u_set(td, io_u, IO_U_F_ZONE_PLACED);
+	return true;
+}
+
+#endif /* FIO_ZBD_EMU_H */